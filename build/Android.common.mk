@@ -150,6 +150,15 @@ $(info Enabling ART_USE_PORTABLE_COMPILER because WITH_ART_USE_PORTABLE_COMPILER
 ART_USE_PORTABLE_COMPILER := true
 endif
 
+#
+# Used to enable the threaded (computed goto) dispatch of the interpreter
+#
+ART_USE_COMPUTED_GOTO_INTERPRETER := false
+ifeq ($(WITH_ART_USE_COMPUTED_GOTO_INTERPRETER),true)
+$(info Enabling ART_USE_COMPUTED_GOTO_INTERPRETER because WITH_ART_USE_COMPUTED_GOTO_INTERPRETER=true)
+ART_USE_COMPUTED_GOTO_INTERPRETER := true
+endif
+
 LLVM_ROOT_PATH := external/llvm
 include $(LLVM_ROOT_PATH)/llvm.mk
 
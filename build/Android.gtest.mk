@@ -48,6 +48,7 @@ TEST_COMMON_SRC_FILES := \
 	runtime/indenter_test.cc \
 	runtime/indirect_reference_table_test.cc \
 	runtime/intern_table_test.cc \
+	runtime/interpreter/inline_cache_test.cc \
 	runtime/jni_internal_test.cc \
 	runtime/mem_map_test.cc \
 	runtime/mirror/dex_cache_test.cc \
@@ -60,6 +61,13 @@ TEST_COMMON_SRC_FILES := \
 	runtime/verifier/reg_type_test.cc \
 	runtime/zip_archive_test.cc
 
+ifeq ($(ART_GC_SERVICE),true)
+TEST_COMMON_SRC_FILES += \
+	runtime/gc/service/proc_sampler_test.cc \
+	runtime/gc/service/request_ring_test.cc \
+	runtime/gc/service/service_simulator_test.cc
+endif
+
 ifeq ($(ART_SEA_IR_MODE),true)
 TEST_COMMON_SRC_FILES += \
 	compiler/utils/scoped_hashtable_test.cc \
@@ -155,6 +155,18 @@ static CompiledMethod* CompileMethod(CompilerDriver& compiler,
     cu.disable_opt |= (1 << kBranchFusing);
   }
 
+  // Linear scan promotion is an alternative mode of the ARM and x86 backends.
+  if (!Runtime::Current()->IsLinearScanMode() ||
+      ((cu.instruction_set != kThumb2) && (cu.instruction_set != kX86))) {
+    cu.disable_opt |= (1 << kLinearScanPromotion);
+  }
+
+  // So are global value numbering and loop invariant code motion.
+  if (!Runtime::Current()->IsGvnLicmMode() || (compiler_backend != kQuick) ||
+      ((cu.instruction_set != kThumb2) && (cu.instruction_set != kX86))) {
+    cu.disable_opt |= (1 << kGlobalValueNumbering) | (1 << kLoopInvariantCodeMotion);
+  }
+
   if (cu.instruction_set == kMips) {
     // Disable some optimizations for mips for now
     cu.disable_opt |= (
@@ -182,7 +194,9 @@ static CompiledMethod* CompileMethod(CompilerDriver& compiler,
                               class_loader, dex_file);
 
 #if !defined(ART_USE_PORTABLE_COMPILER)
-  if (cu.mir_graph->SkipCompilation(Runtime::Current()->GetCompilerFilter())) {
+  // Hot methods of a running app are compiled whatever the filter it was installed with.
+  if (!Runtime::Current()->IsStarted() &&
+      cu.mir_graph->SkipCompilation(Runtime::Current()->GetCompilerFilter())) {
     return NULL;
   }
 #endif
@@ -202,6 +216,9 @@ static CompiledMethod* CompileMethod(CompilerDriver& compiler,
   /* Perform null check elimination */
   cu.mir_graph->NullCheckElimination();
 
+  /* Number values over the dominator tree to remove redundant checks */
+  cu.mir_graph->GlobalValueNumbering();
+
   /* Combine basic blocks where possible */
   cu.mir_graph->BasicBlockCombine();
 
@@ -219,6 +236,9 @@ static CompiledMethod* CompileMethod(CompilerDriver& compiler,
   /* Set up regLocation[] array to describe values - one for each ssa_name. */
   cu.mir_graph->BuildRegLocations();
 
+  /* Hoist loop invariant code now that the value types are known */
+  cu.mir_graph->LoopInvariantCodeMotion();
+
   CompiledMethod* result = NULL;
 
 #if defined(ART_USE_PORTABLE_COMPILER)
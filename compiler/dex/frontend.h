@@ -56,6 +56,9 @@ enum opt_control_vector {
   kMatch,
   kPromoteCompilerTemps,
   kBranchFusing,
+  kLinearScanPromotion,
+  kGlobalValueNumbering,
+  kLoopInvariantCodeMotion,
 };
 
 // Force code generation paths for testing.
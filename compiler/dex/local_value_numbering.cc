@@ -28,14 +28,11 @@ uint16_t LocalValueNumbering::GetValueNumber(MIR* mir) {
     case Instruction::RETURN:
     case Instruction::RETURN_OBJECT:
     case Instruction::RETURN_WIDE:
-    case Instruction::MONITOR_ENTER:
-    case Instruction::MONITOR_EXIT:
     case Instruction::GOTO:
     case Instruction::GOTO_16:
     case Instruction::GOTO_32:
     case Instruction::CHECK_CAST:
     case Instruction::THROW:
-    case Instruction::FILL_ARRAY_DATA:
     case Instruction::FILLED_NEW_ARRAY:
     case Instruction::FILLED_NEW_ARRAY_RANGE:
     case Instruction::PACKED_SWITCH:
@@ -52,6 +49,16 @@ uint16_t LocalValueNumbering::GetValueNumber(MIR* mir) {
     case Instruction::IF_GEZ:
     case Instruction::IF_GTZ:
     case Instruction::IF_LEZ:
+    case kMirOpFusedCmplFloat:
+    case kMirOpFusedCmpgFloat:
+    case kMirOpFusedCmplDouble:
+    case kMirOpFusedCmpgDouble:
+    case kMirOpFusedCmpLong:
+      // Nothing defined - take no action.
+      break;
+
+    case Instruction::MONITOR_ENTER:
+    case Instruction::MONITOR_EXIT:
     case Instruction::INVOKE_STATIC_RANGE:
     case Instruction::INVOKE_STATIC:
     case Instruction::INVOKE_DIRECT:
@@ -62,12 +69,13 @@ uint16_t LocalValueNumbering::GetValueNumber(MIR* mir) {
     case Instruction::INVOKE_SUPER_RANGE:
     case Instruction::INVOKE_INTERFACE:
     case Instruction::INVOKE_INTERFACE_RANGE:
-    case kMirOpFusedCmplFloat:
-    case kMirOpFusedCmpgFloat:
-    case kMirOpFusedCmplDouble:
-    case kMirOpFusedCmpgDouble:
-    case kMirOpFusedCmpLong:
-      // Nothing defined - take no action.
+      // Nothing defined, but memory may have been written by the callee or another thread.
+      KillMemory();
+      break;
+
+    case Instruction::FILL_ARRAY_DATA:
+      // Nothing defined, but array contents change.
+      AdvanceMemoryVersion(NO_VALUE, ARRAY_REF);
       break;
 
     case Instruction::MOVE_EXCEPTION:
@@ -79,6 +87,10 @@ uint16_t LocalValueNumbering::GetValueNumber(MIR* mir) {
     case Instruction::CONST_STRING_JUMBO:
     case Instruction::CONST_CLASS:
     case Instruction::NEW_ARRAY: {
+        if (opcode == Instruction::NEW_INSTANCE) {
+          // May run a class initializer.
+          KillMemory();
+        }
         // 1 result, treat as unique each time, use result s_reg - will be unique.
         uint16_t res = GetOperandValue(mir->ssa_rep->defs[0]);
         SetOperandValue(mir->ssa_rep->defs[0], res);
@@ -384,7 +396,8 @@ uint16_t LocalValueNumbering::GetValueNumber(MIR* mir) {
         // Use side effect to note range check completed.
         (void)LookupValue(ARRAY_REF, array, index, NO_VALUE);
         // Establish value number for loaded register. Note use of memory version.
-        uint16_t memory_version = GetMemoryVersion(array, NO_VALUE);
+        // Arrays may alias each other, so they share a single memory version.
+        uint16_t memory_version = GetMemoryVersion(NO_VALUE, ARRAY_REF);
         uint16_t res = LookupValue(ARRAY_REF, array, index, memory_version);
         if (opcode == Instruction::AGET_WIDE) {
           SetOperandValueWide(mir->ssa_rep->defs[0], res);
@@ -423,7 +436,7 @@ uint16_t LocalValueNumbering::GetValueNumber(MIR* mir) {
         // Use side effect to note range check completed.
         (void)LookupValue(ARRAY_REF, array, index, NO_VALUE);
         // Rev the memory version
-        AdvanceMemoryVersion(array, NO_VALUE);
+        AdvanceMemoryVersion(NO_VALUE, ARRAY_REF);
       }
       break;
 
@@ -445,7 +458,8 @@ uint16_t LocalValueNumbering::GetValueNumber(MIR* mir) {
         }
         mir->meta.throw_insn->optimization_flags |= mir->optimization_flags;
         uint16_t field_ref = mir->dalvikInsn.vC;
-        uint16_t memory_version = GetMemoryVersion(base, field_ref);
+        // Any two bases may alias, so the version is kept per field.
+        uint16_t memory_version = GetMemoryVersion(NO_VALUE, field_ref);
         if (opcode == Instruction::IGET_WIDE) {
           uint16_t res = LookupValue(Instruction::IGET_WIDE, base, field_ref, memory_version);
           SetOperandValueWide(mir->ssa_rep->defs[0], res);
@@ -475,7 +489,7 @@ uint16_t LocalValueNumbering::GetValueNumber(MIR* mir) {
         }
         mir->meta.throw_insn->optimization_flags |= mir->optimization_flags;
         uint16_t field_ref = mir->dalvikInsn.vC;
-        AdvanceMemoryVersion(base, field_ref);
+        AdvanceMemoryVersion(NO_VALUE, field_ref);
       }
       break;
 
@@ -486,6 +500,8 @@ uint16_t LocalValueNumbering::GetValueNumber(MIR* mir) {
     case Instruction::SGET_CHAR:
     case Instruction::SGET_SHORT:
     case Instruction::SGET_WIDE: {
+        // May run a class initializer.
+        KillMemory();
         uint16_t field_ref = mir->dalvikInsn.vB;
         uint16_t memory_version = GetMemoryVersion(NO_VALUE, field_ref);
         if (opcode == Instruction::SGET_WIDE) {
@@ -505,6 +521,8 @@ uint16_t LocalValueNumbering::GetValueNumber(MIR* mir) {
     case Instruction::SPUT_CHAR:
     case Instruction::SPUT_SHORT:
     case Instruction::SPUT_WIDE: {
+        // May run a class initializer.
+        KillMemory();
         uint16_t field_ref = mir->dalvikInsn.vB;
         AdvanceMemoryVersion(NO_VALUE, field_ref);
       }
@@ -33,7 +33,12 @@ typedef SafeMap<uint32_t, uint16_t> MemoryVersionMap;
 
 class LocalValueNumbering {
  public:
-  explicit LocalValueNumbering(CompilationUnit* cu) : cu_(cu) {}
+  explicit LocalValueNumbering(CompilationUnit* cu)
+      : cu_(cu), last_version_(0), memory_epoch_(0) {}
+
+  // Value names and memory versions are 16 bits wide.  Numbering must stop before they
+  // run into NO_VALUE and ARRAY_REF.
+  static const size_t kMaxValueNames = 0xff00;
 
   static uint64_t BuildKey(uint16_t op, uint16_t operand1, uint16_t operand2, uint16_t modifier) {
     return (static_cast<uint64_t>(op) << 48 | static_cast<uint64_t>(operand1) << 32 |
@@ -64,7 +69,7 @@ class LocalValueNumbering {
     uint16_t res;
     MemoryVersionMap::iterator it = memory_version_map_.find(key);
     if (it == memory_version_map_.end()) {
-      res = 0;
+      res = memory_epoch_;
       memory_version_map_.Put(key, res);
     } else {
       res = it->second;
@@ -76,12 +81,23 @@ class LocalValueNumbering {
     uint32_t key = (base << 16) | field;
     MemoryVersionMap::iterator it = memory_version_map_.find(key);
     if (it == memory_version_map_.end()) {
-      memory_version_map_.Put(key, 0);
+      memory_version_map_.Put(key, ++last_version_);
     } else {
-      it->second++;
+      it->second = ++last_version_;
     }
   };
 
+  // Forget everything known about memory, e.g. across a call or a control flow merge.
+  // Versions are never reused, so values loaded before the kill can't match later loads.
+  void KillMemory() {
+    memory_version_map_.clear();
+    memory_epoch_ = ++last_version_;
+  };
+
+  bool Overflowed() const {
+    return (value_map_.size() >= kMaxValueNames) || (last_version_ >= kMaxValueNames);
+  };
+
   void SetOperandValue(uint16_t s_reg, uint16_t value) {
     SregValueMap::iterator it = sreg_value_map_.find(s_reg);
     if (it != sreg_value_map_.end()) {
@@ -134,6 +150,8 @@ class LocalValueNumbering {
   SregValueMap sreg_wide_value_map_;
   ValueMap value_map_;
   MemoryVersionMap memory_version_map_;
+  uint16_t last_version_;
+  uint16_t memory_epoch_;
   std::set<uint16_t> null_checked_;
 };
 
@@ -580,6 +580,8 @@ class MIRGraph {
   void SSATransformation();
   void CheckForDominanceFrontier(BasicBlock* dom_bb, const BasicBlock* succ_bb);
   void NullCheckElimination();
+  void GlobalValueNumbering();
+  void LoopInvariantCodeMotion();
   bool SetFp(int index, bool is_fp);
   bool SetCore(int index, bool is_core);
   bool SetRef(int index, bool is_ref);
@@ -674,6 +676,13 @@ class MIRGraph {
   void DoConstantPropogation(BasicBlock* bb);
   void CountChecks(BasicBlock* bb);
   bool CombineBlocks(BasicBlock* bb);
+  bool IsLoopInvariant(MIR* mir, BasicBlock* pre_header, ArenaBitVector* loop_blocks,
+                       const std::vector<BasicBlock*>& def_blocks,
+                       const std::vector<int>& vreg_defs, const std::vector<bool>& ref_vregs,
+                       bool loop_writes_fields);
+  bool HoistLoopInvariants(BasicBlock* pre_header, ArenaBitVector* loop_blocks,
+                           std::vector<BasicBlock*>* def_blocks,
+                           const std::vector<bool>& ref_vregs);
   void AnalyzeBlock(BasicBlock* bb, struct MethodStats* stats);
   bool ComputeSkipCompilation(struct MethodStats* stats, bool skip_default);
 
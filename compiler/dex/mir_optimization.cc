@@ -14,6 +14,8 @@
  * limitations under the License.
  */
 
+#include <algorithm>
+
 #include "compiler_internals.h"
 #include "local_value_numbering.h"
 #include "dataflow_iterator-inl.h"
@@ -872,4 +874,411 @@ void MIRGraph::BasicBlockOptimization() {
   }
 }
 
+/*
+ * Global value numbering.  Walk the dominator tree, handing each block the value numbering
+ * state left at the end of its immediate dominator.  Null and range checks done there hold
+ * in every dominated block.  Memory state only carries over to a block entered solely from
+ * the end of its dominator.
+ */
+void MIRGraph::GlobalValueNumbering() {
+  if (cu_->disable_opt & (1 << kGlobalValueNumbering)) {
+    return;
+  }
+  std::vector<std::pair<BasicBlock*, LocalValueNumbering*> > work_stack;
+  work_stack.push_back(std::make_pair(GetEntryBlock(), new LocalValueNumbering(cu_)));
+  bool overflowed = false;
+  while (!work_stack.empty()) {
+    BasicBlock* bb = work_stack.back().first;
+    LocalValueNumbering* valnum = work_stack.back().second;
+    work_stack.pop_back();
+    if (overflowed) {
+      delete valnum;
+      continue;
+    }
+    if (bb->catch_entry) {
+      // Be conservative with catch blocks, as the null check elimination is.
+      delete valnum;
+      valnum = new LocalValueNumbering(cu_);
+    } else if ((Predecessors(bb) != 1) || (bb->predecessors->Get(0) != bb->i_dom)) {
+      valnum->KillMemory();
+    }
+    for (MIR* mir = bb->first_mir_insn; mir != NULL; mir = mir->next) {
+      valnum->GetValueNumber(mir);
+      if (valnum->Overflowed()) {
+        // Checks removed so far are sound; give up on the rest of the method.
+        if (cu_->verbose) {
+          LOG(INFO) << "Out of value names in " << PrettyMethod(cu_->method_idx, *cu_->dex_file);
+        }
+        overflowed = true;
+        break;
+      }
+    }
+    std::vector<BasicBlock*> dominated;
+    if (!overflowed && (bb->i_dominated != NULL)) {
+      ArenaBitVector::Iterator iter(bb->i_dominated);
+      for (int idx = iter.Next(); idx != -1; idx = iter.Next()) {
+        dominated.push_back(GetBasicBlock(idx));
+      }
+    }
+    if (dominated.empty()) {
+      delete valnum;
+      continue;
+    }
+    // Each dominated block gets its own copy of the state; the last one takes this one.
+    for (size_t i = 0; i + 1 < dominated.size(); i++) {
+      work_stack.push_back(std::make_pair(dominated[i], new LocalValueNumbering(*valnum)));
+    }
+    work_stack.push_back(std::make_pair(dominated.back(), valnum));
+  }
+  if (cu_->enable_debug & (1 << kDebugDumpCFG)) {
+    DumpCFG("/sdcard/4_post_gvn_cfg/", false);
+  }
+}
+
+static void GetSuccessors(BasicBlock* bb, std::vector<BasicBlock*>* successors) {
+  if (bb->taken != NULL) {
+    successors->push_back(bb->taken);
+  }
+  if (bb->fall_through != NULL) {
+    successors->push_back(bb->fall_through);
+  }
+  if (bb->successor_block_list.block_list_type != kNotUsed) {
+    GrowableArray<SuccessorBlockInfo*>::Iterator iterator(bb->successor_block_list.blocks);
+    for (SuccessorBlockInfo* info = iterator.Next(); info != NULL; info = iterator.Next()) {
+      successors->push_back(info->block);
+    }
+  }
+}
+
+/* Stores, calls, monitors and anything that may run a class initializer */
+static bool MayWriteFields(Instruction::Code opcode) {
+  switch (opcode) {
+    case Instruction::IPUT:
+    case Instruction::IPUT_WIDE:
+    case Instruction::IPUT_OBJECT:
+    case Instruction::IPUT_BOOLEAN:
+    case Instruction::IPUT_BYTE:
+    case Instruction::IPUT_CHAR:
+    case Instruction::IPUT_SHORT:
+    case Instruction::SGET:
+    case Instruction::SGET_WIDE:
+    case Instruction::SGET_OBJECT:
+    case Instruction::SGET_BOOLEAN:
+    case Instruction::SGET_BYTE:
+    case Instruction::SGET_CHAR:
+    case Instruction::SGET_SHORT:
+    case Instruction::SPUT:
+    case Instruction::SPUT_WIDE:
+    case Instruction::SPUT_OBJECT:
+    case Instruction::SPUT_BOOLEAN:
+    case Instruction::SPUT_BYTE:
+    case Instruction::SPUT_CHAR:
+    case Instruction::SPUT_SHORT:
+    case Instruction::NEW_INSTANCE:
+    case Instruction::MONITOR_ENTER:
+    case Instruction::MONITOR_EXIT:
+      return true;
+    default:
+      return (Instruction::FlagsOf(opcode) & Instruction::kInvoke) != 0;
+  }
+}
+
+static void RemoveMIR(BasicBlock* bb, MIR* mir) {
+  if (mir->prev != NULL) {
+    mir->prev->next = mir->next;
+  } else {
+    bb->first_mir_insn = mir->next;
+  }
+  if (mir->next != NULL) {
+    mir->next->prev = mir->prev;
+  } else {
+    bb->last_mir_insn = mir->prev;
+  }
+  mir->prev = mir->next = NULL;
+}
+
+/*
+ * Can this loop MIR be computed once in the pre-header instead?  Quick generates code per
+ * Dalvik register rather than per SSA name, so the MIR must be the only def of its registers
+ * in the loop (no phi at the header means they are dead there), and it must not hold
+ * references the GC maps don't expect.
+ */
+bool MIRGraph::IsLoopInvariant(MIR* mir, BasicBlock* pre_header, ArenaBitVector* loop_blocks,
+                               const std::vector<BasicBlock*>& def_blocks,
+                               const std::vector<int>& vreg_defs,
+                               const std::vector<bool>& ref_vregs, bool loop_writes_fields) {
+  int opcode = mir->dalvikInsn.opcode;
+  if ((opcode >= static_cast<int>(kMirOpFirst)) || (mir->ssa_rep == NULL) ||
+      (mir->ssa_rep->num_defs == 0)) {
+    return false;
+  }
+  // The check half of a split instruction generates the code for both halves.
+  if ((mir->meta.throw_insn != NULL) && (mir->meta.throw_insn != mir)) {
+    return false;
+  }
+  switch (opcode) {
+    case Instruction::NOP:
+    case Instruction::MOVE_RESULT:
+    case Instruction::MOVE_RESULT_WIDE:
+    case Instruction::MOVE_RESULT_OBJECT:
+    case Instruction::MOVE_EXCEPTION:
+    // Constants are rematerialized at their uses anyway.
+    case Instruction::CONST_4:
+    case Instruction::CONST_16:
+    case Instruction::CONST:
+    case Instruction::CONST_HIGH16:
+    case Instruction::CONST_WIDE_16:
+    case Instruction::CONST_WIDE_32:
+    case Instruction::CONST_WIDE:
+    case Instruction::CONST_WIDE_HIGH16:
+      return false;
+    default:
+      break;
+  }
+  int flags = Instruction::FlagsOf(static_cast<Instruction::Code>(opcode));
+  if (flags & (Instruction::kBranch | Instruction::kSwitch | Instruction::kReturn |
+               Instruction::kInvoke)) {
+    return false;
+  }
+  if (flags & Instruction::kThrow) {
+    // Only loads that can no longer throw: their base is non-null before the loop.
+    switch (opcode) {
+      case Instruction::ARRAY_LENGTH:
+        break;
+      case Instruction::IGET:
+      case Instruction::IGET_WIDE:
+      case Instruction::IGET_BOOLEAN:
+      case Instruction::IGET_BYTE:
+      case Instruction::IGET_CHAR:
+      case Instruction::IGET_SHORT: {
+          if (loop_writes_fields) {
+            return false;
+          }
+          int field_offset;
+          bool is_volatile;
+          if (!cu_->compiler_driver->ComputeInstanceFieldInfo(
+              mir->dalvikInsn.vC, GetCurrentDexCompilationUnit(), field_offset, is_volatile,
+              false) || is_volatile) {
+            return false;
+          }
+        }
+        break;
+      default:
+        return false;
+    }
+    if (((mir->optimization_flags & MIR_IGNORE_NULL_CHECK) == 0) ||
+        (cu_->disable_opt & (1 << kNullCheckElimination)) ||
+        (pre_header->data_flow_info == NULL) ||
+        (pre_header->data_flow_info->ending_null_check_v == NULL) ||
+        !pre_header->data_flow_info->ending_null_check_v->IsBitSet(mir->ssa_rep->uses[0])) {
+      return false;
+    }
+  }
+  for (int i = 0; i < mir->ssa_rep->num_defs; i++) {
+    int s_reg = mir->ssa_rep->defs[i];
+    int v_reg = SRegToVReg(s_reg);
+    if ((v_reg < 0) || reg_location_[s_reg].ref || ref_vregs[v_reg] || (vreg_defs[v_reg] != 1)) {
+      return false;
+    }
+  }
+  for (int i = 0; i < mir->ssa_rep->num_uses; i++) {
+    BasicBlock* def_bb = def_blocks[mir->ssa_rep->uses[i]];
+    if ((def_bb != NULL) && loop_blocks->IsBitSet(def_bb->id)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/* Move the invariant MIRs of a loop to the end of its pre-header */
+bool MIRGraph::HoistLoopInvariants(BasicBlock* pre_header, ArenaBitVector* loop_blocks,
+                                   std::vector<BasicBlock*>* def_blocks,
+                                   const std::vector<bool>& ref_vregs) {
+  std::vector<int> vreg_defs(cu_->num_dalvik_registers, 0);
+  bool loop_writes_fields = false;
+  ArenaBitVector::Iterator iter(loop_blocks);
+  for (int idx = iter.Next(); idx != -1; idx = iter.Next()) {
+    BasicBlock* bb = GetBasicBlock(idx);
+    for (MIR* mir = bb->first_mir_insn; mir != NULL; mir = mir->next) {
+      if (mir->ssa_rep != NULL) {
+        for (int i = 0; i < mir->ssa_rep->num_defs; i++) {
+          int v_reg = SRegToVReg(mir->ssa_rep->defs[i]);
+          if (v_reg >= 0) {
+            vreg_defs[v_reg]++;
+          }
+        }
+      }
+      int opcode = mir->dalvikInsn.opcode;
+      if (opcode >= static_cast<int>(kMirOpFirst)) {
+        continue;
+      }
+      loop_writes_fields |= MayWriteFields(static_cast<Instruction::Code>(opcode));
+    }
+  }
+
+  // Hoisting may make the MIRs using the hoisted results invariant, so repeat.
+  bool hoisted = false;
+  bool change = true;
+  while (change) {
+    change = false;
+    ArenaBitVector::Iterator body_iter(loop_blocks);
+    for (int idx = body_iter.Next(); idx != -1; idx = body_iter.Next()) {
+      BasicBlock* bb = GetBasicBlock(idx);
+      MIR* next_mir;
+      for (MIR* mir = bb->first_mir_insn; mir != NULL; mir = next_mir) {
+        next_mir = mir->next;
+        if (!IsLoopInvariant(mir, pre_header, loop_blocks, *def_blocks, vreg_defs, ref_vregs,
+                             loop_writes_fields)) {
+          continue;
+        }
+        if (cu_->verbose) {
+          LOG(INFO) << "Hoisting loop invariant at 0x" << std::hex << mir->offset;
+        }
+        RemoveMIR(bb, mir);
+        // Keep the pre-header's branch to the loop last.
+        MIR* last_mir = pre_header->last_mir_insn;
+        if ((last_mir != NULL) &&
+            (static_cast<int>(last_mir->dalvikInsn.opcode) < static_cast<int>(kMirOpFirst)) &&
+            (Instruction::FlagsOf(last_mir->dalvikInsn.opcode) & Instruction::kBranch)) {
+          if (last_mir->prev != NULL) {
+            InsertMIRAfter(pre_header, last_mir->prev, mir);
+          } else {
+            PrependMIR(pre_header, mir);
+          }
+        } else {
+          AppendMIR(pre_header, mir);
+        }
+        for (int i = 0; i < mir->ssa_rep->num_defs; i++) {
+          (*def_blocks)[mir->ssa_rep->defs[i]] = pre_header;
+        }
+        change = true;
+        hoisted = true;
+      }
+    }
+  }
+  return hoisted;
+}
+
+/*
+ * Loop invariant code motion.  Runs after block combining, which leaves the predecessor lists
+ * stale, so the loops are found from the successor edges.  A block that dominates one of its
+ * predecessors heads a natural loop.  Inner loops go first, so what they hoist can move on
+ * out of the enclosing loops.
+ */
+void MIRGraph::LoopInvariantCodeMotion() {
+  if (cu_->disable_opt & (1 << kLoopInvariantCodeMotion)) {
+    return;
+  }
+  int num_blocks = GetNumBlocks();
+  std::vector<std::vector<BasicBlock*> > predecessors(num_blocks);
+  std::vector<BasicBlock*> def_blocks(GetNumSSARegs(), static_cast<BasicBlock*>(NULL));
+  std::vector<ArenaBitVector*> loops(num_blocks, static_cast<ArenaBitVector*>(NULL));
+  std::vector<BasicBlock*> latches;
+  for (int i = 0; i < num_blocks; i++) {
+    BasicBlock* bb = GetBasicBlock(i);
+    if ((bb == NULL) || (bb->block_type == kDead) || bb->hidden || (bb->dominators == NULL)) {
+      continue;
+    }
+    for (MIR* mir = bb->first_mir_insn; mir != NULL; mir = mir->next) {
+      if (mir->ssa_rep != NULL) {
+        for (int j = 0; j < mir->ssa_rep->num_defs; j++) {
+          def_blocks[mir->ssa_rep->defs[j]] = bb;
+        }
+      }
+    }
+    std::vector<BasicBlock*> successors;
+    GetSuccessors(bb, &successors);
+    for (size_t j = 0; j < successors.size(); j++) {
+      BasicBlock* succ_bb = successors[j];
+      predecessors[succ_bb->id].push_back(bb);
+      if (bb->dominators->IsBitSet(succ_bb->id)) {
+        latches.push_back(bb);
+        if (loops[succ_bb->id] == NULL) {
+          loops[succ_bb->id] = new (arena_) ArenaBitVector(arena_, num_blocks, false);
+          loops[succ_bb->id]->SetBit(succ_bb->id);
+        }
+      }
+    }
+  }
+  if (latches.empty()) {
+    return;
+  }
+
+  // Grow each loop body backwards from its latches up to the header.
+  for (size_t i = 0; i < latches.size(); i++) {
+    std::vector<BasicBlock*> successors;
+    GetSuccessors(latches[i], &successors);
+    for (size_t j = 0; j < successors.size(); j++) {
+      BasicBlock* header = successors[j];
+      if (!latches[i]->dominators->IsBitSet(header->id)) {
+        continue;
+      }
+      ArenaBitVector* loop_blocks = loops[header->id];
+      std::vector<BasicBlock*> work_list;
+      if (!loop_blocks->IsBitSet(latches[i]->id)) {
+        loop_blocks->SetBit(latches[i]->id);
+        work_list.push_back(latches[i]);
+      }
+      while (!work_list.empty()) {
+        BasicBlock* bb = work_list.back();
+        work_list.pop_back();
+        for (size_t k = 0; k < predecessors[bb->id].size(); k++) {
+          BasicBlock* pred_bb = predecessors[bb->id][k];
+          if (!loop_blocks->IsBitSet(pred_bb->id)) {
+            loop_blocks->SetBit(pred_bb->id);
+            work_list.push_back(pred_bb);
+          }
+        }
+      }
+    }
+  }
+
+  std::vector<std::pair<int, int> > loop_order;
+  for (int i = 0; i < num_blocks; i++) {
+    if (loops[i] != NULL) {
+      loop_order.push_back(std::make_pair(loops[i]->NumSetBits(), i));
+    }
+  }
+  std::sort(loop_order.begin(), loop_order.end());
+
+  std::vector<bool> ref_vregs(cu_->num_dalvik_registers, false);
+  for (int i = 0; i < GetNumSSARegs(); i++) {
+    int v_reg = SRegToVReg(i);
+    if ((v_reg >= 0) && reg_location_[i].ref) {
+      ref_vregs[v_reg] = true;
+    }
+  }
+
+  for (size_t i = 0; i < loop_order.size(); i++) {
+    BasicBlock* header = GetBasicBlock(loop_order[i].second);
+    ArenaBitVector* loop_blocks = loops[header->id];
+    if (header->catch_entry) {
+      continue;
+    }
+    // Need a single pre-header that falls or branches into the header and nowhere else.
+    BasicBlock* pre_header = NULL;
+    bool single_entry = true;
+    for (size_t j = 0; j < predecessors[header->id].size(); j++) {
+      BasicBlock* pred_bb = predecessors[header->id][j];
+      if (loop_blocks->IsBitSet(pred_bb->id)) {
+        continue;
+      }
+      single_entry &= (pre_header == NULL);
+      pre_header = pred_bb;
+    }
+    if (!single_entry || (pre_header == NULL) || (pre_header->block_type != kDalvikByteCode)) {
+      continue;
+    }
+    std::vector<BasicBlock*> successors;
+    GetSuccessors(pre_header, &successors);
+    if (successors.size() != 1) {
+      continue;
+    }
+    HoistLoopInvariants(pre_header, loop_blocks, &def_blocks, ref_vregs);
+  }
+  if (cu_->enable_debug & (1 << kDebugDumpCFG)) {
+    DumpCFG("/sdcard/7_post_licm_cfg/", false);
+  }
+}
+
 }  // namespace art
@@ -275,7 +275,7 @@ void Mir2Lir::FlushIns(RegLocation* ArgLocs, RegLocation rl_method) {
       RegLocation* t_loc = &ArgLocs[i];
       if ((v_map->core_location == kLocPhysReg) && !t_loc->fp) {
         OpRegCopy(v_map->core_reg, TargetReg(arg_regs[i]));
-        need_flush = false;
+        need_flush = v_map->write_through;
       } else if ((v_map->fp_location == kLocPhysReg) && t_loc->fp) {
         OpRegCopy(v_map->FpReg, TargetReg(arg_regs[i]));
         need_flush = false;
@@ -224,6 +224,7 @@ class Mir2Lir : public Backend {
       RegLocationType fp_location:3;
       uint8_t FpReg;
       bool first_in_pair;
+      bool write_through;         // Shares core_reg; defs also go to the frame.
     };
 
     virtual ~Mir2Lir() {}
@@ -370,6 +371,8 @@ class Mir2Lir : public Backend {
     void CountRefs(RefCounts* core_counts, RefCounts* fp_counts);
     void DumpCounts(const RefCounts* arr, int size, const char* msg);
     void DoPromotion();
+    // Implemented in ralloc_linear_scan.cc
+    void LinearScanPromotion(int promotion_threshold);
     int VRegOffset(int v_reg);
     int SRegOffset(int s_reg);
     RegLocation GetReturnWide(bool is_double);
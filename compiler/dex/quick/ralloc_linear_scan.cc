@@ -0,0 +1,347 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <vector>
+
+#include "dex/compiler_ir.h"
+#include "dex/compiler_internals.h"
+#include "dex/dataflow_iterator-inl.h"
+#include "mir_to_lir-inl.h"
+
+namespace art {
+
+/*
+ * Live range of a Dalvik register, as the hull of the positions where one of
+ * its SSA names is defined, used or live across a block boundary. Positions
+ * number the blocks and MIRs in the pre-order the code is generated in.
+ */
+struct LiveInterval {
+  int v_reg;
+  int start;
+  int end;
+  int weight;      // Uses of its SSA names, as counted by CountRefs.
+  bool ref;        // One of its SSA names holds a reference.
+  int reg;         // Assigned callee save register, or INVALID_REG.
+};
+
+static bool StartsBefore(const LiveInterval* a, const LiveInterval* b) {
+  return (a->start == b->start) ? (a->v_reg < b->v_reg) : (a->start < b->start);
+}
+
+
+/*
+ * Per block use/def sets of the Dalvik registers from the current SSA
+ * names, then live-in/live-out to a fixpoint. The sets built by the SSA
+ * transformation predate the block combining, so they are recomputed here.
+ * Phi nodes move nothing between Dalvik registers and are skipped.
+ */
+static void ComputeLiveness(MIRGraph* mir_graph, int num_vregs,
+                            const std::vector<BasicBlock*>& blocks, ArenaBitVector** live_in,
+                            ArenaBitVector** live_out, ArenaAllocator* arena) {
+  int num_blocks = mir_graph->GetNumBlocks();
+  ArenaBitVector** use = static_cast<ArenaBitVector**>(
+      arena->Alloc(sizeof(ArenaBitVector*) * num_blocks, ArenaAllocator::kAllocRegAlloc));
+  ArenaBitVector** def = static_cast<ArenaBitVector**>(
+      arena->Alloc(sizeof(ArenaBitVector*) * num_blocks, ArenaAllocator::kAllocRegAlloc));
+  for (size_t i = 0; i < blocks.size(); i++) {
+    BasicBlock* bb = blocks[i];
+    use[bb->id] = new (arena) ArenaBitVector(arena, num_vregs, false, kBitMapUse);
+    def[bb->id] = new (arena) ArenaBitVector(arena, num_vregs, false, kBitMapDef);
+    live_in[bb->id] = new (arena) ArenaBitVector(arena, num_vregs, false, kBitMapLiveIn);
+    live_out[bb->id] = new (arena) ArenaBitVector(arena, num_vregs, false, kBitMapLiveIn);
+    for (MIR* mir = bb->first_mir_insn; mir != NULL; mir = mir->next) {
+      SSARepresentation* ssa_rep = mir->ssa_rep;
+      if ((ssa_rep == NULL) ||
+          (static_cast<int>(mir->dalvikInsn.opcode) == kMirOpPhi)) {
+        continue;
+      }
+      for (int j = 0; j < ssa_rep->num_uses; j++) {
+        int v_reg = mir_graph->SRegToVReg(ssa_rep->uses[j]);
+        if ((v_reg >= 0) && !def[bb->id]->IsBitSet(v_reg)) {
+          use[bb->id]->SetBit(v_reg);
+        }
+      }
+      for (int j = 0; j < ssa_rep->num_defs; j++) {
+        int v_reg = mir_graph->SRegToVReg(ssa_rep->defs[j]);
+        if (v_reg >= 0) {
+          def[bb->id]->SetBit(v_reg);
+        }
+      }
+    }
+  }
+
+  ArenaBitVector* temp = new (arena) ArenaBitVector(arena, num_vregs, false, kBitMapRegisterV);
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    // Backwards over the pre-order converges in few passes.
+    for (size_t i = blocks.size(); i-- > 0; ) {
+      BasicBlock* bb = blocks[i];
+      ArenaBitVector* out = live_out[bb->id];
+      BasicBlock* succs[2] = { bb->taken, bb->fall_through };
+      for (int j = 0; j < 2; j++) {
+        if ((succs[j] != NULL) && (live_in[succs[j]->id] != NULL)) {
+          out->Union(live_in[succs[j]->id]);
+        }
+      }
+      if (bb->successor_block_list.block_list_type != kNotUsed) {
+        GrowableArray<SuccessorBlockInfo*>::Iterator iterator(bb->successor_block_list.blocks);
+        for (SuccessorBlockInfo* info = iterator.Next(); info != NULL; info = iterator.Next()) {
+          if (live_in[info->block->id] != NULL) {
+            out->Union(live_in[info->block->id]);
+          }
+        }
+      }
+      // live_in = use | (live_out & ~def)
+      temp->Copy(out);
+      for (int v_reg = 0; v_reg < num_vregs; v_reg++) {
+        if (def[bb->id]->IsBitSet(v_reg)) {
+          temp->ClearBit(v_reg);
+        }
+      }
+      temp->Union(use[bb->id]);
+      if (!temp->Equal(live_in[bb->id])) {
+        live_in[bb->id]->Copy(temp);
+        changed = true;
+      }
+    }
+  }
+}
+
+
+/*
+ * Linear scan promotion of the core Dalvik registers into the callee save
+ * registers. Registers whose live intervals do not overlap share a callee
+ * save; when more intervals are live than there are callee saves, the one
+ * with the fewest uses stays in the frame. Callee saves survive calls, so
+ * intervals are not split around them.
+ * The vmap table holds one Dalvik register per physical register: the first
+ * one assigned owns it and the others sharing it write every def through to
+ * their frame slot, where stack walks find them. An owner holding references
+ * would be read by the GC after its interval ends, so its register is not
+ * shared.
+ * Only narrow core registers are scanned; wide, fp and mixed registers, the
+ * Method* and the compiler temps are left to the count based promotion.
+ */
+void Mir2Lir::LinearScanPromotion(int promotion_threshold) {
+  int num_vregs = cu_->num_dalvik_registers;
+  if (num_vregs == 0) {
+    return;
+  }
+
+  // Candidates and their weights.
+  LiveInterval* intervals = static_cast<LiveInterval*>(
+      arena_->Alloc(sizeof(LiveInterval) * num_vregs, ArenaAllocator::kAllocRegAlloc));
+  bool* excluded = static_cast<bool*>(
+      arena_->Alloc(sizeof(bool) * num_vregs, ArenaAllocator::kAllocRegAlloc));
+  for (int v_reg = 0; v_reg < num_vregs; v_reg++) {
+    intervals[v_reg].v_reg = v_reg;
+    intervals[v_reg].start = -1;
+    intervals[v_reg].end = -1;
+    intervals[v_reg].reg = INVALID_REG;
+  }
+  for (int i = 0; i < mir_graph_->GetNumSSARegs(); i++) {
+    RegLocation loc = mir_graph_->reg_location_[i];
+    int v_reg = mir_graph_->SRegToVReg(loc.s_reg_low);
+    if (v_reg < 0) {
+      continue;
+    }
+    if (loc.wide || loc.fp) {
+      excluded[v_reg] = true;
+      continue;
+    }
+    intervals[v_reg].ref |= loc.ref;
+    if (!IsInexpensiveConstant(loc)) {
+      intervals[v_reg].weight += mir_graph_->GetUseCount(i);
+    }
+  }
+
+  // Number the code in the order it is generated.
+  std::vector<BasicBlock*> blocks;
+  PreOrderDfsIterator iter(mir_graph_, false /* not iterative */);
+  for (BasicBlock* bb = iter.Next(); bb != NULL; bb = iter.Next()) {
+    if (bb->block_type != kDead) {
+      blocks.push_back(bb);
+    }
+  }
+  int num_blocks = mir_graph_->GetNumBlocks();
+  ArenaBitVector** live_in = static_cast<ArenaBitVector**>(
+      arena_->Alloc(sizeof(ArenaBitVector*) * num_blocks, ArenaAllocator::kAllocRegAlloc));
+  ArenaBitVector** live_out = static_cast<ArenaBitVector**>(
+      arena_->Alloc(sizeof(ArenaBitVector*) * num_blocks, ArenaAllocator::kAllocRegAlloc));
+  ComputeLiveness(mir_graph_, num_vregs, blocks, live_in, live_out, arena_);
+
+  int pos = 0;
+  for (size_t i = 0; i < blocks.size(); i++) {
+    BasicBlock* bb = blocks[i];
+    int block_start = pos++;
+    for (MIR* mir = bb->first_mir_insn; mir != NULL; mir = mir->next) {
+      SSARepresentation* ssa_rep = mir->ssa_rep;
+      int mir_pos = pos++;
+      if ((ssa_rep == NULL) ||
+          (static_cast<int>(mir->dalvikInsn.opcode) == kMirOpPhi)) {
+        continue;
+      }
+      // Uses and defs share the position of the MIR: a register read by a
+      // MIR is not handed to the register it defines.
+      for (int j = 0; j < ssa_rep->num_uses + ssa_rep->num_defs; j++) {
+        int s_reg = (j < ssa_rep->num_uses) ? ssa_rep->uses[j] :
+            ssa_rep->defs[j - ssa_rep->num_uses];
+        int v_reg = mir_graph_->SRegToVReg(s_reg);
+        if (v_reg >= 0) {
+          LiveInterval* interval = &intervals[v_reg];
+          if (interval->start < 0 || mir_pos < interval->start) {
+            interval->start = mir_pos;
+          }
+          interval->end = std::max(interval->end, mir_pos);
+        }
+      }
+    }
+    int block_end = pos++;
+    for (int v_reg = 0; v_reg < num_vregs; v_reg++) {
+      LiveInterval* interval = &intervals[v_reg];
+      if (live_in[bb->id]->IsBitSet(v_reg)) {
+        if (interval->start < 0 || block_start < interval->start) {
+          interval->start = block_start;
+        }
+        interval->end = std::max(interval->end, block_start);
+      }
+      if (live_out[bb->id]->IsBitSet(v_reg)) {
+        if (interval->start < 0) {
+          interval->start = block_end;
+        }
+        interval->end = std::max(interval->end, block_end);
+      }
+    }
+  }
+  // The ins are copied to their homes on entry.
+  for (int v_reg = num_vregs - cu_->num_ins; v_reg < num_vregs; v_reg++) {
+    intervals[v_reg].start = 0;
+    intervals[v_reg].end = std::max(intervals[v_reg].end, 0);
+  }
+
+  std::vector<LiveInterval*> unhandled;
+  for (int v_reg = 0; v_reg < num_vregs; v_reg++) {
+    LiveInterval* interval = &intervals[v_reg];
+    int p_map_idx = SRegToPMap(v_reg);
+    if (!excluded[v_reg] && (interval->start >= 0) &&
+        (interval->weight >= promotion_threshold) &&
+        (promotion_map_[p_map_idx].core_location != kLocPhysReg)) {
+      unhandled.push_back(interval);
+    }
+  }
+  std::sort(unhandled.begin(), unhandled.end(), StartsBefore);
+
+  // Free callee saves, in the order AllocPreservedCoreReg takes them.
+  std::vector<int> free_regs;
+  RegisterInfo* core_regs = reg_pool_->core_regs;
+  for (int i = reg_pool_->num_core_regs - 1; i >= 0; i--) {
+    if (!core_regs[i].is_temp && !core_regs[i].in_use) {
+      free_regs.push_back(core_regs[i].reg);
+    }
+  }
+  if (free_regs.empty()) {
+    return;
+  }
+  // Owner of each register: the first interval it was assigned to that kept it.
+  std::vector<LiveInterval*> active;
+  std::vector<std::pair<int, LiveInterval*> > owners;
+
+  for (size_t i = 0; i < unhandled.size(); i++) {
+    LiveInterval* current = unhandled[i];
+    // Expire the intervals that ended before this one starts.
+    for (size_t j = 0; j < active.size(); ) {
+      LiveInterval* interval = active[j];
+      if (interval->end >= current->start) {
+        j++;
+        continue;
+      }
+      active.erase(active.begin() + j);
+      bool owner = false;
+      for (size_t k = 0; k < owners.size(); k++) {
+        if (owners[k].second == interval) {
+          owner = true;
+        }
+      }
+      if (!(owner && interval->ref)) {
+        free_regs.push_back(interval->reg);
+      }
+    }
+    int reg = INVALID_REG;
+    if (!free_regs.empty()) {
+      reg = free_regs.back();
+      free_regs.pop_back();
+    } else {
+      // Spill the lightest of the active intervals and the current one.
+      size_t lightest = active.size();
+      int weight = current->weight;
+      for (size_t j = 0; j < active.size(); j++) {
+        if (active[j]->weight < weight) {
+          lightest = j;
+          weight = active[j]->weight;
+        }
+      }
+      if (lightest == active.size()) {
+        continue;
+      }
+      LiveInterval* spilled = active[lightest];
+      reg = spilled->reg;
+      spilled->reg = INVALID_REG;
+      active.erase(active.begin() + lightest);
+      for (size_t k = 0; k < owners.size(); k++) {
+        if (owners[k].second == spilled) {
+          owners.erase(owners.begin() + k);
+          break;
+        }
+      }
+    }
+    current->reg = reg;
+    active.push_back(current);
+    bool owned = false;
+    for (size_t k = 0; k < owners.size(); k++) {
+      owned |= (owners[k].first == reg);
+    }
+    if (!owned) {
+      owners.push_back(std::make_pair(reg, current));
+    }
+  }
+
+  for (size_t k = 0; k < owners.size(); k++) {
+    RecordCorePromotion(owners[k].first, owners[k].second->v_reg);
+  }
+  for (size_t i = 0; i < unhandled.size(); i++) {
+    LiveInterval* interval = unhandled[i];
+    int p_map_idx = SRegToPMap(interval->v_reg);
+    if ((interval->reg != INVALID_REG) &&
+        (promotion_map_[p_map_idx].core_location != kLocPhysReg)) {
+      promotion_map_[p_map_idx].core_location = kLocPhysReg;
+      promotion_map_[p_map_idx].core_reg = interval->reg;
+      promotion_map_[p_map_idx].write_through = true;
+    }
+  }
+  if (cu_->verbose) {
+    for (size_t i = 0; i < unhandled.size(); i++) {
+      LiveInterval* interval = unhandled[i];
+      LOG(INFO) << "v" << interval->v_reg << " [" << interval->start << ", " << interval->end
+                << "] weight " << interval->weight << " -> "
+                << ((interval->reg == INVALID_REG) ? "frame" : StringPrintf("r%d", interval->reg))
+                << (promotion_map_[SRegToPMap(interval->v_reg)].write_through ? " (shared)" : "");
+    }
+  }
+}
+
+}  // namespace art
@@ -1026,7 +1026,10 @@ void Mir2Lir::DoPromotion() {
       }
     }
 
-    // Promote core regs
+    // Promote core regs, by live range first when enabled
+    if (!(cu_->disable_opt & (1 << kLinearScanPromotion))) {
+      LinearScanPromotion(promotion_threshold);
+    }
     for (int i = 0; (i < num_regs) &&
             (core_regs[i].count >= promotion_threshold); i++) {
       int p_map_idx = SRegToPMap(core_regs[i].s_reg);
@@ -1055,7 +1058,8 @@ void Mir2Lir::DoPromotion() {
         if (promotion_map_[p_map_idx].core_location == kLocPhysReg) {
           curr->location = kLocPhysReg;
           curr->low_reg = promotion_map_[p_map_idx].core_reg;
-          curr->home = true;
+          // A shared register is not the home of the vreg: defs get flushed.
+          curr->home = !promotion_map_[p_map_idx].write_through;
         }
       }
       curr->high_reg = INVALID_REG;
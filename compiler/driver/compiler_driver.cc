@@ -27,6 +27,7 @@
 #include "class_linker.h"
 #include "dex_compilation_unit.h"
 #include "dex_file-inl.h"
+#include "dex_instruction.h"
 #include "jni_internal.h"
 #include "object_utils.h"
 #include "runtime.h"
@@ -45,6 +46,7 @@
 #include "ScopedLocalRef.h"
 #include "thread.h"
 #include "thread_pool.h"
+#include "tiered_compiler.h"
 #include "trampolines/trampoline_compiler.h"
 #include "verifier/method_verifier.h"
 
@@ -388,7 +390,8 @@ CompilerDriver::CompilerDriver(CompilerBackend compiler_backend, InstructionSet
     jni_compiler_ = reinterpret_cast<JniCompilerFn>(ArtQuickJniCompileMethod);
   }
 
-  CHECK(!Runtime::Current()->IsStarted());
+  // Only the tiered compiler creates a driver once the runtime started.
+  CHECK(!Runtime::Current()->IsStarted() || Runtime::Current()->GetTieredCompiler() != NULL);
   if (!image_) {
     CHECK(image_classes_.get() == NULL);
   }
@@ -410,6 +413,23 @@ std::vector<uint8_t>* CompilerDriver::DeduplicateGCMap(const std::vector<uint8_t
   return dedupe_gc_map_.Add(Thread::Current(), code);
 }
 
+template <typename DedupeSetType>
+static void DumpDedupeStat(const DedupeSetType& dedupe_set, const char* name) {
+  size_t size;
+  size_t hits;
+  uint64_t add_time_ns;
+  dedupe_set.GetStats(Thread::Current(), &size, &hits, &add_time_ns);
+  DumpStat(hits, size, name);
+  VLOG(compiler) << PrettyDuration(add_time_ns) << " adding " << (hits + size) << " " << name;
+}
+
+void CompilerDriver::DumpDedupeStats() const {
+  DumpDedupeStat(dedupe_code_, "code arrays deduplicated");
+  DumpDedupeStat(dedupe_mapping_table_, "mapping tables deduplicated");
+  DumpDedupeStat(dedupe_vmap_table_, "vmap tables deduplicated");
+  DumpDedupeStat(dedupe_gc_map_, "GC maps deduplicated");
+}
+
 CompilerDriver::~CompilerDriver() {
   Thread* self = Thread::Current();
   {
@@ -494,6 +514,7 @@ void CompilerDriver::CompileAll(jobject class_loader,
   Compile(class_loader, dex_files, *thread_pool.get(), timings);
   if (dump_stats_) {
     stats_->Dump();
+    DumpDedupeStats();
   }
 }
 
@@ -574,6 +595,87 @@ void CompilerDriver::CompileOne(const mirror::ArtMethod* method, base::TimingLog
   self->TransitionFromSuspendedToRunnable();
 }
 
+// The DEX-to-DEX pass run on the apps installed with interpret-only rewrites field accesses,
+// virtual calls and the return of constructors into forms the Quick backend has no cases for.
+static bool HasQuickenedInstructions(const DexFile::CodeItem* code_item) {
+  const Instruction* inst = Instruction::At(code_item->insns_);
+  const Instruction* end =
+      Instruction::At(code_item->insns_ + code_item->insns_size_in_code_units_);
+  while (inst < end) {
+    switch (inst->Opcode()) {
+      case Instruction::RETURN_VOID_BARRIER:
+      case Instruction::IGET_QUICK:
+      case Instruction::IGET_WIDE_QUICK:
+      case Instruction::IGET_OBJECT_QUICK:
+      case Instruction::IPUT_QUICK:
+      case Instruction::IPUT_WIDE_QUICK:
+      case Instruction::IPUT_OBJECT_QUICK:
+      case Instruction::INVOKE_VIRTUAL_QUICK:
+      case Instruction::INVOKE_VIRTUAL_RANGE_QUICK:
+        return true;
+      default:
+        break;
+    }
+    inst = inst->Next();
+  }
+  return false;
+}
+
+CompiledMethod* CompilerDriver::CompileHotMethod(Thread* self, mirror::ArtMethod* method) {
+  jobject jclass_loader;
+  const DexFile* dex_file;
+  uint16_t class_def_idx;
+  const DexFile::CodeItem* code_item;
+  uint32_t method_idx;
+  uint32_t access_flags;
+  InvokeType invoke_type;
+  {
+    ScopedObjectAccess soa(self);
+    MethodHelper mh(method);
+    code_item = mh.GetCodeItem();
+    // Quickened methods stay in the interpreter.
+    if (HasQuickenedInstructions(code_item)) {
+      VLOG(compiler) << "Not compiling quickened method " << PrettyMethod(method);
+      return NULL;
+    }
+    // Records the GC map the backend emits, and the safe casts and devirtualized call sites.
+    if (!verifier::MethodVerifier::VerifyMethodForCompilation(method)) {
+      return NULL;
+    }
+    ScopedLocalRef<jobject>
+      local_class_loader(soa.Env(),
+                    soa.AddLocalReference<jobject>(method->GetDeclaringClass()->GetClassLoader()));
+    jclass_loader = soa.Env()->NewGlobalRef(local_class_loader.get());
+    dex_file = &mh.GetDexFile();
+    class_def_idx = mh.GetClassDefIndex();
+    method_idx = method->GetDexMethodIndex();
+    access_flags = method->GetAccessFlags();
+    invoke_type = method->GetInvokeType();
+  }
+  // The compiler filter of the app is not consulted, the method proved hot. The method is not
+  // added to compiled_methods_: its code lives in the code cache of the tiered compiler.
+  CompiledMethod* compiled_method = (*compiler_)(*this, code_item, access_flags, invoke_type,
+                                                 class_def_idx, method_idx, jclass_loader,
+                                                 *dex_file);
+  self->GetJniEnv()->DeleteGlobalRef(jclass_loader);
+  if (self->IsExceptionPending()) {
+    ScopedObjectAccess soa(self);
+    LOG(WARNING) << "Unexpected exception compiling " << PrettyMethod(method_idx, *dex_file)
+                 << "\n" << self->GetException(NULL)->Dump();
+    self->ClearException();
+    if (compiled_method != NULL) {
+      ReleaseCode(&compiled_method->GetCode());
+      delete compiled_method;
+    }
+    return NULL;
+  }
+  return compiled_method;
+}
+
+void CompilerDriver::ReleaseCode(const std::vector<uint8_t>* code) {
+  dedupe_code_.Remove(Thread::Current(), code);
+}
+
 void CompilerDriver::Resolve(jobject class_loader, const std::vector<const DexFile*>& dex_files,
                              ThreadPool& thread_pool, base::TimingLogger& timings) {
   for (size_t i = 0; i != dex_files.size(); ++i) {
@@ -2481,3 +2583,48 @@ void CompilerDriver::InstructionSetToLLVMTarget(InstructionSet instruction_set,
     }
   }
 }  // namespace art
+
+extern "C" bool ArtTieredCompileMethod(art::TieredCompiler* tiered, art::Thread* self,
+                                       art::mirror::ArtMethod* method, art::TieredCode* result) {
+  art::CompilerDriver* driver =
+      reinterpret_cast<art::CompilerDriver*>(tiered->GetCompilerContext());
+  if (driver == NULL) {
+    art::InstructionSet instruction_set = art::kNone;
+#if defined(__arm__)
+    instruction_set = art::kThumb2;
+#elif defined(__mips__)
+    instruction_set = art::kMips;
+#elif defined(__i386__)
+    instruction_set = art::kX86;
+#endif
+    if (instruction_set == art::kNone) {
+      return false;
+    }
+    driver = new art::CompilerDriver(art::kQuick, instruction_set, false, NULL, 1, false);
+    // The code is not part of an image.
+    driver->SetSupportBootImageFixup(false);
+    tiered->SetCompilerContext(driver);
+  }
+  art::CompiledMethod* compiled_method = driver->CompileHotMethod(self, method);
+  if (compiled_method == NULL) {
+    return false;
+  }
+  const std::vector<uint8_t>* code = &compiled_method->GetCode();
+  const void* code_begin = tiered->CommitCode(&(*code)[0], code->size());
+  if (code_begin != NULL) {
+    result->code_ = art::CompiledMethod::CodePointer(code_begin,
+                                                     compiled_method->GetInstructionSet());
+    result->frame_size_in_bytes_ = compiled_method->GetFrameSizeInBytes();
+    result->core_spill_mask_ = compiled_method->GetCoreSpillMask();
+    result->fp_spill_mask_ = compiled_method->GetFpSpillMask();
+    // The tables stay in the dedupe sets of the driver, which lives as long as the runtime.
+    result->mapping_table_ = &compiled_method->GetMappingTable()[0];
+    result->vmap_table_ = &compiled_method->GetVmapTable()[0];
+    result->gc_map_ = &compiled_method->GetGcMap()[0];
+  }
+  // Only the copy in the code cache runs; methods are compiled one at a time on the compile
+  // thread, so nothing else holds the code.
+  delete compiled_method;
+  driver->ReleaseCode(code);
+  return code_begin != NULL;
+}
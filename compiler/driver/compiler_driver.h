@@ -104,6 +104,15 @@ class CompilerDriver {
   void CompileOne(const mirror::ArtMethod* method, base::TimingLogger& timings)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
+  // Compile a hot method of a running app for the tiered compiler, NULL if it was quickened,
+  // does not verify or the backend declines it. The method is not kept by the driver; the caller
+  // deletes it and releases its code once the code is copied out.
+  CompiledMethod* CompileHotMethod(Thread* self, mirror::ArtMethod* method)
+      LOCKS_EXCLUDED(Locks::mutator_lock_);
+
+  // Frees code that DeduplicateCode returned, when nothing compiled by this driver uses it.
+  void ReleaseCode(const std::vector<uint8_t>* code);
+
   InstructionSet GetInstructionSet() const {
     return instruction_set_;
   }
@@ -318,6 +327,9 @@ class CompilerDriver {
   std::vector<uint8_t>* DeduplicateVMapTable(const std::vector<uint8_t>& code);
   std::vector<uint8_t>* DeduplicateGCMap(const std::vector<uint8_t>& code);
 
+  // Logs the hit rate of the deduplication sets and the time spent adding to them.
+  void DumpDedupeStats() const;
+
  private:
   // Compute constant code and method pointers when possible
   void GetCodeAndMethodForDirectCall(InvokeType type, InvokeType sharp_type,
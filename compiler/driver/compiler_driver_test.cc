@@ -23,6 +23,7 @@
 #include "class_linker.h"
 #include "common_test.h"
 #include "dex_file.h"
+#include "dex_instruction.h"
 #include "gc/heap.h"
 #include "mirror/art_method-inl.h"
 #include "mirror/class.h"
@@ -30,6 +31,17 @@
 #include "mirror/dex_cache-inl.h"
 #include "mirror/object_array-inl.h"
 #include "mirror/object-inl.h"
+#include "object_utils.h"
+#include "tiered_compiler.h"
+
+extern "C" void ArtCompileDEX(art::CompilerDriver& compiler,
+                              const art::DexFile::CodeItem* code_item,
+                              uint32_t access_flags, art::InvokeType invoke_type,
+                              uint16_t class_def_idx, uint32_t method_idx, jobject class_loader,
+                              const art::DexFile& dex_file,
+                              art::DexToDexCompilationLevel dex_to_dex_compilation_level);
+extern "C" bool ArtTieredCompileMethod(art::TieredCompiler* tiered, art::Thread* self,
+                                       art::mirror::ArtMethod* method, art::TieredCode* result);
 
 namespace art {
 
@@ -165,6 +177,179 @@ TEST_F(CompilerDriverTest, AbstractMethodErrorStub) {
   Thread::Current()->ClearException();
 }
 
+TEST_F(CompilerDriverTest, TieredCompileHotMethod) {
+  TEST_DISABLED_FOR_PORTABLE();
+  jobject class_loader;
+  {
+    ScopedObjectAccess soa(Thread::Current());
+    class_loader = LoadDex("HotLoop");
+  }
+  ASSERT_TRUE(class_loader != NULL);
+  // Nothing is compiled ahead of time, the methods start in the interpreter.
+  MakeAllExecutable(class_loader);
+  Thread::Current()->TransitionFromSuspendedToRunnable();
+  bool started = runtime_->Start();
+  CHECK(started);
+  TieredCompiler* tiered = new TieredCompiler(100, 1 * MB);
+  tiered->SetCompileFn(ArtTieredCompileMethod);
+  runtime_->SetTieredCompiler(tiered);
+  env_ = Thread::Current()->GetJniEnv();
+  class_ = env_->FindClass("HotLoop");
+  ASSERT_TRUE(class_ != NULL);
+  mid_ = env_->GetStaticMethodID(class_, "sum", "(I)I");
+  ASSERT_TRUE(mid_ != NULL);
+
+  // The loop makes the first call hot.
+  EXPECT_EQ(4950, env_->CallStaticIntMethod(class_, mid_, 100));
+  tiered->WaitForCompilations(Thread::Current());
+  // Daemon threads may have made other methods hot meanwhile.
+  EXPECT_LE(1U, tiered->GetCompiledCount());
+  {
+    ScopedObjectAccess soa(Thread::Current());
+    mirror::ArtMethod* method = soa.DecodeMethod(mid_);
+    EXPECT_TRUE(method->GetEntryPointFromCompiledCode() != GetCompiledCodeToInterpreterBridge());
+    EXPECT_TRUE(method->GetEntryPointFromInterpreter() == artInterpreterToCompiledCodeBridge);
+  }
+  EXPECT_EQ(4950, env_->CallStaticIntMethod(class_, mid_, 100));
+  EXPECT_EQ(0, env_->CallStaticIntMethod(class_, mid_, 0));
+}
+
+// Apps installed with interpret-only run DEX-to-DEX quickened code, which the Quick backend
+// cannot compile: hot quickened methods stay in the interpreter.
+TEST_F(CompilerDriverTest, TieredSkipsQuickenedMethod) {
+  TEST_DISABLED_FOR_PORTABLE();
+  jobject class_loader;
+  {
+    ScopedObjectAccess soa(Thread::Current());
+    class_loader = LoadDex("HotLoop");
+  }
+  ASSERT_TRUE(class_loader != NULL);
+  MakeAllExecutable(class_loader);
+  Thread::Current()->TransitionFromSuspendedToRunnable();
+  bool started = runtime_->Start();
+  CHECK(started);
+  TieredCompiler* tiered = new TieredCompiler(100, 1 * MB);
+  tiered->SetCompileFn(ArtTieredCompileMethod);
+  runtime_->SetTieredCompiler(tiered);
+  env_ = Thread::Current()->GetJniEnv();
+  class_ = env_->FindClass("HotLoop");
+  ASSERT_TRUE(class_ != NULL);
+  // Initializes the class, so that the fields resolve when quickening.
+  jobject receiver = env_->AllocObject(class_);
+  ASSERT_TRUE(receiver != NULL);
+  mid_ = env_->GetMethodID(class_, "add", "(I)V");
+  ASSERT_TRUE(mid_ != NULL);
+  jfieldID fid = env_->GetFieldID(class_, "total", "I");
+  ASSERT_TRUE(fid != NULL);
+
+  {
+    ScopedObjectAccess soa(Thread::Current());
+    mirror::ArtMethod* method = soa.DecodeMethod(mid_);
+    MethodHelper mh(method);
+    const DexFile& dex_file = mh.GetDexFile();
+    const DexFile::CodeItem* code_item = mh.GetCodeItem();
+    ASSERT_TRUE(dex_file.EnableWrite());
+    ArtCompileDEX(*compiler_driver_, code_item, method->GetAccessFlags(),
+                  method->GetInvokeType(), mh.GetClassDefIndex(), method->GetDexMethodIndex(),
+                  class_loader, dex_file, kOptimize);
+    ASSERT_TRUE(dex_file.DisableWrite());
+    bool quickened = false;
+    const Instruction* inst = Instruction::At(code_item->insns_);
+    const Instruction* end =
+        Instruction::At(code_item->insns_ + code_item->insns_size_in_code_units_);
+    for (; inst < end; inst = inst->Next()) {
+      quickened |= (inst->Opcode() == Instruction::IGET_QUICK);
+    }
+    ASSERT_TRUE(quickened);
+  }
+
+  // The loop makes the first call hot.
+  env_->CallVoidMethod(receiver, mid_, 100);
+  tiered->WaitForCompilations(Thread::Current());
+  EXPECT_LE(1U, tiered->GetFailedCount());
+  {
+    ScopedObjectAccess soa(Thread::Current());
+    mirror::ArtMethod* method = soa.DecodeMethod(mid_);
+    EXPECT_TRUE(method->GetEntryPointFromCompiledCode() == GetCompiledCodeToInterpreterBridge());
+  }
+  env_->CallVoidMethod(receiver, mid_, 100);
+  EXPECT_EQ(9900, env_->GetIntField(receiver, fid));
+}
+
+TEST_F(CompilerDriverTest, GlobalValueNumberingAndLoopInvariants) {
+  TEST_DISABLED_FOR_PORTABLE();
+  jobject class_loader;
+  {
+    ScopedObjectAccess soa(Thread::Current());
+    class_loader = LoadDex("LoopInvariants");
+  }
+  ASSERT_TRUE(class_loader != NULL);
+  runtime_->SetGvnLicmMode(true);
+  EnsureCompiled(class_loader, "LoopInvariants", "sumArray", "([I)I", false);
+  runtime_->SetGvnLicmMode(false);
+
+  jint values[] = { 1, 2, 3, 4, 5 };
+  jintArray array = env_->NewIntArray(5);
+  env_->SetIntArrayRegion(array, 0, 5, values);
+  jintArray zeros = env_->NewIntArray(10);
+  jclass npe = env_->FindClass("java/lang/NullPointerException");
+  jclass aioobe = env_->FindClass("java/lang/ArrayIndexOutOfBoundsException");
+  jmethodID constructor = env_->GetMethodID(class_, "<init>", "(II)V");
+
+  EXPECT_EQ(15, env_->CallStaticIntMethod(class_, mid_, array));
+
+  // Field loads leave the loop only when nothing in it may store to the field.
+  jmethodID field_bound = env_->GetMethodID(class_, "fieldBound", "()I");
+  jmethodID field_written = env_->GetMethodID(class_, "fieldWritten", "()I");
+  jmethodID call_in_loop = env_->GetMethodID(class_, "callInLoop", "()I");
+  EXPECT_EQ(66, env_->CallIntMethod(env_->NewObject(class_, constructor, 4, 3), field_bound));
+  EXPECT_EQ(22, env_->CallIntMethod(env_->NewObject(class_, constructor, 4, 3), field_written));
+  EXPECT_EQ(22, env_->CallIntMethod(env_->NewObject(class_, constructor, 4, 3), call_in_loop));
+
+  jmethodID arithmetic = env_->GetStaticMethodID(class_, "invariantArithmetic", "(III)I");
+  EXPECT_EQ(86, env_->CallStaticIntMethod(class_, arithmetic, 3, 5, 4));
+
+  // Checks inside the loop still throw where the code says.
+  jmethodID length_in_loop = env_->GetStaticMethodID(class_, "lengthInLoop", "([II)I");
+  EXPECT_EQ(0, env_->CallStaticIntMethod(class_, length_in_loop, NULL, 0));
+  EXPECT_EQ(15, env_->CallStaticIntMethod(class_, length_in_loop, array, 3));
+  env_->CallStaticIntMethod(class_, length_in_loop, NULL, 3);
+  ASSERT_EQ(JNI_TRUE, env_->ExceptionCheck());
+  jthrowable exception = env_->ExceptionOccurred();
+  env_->ExceptionClear();
+  EXPECT_TRUE(env_->IsInstanceOf(exception, npe));
+
+  jmethodID count_then_throw = env_->GetStaticMethodID(class_, "countThenThrow", "([II)I");
+  EXPECT_EQ(-3, env_->CallStaticIntMethod(class_, count_then_throw, NULL, 5));
+  EXPECT_EQ(2, env_->CallStaticIntMethod(class_, count_then_throw, NULL, 2));
+  EXPECT_EQ(35, env_->CallStaticIntMethod(class_, count_then_throw, zeros, 5));
+
+  jmethodID index_in_loop = env_->GetStaticMethodID(class_, "indexInLoop", "([II)I");
+  EXPECT_EQ(15, env_->CallStaticIntMethod(class_, index_in_loop, array, 5));
+  env_->CallStaticIntMethod(class_, index_in_loop, array, 6);
+  ASSERT_EQ(JNI_TRUE, env_->ExceptionCheck());
+  exception = env_->ExceptionOccurred();
+  env_->ExceptionClear();
+  EXPECT_TRUE(env_->IsInstanceOf(exception, aioobe));
+
+  // Memory is not assumed unchanged across stores, joins or possible aliases.
+  jmethodID read_write = env_->GetStaticMethodID(class_, "readWriteElement", "([IIZ)I");
+  EXPECT_EQ(5, env_->CallStaticIntMethod(class_, read_write, array, 1, JNI_TRUE));
+  EXPECT_EQ(6, env_->CallStaticIntMethod(class_, read_write, array, 1, JNI_FALSE));
+  jmethodID aliased_index = env_->GetStaticMethodID(class_, "aliasedIndex",
+      "(LLoopInvariants;LLoopInvariants;[I)I");
+  jobject p = env_->NewObject(class_, constructor, 0, 0);
+  jobject q = env_->NewObject(class_, constructor, 0, 0);
+  EXPECT_EQ(2, env_->CallStaticIntMethod(class_, aliased_index, p, q, array));
+  jobject r = env_->NewObject(class_, constructor, 4, 0);
+  env_->CallStaticIntMethod(class_, aliased_index, r, r, array);
+  ASSERT_EQ(JNI_TRUE, env_->ExceptionCheck());
+  exception = env_->ExceptionOccurred();
+  env_->ExceptionClear();
+  EXPECT_TRUE(env_->IsInstanceOf(exception, aioobe));
+  Thread::Current()->ClearException();
+}
+
 // TODO: need check-cast test (when stub complete & we can throw/catch
 
 }  // namespace art
@@ -17,63 +17,163 @@
 #ifndef ART_COMPILER_UTILS_DEDUPE_SET_H_
 #define ART_COMPILER_UTILS_DEDUPE_SET_H_
 
-#include <set>
+#include <vector>
 
 #include "base/mutex.h"
-#include "base/stl_util.h"
+#include "utils.h"
 
 namespace art {
 
 // A simple data structure to handle hashed deduplication. Add is thread safe.
+// The keys are spread over kShardsCount shards by their hash, each an open
+// addressing table with linear probing behind its own lock, so threads adding
+// unrelated keys do not serialize. Keys of equal hash are told apart with
+// operator==.
 template <typename Key, typename HashType, typename HashFunc>
 class DedupeSet {
   typedef std::pair<HashType, Key*> HashedKey;
 
-  class Comparator {
+  static const size_t kShardsBits = 4;
+  static const size_t kShardsCount = 1 << kShardsBits;
+  static const size_t kMinCapacity = 64;
+
+  class Shard {
    public:
-    bool operator()(const HashedKey& a, const HashedKey& b) const {
-      if (a.first < b.first) return true;
-      if (a.first > b.first) return true;
-      return *a.second < *b.second;
+    Shard() : lock_("dedupe lock"), size_(0), hits_(0), add_time_ns_(0) {
+    }
+
+    ~Shard() {
+      for (size_t i = 0; i < slots_.size(); ++i) {
+        delete slots_[i].second;
+      }
     }
-  };
 
-  typedef std::set<HashedKey, Comparator> Keys;
+    Key* Add(Thread* self, const Key& key, HashType hash, uint64_t start_ns) {
+      MutexLock lock(self, lock_);
+      if ((size_ + 1) * 4 > slots_.size() * 3) {
+        Resize(slots_.empty() ? kMinCapacity : slots_.size() * 2);
+      }
+      const size_t mask = slots_.size() - 1;
+      size_t i = SlotOf(hash, mask);
+      Key* result = NULL;
+      for (; slots_[i].second != NULL; i = (i + 1) & mask) {
+        if (slots_[i].first == hash && *slots_[i].second == key) {
+          result = slots_[i].second;
+          ++hits_;
+          break;
+        }
+      }
+      if (result == NULL) {
+        result = new Key(key);
+        slots_[i] = HashedKey(hash, result);
+        ++size_;
+      }
+      add_time_ns_ += NanoTime() - start_ns;
+      return result;
+    }
 
- public:
-  typedef typename Keys::iterator iterator;
-  typedef typename Keys::const_iterator const_iterator;
-  typedef typename Keys::size_type size_type;
-  typedef typename Keys::value_type value_type;
+    void Remove(Thread* self, const Key* key, HashType hash) {
+      MutexLock lock(self, lock_);
+      const size_t mask = slots_.size() - 1;
+      size_t i = SlotOf(hash, mask);
+      while (slots_[i].second != key) {
+        CHECK(slots_[i].second != NULL);
+        i = (i + 1) & mask;
+      }
+      delete slots_[i].second;
+      slots_[i] = HashedKey(0, NULL);
+      --size_;
+      // Moves back the keys of the probe run that would no longer be reachable
+      // across the emptied slot.
+      for (size_t j = (i + 1) & mask; slots_[j].second != NULL; j = (j + 1) & mask) {
+        size_t home = SlotOf(slots_[j].first, mask);
+        bool reachable = (i <= j) ? (i < home && home <= j) : (i < home || home <= j);
+        if (!reachable) {
+          slots_[i] = slots_[j];
+          slots_[j] = HashedKey(0, NULL);
+          i = j;
+        }
+      }
+    }
+
+    Mutex lock_ DEFAULT_MUTEX_ACQUIRED_AFTER;
+    std::vector<HashedKey> slots_ GUARDED_BY(lock_);
+    // Distinct keys, Add calls that found their key, and time spent in Add.
+    size_t size_ GUARDED_BY(lock_);
+    size_t hits_ GUARDED_BY(lock_);
+    uint64_t add_time_ns_ GUARDED_BY(lock_);
+
+   private:
+    void Resize(size_t capacity) {
+      std::vector<HashedKey> old_slots(capacity, HashedKey(0, NULL));
+      old_slots.swap(slots_);
+      const size_t mask = capacity - 1;
+      for (size_t j = 0; j < old_slots.size(); ++j) {
+        if (old_slots[j].second == NULL) {
+          continue;
+        }
+        size_t i = SlotOf(old_slots[j].first, mask);
+        while (slots_[i].second != NULL) {
+          i = (i + 1) & mask;
+        }
+        slots_[i] = old_slots[j];
+      }
+    }
+
+    DISALLOW_COPY_AND_ASSIGN(Shard);
+  };
+
+  // The hash functions of the compiler are cheap; spread their bits before
+  // picking the shard from the high ones and the slot from the low ones.
+  static uint32_t Mix(HashType hash) {
+    uint32_t mixed = static_cast<uint32_t>(hash) * 0x9E3779B1U;
+    return mixed ^ (mixed >> 16);
+  }
 
-  iterator begin() { return keys_.begin(); }
-  const_iterator begin() const { return keys_.begin(); }
-  iterator end() { return keys_.end(); }
-  const_iterator end() const { return keys_.end(); }
+  static size_t SlotOf(HashType hash, size_t mask) {
+    return Mix(hash) & mask;
+  }
 
+ public:
   Key* Add(Thread* self, const Key& key) {
+    uint64_t start_ns = NanoTime();
     HashType hash = HashFunc()(key);
-    HashedKey hashed_key(hash, const_cast<Key*>(&key));
-    MutexLock lock(self, lock_);
-    auto it = keys_.find(hashed_key);
-    if (it != keys_.end()) {
-      return it->second;
+    return shards_[Mix(hash) >> (32 - kShardsBits)]->Add(self, key, hash, start_ns);
+  }
+
+  // Frees key, as returned by Add. The caller must know that no one else holds it.
+  void Remove(Thread* self, const Key* key) {
+    HashType hash = HashFunc()(*key);
+    shards_[Mix(hash) >> (32 - kShardsBits)]->Remove(self, key, hash);
+  }
+
+  // Statistics over all the Add calls.
+  void GetStats(Thread* self, size_t* size, size_t* hits, uint64_t* add_time_ns) const {
+    *size = 0;
+    *hits = 0;
+    *add_time_ns = 0;
+    for (size_t i = 0; i < kShardsCount; ++i) {
+      MutexLock lock(self, shards_[i]->lock_);
+      *size += shards_[i]->size_;
+      *hits += shards_[i]->hits_;
+      *add_time_ns += shards_[i]->add_time_ns_;
     }
-    hashed_key.second = new Key(key);
-    keys_.insert(hashed_key);
-    return hashed_key.second;
   }
 
-  DedupeSet() : lock_("dedupe lock") {
+  DedupeSet() {
+    for (size_t i = 0; i < kShardsCount; ++i) {
+      shards_[i] = new Shard();
+    }
   }
 
   ~DedupeSet() {
-    STLDeleteValues(&keys_);
+    for (size_t i = 0; i < kShardsCount; ++i) {
+      delete shards_[i];
+    }
   }
 
  private:
-  Mutex lock_ DEFAULT_MUTEX_ACQUIRED_AFTER;
-  Keys keys_;
+  Shard* shards_[kShardsCount];
   DISALLOW_COPY_AND_ASSIGN(DedupeSet);
 };
 
@@ -75,4 +75,59 @@ TEST_F(DedupeSetTest, Test) {
   }
 }
 
+class CollidingHashFunc {
+ public:
+  size_t operator()(const std::vector<uint8_t>& array) const {
+    return array.size();
+  }
+};
+
+TEST_F(DedupeSetTest, EqualHashes) {
+  Thread* self = Thread::Current();
+  typedef std::vector<uint8_t> ByteArray;
+  DedupeSet<ByteArray, size_t, CollidingHashFunc> deduplicator;
+  // All the arrays have the same hash, only equality tells them apart.
+  std::vector<ByteArray*> added;
+  for (size_t i = 0; i < 256; ++i) {
+    ByteArray test1(4, 0);
+    test1[i % 4] = i;
+    added.push_back(deduplicator.Add(self, test1));
+    ASSERT_EQ(test1, *added.back());
+  }
+  for (size_t i = 0; i < 256; ++i) {
+    ByteArray test1(4, 0);
+    test1[i % 4] = i;
+    ASSERT_EQ(added[i], deduplicator.Add(self, test1));
+  }
+  size_t size;
+  size_t hits;
+  uint64_t add_time_ns;
+  deduplicator.GetStats(self, &size, &hits, &add_time_ns);
+  EXPECT_EQ(256U, size);
+  EXPECT_EQ(256U, hits);
+}
+
+TEST_F(DedupeSetTest, Remove) {
+  Thread* self = Thread::Current();
+  typedef std::vector<uint8_t> ByteArray;
+  DedupeSet<ByteArray, size_t, CollidingHashFunc> deduplicator;
+  // One long probe run: removing from its middle must keep the rest reachable.
+  std::vector<ByteArray*> added;
+  for (size_t i = 0; i < 128; ++i) {
+    added.push_back(deduplicator.Add(self, ByteArray(4, i)));
+  }
+  for (size_t i = 0; i < 128; i += 2) {
+    deduplicator.Remove(self, added[i]);
+  }
+  for (size_t i = 1; i < 128; i += 2) {
+    ASSERT_EQ(added[i], deduplicator.Add(self, ByteArray(4, i)));
+  }
+  size_t size;
+  size_t hits;
+  uint64_t add_time_ns;
+  deduplicator.GetStats(self, &size, &hits, &add_time_ns);
+  EXPECT_EQ(64U, size);
+  EXPECT_EQ(64U, hits);
+}
+
 }  // namespace art
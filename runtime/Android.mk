@@ -33,6 +33,7 @@ LIBART_COMMON_SRC_FILES := \
 	base/unix_file/string_file.cc \
 	check_jni.cc \
 	class_linker.cc \
+	class_table.cc \
 	common_throws.cc \
 	debugger.cc \
 	dex_file.cc \
@@ -44,6 +45,7 @@ LIBART_COMMON_SRC_FILES := \
 	disassembler_x86.cc \
 	elf_file.cc \
 	gc/allocator/dlmalloc.cc \
+	gc/accounting/bitmap_kernels.cc \
 	gc/accounting/card_table.cc \
 	gc/accounting/gc_allocator.cc \
 	gc/accounting/heap_bitmap.cc \
@@ -56,6 +58,7 @@ LIBART_COMMON_SRC_FILES := \
 	gc/collector/compactor.cc \
 	gc/heap.cc \
 	gc/space/dlmalloc_space.cc \
+	gc/space/slab_allocator.cc \
 	gc/space/image_space.cc \
 	gc/space/large_object_space.cc \
 	gc/space/space.cc \
@@ -67,6 +70,7 @@ LIBART_COMMON_SRC_FILES := \
 	indirect_reference_table.cc \
 	instrumentation.cc \
 	intern_table.cc \
+	interpreter/inline_cache.cc \
 	interpreter/interpreter.cc \
 	jdwp/jdwp_event.cc \
 	jdwp/jdwp_expand_buf.cc \
@@ -127,6 +131,7 @@ LIBART_COMMON_SRC_FILES := \
 	thread_list.cc \
 	thread_pool.cc \
 	throw_location.cc \
+	tiered_compiler.cc \
 	trace.cc \
 	utf.cc \
 	utils.cc \
@@ -146,6 +151,8 @@ LIBART_COMMON_SRC_FILES += \
 	gc/service/base_bitmap.cc \
 	gc/accounting/card_base_table.cc \
 	gc/service/gcservice_daemon.cc \
+	gc/service/host_ipc.cc \
+	gc/service/proc_sampler.cc \
 	gc/service/service_client.cc \
 	gc/collector/ipc_server_sweep.cc \
 	gc/collector/ipc_mark_sweep.cc \
@@ -271,6 +278,9 @@ LIBART_CFLAGS :=
 ifeq ($(ART_USE_PORTABLE_COMPILER),true)
   LIBART_CFLAGS += -DART_USE_PORTABLE_COMPILER=1
 endif
+ifeq ($(ART_USE_COMPUTED_GOTO_INTERPRETER),true)
+  LIBART_CFLAGS += -DART_USE_COMPUTED_GOTO_INTERPRETER=1
+endif
 
 # $(1): target or host
 # $(2): ndebug or debug
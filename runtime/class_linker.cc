@@ -1120,9 +1120,7 @@ void ClassLinker::VisitRoots(RootVisitor* visitor, void* arg, bool only_dirty, b
   {
     ReaderMutexLock mu(self, *Locks::classlinker_classes_lock_);
     if (!only_dirty || class_table_dirty_) {
-      for (const std::pair<size_t, mirror::Class*>& it : class_table_) {
-        visitor(it.second, arg);
-      }
+      class_table_.VisitRoots(visitor, arg);
       if (clean_dirty) {
         class_table_dirty_ = false;
       }
@@ -1140,11 +1138,7 @@ void ClassLinker::VisitClasses(ClassVisitor* visitor, void* arg) {
     MoveImageClassesToClassTable();
   }
   ReaderMutexLock mu(Thread::Current(), *Locks::classlinker_classes_lock_);
-  for (const std::pair<size_t, mirror::Class*>& it : class_table_) {
-    if (!visitor(it.second, arg)) {
-      return;
-    }
-  }
+  class_table_.VisitClasses(visitor, arg);
 }
 
 static bool GetClassesVisitor(mirror::Class* c, void* arg) {
@@ -1153,6 +1147,11 @@ static bool GetClassesVisitor(mirror::Class* c, void* arg) {
   return true;
 }
 
+static bool AppendClassVisitor(mirror::Class* c, void* arg) {
+  reinterpret_cast<std::vector<mirror::Class*>*>(arg)->push_back(c);
+  return true;
+}
+
 void ClassLinker::VisitClassesWithoutClassesLock(ClassVisitor* visitor, void* arg) {
   std::set<mirror::Class*> classes;
   VisitClasses(GetClassesVisitor, &classes);
@@ -2225,7 +2224,7 @@ mirror::Class* ClassLinker::InsertClass(const char* descriptor, mirror::Class* k
     }
   }
   Runtime::Current()->GetHeap()->VerifyObject(klass);
-  class_table_.insert(std::make_pair(hash, klass));
+  class_table_.Insert(klass, hash);
   class_table_dirty_ = true;
   return NULL;
 }
@@ -2233,34 +2232,22 @@ mirror::Class* ClassLinker::InsertClass(const char* descriptor, mirror::Class* k
 bool ClassLinker::RemoveClass(const char* descriptor, const mirror::ClassLoader* class_loader) {
   size_t hash = Hash(descriptor);
   WriterMutexLock mu(Thread::Current(), *Locks::classlinker_classes_lock_);
-  ClassHelper kh;
-  for (auto it = class_table_.lower_bound(hash), end = class_table_.end(); it != end && it->first == hash;
-       ++it) {
-    mirror::Class* klass = it->second;
-    kh.ChangeClass(klass);
-    if (strcmp(kh.GetDescriptor(), descriptor) == 0 && klass->GetClassLoader() == class_loader) {
-      class_table_.erase(it);
-      return true;
-    }
-  }
-  return false;
+  return class_table_.Remove(descriptor, class_loader, hash);
 }
 
 mirror::Class* ClassLinker::LookupClass(const char* descriptor,
                                         const mirror::ClassLoader* class_loader) {
   size_t hash = Hash(descriptor);
-  {
-    ReaderMutexLock mu(Thread::Current(), *Locks::classlinker_classes_lock_);
-    mirror::Class* result = LookupClassFromTableLocked(descriptor, class_loader, hash);
-    if (result != NULL) {
-      return result;
-    }
+  // Lock free, see ClassTable.
+  mirror::Class* result = class_table_.Lookup(descriptor, class_loader, hash);
+  if (result != NULL) {
+    return result;
   }
   if (class_loader != NULL || !dex_cache_image_class_lookup_required_) {
     return NULL;
   } else {
     // Lookup failed but need to search dex_caches_.
-    mirror::Class* result = LookupClassFromImage(descriptor);
+    result = LookupClassFromImage(descriptor);
     if (result != NULL) {
       InsertClass(descriptor, result, hash);
     } else {
@@ -2279,26 +2266,18 @@ mirror::Class* ClassLinker::LookupClass(const char* descriptor,
 mirror::Class* ClassLinker::LookupClassFromTableLocked(const char* descriptor,
                                                        const mirror::ClassLoader* class_loader,
                                                        size_t hash) {
-  ClassHelper kh(NULL, this);
-  auto end = class_table_.end();
-  for (auto it = class_table_.lower_bound(hash); it != end && it->first == hash; ++it) {
-    mirror::Class* klass = it->second;
-    kh.ChangeClass(klass);
-    if (klass->GetClassLoader() == class_loader && strcmp(descriptor, kh.GetDescriptor()) == 0) {
-      if (kIsDebugBuild) {
-        // Check for duplicates in the table.
-        for (++it; it != end && it->first == hash; ++it) {
-          mirror::Class* klass2 = it->second;
-          kh.ChangeClass(klass2);
-          CHECK(!(strcmp(descriptor, kh.GetDescriptor()) == 0 && klass2->GetClassLoader() == class_loader))
+  mirror::Class* klass = class_table_.Lookup(descriptor, class_loader, hash);
+  if (kIsDebugBuild && klass != NULL) {
+    // Check for duplicates in the table.
+    std::vector<mirror::Class*> classes;
+    class_table_.LookupClasses(descriptor, hash, classes);
+    for (mirror::Class* klass2 : classes) {
+      CHECK(klass2 == klass || klass2->GetClassLoader() != class_loader)
           << PrettyClass(klass) << " " << klass << " " << klass->GetClassLoader() << " "
           << PrettyClass(klass2) << " " << klass2 << " " << klass2->GetClassLoader();
-        }
-      }
-      return klass;
     }
   }
-  return NULL;
+  return klass;
 }
 
 static mirror::ObjectArray<mirror::DexCache>* GetImageDexCaches()
@@ -2346,7 +2325,7 @@ void ClassLinker::MoveImageClassesToClassTable() {
           CHECK(existing == klass) << PrettyClassAndClassLoader(existing) << " != "
               << PrettyClassAndClassLoader(klass);
         } else {
-          class_table_.insert(std::make_pair(hash, klass));
+          class_table_.Insert(klass, hash);
         }
       }
     }
@@ -2405,15 +2384,7 @@ void ClassLinker::LookupClasses(const char* descriptor, std::vector<mirror::Clas
   }
   size_t hash = Hash(descriptor);
   ReaderMutexLock mu(Thread::Current(), *Locks::classlinker_classes_lock_);
-  ClassHelper kh(NULL, this);
-  for (auto it = class_table_.lower_bound(hash), end = class_table_.end();
-      it != end && it->first == hash; ++it) {
-    mirror::Class* klass = it->second;
-    kh.ChangeClass(klass);
-    if (strcmp(descriptor, kh.GetDescriptor()) == 0) {
-      result.push_back(klass);
-    }
-  }
+  class_table_.LookupClasses(descriptor, hash, result);
 }
 
 void ClassLinker::VerifyClass(mirror::Class* klass) {
@@ -4254,9 +4225,7 @@ void ClassLinker::DumpAllClasses(int flags) {
   std::vector<mirror::Class*> all_classes;
   {
     ReaderMutexLock mu(Thread::Current(), *Locks::classlinker_classes_lock_);
-    for (const std::pair<size_t, mirror::Class*>& it : class_table_) {
-      all_classes.push_back(it.second);
-    }
+    class_table_.VisitClasses(AppendClassVisitor, &all_classes);
   }
 
   for (size_t i = 0; i < all_classes.size(); ++i) {
@@ -4267,9 +4236,7 @@ void ClassLinker::DumpAllClasses(int flags) {
 void ClassLinker::GCPGetAllClasses(
 		std::vector<mirror::Class*>& allKlasses){
   ReaderMutexLock mu(Thread::Current(), *Locks::classlinker_classes_lock_);
-  for (const std::pair<size_t, mirror::Class*>& it : class_table_) {
-  	allKlasses.push_back(it.second);
-  }
+  class_table_.VisitClasses(AppendClassVisitor, &allKlasses);
 }
 
 void ClassLinker::GCPDumpAllClasses(int flags, std::ostream& os) {
@@ -4281,9 +4248,7 @@ void ClassLinker::GCPDumpAllClasses(int flags, std::ostream& os) {
   std::vector<mirror::Class*> all_classes;
   {
     ReaderMutexLock mu(Thread::Current(), *Locks::classlinker_classes_lock_);
-    for (const std::pair<size_t, mirror::Class*>& it : class_table_) {
-      all_classes.push_back(it.second);
-    }
+    class_table_.VisitClasses(AppendClassVisitor, &all_classes);
   }
 
   for (size_t i = 0; i < all_classes.size(); ++i) {
@@ -4296,7 +4261,7 @@ void ClassLinker::DumpForSigQuit(std::ostream& os) {
     MoveImageClassesToClassTable();
   }
   ReaderMutexLock mu(Thread::Current(), *Locks::classlinker_classes_lock_);
-  os << "Loaded classes: " << class_table_.size() << " allocated classes\n";
+  os << "Loaded classes: " << class_table_.Size() << " allocated classes\n";
 }
 
 size_t ClassLinker::NumLoadedClasses() {
@@ -4304,7 +4269,7 @@ size_t ClassLinker::NumLoadedClasses() {
     MoveImageClassesToClassTable();
   }
   ReaderMutexLock mu(Thread::Current(), *Locks::classlinker_classes_lock_);
-  return class_table_.size();
+  return class_table_.Size();
 }
 
 pid_t ClassLinker::GetClassesLockOwner() {
@@ -23,6 +23,7 @@
 
 #include "base/macros.h"
 #include "base/mutex.h"
+#include "class_table.h"
 #include "dex_file.h"
 #include "gtest/gtest.h"
 #include "root_visitor.h"
@@ -538,11 +539,10 @@ class ClassLinker {
   std::vector<const OatFile*> oat_files_ GUARDED_BY(dex_lock_);
 
 
-  // multimap from a string hash code of a class descriptor to
-  // mirror::Class* instances. Results should be compared for a matching
-  // Class::descriptor_ and Class::class_loader_.
-  typedef std::multimap<size_t, mirror::Class*> Table;
-  Table class_table_ GUARDED_BY(Locks::classlinker_classes_lock_);
+  // Table from a string hash code of a class descriptor to mirror::Class*
+  // instances. Modified with the classlinker_classes_lock_ held exclusively,
+  // LookupClass reads it without the lock.
+  ClassTable class_table_;
 
   // Do we need to search dex caches to find image classes?
   bool dex_cache_image_class_lookup_required_;
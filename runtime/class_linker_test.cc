@@ -16,9 +16,11 @@
 
 #include "class_linker.h"
 
+#include <numeric>
 #include <string>
 
 #include "UniquePtr.h"
+#include "atomic_integer.h"
 #include "class_linker-inl.h"
 #include "common_test.h"
 #include "dex_file.h"
@@ -34,6 +36,7 @@
 #include "mirror/proxy.h"
 #include "mirror/stack_trace_element.h"
 #include "sirt_ref.h"
+#include "thread_pool.h"
 
 namespace art {
 
@@ -1056,4 +1059,235 @@ TEST_F(ClassLinkerTest, ClassRootDescriptors) {
   }
 }
 
+class LookupClassesTask : public Task {
+ public:
+  LookupClassesTask(ClassLinker* class_linker, const std::vector<std::string>* descriptors,
+                    const std::vector<mirror::Class*>* classes, size_t* mismatches)
+      : class_linker_(class_linker), descriptors_(descriptors), classes_(classes),
+        mismatches_(mismatches) {}
+
+  void Run(Thread* self) {
+    ScopedObjectAccess soa(self);
+    for (size_t i = 0; i < descriptors_->size(); ++i) {
+      if (class_linker_->LookupClass((*descriptors_)[i].c_str(), NULL) != (*classes_)[i]) {
+        ++*mismatches_;
+      }
+    }
+  }
+
+  void Finalize() {
+    delete this;
+  }
+
+ private:
+  ClassLinker* const class_linker_;
+  const std::vector<std::string>* const descriptors_;
+  const std::vector<mirror::Class*>* const classes_;
+  size_t* const mismatches_;
+};
+
+// Loads the classes of the boot class path dex files, then reports the time of
+// the class table lookups from one and from several threads.
+TEST_F(ClassLinkerTest, LookupClassBenchmark) {
+  Thread* self = Thread::Current();
+  std::vector<std::string> descriptors;
+  std::vector<mirror::Class*> classes;
+  uint64_t start = NanoTime();
+  {
+    ScopedObjectAccess soa(self);
+    for (const DexFile* dex_file : boot_class_path_) {
+      for (size_t i = 0; i < dex_file->NumClassDefs(); ++i) {
+        const char* descriptor = dex_file->GetClassDescriptor(dex_file->GetClassDef(i));
+        mirror::Class* klass = class_linker_->FindSystemClass(descriptor);
+        if (klass == NULL) {
+          soa.Self()->ClearException();
+          continue;
+        }
+        descriptors.push_back(descriptor);
+        classes.push_back(klass);
+      }
+    }
+  }
+  uint64_t load_ns = NanoTime() - start;
+  ASSERT_FALSE(classes.empty());
+  static const size_t kRounds = 10;
+  static const size_t kThreadsCount[] = { 1, 4 };
+  for (size_t t = 0; t < arraysize(kThreadsCount); ++t) {
+    const size_t threads = kThreadsCount[t];
+    std::vector<size_t> mismatches(threads, 0);
+    ThreadPool thread_pool(threads - 1);
+    for (size_t r = 0; r < kRounds; ++r) {
+      for (size_t i = 0; i < threads; ++i) {
+        thread_pool.AddTask(self, new LookupClassesTask(class_linker_, &descriptors, &classes,
+                                                        &mismatches[i]));
+      }
+    }
+    start = NanoTime();
+    thread_pool.StartWorkers(self);
+    thread_pool.Wait(self, true, false);
+    uint64_t lookup_ns = NanoTime() - start;
+    LOG(INFO) << "Loaded " << classes.size() << " classes in " << PrettyDuration(load_ns)
+              << ", " << kRounds * threads * classes.size() << " lookups from " << threads
+              << " threads in " << PrettyDuration(lookup_ns);
+    for (size_t i = 0; i < threads; ++i) {
+      EXPECT_EQ(0U, mismatches[i]);
+    }
+  }
+}
+
+// Looks the class roots up until the inserter is done; they are in the table
+// all along, so every lookup must find them.
+class LookupClassRootsTask : public Task {
+ public:
+  LookupClassRootsTask(ClassLinker* class_linker, const AtomicInteger* done, size_t* lookups,
+                       size_t* misses)
+      : class_linker_(class_linker), done_(done), lookups_(lookups), misses_(misses) {}
+
+  void Run(Thread* self) {
+    ClassHelper kh;
+    while (done_->load() == 0) {
+      // A round at a time, so that the inserter can suspend the readers for a GC.
+      ScopedObjectAccess soa(self);
+      for (int i = 0; i < ClassLinker::kClassRootsMax; i++) {
+        mirror::Class* root = class_linker_->GetClassRoot(ClassLinker::ClassRoot(i));
+        kh.ChangeClass(root);
+        if (class_linker_->LookupClass(kh.GetDescriptor(), NULL) != root) {
+          ++*misses_;
+        }
+        ++*lookups_;
+      }
+    }
+  }
+
+  void Finalize() {
+    delete this;
+  }
+
+ private:
+  ClassLinker* const class_linker_;
+  const AtomicInteger* const done_;
+  size_t* const lookups_;
+  size_t* const misses_;
+};
+
+// Loads the boot class path, growing the class table several times.
+class InsertClassesTask : public Task {
+ public:
+  InsertClassesTask(ClassLinker* class_linker, const std::vector<const DexFile*>* dex_files,
+                    AtomicInteger* done)
+      : class_linker_(class_linker), dex_files_(dex_files), done_(done) {}
+
+  void Run(Thread* self) {
+    for (const DexFile* dex_file : *dex_files_) {
+      for (size_t i = 0; i < dex_file->NumClassDefs(); ++i) {
+        ScopedObjectAccess soa(self);
+        const char* descriptor = dex_file->GetClassDescriptor(dex_file->GetClassDef(i));
+        if (class_linker_->FindSystemClass(descriptor) == NULL) {
+          soa.Self()->ClearException();
+        }
+      }
+    }
+    done_->store(1);
+  }
+
+  void Finalize() {
+    delete this;
+  }
+
+ private:
+  ClassLinker* const class_linker_;
+  const std::vector<const DexFile*>* const dex_files_;
+  AtomicInteger* const done_;
+};
+
+// Lock free lookups racing with insertions and resizes of the class table.
+TEST_F(ClassLinkerTest, LookupClassWhileInserting) {
+  Thread* self = Thread::Current();
+  static const size_t kReaders = 3;
+  const size_t classes_before = class_linker_->NumLoadedClasses();
+  AtomicInteger done(0);
+  std::vector<size_t> lookups(kReaders, 0);
+  std::vector<size_t> misses(kReaders, 0);
+  // The calling thread runs one of the tasks.
+  ThreadPool thread_pool(kReaders);
+  thread_pool.AddTask(self, new InsertClassesTask(class_linker_, &boot_class_path_, &done));
+  for (size_t i = 0; i < kReaders; ++i) {
+    thread_pool.AddTask(self, new LookupClassRootsTask(class_linker_, &done, &lookups[i],
+                                                       &misses[i]));
+  }
+  thread_pool.StartWorkers(self);
+  thread_pool.Wait(self, true, false);
+  const size_t classes_after = class_linker_->NumLoadedClasses();
+  LOG(INFO) << "Inserted " << (classes_after - classes_before) << " classes after "
+            << classes_before << " during "
+            << std::accumulate(lookups.begin(), lookups.end(), 0U) << " lookups";
+  EXPECT_LT(classes_before, classes_after);
+  for (size_t i = 0; i < kReaders; ++i) {
+    EXPECT_EQ(0U, misses[i]);
+  }
+}
+
+// The class definition search of the dex files without the descriptor index:
+// binary searches of the string and the type, then a scan of the class defs.
+static const DexFile::ClassDef* ScanClassDef(const DexFile& dex_file, const char* descriptor) {
+  const DexFile::StringId* string_id = dex_file.FindStringId(descriptor);
+  if (string_id == NULL) {
+    return NULL;
+  }
+  const DexFile::TypeId* type_id = dex_file.FindTypeId(dex_file.GetIndexForStringId(*string_id));
+  if (type_id == NULL) {
+    return NULL;
+  }
+  uint16_t type_idx = dex_file.GetIndexForTypeId(*type_id);
+  for (size_t i = 0; i < dex_file.NumClassDefs(); ++i) {
+    if (dex_file.GetClassDef(i).class_idx_ == type_idx) {
+      return &dex_file.GetClassDef(i);
+    }
+  }
+  return NULL;
+}
+
+// Searches the boot class path for every class it defines, as FindSystemClass
+// does, and reports the time of the scans and of the descriptor index.
+TEST_F(ClassLinkerTest, FindClassDefBenchmark) {
+  std::vector<std::string> descriptors;
+  for (const DexFile* dex_file : boot_class_path_) {
+    for (size_t i = 0; i < dex_file->NumClassDefs(); ++i) {
+      descriptors.push_back(dex_file->GetClassDescriptor(dex_file->GetClassDef(i)));
+    }
+  }
+  descriptors.push_back("Lno/such/Class;");
+  uint64_t start = NanoTime();
+  std::vector<DexFile::ClassPathEntry> scanned;
+  for (const std::string& descriptor : descriptors) {
+    DexFile::ClassPathEntry entry(reinterpret_cast<const DexFile*>(NULL),
+                                  reinterpret_cast<const DexFile::ClassDef*>(NULL));
+    for (const DexFile* dex_file : boot_class_path_) {
+      const DexFile::ClassDef* class_def = ScanClassDef(*dex_file, descriptor.c_str());
+      if (class_def != NULL) {
+        entry = DexFile::ClassPathEntry(dex_file, class_def);
+        break;
+      }
+    }
+    scanned.push_back(entry);
+  }
+  uint64_t scan_ns = NanoTime() - start;
+  // The first pass includes building the indexes, if no test did it before.
+  uint64_t index_ns[2];
+  for (size_t pass = 0; pass < 2; ++pass) {
+    start = NanoTime();
+    for (size_t i = 0; i < descriptors.size(); ++i) {
+      DexFile::ClassPathEntry entry =
+          DexFile::FindInClassPath(descriptors[i].c_str(), boot_class_path_);
+      EXPECT_EQ(scanned[i].first, entry.first) << descriptors[i];
+      EXPECT_EQ(scanned[i].second, entry.second) << descriptors[i];
+    }
+    index_ns[pass] = NanoTime() - start;
+  }
+  LOG(INFO) << "Searched the boot class path for " << descriptors.size() << " classes: scan "
+            << PrettyDuration(scan_ns) << ", index " << PrettyDuration(index_ns[0])
+            << " (first pass) " << PrettyDuration(index_ns[1]) << " (second pass), saved "
+            << PrettyDuration(scan_ns > index_ns[0] ? scan_ns - index_ns[0] : 0);
+}
+
 }  // namespace art
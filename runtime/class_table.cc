@@ -0,0 +1,196 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+
+#include "class_table.h"
+#include "cutils/atomic-inline.h"
+#include "mirror/class-inl.h"
+#include "object_utils.h"
+#include "utils.h"
+
+namespace art {
+
+const size_t ClassTable::kMinCapacity;
+
+// Spreads the String.hashCode() style descriptor hashes over the slots.
+static inline size_t SlotOf(size_t hash, size_t mask) {
+  uint32_t mixed = static_cast<uint32_t>(hash) * 0x9E3779B1U;
+  return (mixed ^ (mixed >> 16)) & mask;
+}
+
+
+ClassTable::ClassTable() : slots_(AllocSlots(kMinCapacity)), size_(0), used_(0) {
+}
+
+
+ClassTable::~ClassTable() {
+  Slots* slots = slots_;
+  while (slots != NULL) {
+    Slots* retired = slots->retired_;
+    free(slots);
+    slots = retired;
+  }
+}
+
+
+ClassTable::Slots* ClassTable::AllocSlots(size_t capacity) {
+  DCHECK(IsPowerOfTwo(capacity));
+  Slots* slots = reinterpret_cast<Slots*>(calloc(1, sizeof(Slots) + capacity * sizeof(Slot)));
+  CHECK(slots != NULL) << "ClassTable: cannot allocate " << capacity << " slots";
+  slots->mask_ = capacity - 1;
+  return slots;
+}
+
+
+bool ClassTable::Matches(mirror::Class* klass, const char* descriptor,
+                         const mirror::ClassLoader* class_loader) {
+  if (klass->GetClassLoader() != class_loader) {
+    return false;
+  }
+  ClassHelper kh(klass);
+  return strcmp(descriptor, kh.GetDescriptor()) == 0;
+}
+
+
+mirror::Class* ClassTable::Lookup(const char* descriptor,
+                                  const mirror::ClassLoader* class_loader,
+                                  size_t hash) const {
+  const Slots* slots = slots_;
+  const size_t mask = slots->mask_;
+  for (size_t i = SlotOf(hash, mask); ; i = (i + 1) & mask) {
+    mirror::Class* klass = slots->slots_[i].klass_;
+    if (klass == NULL) {
+      return NULL;
+    }
+    // A stale hash only makes a concurrent insertion look like a miss.
+    if (klass != Tombstone() && slots->slots_[i].hash_ == hash &&
+        Matches(klass, descriptor, class_loader)) {
+      return klass;
+    }
+  }
+}
+
+
+void ClassTable::Insert(mirror::Class* klass, size_t hash) {
+  // Keep the load, tombstones included, under 3/4.
+  if ((used_ + 1) * 4 > (slots_->mask_ + 1) * 3) {
+    size_t capacity = std::max(slots_->mask_ + 1, kMinCapacity);
+    while ((size_ + 1) * 2 > capacity) {
+      capacity *= 2;
+    }
+    Resize(capacity);
+  }
+  Slots* slots = slots_;
+  const size_t mask = slots->mask_;
+  size_t i = SlotOf(hash, mask);
+  while (IsLive(slots->slots_[i].klass_)) {
+    i = (i + 1) & mask;
+  }
+  if (slots->slots_[i].klass_ == NULL) {
+    used_++;
+  }
+  slots->slots_[i].hash_ = hash;
+  // Publish the hash and the class contents before the class.
+  ANDROID_MEMBAR_STORE();
+  slots->slots_[i].klass_ = klass;
+  size_++;
+}
+
+
+bool ClassTable::Remove(const char* descriptor, const mirror::ClassLoader* class_loader,
+                        size_t hash) {
+  Slots* slots = slots_;
+  const size_t mask = slots->mask_;
+  for (size_t i = SlotOf(hash, mask); slots->slots_[i].klass_ != NULL; i = (i + 1) & mask) {
+    mirror::Class* klass = slots->slots_[i].klass_;
+    if (klass != Tombstone() && slots->slots_[i].hash_ == hash &&
+        Matches(klass, descriptor, class_loader)) {
+      slots->slots_[i].klass_ = Tombstone();
+      size_--;
+      return true;
+    }
+  }
+  return false;
+}
+
+
+void ClassTable::Resize(size_t capacity) {
+  Slots* old_slots = slots_;
+  Slots* new_slots = AllocSlots(capacity);
+  const size_t mask = new_slots->mask_;
+  for (size_t j = 0; j <= old_slots->mask_; j++) {
+    const Slot& slot = old_slots->slots_[j];
+    if (!IsLive(slot.klass_)) {
+      continue;
+    }
+    size_t i = SlotOf(slot.hash_, mask);
+    while (new_slots->slots_[i].klass_ != NULL) {
+      i = (i + 1) & mask;
+    }
+    new_slots->slots_[i] = slot;
+  }
+  // Readers may still walk the old array.
+  new_slots->retired_ = old_slots;
+  ANDROID_MEMBAR_STORE();
+  slots_ = new_slots;
+  used_ = size_;
+}
+
+
+void ClassTable::LookupClasses(const char* descriptor, size_t hash,
+                               std::vector<mirror::Class*>& result) const {
+  const Slots* slots = slots_;
+  const size_t mask = slots->mask_;
+  ClassHelper kh;
+  for (size_t i = SlotOf(hash, mask); slots->slots_[i].klass_ != NULL; i = (i + 1) & mask) {
+    mirror::Class* klass = slots->slots_[i].klass_;
+    if (klass == Tombstone() || slots->slots_[i].hash_ != hash) {
+      continue;
+    }
+    kh.ChangeClass(klass);
+    if (strcmp(descriptor, kh.GetDescriptor()) == 0) {
+      result.push_back(klass);
+    }
+  }
+}
+
+
+void ClassTable::VisitRoots(RootVisitor* visitor, void* arg) const {
+  const Slots* slots = slots_;
+  for (size_t i = 0; i <= slots->mask_; i++) {
+    mirror::Class* klass = slots->slots_[i].klass_;
+    if (IsLive(klass)) {
+      visitor(klass, arg);
+    }
+  }
+}
+
+
+void ClassTable::VisitClasses(bool (*visitor)(mirror::Class* c, void* arg), void* arg) const {
+  const Slots* slots = slots_;
+  for (size_t i = 0; i <= slots->mask_; i++) {
+    mirror::Class* klass = slots->slots_[i].klass_;
+    if (IsLive(klass) && !visitor(klass, arg)) {
+      return;
+    }
+  }
+}
+
+}  // namespace art
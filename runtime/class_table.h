@@ -0,0 +1,119 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_RUNTIME_CLASS_TABLE_H_
+#define ART_RUNTIME_CLASS_TABLE_H_
+
+#include <vector>
+
+#include "base/macros.h"
+#include "base/mutex.h"
+#include "root_visitor.h"
+
+namespace art {
+namespace mirror {
+  class Class;
+  class ClassLoader;
+}  // namespace mirror
+
+/*
+ * Flat table of the loaded classes keyed by the hash of their descriptor,
+ * with linear probing. Results are matched on the descriptor and the class
+ * loader.
+ * Writers hold the classlinker_classes_lock_ exclusively. Lookup() takes no
+ * lock: a slot never goes back to empty, Remove() leaves a tombstone that
+ * Insert() may fill with another class, and a live class stays in its slot
+ * until a resize copies it to a new array. So a probe sequence a reader walks
+ * never ends before a class that was in the table when the walk started. A
+ * reader racing with an insertion may miss the new class, or see a reused
+ * slot with the hash of its old class, and falls back to defining the class
+ * under the lock, where InsertClass finds it. The arrays replaced on resize
+ * are kept until the table is destroyed since readers may still walk them;
+ * growing by doubling bounds them by the size of the live array.
+ */
+class ClassTable {
+ public:
+  ClassTable();
+  ~ClassTable();
+
+  mirror::Class* Lookup(const char* descriptor, const mirror::ClassLoader* class_loader,
+                        size_t hash) const
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  void Insert(mirror::Class* klass, size_t hash)
+      EXCLUSIVE_LOCKS_REQUIRED(Locks::classlinker_classes_lock_);
+
+  bool Remove(const char* descriptor, const mirror::ClassLoader* class_loader, size_t hash)
+      EXCLUSIVE_LOCKS_REQUIRED(Locks::classlinker_classes_lock_)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  // Classes of any class loader with the descriptor.
+  void LookupClasses(const char* descriptor, size_t hash,
+                     std::vector<mirror::Class*>& result) const
+      SHARED_LOCKS_REQUIRED(Locks::classlinker_classes_lock_, Locks::mutator_lock_);
+
+  void VisitRoots(RootVisitor* visitor, void* arg) const
+      SHARED_LOCKS_REQUIRED(Locks::classlinker_classes_lock_);
+
+  // Stops at the first class the visitor returns false for.
+  void VisitClasses(bool (*visitor)(mirror::Class* c, void* arg), void* arg) const
+      SHARED_LOCKS_REQUIRED(Locks::classlinker_classes_lock_);
+
+  size_t Size() const {
+    return size_;
+  }
+
+ private:
+  struct Slot {
+    mirror::Class* volatile klass_;
+    size_t hash_;
+  };
+
+  struct Slots {
+    size_t mask_;
+    Slots* retired_;
+    Slot slots_[0];
+  };
+
+  static const size_t kMinCapacity = 1024;
+
+  static mirror::Class* Tombstone() {
+    return reinterpret_cast<mirror::Class*>(1);
+  }
+
+  static bool IsLive(const mirror::Class* klass) {
+    return klass != NULL && klass != Tombstone();
+  }
+
+  static bool Matches(mirror::Class* klass, const char* descriptor,
+                      const mirror::ClassLoader* class_loader)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  static Slots* AllocSlots(size_t capacity);
+
+  void Resize(size_t capacity);
+
+  Slots* volatile slots_;
+  // Live classes, and live classes plus tombstones.
+  size_t size_;
+  size_t used_;
+
+  DISALLOW_COPY_AND_ASSIGN(ClassTable);
+};
+
+}  // namespace art
+
+#endif  // ART_RUNTIME_CLASS_TABLE_H_
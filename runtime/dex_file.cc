@@ -50,9 +50,10 @@ const byte DexFile::kDexMagicVersion[] = { '0', '3', '5', '\0' };
 
 DexFile::ClassPathEntry DexFile::FindInClassPath(const char* descriptor,
                                                  const ClassPath& class_path) {
+  const uint32_t hash = ComputeDescriptorHash(descriptor);
   for (size_t i = 0; i != class_path.size(); ++i) {
     const DexFile* dex_file = class_path[i];
-    const DexFile::ClassDef* dex_class_def = dex_file->FindClassDef(descriptor);
+    const DexFile::ClassDef* dex_class_def = dex_file->FindClassDef(descriptor, hash);
     if (dex_class_def != NULL) {
       return ClassPathEntry(dex_file, dex_class_def);
     }
@@ -274,6 +275,7 @@ DexFile::~DexFile() {
   // that's only called after DetachCurrentThread, which means there's no JNIEnv. We could
   // re-attach, but cleaning up these global references is not obviously useful. It's not as if
   // the global reference table is otherwise empty!
+  free(class_def_index_);
 }
 
 bool DexFile::Init() {
@@ -331,35 +333,73 @@ uint32_t DexFile::GetVersion() const {
   return atoi(version);
 }
 
-const DexFile::ClassDef* DexFile::FindClassDef(const char* descriptor) const {
-  size_t num_class_defs = NumClassDefs();
-  if (num_class_defs == 0) {
-    return NULL;
+// Spreads the descriptor hashes, whose low bits are poor, over the entries.
+static inline uint32_t ClassDefIndexSlot(uint32_t hash, uint32_t mask) {
+  uint32_t mixed = hash * 0x9E3779B1U;
+  return (mixed ^ (mixed >> 16)) & mask;
+}
+
+const DexFile::ClassDefIndex* DexFile::BuildClassDefIndex() const {
+  const size_t num_class_defs = NumClassDefs();
+  // Keep the load under 1/2.
+  uint32_t capacity = 16;
+  while (capacity < num_class_defs * 2) {
+    capacity *= 2;
+  }
+  ClassDefIndex* index = reinterpret_cast<ClassDefIndex*>(
+      malloc(sizeof(ClassDefIndex) + capacity * sizeof(ClassDefIndexEntry)));
+  CHECK(index != NULL) << GetLocation();
+  index->mask_ = capacity - 1;
+  for (uint32_t i = 0; i < capacity; ++i) {
+    index->entries_[i].hash_ = 0;
+    index->entries_[i].class_def_idx_ = kDexNoIndex;
   }
-  const StringId* string_id = FindStringId(descriptor);
-  if (string_id == NULL) {
-    return NULL;
+  for (size_t i = 0; i < num_class_defs; ++i) {
+    uint32_t hash = ComputeDescriptorHash(GetClassDescriptor(GetClassDef(i)));
+    uint32_t slot = ClassDefIndexSlot(hash, index->mask_);
+    while (index->entries_[slot].class_def_idx_ != kDexNoIndex) {
+      slot = (slot + 1) & index->mask_;
+    }
+    index->entries_[slot].hash_ = hash;
+    index->entries_[slot].class_def_idx_ = i;
   }
-  const TypeId* type_id = FindTypeId(GetIndexForStringId(*string_id));
-  if (type_id == NULL) {
+  // The compare and swap is a full barrier: the entries are visible first.
+  if (!__sync_bool_compare_and_swap(&class_def_index_, static_cast<ClassDefIndex*>(NULL), index)) {
+    free(index);
+  }
+  return class_def_index_;
+}
+
+const DexFile::ClassDef* DexFile::FindClassDef(const char* descriptor, uint32_t hash) const {
+  if (NumClassDefs() == 0) {
     return NULL;
   }
-  uint16_t type_idx = GetIndexForTypeId(*type_id);
-  for (size_t i = 0; i < num_class_defs; ++i) {
-    const ClassDef& class_def = GetClassDef(i);
-    if (class_def.class_idx_ == type_idx) {
-      return &class_def;
+  const ClassDefIndex* index = GetClassDefIndex();
+  for (uint32_t slot = ClassDefIndexSlot(hash, index->mask_);
+       index->entries_[slot].class_def_idx_ != kDexNoIndex; slot = (slot + 1) & index->mask_) {
+    if (index->entries_[slot].hash_ == hash) {
+      const ClassDef& class_def = GetClassDef(index->entries_[slot].class_def_idx_);
+      if (strcmp(descriptor, GetClassDescriptor(class_def)) == 0) {
+        return &class_def;
+      }
     }
   }
   return NULL;
 }
 
 const DexFile::ClassDef* DexFile::FindClassDef(uint16_t type_idx) const {
-  size_t num_class_defs = NumClassDefs();
-  for (size_t i = 0; i < num_class_defs; ++i) {
-    const ClassDef& class_def = GetClassDef(i);
-    if (class_def.class_idx_ == type_idx) {
-      return &class_def;
+  if (NumClassDefs() == 0) {
+    return NULL;
+  }
+  const ClassDefIndex* index = GetClassDefIndex();
+  uint32_t hash = ComputeDescriptorHash(StringByTypeIdx(type_idx));
+  for (uint32_t slot = ClassDefIndexSlot(hash, index->mask_);
+       index->entries_[slot].class_def_idx_ != kDexNoIndex; slot = (slot + 1) & index->mask_) {
+    if (index->entries_[slot].hash_ == hash) {
+      const ClassDef& class_def = GetClassDef(index->entries_[slot].class_def_idx_);
+      if (class_def.class_idx_ == type_idx) {
+        return &class_def;
+      }
     }
   }
   return NULL;
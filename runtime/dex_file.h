@@ -597,7 +597,22 @@ class DexFile {
   }
 
   // Looks up a class definition by its class descriptor.
-  const ClassDef* FindClassDef(const char* descriptor) const;
+  const ClassDef* FindClassDef(const char* descriptor) const {
+    return FindClassDef(descriptor, ComputeDescriptorHash(descriptor));
+  }
+
+  // Looks up a class definition by its class descriptor and the
+  // ComputeDescriptorHash() of the descriptor.
+  const ClassDef* FindClassDef(const char* descriptor, uint32_t hash) const;
+
+  // The String.hashCode() of the modified UTF-8 bytes of a descriptor.
+  static uint32_t ComputeDescriptorHash(const char* descriptor) {
+    uint32_t hash = 0;
+    for (; *descriptor != '\0'; ++descriptor) {
+      hash = hash * 31 + *descriptor;
+    }
+    return hash;
+  }
 
   // Looks up a class definition by its type index.
   const ClassDef* FindClassDef(uint16_t type_idx) const;
@@ -850,7 +865,8 @@ class DexFile {
         field_ids_(0),
         method_ids_(0),
         proto_ids_(0),
-        class_defs_(0) {
+        class_defs_(0),
+        class_def_index_(NULL) {
     CHECK(begin_ != NULL) << GetLocation();
     CHECK_GT(size_, 0U) << GetLocation();
   }
@@ -864,6 +880,30 @@ class DexFile {
   // Returns true if the header magic and version numbers are of the expected values.
   bool CheckMagicAndVersion() const;
 
+  // Open addressing table from descriptor hashes to class definition indexes,
+  // with linear probing.
+  struct ClassDefIndexEntry {
+    uint32_t hash_;
+    uint32_t class_def_idx_;
+  };
+
+  struct ClassDefIndex {
+    uint32_t mask_;
+    ClassDefIndexEntry entries_[0];
+  };
+
+  const ClassDefIndex* GetClassDefIndex() const {
+    const ClassDefIndex* index = class_def_index_;
+    if (UNLIKELY(index == NULL)) {
+      index = BuildClassDefIndex();
+    }
+    return index;
+  }
+
+  // Builds the index on the first lookup. Racing threads build their own and
+  // keep the first one published.
+  const ClassDefIndex* BuildClassDefIndex() const;
+
   void DecodeDebugInfo0(const CodeItem* code_item, bool is_static, uint32_t method_idx,
       DexDebugNewPositionCb position_cb, DexDebugNewLocalCb local_cb,
       void* context, const byte* stream, LocalInfo* local_in_reg) const;
@@ -910,6 +950,9 @@ class DexFile {
 
   // Points to the base of the class definition list.
   const ClassDef* class_defs_;
+
+  // Lazily built by GetClassDefIndex().
+  mutable ClassDefIndex* volatile class_def_index_;
 };
 
 // Iterate over a dex file's ProtoId's paramters
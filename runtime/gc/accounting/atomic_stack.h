@@ -96,14 +96,18 @@ class StructuredAtomicStack {
     return new ServerStructuredAtomicStack<T>(memory_data, server_begin);
   }
 
-  // Capacity is how many elements we can store in the stack.
+  // Capacity is how many elements we can store in the stack. A shared stack
+  // starts with one segment of high_capacity elements and chains up to
+  // max_segments segments inside the same shared reservation on overflow.
   static StructuredAtomicStack* ShareStack(StructuredAtomicStack* original,
-      StructuredObjectStackData* memory_data, bool shareMem, size_t high_capacity) {
+      StructuredObjectStackData* memory_data, bool shareMem, size_t high_capacity,
+      size_t max_segments = 1) {
 //    LOG(ERROR) << "....Calling ShareStack...." << memory_data <<
 //        ", with high capacity " << high_capacity;
     UniquePtr<StructuredAtomicStack> mark_stack(
         new StructuredAtomicStack(std::string(original->stack_data_->name_),
             high_capacity, memory_data, shareMem));
+    mark_stack->stack_data_->reserved_capacity_ = high_capacity * max_segments;
     mark_stack->Init(shareMem);
     if(!original->stack_data_->is_shared_) {
 //      LOG(ERROR) << "....Original stack was not shared....";
@@ -153,16 +157,88 @@ class StructuredAtomicStack {
     int32_t index;
     do {
       index = stack_data_->back_index_;
-      if (UNLIKELY(static_cast<size_t>(index) >= stack_data_->capacity_)) {
-        // Stack overflow.
-        return false;
+      if (UNLIKELY(index >= stack_data_->capacity_)) {
+        if (!GrowSegment(index)) {
+          // Stack overflow.
+          return false;
+        }
       }
     } while (android_atomic_cas(index, index + 1, &stack_data_->back_index_) != 0);
 
     SetEntryIndex(index, value);
+    UpdatePeakDepth(index + 1);
+    return true;
+  }
+
+  // Atomically bump the back index by the given number of slots. Returns false
+  // if we overflowed the stack.
+  bool AtomicBumpBack(size_t num_slots, T** start_address, T** end_address) {
+    if (kIsDebugBuild) {
+      stack_data_->debug_is_sorted_ = 0;
+    }
+    int32_t index;
+    int32_t new_index;
+    do {
+      index = stack_data_->back_index_;
+      new_index = index + num_slots;
+      if (UNLIKELY(new_index > stack_data_->capacity_)) {
+        if (!GrowSegment(new_index - 1)) {
+          // Stack overflow.
+          return false;
+        }
+      }
+    } while (android_atomic_cas(index, new_index, &stack_data_->back_index_) != 0);
+    *start_address = GetBaseAddress() + index;
+    *end_address = GetBaseAddress() + new_index;
+    UpdatePeakDepth(new_index);
     return true;
   }
 
+  // Commits the next segments of the shared reservation so that index fits.
+  // Both the client and the service map the whole reservation, so growing
+  // only moves the capacity bound. Returns false when the reservation is
+  // exhausted.
+  bool GrowSegment(int32_t index) {
+    while (true) {
+      int32_t _capacity = stack_data_->capacity_;
+      if (index < _capacity) {
+        return true;
+      }
+      if (stack_data_->segment_capacity_ == 0 ||
+          static_cast<size_t>(_capacity) + stack_data_->segment_capacity_ >
+              stack_data_->reserved_capacity_) {
+        return false;
+      }
+      int32_t _new_capacity =
+          _capacity + static_cast<int32_t>(stack_data_->segment_capacity_);
+      if (android_atomic_cas(_capacity, _new_capacity, &stack_data_->capacity_) == 0) {
+        IPC_MS_VLOG(INFO) << "StructuredAtomicStack: " << stack_data_->name_ <<
+            " grew to " << _new_capacity << " entries";
+      }
+    }
+  }
+
+  void UpdatePeakDepth(int32_t depth) {
+    if (depth > stack_data_->peak_depth_) {
+      stack_data_->peak_depth_ = depth;
+    }
+  }
+
+  // Peak depth of the current and of the previous cycle.
+  int32_t GetPeakDepth() const {
+    return stack_data_->peak_depth_;
+  }
+
+  int32_t GetLastPeakDepth() const {
+    return stack_data_->last_peak_depth_;
+  }
+
+  size_t GetSegmentsCount() const {
+    if (stack_data_->segment_capacity_ == 0)
+      return 1;
+    return static_cast<size_t>(stack_data_->capacity_) / stack_data_->segment_capacity_;
+  }
+
   virtual void Reset() {
     DCHECK(mem_map_.get() != NULL);
     DCHECK(GetBaseAddress() != NULL);
@@ -171,9 +247,11 @@ class StructuredAtomicStack {
 //    stack_data_->front_index_ = 0;
 //    stack_data_->back_index_ = 0;
     stack_data_->debug_is_sorted_ = 1;
+    stack_data_->last_peak_depth_ = stack_data_->peak_depth_;
+    stack_data_->peak_depth_ = 0;
     if(stack_data_->is_shared_ == 1) {
 //      LOG(ERROR) << "AAAAA.......Resetting Shared atomic stack......., before the memset call";
-      size_t _mem_length =  sizeof(T) * stack_data_->capacity_;
+      size_t _mem_length =  sizeof(T) * stack_data_->reserved_capacity_;
       if(mem_map_.get()!=NULL) {
         byte* _calc_end = mem_map_->End();
         byte* _end = reinterpret_cast<byte*>(stack_data_->begin_) + _mem_length;
@@ -193,11 +271,15 @@ class StructuredAtomicStack {
 //        LOG(ERROR) << ", calcEnd:" << reinterpret_cast<void*>(mem_map_->End());
       }
       //memset(reinterpret_cast<void*>(GetBaseAddress()), 0, _mem_length);
+      // Release the committed segments and shrink back to one segment.
       int result = madvise(GetBaseAddress(),
-          _mem_length, MADV_DONTNEED);
+          sizeof(T) * stack_data_->capacity_, MADV_DONTNEED);
       if (result == -1) {
         PLOG(WARNING) << "madvise failed in Atomic Stack shared here";
       }
+      if (stack_data_->segment_capacity_ != 0) {
+        stack_data_->capacity_ = static_cast<int32_t>(stack_data_->segment_capacity_);
+      }
     } else {
 //      LOG(ERROR) << ".......Resetting Non Shared atomic stack.......";
       int result = madvise(GetBaseAddress(),
@@ -216,16 +298,18 @@ class StructuredAtomicStack {
       stack_data_->debug_is_sorted_ = 0;
     }
     int32_t index = android_atomic_release_load(&(stack_data_->back_index_));
-    DCHECK_LT(static_cast<size_t>(index), stack_data_->capacity_);
     //stack_data_->back_index_ = index + 1;
 
-    if(static_cast<size_t>(index) >= stack_data_->capacity_) {
-      LOG(FATAL) << "ERROR in pushing back " << index << "; capacity = " <<
-          stack_data_->capacity_;
+    if(UNLIKELY(index >= stack_data_->capacity_)) {
+      if(!GrowSegment(index)) {
+        LOG(FATAL) << "ERROR in pushing back " << index << "; capacity = " <<
+            stack_data_->capacity_ << "; reserved = " << stack_data_->reserved_capacity_;
+      }
     }
 
     android_atomic_add(1, &(stack_data_->back_index_));
     SetEntryIndex(index, value);
+    UpdatePeakDepth(index + 1);
   }
 
   T PopBack() {
@@ -282,10 +366,20 @@ class StructuredAtomicStack {
 //    LOG(ERROR) << ".......Resizing atomic stack.......: " <<
 //        stack_data_->capacity_ << ", to newCapacity: "<<  new_capacity;
 
-    stack_data_->capacity_ = new_capacity;
-if(stack_data_->is_shared_) {
-  LOG(FATAL) << ".......Resizing atomic stack WHILE IT IS SHARED.......: " << new_capacity;
-}
+    if(stack_data_->is_shared_) {
+      // The other process maps the reservation: keep the committed segments
+      // and grow by segments instead, but clear the stack all the same.
+      android_atomic_acquire_store(0, &(stack_data_->front_index_));
+      android_atomic_acquire_store(0, &(stack_data_->back_index_));
+      if(!GrowSegment(static_cast<int32_t>(new_capacity) - 1)) {
+        LOG(FATAL) << ".......Resizing shared atomic stack beyond its reservation.......: "
+            << new_capacity << ", reserved: " << stack_data_->reserved_capacity_;
+      }
+      return;
+    }
+    stack_data_->capacity_ = static_cast<int32_t>(new_capacity);
+    stack_data_->reserved_capacity_ = new_capacity;
+    stack_data_->segment_capacity_ = new_capacity;
     //Reset();
     Init(stack_data_->is_shared_);
   }
@@ -414,7 +508,7 @@ if(stack_data_->is_shared_) {
 //          stack_data_->capacity_;
     }
     mem_map_.reset(MEM_MAP::CreateStructedMemMap(stack_data_->name_, NULL,
-        stack_data_->capacity_ * sizeof(T), PROT_READ | PROT_WRITE,
+        stack_data_->reserved_capacity_ * sizeof(T), PROT_READ | PROT_WRITE,
         (shareMem == 1), &(stack_data_->memory_)));
 //    LOG(ERROR) << "..........Created mem_map of the atomic stack.....";
     CHECK(mem_map_.get() != NULL) << "couldn't allocate mark stack";
@@ -439,7 +533,11 @@ if(stack_data_->is_shared_) {
               SERVICE_ALLOC_ALIGN_BYTE(StructuredObjectStackData)));
     }
     COPY_NAME_TO_STRUCT(stack_data_->name_, name);
-    stack_data_->capacity_ = capacity;
+    stack_data_->capacity_ = static_cast<int32_t>(capacity);
+    stack_data_->reserved_capacity_ = capacity;
+    stack_data_->segment_capacity_ = capacity;
+    stack_data_->peak_depth_ = 0;
+    stack_data_->last_peak_depth_ = 0;
     stack_data_->is_shared_ = shareMem ? 1 : 0;
     mem_map_.reset(NULL);
   }
@@ -469,7 +567,7 @@ class ServerStructuredAtomicStack : public StructuredObjectStack {
 //    LOG(ERROR) << "ServerStructuredAtomicStack::.......Resizing atomic stack.......: " <<
 //        stack_data_->capacity_ << ", to newCapacity: "<<  new_capacity;
 
-    stack_data_->capacity_ = new_capacity;
+    stack_data_->capacity_ = static_cast<int32_t>(new_capacity);
 
     Reset();
     //Init(stack_data_->is_shared_);
@@ -537,6 +635,8 @@ class ServerStructuredAtomicStack : public StructuredObjectStack {
 //    stack_data_->front_index_ = 0;
 //    stack_data_->back_index_ = 0;
     stack_data_->debug_is_sorted_ = 1;
+    stack_data_->last_peak_depth_ = stack_data_->peak_depth_;
+    stack_data_->peak_depth_ = 0;
     if(stack_data_->is_shared_ == 1) {
 //      LOG(ERROR) << "ServerStructuredAtomicStack::.......Resetting Shared atomic stack......., before the memset call";
       size_t _mem_length =  sizeof(T) * stack_data_->capacity_;
@@ -551,6 +651,9 @@ class ServerStructuredAtomicStack : public StructuredObjectStack {
         PLOG(WARNING) << "madvise failed in Atomic Stack";
       }
      // memset(reinterpret_cast<void*>(GetBaseAddress()), 0, _mem_length);
+      if (stack_data_->segment_capacity_ != 0) {
+        stack_data_->capacity_ = static_cast<int32_t>(stack_data_->segment_capacity_);
+      }
     } else {
       PLOG(ERROR) << "shared atomic stack has to be shared failed";
     }
@@ -650,6 +753,27 @@ class AtomicStack {
     return true;
   }
 
+  // Atomically bump the back index by the given number of slots. Returns false
+  // if we overflowed the stack.
+  bool AtomicBumpBack(size_t num_slots, T** start_address, T** end_address) {
+    if (kIsDebugBuild) {
+      debug_is_sorted_ = false;
+    }
+    int32_t index;
+    int32_t new_index;
+    do {
+      index = back_index_;
+      new_index = index + num_slots;
+      if (UNLIKELY(static_cast<size_t>(new_index) > capacity_)) {
+        // Stack overflow.
+        return false;
+      }
+    } while (!back_index_.compare_and_swap(index, new_index));
+    *start_address = &begin_[index];
+    *end_address = &begin_[new_index];
+    return true;
+  }
+
   void PushBack(const T& value) {
     if (kIsDebugBuild) {
       debug_is_sorted_ = false;
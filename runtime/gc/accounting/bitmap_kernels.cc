@@ -0,0 +1,313 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+
+#include "gc/accounting/bitmap_kernels.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// The AVX2 kernels are built with the target attribute and only run when
+// cpuid reports AVX2, so the rest of the runtime keeps its baseline flags.
+#if (defined(__i386__) || defined(__x86_64__)) && \
+    ((defined(__clang__) && __clang_major__ >= 4) || \
+     (!defined(__clang__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))))
+#define ART_BITMAP_KERNELS_AVX2 1
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#define ART_BITMAP_KERNELS_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace art {
+namespace gc {
+namespace accounting {
+
+const BitmapKernels::KernelsTable* BitmapKernels::kernels_ = NULL;
+
+
+static size_t PortableFindNonZero(const word* words, size_t begin, size_t end) {
+  size_t i = begin;
+  for (; i + 4 <= end; i += 4) {
+    if ((words[i] | words[i + 1] | words[i + 2] | words[i + 3]) != 0) {
+      break;
+    }
+  }
+  while (i < end && words[i] == 0) {
+    i++;
+  }
+  return i;
+}
+
+static size_t PortableFindAndNot(const word* a, const word* b, size_t begin, size_t end) {
+  size_t i = begin;
+  for (; i + 4 <= end; i += 4) {
+    if (((a[i] & ~b[i]) | (a[i + 1] & ~b[i + 1]) |
+         (a[i + 2] & ~b[i + 2]) | (a[i + 3] & ~b[i + 3])) != 0) {
+      break;
+    }
+  }
+  while (i < end && (a[i] & ~b[i]) == 0) {
+    i++;
+  }
+  return i;
+}
+
+static size_t PortableCountBits(const word* words, size_t count) {
+  size_t bits = 0;
+  for (size_t i = 0; i < count; i++) {
+    bits += __builtin_popcountl(static_cast<uintptr_t>(words[i]));
+  }
+  return bits;
+}
+
+// libc memcpy is already vectorized on every target we run on.
+static void LibcCopy(word* dst, const word* src, size_t count) {
+  memcpy(dst, src, count * kWordSize);
+}
+
+static const BitmapKernels::KernelsTable kPortableKernels = {
+  "portable", PortableFindNonZero, PortableFindAndNot, PortableCountBits, LibcCopy
+};
+
+
+#if defined(__SSE2__)
+static const size_t kSse2Words = sizeof(__m128i) / sizeof(word);
+
+static size_t Sse2FindNonZero(const word* words, size_t begin, size_t end) {
+  size_t i = begin;
+  const __m128i zero = _mm_setzero_si128();
+  // 64 bytes per iteration; the word loop finds the word in the block.
+  for (; i + 4 * kSse2Words <= end; i += 4 * kSse2Words) {
+    const __m128i* p = reinterpret_cast<const __m128i*>(words + i);
+    __m128i v = _mm_or_si128(_mm_or_si128(_mm_loadu_si128(p), _mm_loadu_si128(p + 1)),
+                             _mm_or_si128(_mm_loadu_si128(p + 2), _mm_loadu_si128(p + 3)));
+    if (_mm_movemask_epi8(_mm_cmpeq_epi8(v, zero)) != 0xFFFF) {
+      break;
+    }
+  }
+  return PortableFindNonZero(words, i, end);
+}
+
+static size_t Sse2FindAndNot(const word* a, const word* b, size_t begin, size_t end) {
+  size_t i = begin;
+  const __m128i zero = _mm_setzero_si128();
+  for (; i + 2 * kSse2Words <= end; i += 2 * kSse2Words) {
+    const __m128i* pa = reinterpret_cast<const __m128i*>(a + i);
+    const __m128i* pb = reinterpret_cast<const __m128i*>(b + i);
+    __m128i v = _mm_or_si128(_mm_andnot_si128(_mm_loadu_si128(pb), _mm_loadu_si128(pa)),
+                             _mm_andnot_si128(_mm_loadu_si128(pb + 1),
+                                              _mm_loadu_si128(pa + 1)));
+    if (_mm_movemask_epi8(_mm_cmpeq_epi8(v, zero)) != 0xFFFF) {
+      break;
+    }
+  }
+  return PortableFindAndNot(a, b, i, end);
+}
+
+// Bits of each byte of v.
+static inline __m128i Sse2PopcountBytes(__m128i v) {
+  const __m128i m1 = _mm_set1_epi8(0x55);
+  const __m128i m2 = _mm_set1_epi8(0x33);
+  const __m128i m4 = _mm_set1_epi8(0x0f);
+  v = _mm_sub_epi8(v, _mm_and_si128(_mm_srli_epi64(v, 1), m1));
+  v = _mm_add_epi8(_mm_and_si128(v, m2), _mm_and_si128(_mm_srli_epi64(v, 2), m2));
+  return _mm_and_si128(_mm_add_epi8(v, _mm_srli_epi64(v, 4)), m4);
+}
+
+static size_t Sse2CountBits(const word* words, size_t count) {
+  size_t i = 0;
+  const __m128i zero = _mm_setzero_si128();
+  __m128i acc = _mm_setzero_si128();
+  for (; i + kSse2Words <= count; i += kSse2Words) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(words + i));
+    acc = _mm_add_epi64(acc, _mm_sad_epu8(Sse2PopcountBytes(v), zero));
+  }
+  uint64_t lanes[2];
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), acc);
+  return lanes[0] + lanes[1] + PortableCountBits(words + i, count - i);
+}
+
+static const BitmapKernels::KernelsTable kSse2Kernels = {
+  "sse2", Sse2FindNonZero, Sse2FindAndNot, Sse2CountBits, LibcCopy
+};
+#endif  // __SSE2__
+
+
+#if defined(ART_BITMAP_KERNELS_AVX2)
+static const size_t kAvx2Words = sizeof(__m256i) / sizeof(word);
+
+__attribute__((target("avx2")))
+static size_t Avx2FindNonZero(const word* words, size_t begin, size_t end) {
+  size_t i = begin;
+  // 128 bytes per iteration.
+  for (; i + 4 * kAvx2Words <= end; i += 4 * kAvx2Words) {
+    const __m256i* p = reinterpret_cast<const __m256i*>(words + i);
+    __m256i v = _mm256_or_si256(
+        _mm256_or_si256(_mm256_loadu_si256(p), _mm256_loadu_si256(p + 1)),
+        _mm256_or_si256(_mm256_loadu_si256(p + 2), _mm256_loadu_si256(p + 3)));
+    if (!_mm256_testz_si256(v, v)) {
+      break;
+    }
+  }
+  return PortableFindNonZero(words, i, end);
+}
+
+__attribute__((target("avx2")))
+static size_t Avx2FindAndNot(const word* a, const word* b, size_t begin, size_t end) {
+  size_t i = begin;
+  for (; i + 2 * kAvx2Words <= end; i += 2 * kAvx2Words) {
+    const __m256i* pa = reinterpret_cast<const __m256i*>(a + i);
+    const __m256i* pb = reinterpret_cast<const __m256i*>(b + i);
+    // testc(b, a) is set when a & ~b is zero.
+    if (!_mm256_testc_si256(_mm256_loadu_si256(pb), _mm256_loadu_si256(pa)) ||
+        !_mm256_testc_si256(_mm256_loadu_si256(pb + 1), _mm256_loadu_si256(pa + 1))) {
+      break;
+    }
+  }
+  return PortableFindAndNot(a, b, i, end);
+}
+
+__attribute__((target("avx2")))
+static size_t Avx2CountBits(const word* words, size_t count) {
+  size_t i = 0;
+  // Bits of each nibble value.
+  const __m256i lut = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                       0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+  const __m256i low_mask = _mm256_set1_epi8(0x0f);
+  __m256i acc = _mm256_setzero_si256();
+  for (; i + kAvx2Words <= count; i += kAvx2Words) {
+    __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(words + i));
+    __m256i lo = _mm256_shuffle_epi8(lut, _mm256_and_si256(v, low_mask));
+    __m256i hi = _mm256_shuffle_epi8(lut, _mm256_and_si256(_mm256_srli_epi16(v, 4),
+                                                           low_mask));
+    acc = _mm256_add_epi64(acc, _mm256_sad_epu8(_mm256_add_epi8(lo, hi),
+                                                _mm256_setzero_si256()));
+  }
+  uint64_t lanes[4];
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), acc);
+  return lanes[0] + lanes[1] + lanes[2] + lanes[3] +
+      PortableCountBits(words + i, count - i);
+}
+
+static const BitmapKernels::KernelsTable kAvx2Kernels = {
+  "avx2", Avx2FindNonZero, Avx2FindAndNot, Avx2CountBits, LibcCopy
+};
+
+// AVX2 needs the CPU feature bit and an OS that saves the YMM registers.
+static bool CpuSupportsAvx2() {
+  unsigned int eax, ebx, ecx, edx;
+  if (__get_cpuid_max(0, NULL) < 7) {
+    return false;
+  }
+  __cpuid(1, eax, ebx, ecx, edx);
+  const unsigned int osxsave_avx = bit_OSXSAVE | bit_AVX;
+  if ((ecx & osxsave_avx) != osxsave_avx) {
+    return false;
+  }
+  unsigned int xcr0_lo, xcr0_hi;
+  __asm__ __volatile__("xgetbv" : "=a"(xcr0_lo), "=d"(xcr0_hi) : "c"(0));
+  if ((xcr0_lo & 0x6) != 0x6) {
+    return false;
+  }
+  __cpuid_count(7, 0, eax, ebx, ecx, edx);
+  return (ebx & (1 << 5)) != 0;
+}
+#endif  // ART_BITMAP_KERNELS_AVX2
+
+
+#if defined(ART_BITMAP_KERNELS_NEON)
+static const size_t kNeonWords = sizeof(uint32x4_t) / sizeof(word);
+
+static inline bool NeonIsZero(uint32x4_t v) {
+  uint32x2_t r = vorr_u32(vget_low_u32(v), vget_high_u32(v));
+  return (vget_lane_u32(r, 0) | vget_lane_u32(r, 1)) == 0;
+}
+
+static size_t NeonFindNonZero(const word* words, size_t begin, size_t end) {
+  size_t i = begin;
+  for (; i + 4 * kNeonWords <= end; i += 4 * kNeonWords) {
+    const uint32_t* p = reinterpret_cast<const uint32_t*>(words + i);
+    uint32x4_t v = vorrq_u32(vorrq_u32(vld1q_u32(p), vld1q_u32(p + 4)),
+                             vorrq_u32(vld1q_u32(p + 8), vld1q_u32(p + 12)));
+    if (!NeonIsZero(v)) {
+      break;
+    }
+  }
+  return PortableFindNonZero(words, i, end);
+}
+
+static size_t NeonFindAndNot(const word* a, const word* b, size_t begin, size_t end) {
+  size_t i = begin;
+  for (; i + 2 * kNeonWords <= end; i += 2 * kNeonWords) {
+    const uint32_t* pa = reinterpret_cast<const uint32_t*>(a + i);
+    const uint32_t* pb = reinterpret_cast<const uint32_t*>(b + i);
+    uint32x4_t v = vorrq_u32(vbicq_u32(vld1q_u32(pa), vld1q_u32(pb)),
+                             vbicq_u32(vld1q_u32(pa + 4), vld1q_u32(pb + 4)));
+    if (!NeonIsZero(v)) {
+      break;
+    }
+  }
+  return PortableFindAndNot(a, b, i, end);
+}
+
+static size_t NeonCountBits(const word* words, size_t count) {
+  size_t i = 0;
+  uint32x4_t acc = vdupq_n_u32(0);
+  for (; i + kNeonWords <= count; i += kNeonWords) {
+    uint8x16_t bits = vcntq_u8(vld1q_u8(reinterpret_cast<const uint8_t*>(words + i)));
+    acc = vpadalq_u16(acc, vpaddlq_u8(bits));
+  }
+  uint64x2_t sum = vpaddlq_u32(acc);
+  return vgetq_lane_u64(sum, 0) + vgetq_lane_u64(sum, 1) +
+      PortableCountBits(words + i, count - i);
+}
+
+static const BitmapKernels::KernelsTable kNeonKernels = {
+  "neon", NeonFindNonZero, NeonFindAndNot, NeonCountBits, LibcCopy
+};
+#endif  // ART_BITMAP_KERNELS_NEON
+
+
+const BitmapKernels::KernelsTable* BitmapKernels::SelectKernels() {
+#if defined(ART_BITMAP_KERNELS_AVX2)
+  if (CpuSupportsAvx2()) {
+    return &kAvx2Kernels;
+  }
+#endif
+#if defined(__SSE2__)
+  return &kSse2Kernels;
+#elif defined(ART_BITMAP_KERNELS_NEON)
+  // NEON is part of the build flags of the ARM targets that enable it.
+  return &kNeonKernels;
+#else
+  return &kPortableKernels;
+#endif
+}
+
+
+void BitmapKernels::UsePortableKernels(bool portable) {
+  kernels_ = portable ? &kPortableKernels : SelectKernels();
+}
+
+}  // namespace accounting
+}  // namespace gc
+}  // namespace art
@@ -0,0 +1,104 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_RUNTIME_GC_ACCOUNTING_BITMAP_KERNELS_H_
+#define ART_RUNTIME_GC_ACCOUNTING_BITMAP_KERNELS_H_
+
+#include <stdint.h>
+
+#include "base/macros.h"
+#include "globals.h"
+
+namespace art {
+namespace gc {
+namespace accounting {
+
+/*
+ * Word array kernels of the space bitmaps: skipping runs of zero words,
+ * finding words of an AND-NOT (live & ~mark) mask, counting bits and bulk
+ * copies. The vector implementation is picked on first use: AVX2 when the
+ * CPU has it and SSE2 otherwise on x86, NEON on ARM, and word loops on other
+ * architectures. Ranges are [begin, end) word indices.
+ */
+class BitmapKernels {
+ public:
+  typedef size_t (FindNonZeroKernel)(const word* words, size_t begin, size_t end);
+  typedef size_t (FindAndNotKernel)(const word* a, const word* b, size_t begin, size_t end);
+  typedef size_t (CountBitsKernel)(const word* words, size_t count);
+  typedef void (CopyKernel)(word* dst, const word* src, size_t count);
+
+  typedef struct KernelsTable_S {
+    const char* name_;
+    FindNonZeroKernel* find_non_zero_;
+    FindAndNotKernel* find_and_not_;
+    CountBitsKernel* count_bits_;
+    CopyKernel* copy_;
+  } KernelsTable;
+
+  // Index of the first non zero word in [begin, end), or end.
+  static size_t FindNonZero(const word* words, size_t begin, size_t end) {
+    // Dense bitmaps rarely have a zero word: test it before calling out.
+    if (begin >= end || words[begin] != 0) {
+      return begin;
+    }
+    return GetKernels()->find_non_zero_(words, begin + 1, end);
+  }
+
+  // Index of the first word with (a[i] & ~b[i]) != 0 in [begin, end), or end.
+  static size_t FindAndNot(const word* a, const word* b, size_t begin, size_t end) {
+    if (begin >= end || (a[begin] & ~b[begin]) != 0) {
+      return begin;
+    }
+    return GetKernels()->find_and_not_(a, b, begin + 1, end);
+  }
+
+  static size_t CountBits(const word* words, size_t count) {
+    return GetKernels()->count_bits_(words, count);
+  }
+
+  static void Copy(word* dst, const word* src, size_t count) {
+    GetKernels()->copy_(dst, src, count);
+  }
+
+  static const char* GetName() {
+    return GetKernels()->name_;
+  }
+
+  // Switches between the word loops and the vector kernels of the CPU.
+  // Only meant for tests and benchmarks.
+  static void UsePortableKernels(bool portable);
+
+ private:
+  static const KernelsTable* GetKernels() {
+    if (UNLIKELY(kernels_ == NULL)) {
+      // Racing threads select the same table.
+      kernels_ = SelectKernels();
+    }
+    return kernels_;
+  }
+
+  static const KernelsTable* SelectKernels();
+
+  static const KernelsTable* kernels_;
+
+  DISALLOW_IMPLICIT_CONSTRUCTORS(BitmapKernels);
+};
+
+}  // namespace accounting
+}  // namespace gc
+}  // namespace art
+
+#endif  // ART_RUNTIME_GC_ACCOUNTING_BITMAP_KERNELS_H_
@@ -19,6 +19,7 @@
 
 #include "base/logging.h"
 #include "cutils/atomic-inline.h"
+#include "gc/accounting/bitmap_kernels.h"
 #include "utils.h"
 
 namespace art {
@@ -105,8 +106,12 @@ void BaseBitmap::VisitMarkedRange(uintptr_t visit_begin, uintptr_t visit_end,
   }
   word_start++;
 
-  for (size_t i = word_start; i < word_end; i++) {
-    size_t w = Begin()[i];
+  // Runs of empty words are skipped by the vector kernels.
+  const word* const bitmap_begin = Begin();
+  for (size_t i = BitmapKernels::FindNonZero(bitmap_begin, word_start, word_end); i < word_end;
+       i = BitmapKernels::FindNonZero(bitmap_begin, i + 1, word_end)) {
+    size_t w = bitmap_begin[i];
+    // The word may have been cleared since the scan saw it.
     if (w != 0) {
       uintptr_t ptr_base = IndexToOffset(i) + HeapBegin();
       do {
@@ -201,8 +206,12 @@ void SpaceBitmap::VisitMarkedRange(uintptr_t visit_begin, uintptr_t visit_end,
   }
   word_start++;
 
-  for (size_t i = word_start; i < word_end; i++) {
-    size_t w = Begin()[i];
+  // Runs of empty words are skipped by the vector kernels.
+  const word* const bitmap_begin = Begin();
+  for (size_t i = BitmapKernels::FindNonZero(bitmap_begin, word_start, word_end); i < word_end;
+       i = BitmapKernels::FindNonZero(bitmap_begin, i + 1, word_end)) {
+    size_t w = bitmap_begin[i];
+    // The word may have been cleared since the scan saw it.
     if (w != 0) {
       uintptr_t ptr_base = IndexToOffset(i) + HeapBegin();
       do {
@@ -121,8 +121,7 @@ void SpaceBitmap::Clear() {
 
 void SpaceBitmap::CopyFrom(SpaceBitmap* source_bitmap) {
   DCHECK_EQ(Size(), source_bitmap->Size());
-  std::copy(source_bitmap->Begin(),
-      source_bitmap->Begin() + source_bitmap->Size() / kWordSize, Begin());
+  BitmapKernels::Copy(Begin(), source_bitmap->Begin(), source_bitmap->Size() / kWordSize);
 }
 
 
@@ -134,8 +133,10 @@ void SpaceBitmap::Walk(SpaceBitmap::Callback* callback, void* arg) {
 
   uintptr_t end = OffsetToIndex(HeapLimit() - HeapBegin() - 1);
   word* bitmap_begin = Begin();
-  for (uintptr_t i = 0; i <= end; ++i) {
+  for (uintptr_t i = BitmapKernels::FindNonZero(bitmap_begin, 0, end + 1); i <= end;
+       i = BitmapKernels::FindNonZero(bitmap_begin, i + 1, end + 1)) {
     word w = bitmap_begin[i];
+    // The word may have been cleared since the scan saw it.
     if (w != 0) {
       uintptr_t ptr_base = IndexToOffset(i) + HeapBegin();
       do {
@@ -178,21 +179,22 @@ void SpaceBitmap::SweepWalk(const SpaceBitmap& live_bitmap,
   CHECK_LT(end, live_bitmap.Size() / kWordSize);
   word* live = live_bitmap.Begin();
   word* mark = mark_bitmap.Begin();
-  for (size_t i = start; i <= end; i++) {
+  // Runs of words without garbage are skipped by the vector kernels.
+  for (size_t i = BitmapKernels::FindAndNot(live, mark, start, end + 1); i <= end;
+       i = BitmapKernels::FindAndNot(live, mark, i + 1, end + 1)) {
+    // Mark bits set since the kernel read the words can leave no garbage.
     word garbage = live[i] & ~mark[i];
-    if (UNLIKELY(garbage != 0)) {
-      uintptr_t ptr_base = IndexToOffset(i) + live_bitmap.HeapBegin();
-      do {
-        const size_t shift = CLZ(garbage);
-        garbage ^= static_cast<size_t>(kWordHighBitMask) >> shift;
-        *pb++ = reinterpret_cast<mirror::Object*>(ptr_base + shift * kAlignment);
-      } while (garbage != 0);
-      // Make sure that there are always enough slots available for an
-      // entire word of one bits.
-      if (pb >= &pointer_buf[buffer_size - kBitsPerWord]) {
-        (*callback)(pb - &pointer_buf[0], &pointer_buf[0], arg);
-        pb = &pointer_buf[0];
-      }
+    uintptr_t ptr_base = IndexToOffset(i) + live_bitmap.HeapBegin();
+    while (garbage != 0) {
+      const size_t shift = CLZ(garbage);
+      garbage ^= static_cast<size_t>(kWordHighBitMask) >> shift;
+      *pb++ = reinterpret_cast<mirror::Object*>(ptr_base + shift * kAlignment);
+    }
+    // Make sure that there are always enough slots available for an
+    // entire word of one bits.
+    if (pb >= &pointer_buf[buffer_size - kBitsPerWord]) {
+      (*callback)(pb - &pointer_buf[0], &pointer_buf[0], arg);
+      pb = &pointer_buf[0];
     }
   }
   if (pb > &pointer_buf[0]) {
@@ -16,6 +16,7 @@
 
 #include "space_bitmap.h"
 
+#include "bitmap_kernels.h"
 #include "common_test.h"
 #include "globals.h"
 #include "space_bitmap-inl.h"
@@ -88,6 +89,124 @@ TEST_F(SpaceBitmapTest, ScanRange) {
   }
 }
 
+static size_t bitmap_rand(size_t* seed) {
+  *seed = *seed * 1103515245 + 12345;
+  return *seed >> 8;
+}
+
+// Marks about one object in every stride of the live bitmap and keeps one
+// in every keep_stride of those in the mark bitmap.
+static void FillBitmaps(SpaceBitmap* live, SpaceBitmap* mark, byte* heap_begin,
+                        size_t heap_capacity, size_t stride, size_t keep_stride) {
+  size_t seed = 17;
+  const size_t slots = heap_capacity / SpaceBitmap::kAlignment;
+  for (size_t i = bitmap_rand(&seed) % stride; i < slots; i += 1 + bitmap_rand(&seed) % stride) {
+    const mirror::Object* obj =
+        reinterpret_cast<mirror::Object*>(heap_begin + i * SpaceBitmap::kAlignment);
+    live->Set(obj);
+    if (bitmap_rand(&seed) % keep_stride == 0) {
+      mark->Set(obj);
+    }
+  }
+}
+
+static void CountSweepCallback(size_t num_ptrs, mirror::Object** /* ptrs */, void* arg) {
+  *reinterpret_cast<size_t*>(arg) += num_ptrs;
+}
+
+class CountVisitor {
+ public:
+  explicit CountVisitor(size_t* count) : count_(count) {}
+
+  void operator()(const mirror::Object* /* obj */) const {
+    ++*count_;
+  }
+
+  size_t* const count_;
+};
+
+// Checks the vector kernels against the word loops on bitmaps of each density.
+TEST_F(SpaceBitmapTest, Kernels) {
+  byte* heap_begin = reinterpret_cast<byte*>(0x10000000);
+  size_t heap_capacity = 4 * MB;
+  static const size_t kStrides[] = { 1, 7, 300, 20000 };
+  for (size_t s = 0; s < arraysize(kStrides); ++s) {
+    UniquePtr<SpaceBitmap> live(SpaceBitmap::Create("live bitmap", heap_begin, heap_capacity));
+    UniquePtr<SpaceBitmap> mark(SpaceBitmap::Create("mark bitmap", heap_begin, heap_capacity));
+    ASSERT_TRUE(live.get() != NULL);
+    ASSERT_TRUE(mark.get() != NULL);
+    FillBitmaps(live.get(), mark.get(), heap_begin, heap_capacity, kStrides[s], 3);
+    // Unaligned ranges exercise the word loops around the vector blocks.
+    uintptr_t begin = reinterpret_cast<uintptr_t>(heap_begin) + 5 * KB + 8;
+    uintptr_t end = reinterpret_cast<uintptr_t>(heap_begin) + heap_capacity - 3 * KB - 24;
+    size_t counts[2][3];
+    for (int portable = 0; portable < 2; ++portable) {
+      BitmapKernels::UsePortableKernels(portable != 0);
+      size_t garbage = 0;
+      SpaceBitmap::SweepWalk(*live, *mark, begin, end, &CountSweepCallback, &garbage);
+      size_t marked = 0;
+      live->VisitMarkedRange(begin, end, CountVisitor(&marked));
+      counts[portable][0] = garbage;
+      counts[portable][1] = marked;
+      counts[portable][2] = BitmapKernels::CountBits(live->Begin(), live->Size() / kWordSize);
+    }
+    BitmapKernels::UsePortableKernels(false);
+    EXPECT_EQ(counts[1][0], counts[0][0]);
+    EXPECT_EQ(counts[1][1], counts[0][1]);
+    EXPECT_EQ(counts[1][2], counts[0][2]);
+    mark->CopyFrom(live.get());
+    EXPECT_EQ(0, memcmp(mark->Begin(), live->Begin(), live->Size()));
+  }
+}
+
+// Reports the time of the bitmap walks with the word loops and with the
+// vector kernels, on sparse and dense heaps.
+TEST_F(SpaceBitmapTest, KernelsBenchmark) {
+  byte* heap_begin = reinterpret_cast<byte*>(0x10000000);
+  size_t heap_capacity = 64 * MB;
+  static const size_t kStrides[] = { 2, 64, 4096 };
+  static const size_t kRounds = 10;
+  for (size_t s = 0; s < arraysize(kStrides); ++s) {
+    UniquePtr<SpaceBitmap> live(SpaceBitmap::Create("live bitmap", heap_begin, heap_capacity));
+    UniquePtr<SpaceBitmap> mark(SpaceBitmap::Create("mark bitmap", heap_begin, heap_capacity));
+    UniquePtr<SpaceBitmap> copy(SpaceBitmap::Create("copy bitmap", heap_begin, heap_capacity));
+    ASSERT_TRUE(live.get() != NULL && mark.get() != NULL && copy.get() != NULL);
+    FillBitmaps(live.get(), mark.get(), heap_begin, heap_capacity, kStrides[s], 2);
+    uintptr_t begin = reinterpret_cast<uintptr_t>(heap_begin);
+    uintptr_t end = begin + heap_capacity;
+    for (int portable = 1; portable >= 0; --portable) {
+      BitmapKernels::UsePortableKernels(portable != 0);
+      size_t count = 0;
+      uint64_t start = NanoTime();
+      for (size_t r = 0; r < kRounds; ++r) {
+        live->VisitMarkedRange(begin, end, CountVisitor(&count));
+      }
+      uint64_t visit_ns = NanoTime() - start;
+      start = NanoTime();
+      for (size_t r = 0; r < kRounds; ++r) {
+        SpaceBitmap::SweepWalk(*live, *mark, begin, end, &CountSweepCallback, &count);
+      }
+      uint64_t sweep_ns = NanoTime() - start;
+      start = NanoTime();
+      for (size_t r = 0; r < kRounds; ++r) {
+        count += BitmapKernels::CountBits(live->Begin(), live->Size() / kWordSize);
+      }
+      uint64_t count_ns = NanoTime() - start;
+      start = NanoTime();
+      for (size_t r = 0; r < kRounds; ++r) {
+        copy->CopyFrom(live.get());
+      }
+      uint64_t copy_ns = NanoTime() - start;
+      LOG(INFO) << BitmapKernels::GetName() << " one object in " << kStrides[s] / 2 + 1
+                << " slots: VisitMarkedRange " << PrettyDuration(visit_ns / kRounds)
+                << ", SweepWalk " << PrettyDuration(sweep_ns / kRounds)
+                << ", CountBits " << PrettyDuration(count_ns / kRounds)
+                << ", CopyFrom " << PrettyDuration(copy_ns / kRounds)
+                << " (" << count << ")";
+    }
+  }
+}
+
 }  // namespace accounting
 }  // namespace gc
 }  // namespace art
@@ -6,6 +6,8 @@
  */
 
 #include "thread.h"
+#include "thread_pool.h"
+#include "utils.h"
 #include "thread_list.h"
 #include "thread-inl.h"
 #include "gc/accounting/heap_bitmap.h"
@@ -29,19 +31,32 @@ namespace collector {
 
 
 
+size_t ForwardingTable::Build(const accounting::SPACE_BITMAP* bitmap,
+                              uintptr_t heap_end) {
+  heap_begin_ = bitmap->HeapBegin();
+  bitmap_words_ = bitmap->Begin();
+  const size_t _words_cnt =
+      accounting::SPACE_BITMAP::OffsetToIndex(heap_end - heap_begin_ - 1) + 1;
+  ranks_.resize(_words_cnt);
+  size_t _live_cnt = 0;
+  for (size_t i = 0; i < _words_cnt; i++) {
+    ranks_[i] = _live_cnt;
+    _live_cnt += __builtin_popcountl(static_cast<uintptr_t>(bitmap_words_[i]));
+  }
+  forwarded_.assign(_live_cnt, NULL);
+  return _live_cnt;
+}
+
+
 inline void SpaceCompactor::allocateSpaceObject(const mirror::Object* obj,
                                          size_t obj_size) {
   size_t actual_space = 0;
   mirror::Object* result = compact_space_->publicAllocWithoutGrowthLocked(obj_size,
                                                             &actual_space);
-//  const byte* src = reinterpret_cast<const byte*>(obj);
-//  byte* dst = reinterpret_cast<byte*>(result);
-//  memcpy(dst, src, obj_size);
-  forwarded_objects_.Put(obj, result);
-
-
-//
-//
+  CHECK(result != NULL) << "compacted space too small for " << obj_size << " bytes";
+  // Objects are visited in address order, so the rank is the visit count.
+  forwarded_objects_.SetForwarded(compacted_cnt_, result);
+  compacted_bytes_ += actual_space;
 }
 
 
@@ -51,9 +66,12 @@ const referenceKlass* SpaceCompactor::MapValueToServer(
   const byte* _raw_address = reinterpret_cast<const byte*>(original_obj);
   if((_raw_address < byte_end_) &&
           (_raw_address >= byte_start_)) {
-    *ismoved = true;
-    FwdedOBJs::const_iterator found = forwarded_objects_.find(original_obj);
-    return found->second;
+    const mirror::Object* _fwd =
+        forwarded_objects_.Lookup(reinterpret_cast<const mirror::Object*>(original_obj));
+    if (_fwd != NULL) {
+      *ismoved = true;
+      return reinterpret_cast<const referenceKlass*>(_fwd);
+    }
   }
 
   return original_obj;
@@ -64,16 +82,21 @@ const referenceKlass* SpaceCompactor::MapValueToServer(
 SpaceCompactor::SpaceCompactor(Heap* vmHeap) : local_heap_(vmHeap),
     objects_cnt_(0),
     compacted_cnt_(0),
+    compacted_bytes_(0),
     original_space_(local_heap_->GetAllocSpace()->AsDlMallocSpace()),
     compact_space_(NULL),
     immune_begin_ (NULL),
     immune_end_ (NULL),
     byte_start_(NULL),
-    byte_end_(NULL) {
-
-
-
+    byte_end_(NULL),
+    plan_ns_(0),
+    fixup_ns_(0) {
+  memset(&frag_before_, 0, sizeof(frag_before_));
+  memset(&frag_after_, 0, sizeof(frag_after_));
+}
 
+SpaceCompactor::~SpaceCompactor() {
+  delete compact_space_;
 }
 
 class CompactVisitor {
@@ -104,30 +127,81 @@ class CompactFixableVisitor {
 
   }
 
+  // Reads only the original objects, so that tasks can run concurrently.
   void operator()(const mirror::Object* o) const SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
-    if(o != NULL) {
-      size_t n = o->SizeOf();
-      compactor_->allocateSpaceObject(o, n);
-      compactor_->compacted_cnt_++;
-    }
+    mirror::Object* _copy = compactor_->forwarded_objects_.Lookup(o);
+    CHECK(_copy != NULL) << "object not planned " << o;
+    memcpy(_copy, o, o->SizeOf());
+    compactor_->FixupObject(o, _copy);
   }
   DISALLOW_COPY_AND_ASSIGN(CompactFixableVisitor);
 };
 
-void SpaceCompactor::FillNewObjects(void) {
-//  for(const auto& ref : forwarded_objects_) {
-//    const byte* src = reinterpret_cast<const byte*>(ref.first);
-//    byte* dst = reinterpret_cast<byte*>(ref.second);
-////    size_t n = ref.first->SizeOf();
-////    memcpy(dst, src, n);
-//  }
+
+class CompactFixupTask : public Task {
+ public:
+  CompactFixupTask(SpaceCompactor* compactor, uintptr_t begin, uintptr_t end)
+      : compactor_(compactor),
+        begin_(begin),
+        end_(end) {
+  }
+
+  virtual void Run(Thread* self) NO_THREAD_SAFETY_ANALYSIS {
+    CompactFixableVisitor visitor(compactor_);
+    compactor_->original_space_->GetLiveBitmap()->VisitMarkedRange(begin_, end_, visitor);
+  }
+
+  virtual void Finalize() {
+    delete this;
+  }
+
+ private:
+  SpaceCompactor* const compactor_;
+  const uintptr_t begin_;
+  const uintptr_t end_;
+};
+
+
+void SpaceCompactor::PlanForwarding(void) {
+  uint64_t _start = NanoTime();
+  accounting::SPACE_BITMAP* _live_bitmap = original_space_->GetLiveBitmap();
+  objects_cnt_ = forwarded_objects_.Build(_live_bitmap,
+                                          reinterpret_cast<uintptr_t>(byte_end_));
+  CompactVisitor compact_visitor(this);
+  _live_bitmap->VisitMarkedRange(reinterpret_cast<uintptr_t>(byte_start_),
+                                 reinterpret_cast<uintptr_t>(byte_end_),
+                                 compact_visitor);
+  CHECK_EQ(objects_cnt_, compacted_cnt_);
+  plan_ns_ = NanoTime() - _start;
 }
 
 
-typedef struct FragmentationInfo_S {
-  uint64_t sum_;
-  uint64_t max_;
-}FragmentationInfo;
+void SpaceCompactor::FillNewObjects(Thread* self) {
+  uint64_t _start = NanoTime();
+  ThreadPool* _thread_pool = local_heap_->GetThreadPool();
+  const size_t _thread_cnt =
+      (_thread_pool == NULL) ? 0 : local_heap_->GetParallelGCThreadCount() + 1;
+  const uintptr_t _begin = reinterpret_cast<uintptr_t>(byte_start_);
+  const uintptr_t _end = reinterpret_cast<uintptr_t>(byte_end_);
+  if (_thread_cnt < 2) {
+    CompactFixableVisitor visitor(this);
+    original_space_->GetLiveBitmap()->VisitMarkedRange(_begin, _end, visitor);
+  } else {
+    // A few tasks per thread so that dense regions do not serialize the pass.
+    const size_t _delta = RoundUp((_end - _begin) / (_thread_cnt * 4) + 1,
+                                  accounting::SPACE_BITMAP::kAlignment * kBitsPerWord);
+    for (uintptr_t _task_begin = _begin; _task_begin < _end; _task_begin += _delta) {
+      _thread_pool->AddTask(self, new CompactFixupTask(this, _task_begin,
+                                                       std::min(_task_begin + _delta, _end)));
+    }
+    _thread_pool->SetMaxActiveWorkers(_thread_cnt - 1);
+    _thread_pool->StartWorkers(self);
+    _thread_pool->Wait(self, true, true);
+    _thread_pool->StopWorkers(self);
+  }
+  fixup_ns_ = NanoTime() - _start;
+}
+
 
 static void MSpaceSumFragChunkCallback(void* start, void* end, size_t used_bytes, void* arg) {
   size_t chunk_size = reinterpret_cast<uint8_t*>(end) - reinterpret_cast<uint8_t*>(start);
@@ -137,13 +211,19 @@ static void MSpaceSumFragChunkCallback(void* start, void* end, size_t used_bytes
       FragmentationInfo* _info = reinterpret_cast<FragmentationInfo*>(arg);
       _info->max_ = std::max(_info->max_, chunk_free_bytes);
       _info->sum_ = _info->sum_ +  chunk_free_bytes;
-//      uint64_t& max_contiguous_allocation = *reinterpret_cast<uint64_t*>(arg);
-//      max_contiguous_allocation = max_contiguous_allocation + chunk_free_bytes;
     }
   }
 }
 
 
+void SpaceCompactor::MeasureFragmentation(space::DLMALLOC_SPACE_T* space,
+                                          FragmentationInfo* frag_info) {
+  frag_info->max_ = 0;
+  frag_info->sum_ = 0;
+  space->Walk(MSpaceSumFragChunkCallback, frag_info);
+}
+
+
 void SpaceCompactor::FixupFields(const mirror::Object* orig,
                                  mirror::Object* copy,
                               uint32_t ref_offsets,
@@ -218,11 +298,17 @@ void SpaceCompactor::FixupStaticFields(const mirror::Class* orig, mirror::Class*
 }
 
 void SpaceCompactor::FixupObjectArray(const mirror::ObjectArray<mirror::Object>* orig, mirror::ObjectArray<mirror::Object>* copy) {
+  const int32_t _data_offset =
+      mirror::Array::DataOffset(sizeof(mirror::Object*)).Int32Value();
   for (int32_t i = 0; i < orig->GetLength(); ++i) {
-    const mirror::Object* element = orig->Get(i);
+    const mirror::Object* element = orig->GetWithoutChecks(i);
     bool isMapped = false;
     const mirror::Object* _new_ref = MapValueToServer<mirror::Object>(element, &isMapped);
-    copy->SetPtrWithoutChecks(i, const_cast<mirror::Object*>(_new_ref));
+    if (isMapped) {
+      // The copy is not covered by the card table: no write barrier.
+      copy->publicSetFieldPtr(MemberOffset(_data_offset + i * sizeof(mirror::Object*)),
+                              _new_ref, false, false);
+    }
   }
 }
 
@@ -241,170 +327,76 @@ void SpaceCompactor::FixupObject(const mirror::Object* orig,
   const mirror::Object* _new_class =
       MapValueToServer<mirror::Object>(_origin_class, &ismapped);
   if(ismapped) {
-    copy->SetClass(down_cast<mirror::Class*>(const_cast<mirror::Object*>(_new_class)));
+    copy->publicSetFieldPtr(mirror::Object::ClassOffset(), _new_class, false, false);
   }
 
   if (orig->IsClass()) {
-   // FixupClass(orig->AsClass(), down_cast<mirror::Class*>(copy));
+    FixupClass(orig->AsClass(), down_cast<mirror::Class*>(copy));
   } else if (orig->IsObjectArray()) {
-  //  FixupObjectArray(orig->AsObjectArray<mirror::Object>(), down_cast<mirror::ObjectArray<mirror::Object>*>(copy));
+    FixupObjectArray(orig->AsObjectArray<mirror::Object>(),
+                     down_cast<mirror::ObjectArray<mirror::Object>*>(copy));
   } else if (orig->IsArtMethod()) {
-   // LOG(ERROR) << "Skipping method fixup";
-    //FixupMethod(orig->AsArtMethod(), down_cast<mirror::ArtMethod*>(copy));
+    FixupMethod(orig->AsArtMethod(), down_cast<mirror::ArtMethod*>(copy));
   } else {
-  //  FixupInstanceFields(orig, copy);
+    FixupInstanceFields(orig, copy);
   }
 
 }
 
 void SpaceCompactor::FixupMethod(const mirror::ArtMethod* orig, mirror::ArtMethod* copy) {
+  // Code and mapping tables are native pointers: only the references move.
   FixupInstanceFields(orig, copy);
-  LOG(ERROR) << "FFFFFFF DANGEROUS FFFFFFFFFFF << fixing up methods";
 }
-void SpaceCompactor::startCompaction(void) {
-  LOG(ERROR) << "Inside SpaceCompactor::startCompaction()";
 
+/*
+ * Copies the live objects of the alloc space into a new space in address
+ * order. Roots are visited read-only in this runtime (RootVisitor cannot
+ * return a new address), so the original space stays the one in use: the
+ * compacted space shows how much a compaction gives back and is released by
+ * FinalizeCompaction().
+ */
+void SpaceCompactor::startCompaction(void) {
   Runtime* runtime = Runtime::Current();
-  if(true) {
   // We only want reachable instances, so do a GC. This also ensures that the alloc stack
   // is empty, so the live bitmap is the only place we need to look.
   Thread* self = Thread::Current();
-  {
-    //ReaderMutexLock mu(self, *Locks::mutator_lock_);
-    //self->TransitionFromRunnableToSuspended(kNative);
-    local_heap_->CollectGarbage(true);
-    //self->TransitionFromSuspendedToRunnable();
-  }
-  LOG(ERROR) << "Done Non-Concurrent Collection: " << self->GetTid();
-  FragmentationInfo _frag_info;
-  _frag_info.max_ = 0;
-  _frag_info.sum_ = 0;
-
-  for (const auto& space : local_heap_->GetContinuousSpaces()) {
-    if (space->IsZygoteSpace()) {
-      space->AsDlMallocSpace()->Walk(MSpaceSumFragChunkCallback, &_frag_info);
-      LOG(ERROR) << "XXXX Fragmentation zygote space = " << _frag_info.max_ << ", " << _frag_info.sum_;
-      break;
-    }
-  }
+  local_heap_->CollectGarbage(true);
+  MeasureFragmentation(original_space_, &frag_before_);
 
-  _frag_info.max_ = 0;
-  _frag_info.sum_ = 0;
-  original_space_->Walk(MSpaceSumFragChunkCallback, &_frag_info);
-
-  LOG(ERROR) << "XXXX Fragmentation before Compaction = " << _frag_info.max_ << ", " << _frag_info.sum_;
   ThreadList* thread_list = runtime->GetThreadList();
   thread_list->SuspendAll();
   {
-
     ReaderMutexLock mu(self, *Locks::heap_bitmap_lock_);
     local_heap_->DisableObjectValidation();
 
-    size_t capacity = original_space_->Capacity();
-    original_space_->SetEnd(reinterpret_cast<byte*>(RoundUp(reinterpret_cast<uintptr_t>(original_space_->End()), kPageSize)));
-    original_space_->Trim();
-    original_space_->GetMemMap()->UnMapAtEnd(original_space_->End());
-
-    _frag_info.max_ = 0;
-    _frag_info.sum_ = 0;
-        original_space_->Walk(MSpaceSumFragChunkCallback, &_frag_info);
-
-    LOG(ERROR) << "XXXX Fragmentation after trimming = " << _frag_info.max_ << ", " << _frag_info.sum_;
-
-    LOG(ERROR) << "original space size is: being:"
-        << reinterpret_cast<void*>(original_space_->Begin()) << ", end: " << reinterpret_cast<void*>(original_space_->End()) <<
-        ", capacity is:" << capacity << ", size is : " << original_space_->Size();
-
-    original_space_->GetLiveBitmap()->SetHeapLimit(reinterpret_cast<uintptr_t>(original_space_->End()));
-    original_space_->GetMarkBitmap()->SetHeapLimit(reinterpret_cast<uintptr_t>(original_space_->End()));
-      compact_space_ = gc::space::DlMallocSpace::Create("compacted_space",
-                                                          original_space_->Size(),
-                                                          capacity, capacity,
-                                                          original_space_->End(), false);
-      LOG(ERROR) << "new dlmalloc space size is: being:"
-          << reinterpret_cast<void*>(compact_space_->Begin()) << ", end: " << reinterpret_cast<void*>(compact_space_->End()) <<
-          ", capacity is:" << compact_space_->Capacity();
-      byte_start_ = original_space_->Begin();
-      byte_end_ = original_space_->End();
-      immune_begin_ = reinterpret_cast<mirror::Object*>(original_space_->Begin());
-      immune_end_ = reinterpret_cast<mirror::Object*>(original_space_->End());
-      accounting::SPACE_BITMAP* _live_bitmap =
-          original_space_->GetLiveBitmap();
-      CompactVisitor compact_visitor(this);
-      _live_bitmap->VisitMarkedRange(_live_bitmap->HeapBegin(),
-                                     _live_bitmap->HeapLimit(),
-                                     compact_visitor);
-
-
-
-
-      LOG(ERROR) << "Start copying and fixing Objects";
-      LOG(ERROR) << "...compacted count = " << compacted_cnt_;
-      int _count = 0;
-      for(const auto& ref : forwarded_objects_) {
-        const byte* src = reinterpret_cast<const byte*>(ref.first);
-        byte* dst = reinterpret_cast<byte*>(ref.second);
-        size_t n = ref.first->SizeOf();
-
-        memcpy(dst, src, n);
-
-        LOG(ERROR) << "++ fixing: "<<  _count << ", "
-            << reinterpret_cast<const void*>(ref.first)
-            << ", to " << reinterpret_cast<const void*>(ref.second)
-            << ", size: " << n;
-        _count++;
-        FixupObject(ref.first,ref.second);
-//        if (ref.first->IsClass()) {
-//
-//        }
-//        const mirror::Object* _origin_class = reinterpret_cast<mirror::Object*>(ref.first->GetClass());
-//        bool ismapped = false;
-//        const mirror::Object* new_addr =
-//            MapValueToServer<mirror::Object>(_origin_class, &ismapped);
-//        if(ismapped) {
-////          const byte* _raw_address = reinterpret_cast<const byte*>(_origin_class);
-//          (const_cast<mirror::Object*>(ref.second))->SetClass(down_cast<mirror::Class*>(const_cast<mirror::Object*>(new_addr)));
-//          LOG(ERROR) << "correcting class of object.." <<
-//              reinterpret_cast<const void*>(ref.first) <<
-//              ", old_class=" << reinterpret_cast<const void*>(_origin_class) <<
-//              ", new_class=" << reinterpret_cast<const void*>(new_addr);
-//        }
-//
-//
-//        LOG(ERROR) << "fwd.. Obj:" << ref.first << ", fwded:" << ref.second <<
-//            ", size=" << n;
-
-
-      }
-
-      LOG(ERROR) << "Start Check Fragmentation";
-      if(false) {
-      _frag_info.max_ = 0;
-      _frag_info.sum_ = 0;
-      mspace_inspect_all(compact_space_->GetMspace(),
-                         MSpaceSumFragChunkCallback,  &_frag_info);
-      MSpaceSumFragChunkCallback(NULL, NULL, 0, &_frag_info);
-      }
-     // MSpaceSumFragChunkCallback(NULL, NULL, 0, &postFragmentation);  // Indicate end of a space.
-//      compact_space_->Walk(MSpaceSumFragChunkCallback, &postFragmentation);
-
-      LOG(ERROR) << "Fragmentation post Compaction = "  << _frag_info.max_ << ", " << _frag_info.sum_;
-      LOG(ERROR) << "Done copying and fixing Objects";
-    //here we should copy and fix all broken references;
-
+    byte_start_ = original_space_->Begin();
+    byte_end_ = original_space_->End();
+    immune_begin_ = reinterpret_cast<mirror::Object*>(byte_start_);
+    immune_end_ = reinterpret_cast<mirror::Object*>(byte_end_);
+    size_t _compact_size = RoundUp(original_space_->GetBytesAllocated() +
+                                   original_space_->GetBytesAllocated() / 8 + kPageSize,
+                                   kPageSize);
+    compact_space_ = gc::space::DlMallocSpace::Create("compacted_space",
+                                                      _compact_size, _compact_size,
+                                                      _compact_size, NULL, false);
+    CHECK(compact_space_ != NULL);
+
+    PlanForwarding();
+    FillNewObjects(self);
+    MeasureFragmentation(compact_space_, &frag_after_);
   }
+  local_heap_->EnableObjectValidation();
   thread_list->ResumeAll();
-  }
 }
 
 void SpaceCompactor::FinalizeCompaction(void) {
-  LOG(ERROR) << "compacted count = " << compacted_cnt_;
-  for(const auto& ref : forwarded_objects_) {
-//    const byte* src = reinterpret_cast<const byte*>(ref.first);
-//    byte* dst = reinterpret_cast<byte*>(ref.second);
-//    memcpy(dst, src, 8);
-    LOG(ERROR) << "fwd.. Obj:" << ref.first << ", fwded:" << ref.second;
-  }
+  LOG(INFO) << "SpaceCompactor: compacted " << compacted_cnt_ << " objects, "
+      << PrettySize(compacted_bytes_) << " from " << PrettySize(original_space_->Size())
+      << "; free chunks before: " << PrettySize(frag_before_.sum_) << " (largest "
+      << PrettySize(frag_before_.max_) << "), after: " << PrettySize(frag_after_.sum_)
+      << "; plan " << PrettyDuration(plan_ns_) << ", fixup " << PrettyDuration(fixup_ns_);
+  delete compact_space_;
+  compact_space_ = NULL;
 }
 
 
@@ -8,30 +8,102 @@
 #ifndef ART_RUNTIME_GC_COLLECTOR_COMPACTOR_H_
 #define ART_RUNTIME_GC_COLLECTOR_COMPACTOR_H_
 
+#include <vector>
+
 #include "gc/heap.h"
 #include "gc/space/dlmalloc_space.h"
 #include "mirror/object-inl.h"
 #include "gc/accounting/gc_allocator.h"
+#include "gc/accounting/space_bitmap.h"
 
 namespace art {
 namespace gc {
 
 namespace collector {
 
+typedef struct FragmentationInfo_S {
+  uint64_t sum_;
+  uint64_t max_;
+}FragmentationInfo;
+
+
+/*
+ * Forwarding addresses of the live objects of a space kept in a dense side
+ * table indexed by the live bitmap instead of a map keyed by object.
+ * ranks_ holds for each bitmap word the number of live objects below that
+ * word. The rank of an object is the base of its word plus the popcount of
+ * the bits of the lower addresses in the word, and forwarded_ holds the new
+ * address of the objects by rank.
+ */
+class ForwardingTable {
+ public:
+  ForwardingTable() : heap_begin_(0), bitmap_words_(NULL) {}
+
+  // Computes ranks_ of the objects below heap_end; returns the live count.
+  size_t Build(const accounting::SPACE_BITMAP* bitmap, uintptr_t heap_end);
+
+  size_t Rank(const mirror::Object* obj) const {
+    const uintptr_t _offset = reinterpret_cast<uintptr_t>(obj) - heap_begin_;
+    const size_t _index = accounting::SPACE_BITMAP::OffsetToIndex(_offset);
+    const uintptr_t _mask =
+        static_cast<uintptr_t>(accounting::SPACE_BITMAP::OffsetToMask(_offset));
+    // Objects at lower addresses own the higher bits of the word.
+    const uintptr_t _lower =
+        static_cast<uintptr_t>(bitmap_words_[_index]) & ~((_mask << 1) - 1);
+    return ranks_[_index] + __builtin_popcountl(_lower);
+  }
+
+  void SetForwarded(size_t rank, mirror::Object* obj) {
+    forwarded_[rank] = obj;
+  }
+
+  // NULL for objects that were not live when the table was built, such as
+  // the ones allocated after the last GC that are still on the alloc stack.
+  mirror::Object* Lookup(const mirror::Object* obj) const {
+    const uintptr_t _offset = reinterpret_cast<uintptr_t>(obj) - heap_begin_;
+    const size_t _index = accounting::SPACE_BITMAP::OffsetToIndex(_offset);
+    if (_index >= ranks_.size() ||
+        (static_cast<uintptr_t>(bitmap_words_[_index]) &
+         static_cast<uintptr_t>(accounting::SPACE_BITMAP::OffsetToMask(_offset))) == 0) {
+      return NULL;
+    }
+    const size_t _rank = Rank(obj);
+    return (_rank < forwarded_.size()) ? forwarded_[_rank] : NULL;
+  }
+
+  size_t Size(void) const {
+    return forwarded_.size();
+  }
+
+ private:
+  uintptr_t heap_begin_;
+  const word* bitmap_words_;
+  std::vector<uint32_t, accounting::GCAllocator<uint32_t> > ranks_;
+  std::vector<mirror::Object*, accounting::GCAllocator<mirror::Object*> > forwarded_;
+
+  DISALLOW_COPY_AND_ASSIGN(ForwardingTable);
+};//class ForwardingTable
+
+
+/*
+ * Profiler experiment, not a compaction mode: builds a compacted copy of the
+ * alloc space to measure what a compaction would give back and how long the
+ * forwarding and fixup passes take. Roots are not relocated, the copy never
+ * replaces the alloc space and Heap never runs it; FinalizeCompaction()
+ * reports the numbers and releases the copy.
+ */
 class SpaceCompactor {
  public:
   Heap* local_heap_;
   uint64_t objects_cnt_;
   uint64_t compacted_cnt_;
+  uint64_t compacted_bytes_;
 
   space::DLMALLOC_SPACE_T* original_space_;
   space::DLMALLOC_SPACE_T* compact_space_;
 
-  typedef   SafeMap<const mirror::Object*, mirror::Object*, std::less<const mirror::Object*>,
-      gc::accounting::GCAllocator<std::pair<const mirror::Object*, mirror::Object*> >> FwdedOBJs;
-
-  // Map of Object to where it will be at runtime.
-  FwdedOBJs forwarded_objects_;
+  // New address of each live object of original_space_.
+  ForwardingTable forwarded_objects_;
   // Immune range, every object inside the immune range is assumed to be marked.
   mirror::Object* immune_begin_;
   mirror::Object* immune_end_;
@@ -39,14 +111,28 @@ class SpaceCompactor {
   byte* byte_start_;
   byte* byte_end_;
 
-
+  FragmentationInfo frag_before_;
+  FragmentationInfo frag_after_;
+  uint64_t plan_ns_;
+  uint64_t fixup_ns_;
 
   SpaceCompactor(Heap*);
+  ~SpaceCompactor();
+
+  // Sums the free chunks of the space and records the largest one.
+  static void MeasureFragmentation(space::DLMALLOC_SPACE_T* space,
+                                   FragmentationInfo* frag_info);
+
   void allocateSpaceObject(const mirror::Object* obj,
                            size_t obj_size);
   //initialize compaction which start by stopping the world
   void startCompaction(void);
-  void FillNewObjects(void);
+  // Allocates the new location of every live object, in address order.
+  void PlanForwarding(void)
+          EXCLUSIVE_LOCKS_REQUIRED(Locks::mutator_lock_);
+  // Copies the live objects and fixes their references on the heap thread pool.
+  void FillNewObjects(Thread* self)
+          EXCLUSIVE_LOCKS_REQUIRED(Locks::mutator_lock_);
 
   void FinalizeCompaction(void);
 
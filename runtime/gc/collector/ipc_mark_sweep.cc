@@ -26,6 +26,8 @@
 #include "gc/accounting/heap_bitmap.h"
 #include "gc/accounting/space_bitmap-inl.h"
 #include "gc/accounting/space_bitmap.h"
+#include "class_linker.h"
+#include "runtime.h"
 #include "mirror/class-inl.h"
 #include "mirror/class_loader.h"
 #include "mirror/dex_cache.h"
@@ -2036,6 +2038,8 @@ void IPCMarkSweep::FinishPhase(void) {
   IPC_MS_VLOG(INFO) << "_______IPCMarkSweep::FinishPhase. starting: _______ " <<
       currThread->GetTid() << "; phase:" << meta_data_->gc_phase_;
   MarkSweep::FinishPhase();
+  IPC_MS_VLOG(INFO) << "IPCMarkSweep::FinishPhase: mark stack peak depth = " <<
+      mark_stack_->GetLastPeakDepth() << ", capacity = " << mark_stack_->Capacity();
 
 
   // IncTotalTimeNs(GetDurationNs());
@@ -2159,6 +2163,8 @@ void IPCMarkSweep::MarkingPhase(void) {
   // Process dirty cards and add dirty cards to mod union tables.
   ipc_heap_->local_heap_->ProcessCards(timings_);
 
+  RevokeThreadLocalBuffers(currThread);
+
   // Need to do this before the checkpoint since we don't want any threads to add references to
   // the live stack during the recursive mark.
   timings_.NewSplit("SwapStacks");
@@ -2214,6 +2220,9 @@ void IPCMarkSweep::HandshakeIPCSweepMarkingPhase(accounting::BaseHeapBitmap* hea
   IPC_MS_VLOG(INFO) << " #### IPCMarkSweep::HandshakeMarkingPhase. starting: _______ " <<
       currThread->GetTid() << "; phase:" << meta_data_->gc_phase_;
   //ipc_heap_->local_heap_->DumpSpaces();
+  android_atomic_release_store(
+      static_cast<int32_t>(Runtime::Current()->GetClassLinker()->NumLoadedClasses()),
+      &heap_meta_->loaded_classes_count_);
   UpdateGCPhase(currThread, space::IPC_GC_PHASE_MARK_REACHABLES);
   int _synchronized = 0;
   if((_synchronized = android_atomic_release_load(&(server_synchronize_))) == 1) {
@@ -49,27 +49,58 @@ byte* IPCServerMarkerSweep::GetClientSpaceBegin(int index) const {
 //
 //}
 
+inline int IPCServerMarkerSweep::ClientSpaceIndex(
+                                          const void* client_address) const {
+  const uintptr_t _addr = reinterpret_cast<uintptr_t>(client_address);
+  // Unsigned wrap-around folds both range bounds into one compare.
+  const int _in_image = (_addr - translation_.client_begin_[KGCSpaceServerImageInd_]) <
+      translation_.client_size_[KGCSpaceServerImageInd_];
+  const int _in_zygote = (_addr - translation_.client_begin_[KGCSpaceServerZygoteInd_]) <
+      translation_.client_size_[KGCSpaceServerZygoteInd_];
+  const int _in_alloc = (_addr - translation_.client_begin_[KGCSpaceServerAllocInd_]) <
+      translation_.client_size_[KGCSpaceServerAllocInd_];
+  // The spaces do not overlap so at most one flag is set.
+  return _in_image * KGCSpaceServerImageInd_ + _in_zygote * KGCSpaceServerZygoteInd_ +
+      _in_alloc * KGCSpaceServerAllocInd_ +
+      (1 - (_in_image | _in_zygote | _in_alloc)) * kGCSrverTranslationSentinel;
+}
+
+inline int IPCServerMarkerSweep::ServerSpaceIndex(
+                                          const void* server_address) const {
+  const uintptr_t _addr = reinterpret_cast<uintptr_t>(server_address);
+  const int _in_image = (_addr - translation_.server_begin_[KGCSpaceServerImageInd_]) <
+      translation_.server_size_[KGCSpaceServerImageInd_];
+  const int _in_zygote = (_addr - translation_.server_begin_[KGCSpaceServerZygoteInd_]) <
+      translation_.server_size_[KGCSpaceServerZygoteInd_];
+  const int _in_alloc = (_addr - translation_.server_begin_[KGCSpaceServerAllocInd_]) <
+      translation_.server_size_[KGCSpaceServerAllocInd_];
+  return _in_image * KGCSpaceServerImageInd_ + _in_zygote * KGCSpaceServerZygoteInd_ +
+      _in_alloc * KGCSpaceServerAllocInd_ +
+      (1 - (_in_image | _in_zygote | _in_alloc)) * kGCSrverTranslationSentinel;
+}
+
+template <int kSpaceIndex, class referenceKlass>
+inline const referenceKlass* IPCServerMarkerSweep::TranslateToServer(
+                                      const referenceKlass* ref_parm) const {
+  if(kSpaceIndex == KGCSpaceServerImageInd_)
+    return ref_parm;
+  return reinterpret_cast<const referenceKlass*>(
+      reinterpret_cast<const byte*>(ref_parm) + translation_.to_server_[kSpaceIndex]);
+}
+
 template <class referenceKlass>
 inline const referenceKlass* IPCServerMarkerSweep::MapValueToServer(
                                       const uint32_t raw_address_value) const {
-//  if(raw_address_value == 0U)
-//    return nullptr;
   const byte* _raw_address = reinterpret_cast<const byte*>(raw_address_value);
   if(_raw_address == nullptr)
     return nullptr;
-
-  for(int i = KGCSpaceServerImageInd_; i <= KGCSpaceServerAllocInd_; i++) {
-    if((_raw_address < GetClientSpaceEnd(i)) &&
-        (_raw_address >= GetClientSpaceBegin(i))) {
-      if(i == KGCSpaceServerImageInd_)
-        return reinterpret_cast<const referenceKlass*>(_raw_address);
-      return reinterpret_cast<const referenceKlass*>(_raw_address + offset_);
-    }
+  const int _index = ClientSpaceIndex(_raw_address);
+  if(UNLIKELY(_index == kGCSrverTranslationSentinel)) {
+    LOG(FATAL) << "IPCServerMarkerSweep::MapValueToServer....0000--raw_Address_value:"
+        << raw_address_value;
   }
-
-  LOG(FATAL) << "IPCServerMarkerSweep::MapValueToServer....0000--raw_Address_value:"
-      << raw_address_value;
-  return nullptr;
+  return reinterpret_cast<const referenceKlass*>(_raw_address +
+      translation_.to_server_[_index]);
 }
 
 
@@ -79,36 +110,22 @@ uint32_t IPCServerMarkerSweep::MapReferenceToValueClient(
   if(mapped_reference == nullptr)
     return 0U;
   const byte* _raw_address = reinterpret_cast<const byte*>(mapped_reference);
-  for(int i = KGCSpaceServerImageInd_; i <= KGCSpaceServerAllocInd_; i++) {
-    if((_raw_address < GetServerSpaceEnd(i)) &&
-        (_raw_address >= GetServerSpaceBegin(i))) {
-      if(i == KGCSpaceServerImageInd_)
-        return reinterpret_cast<uint32_t>(_raw_address);
-      return reinterpret_cast<uint32_t>(_raw_address - offset_);
-    }
+  const int _index = ServerSpaceIndex(_raw_address);
+  if(UNLIKELY(_index == kGCSrverTranslationSentinel)) {
+    LOG(FATAL) << "IPCServerMarkerSweep::MapReferenceToValueClient....0000--raw_Address_value:"
+        << mapped_reference;
   }
-
-  LOG(FATAL) << "IPCServerMarkerSweep::MapReferenceToValueClient....0000--raw_Address_value:"
-      << mapped_reference;
-  return 0U;
+  return reinterpret_cast<uint32_t>(_raw_address - translation_.to_server_[_index]);
 }
 
 
 template <class referenceKlass>
 const referenceKlass* IPCServerMarkerSweep::MapReferenceToClient(
                                       const referenceKlass* const ref_parm) {
-  if(ref_parm == nullptr)
-    return nullptr;
+  // Addresses outside the spaces map to themselves through the sentinel.
   const byte* casted_param = reinterpret_cast<const byte*>(ref_parm);
-  for(int i = KGCSpaceServerImageInd_; i <= KGCSpaceServerAllocInd_; i++) {
-    if((casted_param < GetServerSpaceEnd(i)) &&
-        (casted_param >= GetServerSpaceBegin(i))) {
-      if(i == KGCSpaceServerImageInd_)
-        return ref_parm;
-      return reinterpret_cast<const referenceKlass*>(casted_param - offset_);
-    }
-  }
-  return ref_parm;
+  return reinterpret_cast<const referenceKlass*>(casted_param -
+      translation_.to_server_[ServerSpaceIndex(casted_param)]);
 }
 
 
@@ -129,44 +146,29 @@ inline const referenceKlass* IPCServerMarkerSweep::MapReferenceToClientChecks(
   if(ref_parm == nullptr)
     return nullptr;
   const byte* casted_param = reinterpret_cast<const byte*>(ref_parm);
-  for(int i = KGCSpaceServerImageInd_; i <= KGCSpaceServerAllocInd_; i++) {
-    if((casted_param < GetServerSpaceEnd(i)) &&
-        (casted_param >= GetServerSpaceBegin(i))) {
-      if(i == KGCSpaceServerImageInd_)
-        return ref_parm;
-      return reinterpret_cast<const referenceKlass*>(casted_param - offset_);
-    }
+  const int _index = ServerSpaceIndex(casted_param);
+  if(UNLIKELY(_index == kGCSrverTranslationSentinel)) {
+    LOG(FATAL) << "..... MapReferenceToClientChecks: .." << ref_parm;
   }
-  LOG(FATAL) << "..... MapReferenceToClientChecks: .." << ref_parm;
-  return ref_parm;
+  return reinterpret_cast<const referenceKlass*>(casted_param -
+      translation_.to_server_[_index]);
 }
 
 
 template <class referenceKlass>
 const referenceKlass* IPCServerMarkerSweep::MapReferenceToServerChecks(
                                       const referenceKlass* const ref_parm) {
-  if(!BelongsToOldHeap<referenceKlass>(ref_parm)) {
-    LOG(FATAL) << "..... MapReferenceToServer: ERROR00.." << ref_parm;
-  }
   if(ref_parm == nullptr)
     return ref_parm;
   const byte* casted_param = reinterpret_cast<const byte*>(ref_parm);
-//  if(casted_param < GetClientSpaceEnd(KGCSpaceServerImageInd_)) {
-//    return ref_parm;
-//  }
-  for(int i = KGCSpaceServerImageInd_; i <= KGCSpaceServerAllocInd_; i++) {
-    if((casted_param < GetClientSpaceEnd(i)) &&
-        (casted_param >= GetClientSpaceBegin(i))) {
-      if(i == KGCSpaceServerImageInd_)
-        return ref_parm;
-      return reinterpret_cast<const referenceKlass*>(casted_param + offset_);
-    }
+  const int _index = ClientSpaceIndex(casted_param);
+  if(UNLIKELY(_index == kGCSrverTranslationSentinel ||
+      !IsAligned<kObjectAlignment>(ref_parm))) {
+    LOG(FATAL) << "..... MapReferenceToServerChecks: ERROR001.." << ref_parm <<
+        ", casted_param  = " << casted_param;
   }
-
-  LOG(FATAL) << "..... MapReferenceToServerChecks: ERROR001.." << ref_parm <<
-      ", casted_param  = " << casted_param;
-
-  return nullptr;
+  return reinterpret_cast<const referenceKlass*>(casted_param +
+      translation_.to_server_[_index]);
 }
 
 
@@ -174,22 +176,9 @@ const referenceKlass* IPCServerMarkerSweep::MapReferenceToServerChecks(
 template <class referenceKlass>
 const referenceKlass* IPCServerMarkerSweep::MapReferenceToServer(
                                         const referenceKlass* const ref_parm) {
-
-  if(ref_parm == nullptr)
-    return ref_parm;
   const byte* casted_param = reinterpret_cast<const byte*>(ref_parm);
-
-  for(int i = KGCSpaceServerImageInd_; i <= KGCSpaceServerAllocInd_; i++) {
-    if((casted_param < GetClientSpaceEnd(i)) &&
-        (casted_param >= GetClientSpaceBegin(i))) {
-      if(i == KGCSpaceServerImageInd_)
-        return ref_parm;
-      return reinterpret_cast<const referenceKlass*>(casted_param + offset_);
-    }
-  }
-
-  //LOG(ERROR) << "..... MapReferenceToServer: ERROR001.." << ref_parm;
-  return ref_parm;
+  return reinterpret_cast<const referenceKlass*>(casted_param +
+      translation_.to_server_[ClientSpaceIndex(casted_param)]);
 }
 
 template <class TypeRef>
@@ -197,17 +186,7 @@ bool IPCServerMarkerSweep::BelongsToServerHeap(
                                         const TypeRef* const ptr_param) const {
   if(ptr_param == nullptr)
     return true;
-  const byte* casted_param = reinterpret_cast<const byte*>(ptr_param);
-//  if(casted_param < GetServerSpaceEnd(KGCSpaceServerImageInd_)) {
-//    return true;
-//  }
-  for(int i = KGCSpaceServerImageInd_; i <= KGCSpaceServerAllocInd_; i++) {
-    if((casted_param < GetServerSpaceEnd(i)) &&
-        (casted_param >= GetServerSpaceBegin(i))) {
-      return true;
-    }
-  }
-  return false;
+  return ServerSpaceIndex(ptr_param) != kGCSrverTranslationSentinel;
 }
 
 
@@ -218,17 +197,7 @@ bool IPCServerMarkerSweep::IsMappedObjectToServer(
     return true;
   if(!IsAligned<kObjectAlignment>(ptr_param))
     return false;
-  const byte* casted_param = reinterpret_cast<const byte*>(ptr_param);
-//  if(casted_param < GetServerSpaceEnd(KGCSpaceServerImageInd_)) {
-//    return true;
-//  }
-  for(int i = KGCSpaceServerImageInd_; i <= KGCSpaceServerAllocInd_; i++) {
-    if((casted_param < GetServerSpaceEnd(i)) &&
-        (casted_param >= GetServerSpaceBegin(i))) {
-      return true;
-    }
-  }
-  return false;
+  return ServerSpaceIndex(ptr_param) != kGCSrverTranslationSentinel;
 }
 
 
@@ -239,17 +208,7 @@ bool IPCServerMarkerSweep::IsMappedObjectToAllocationSpace(
     return false;
   if(!IsAligned<kObjectAlignment>(ptr_param))
     return false;
-  const byte* casted_param = reinterpret_cast<const byte*>(ptr_param);
-//  if(casted_param < GetServerSpaceEnd(KGCSpaceServerImageInd_)) {
-//    return true;
-//  }
-  for(int i = KGCSpaceServerAllocInd_; i <= KGCSpaceServerAllocInd_; i++) {
-    if((casted_param < GetServerSpaceEnd(i)) &&
-        (casted_param >= GetServerSpaceBegin(i))) {
-      return true;
-    }
-  }
-  return false;
+  return ServerSpaceIndex(ptr_param) == KGCSpaceServerAllocInd_;
 }
 
 template <class referenceKlass>
@@ -259,17 +218,7 @@ bool IPCServerMarkerSweep::BelongsToOldHeap(
     return true;
   if(!IsAligned<kObjectAlignment>(ptr_param))
     return false;
-  const byte* casted_param = reinterpret_cast<const byte*>(ptr_param);
-//  if(casted_param < GetClientSpaceEnd(KGCSpaceServerImageInd_)) {
-//    return true;
-//  }
-  for(int i = KGCSpaceServerImageInd_; i <= KGCSpaceServerAllocInd_; i++) {
-    if((casted_param < GetClientSpaceEnd(i)) &&
-        (casted_param >= GetClientSpaceBegin(i))) {
-      return true;
-    }
-  }
-  return false;
+  return ClientSpaceIndex(ptr_param) != kGCSrverTranslationSentinel;
 }
 
 const mirror::Class* IPCServerMarkerSweep::GetMappedObjectKlass(
@@ -455,6 +404,57 @@ int IPCServerMarkerSweep::GetMappedClassType(const mirror::Class* klass) const {
   return 3;
 }
 
+bool IPCServerMarkerSweep::IsMappedClassResolved(
+                                      const mirror::Class* mapped_klass) const {
+  int32_t _raw_status =
+      mirror::Object::GetRawValueFromObject(
+          reinterpret_cast<const mirror::Object*>(mapped_klass),
+          mirror::Class::StatusOffset());
+  return _raw_status >= mirror::Class::kStatusResolved;
+}
+
+inline void IPCServerMarkerSweep::GetMappedClassInfo(
+                                      const mirror::Class* mapped_klass,
+                                      GCSrverMappedClassInfo* klass_info) {
+  GCSrverMappedClassInfo* _entry = &class_cache_[
+      (reinterpret_cast<uintptr_t>(mapped_klass) / kObjectAlignment) &
+          (kClassCacheSize - 1)];
+  // Several marking workers share the cache. Readers retry through the slow
+  // path if a writer held the entry while they copied it.
+  int32_t _seq = android_atomic_acquire_load(&_entry->seq_);
+  if((_seq & 1) == 0 && _entry->mapped_klass_ == mapped_klass) {
+    klass_info->access_flags_ = _entry->access_flags_;
+    klass_info->reference_instance_offsets_ = _entry->reference_instance_offsets_;
+    klass_info->class_type_ = _entry->class_type_;
+    ANDROID_MEMBAR_FULL();
+    if(android_atomic_acquire_load(&_entry->seq_) == _seq) {
+      IncMarkCounter(&cashed_stats_client_.class_cache_hits_);
+      return;
+    }
+  }
+  IncMarkCounter(&cashed_stats_client_.class_cache_misses_);
+  klass_info->mapped_klass_ = mapped_klass;
+  klass_info->access_flags_ = GetClassAccessFlags(mapped_klass);
+  klass_info->reference_instance_offsets_ =
+      mirror::Object::GetRawValueFromObject(
+          reinterpret_cast<const mirror::Object*>(mapped_klass),
+          mirror::Class::GetReferenceInstanceOffsetsOffset());
+  klass_info->class_type_ = GetMappedClassType(mapped_klass);
+  // A class still being linked may change its flags and offsets.
+  if(!IsMappedClassResolved(mapped_klass))
+    return;
+  if((_seq & 1) != 0 ||
+      android_atomic_acquire_cas(_seq, _seq + 1, &_entry->seq_) != 0) {
+    // Another worker is filling the entry.
+    return;
+  }
+  _entry->mapped_klass_ = mapped_klass;
+  _entry->access_flags_ = klass_info->access_flags_;
+  _entry->reference_instance_offsets_ = klass_info->reference_instance_offsets_;
+  _entry->class_type_ = klass_info->class_type_;
+  android_atomic_release_store(_seq + 2, &_entry->seq_);
+}
+
 inline void IPCServerMarkerSweep::MarkObject(const mirror::Object* obj) {
   if (obj != NULL) {
     MarkObjectNonNull(obj);
@@ -535,7 +535,12 @@ void IPCServerMarkerSweep::ServerDelayReferenceReferent(
                                                       ref_referent_off_client_);
   const mirror::Object* mapped_referent =
       MapValueToServer<mirror::Object>(referent_raw_value);
-  if (mapped_referent != nullptr && !IsMappedObjectMarked(mapped_referent)) {//TODO: Implement ismarked
+  if (mapped_referent == nullptr) {
+    return;
+  }
+  // The lists are shared by all the marking workers.
+  MutexLock mu(Thread::Current(), references_lock_);
+  if (!IsMappedObjectMarked(mapped_referent)) {//TODO: Implement ismarked
     cashed_stats_client_.reference_count_ += 1;
     //Thread* self = Thread::Current();
     bool is_enqueued_object = IsMappedReferentEnqueued(obj);
@@ -636,11 +641,28 @@ bool IPCServerMarkerSweep::ServerScanObjectVisitRemoval(const mirror::Object* ob
 template <typename MarkVisitor>
 void IPCServerMarkerSweep::ServerScanObjectVisit(const mirror::Object* obj,
     const MarkVisitor& visitor) {
-//  if(!BelongsToOldHeap<mirror::Object>(obj)) {
-//    LOG(FATAL) << "MAPPINGERROR: XXXXXXX does not belong to Heap XXXXXXXXX";
-//  }
+  // Resolve the space once; the scan itself then uses a constant offset.
+  switch(ClientSpaceIndex(obj)) {
+    case KGCSpaceServerAllocInd_:
+      ServerScanSpaceObjectVisit<KGCSpaceServerAllocInd_>(obj, visitor);
+      break;
+    case KGCSpaceServerZygoteInd_:
+      ServerScanSpaceObjectVisit<KGCSpaceServerZygoteInd_>(obj, visitor);
+      break;
+    case KGCSpaceServerImageInd_:
+      ServerScanSpaceObjectVisit<KGCSpaceServerImageInd_>(obj, visitor);
+      break;
+    default:
+      LOG(FATAL) << "MAPPINGERROR: XXXXXXX does not belong to Heap XXXXXXXXX " << obj;
+  }
+}
+
+template <int kSpaceIndex, typename MarkVisitor>
+void IPCServerMarkerSweep::ServerScanSpaceObjectVisit(const mirror::Object* obj,
+    const MarkVisitor& visitor) {
+  DCHECK(IsAligned<kObjectAlignment>(obj)) << obj;
   const mirror::Object* mapped_object =
-                                MapReferenceToServerChecks<mirror::Object>(obj);
+                                TranslateToServer<kSpaceIndex>(obj);
 
 
 
@@ -665,9 +687,11 @@ void IPCServerMarkerSweep::ServerScanObjectVisit(const mirror::Object* obj,
 //    LOG(FATAL) << "..... ServerScanObjectVisit: ERROR03";
 //  }
 
-  int mapped_class_type = GetMappedClassType(mapped_klass);
+  GCSrverMappedClassInfo _klass_info;
+  GetMappedClassInfo(mapped_klass, &_klass_info);
+  int mapped_class_type = _klass_info.class_type_;
   if (UNLIKELY(mapped_class_type < 2)) {
-    cashed_stats_client_.array_count_ += 1;
+    IncMarkCounter(&cashed_stats_client_.array_count_);
     //android_atomic_add(1, &(array_count_));
     if(mapped_class_type == 0) {
       ServerVisitObjectArrayReferences(
@@ -675,13 +699,17 @@ void IPCServerMarkerSweep::ServerScanObjectVisit(const mirror::Object* obj,
                                                                     visitor);
     }
   } else if (UNLIKELY(mapped_class_type == 2)) {
-    cashed_stats_client_.class_count_ += 1;
-    ServerVisitClassReferences(mapped_klass, mapped_object, visitor);
+    IncMarkCounter(&cashed_stats_client_.class_count_);
+    ServerVisitFieldsReferences(mapped_object,
+        _klass_info.reference_instance_offsets_, false, visitor);
+    ServerVisitStaticFieldsReferences(
+        down_cast<const mirror::Class*>(mapped_object), visitor);
   } else if (UNLIKELY(mapped_class_type == 3)) {
-    cashed_stats_client_.other_count_ += 1;
-    ServerVisitOtherReferences(mapped_klass, mapped_object, visitor);
-    if(UNLIKELY(IsReferenceMappedClass(mapped_klass))) {
-      is_reference_class_cnt_++;
+    IncMarkCounter(&cashed_stats_client_.other_count_);
+    ServerVisitFieldsReferences(mapped_object,
+        _klass_info.reference_instance_offsets_, false, visitor);
+    if(UNLIKELY((_klass_info.access_flags_ & kAccClassIsReference) != 0)) {
+      IncMarkCounter(&is_reference_class_cnt_);
       ServerDelayReferenceReferent(mapped_klass,
                                   const_cast<mirror::Object*>(mapped_object));
     }
@@ -1045,6 +1073,32 @@ inline void IPCServerMarkerSweep::MarkObjectNonNull(const mirror::Object* obj) {
     }
   }
 }
+
+inline const mirror::Object* IPCServerMarkerSweep::MarkObjectParallel(
+                                                  const mirror::Object* obj) {
+  DCHECK(obj != nullptr);
+  if (IsMappedObjectImmuned(obj)) {
+    return NULL;
+  }
+  accounting::SharedServerSpaceBitmap* object_bitmap = current_mark_bitmap_;
+  if (UNLIKELY(!object_bitmap->HasAddress(obj))) {
+    object_bitmap = NULL;
+    for (const auto& beetmap : mark_bitmaps_) {
+      if(beetmap->HasAddress(obj)) {
+        object_bitmap = beetmap;
+        break;
+      }
+    }
+    if(object_bitmap == NULL) {
+      LOG(FATAL) << "Object belongs to no Beetmaps.." << obj;
+    }
+  }
+  // Another worker may be marking the same object.
+  if(object_bitmap->AtomicTestAndSet(obj)) {
+    return NULL;
+  }
+  return MapReferenceToClientChecks(obj);
+}
 //
 //template <class TypeRef>
 //inline TypeRef* IPCServerMarkerSweep::ServerMapHeapReference(TypeRef* ptr_param) {
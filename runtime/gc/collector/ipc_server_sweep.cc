@@ -7,6 +7,7 @@
 
 
 
+#include <algorithm>
 #include <string>
 #include <cutils/ashmem.h>
 #include "globals.h"
@@ -93,13 +94,189 @@ class ServerMarkObjectVisitorRemoval {
 };
 
 
+/*
+ * A chunk of the client mark stack scanned by one of the marking workers.
+ * Entries are client addresses, same as in the shared mark stack. Workers
+ * that run out of work steal the bottom half of the chunk of a running task.
+ */
+class ServerMarkStackTask : public WorkStealingTask {
+ public:
+  static const size_t kMaxSize = 1 * KB;
+  // Number of entries popped from the chunk per lock acquisition.
+  static const size_t kScanBatchSize = 32;
+
+  ServerMarkStackTask(ThreadPool* thread_pool, IPCServerMarkerSweep* mark_sweep,
+                      size_t mark_stack_size, mirror::Object** mark_stack)
+      : mark_sweep_(mark_sweep),
+        thread_pool_(thread_pool),
+        stack_lock_("server mark stack task lock"),
+        mark_stack_pos_(mark_stack_size),
+        pushed_pos_(0) {
+    if (mark_stack_size != 0) {
+      DCHECK(mark_stack != NULL);
+      std::copy(mark_stack, mark_stack + mark_stack_size, mark_stack_);
+    }
+    android_atomic_inc(&mark_sweep_->mark_chunks_created_);
+  }
+
+  virtual ~ServerMarkStackTask() {
+    DCHECK_EQ(mark_stack_pos_, 0U);
+    DCHECK_EQ(pushed_pos_, 0U);
+    android_atomic_inc(&mark_sweep_->mark_chunks_deleted_);
+  }
+
+  class ScanObjectParallelVisitor {
+   public:
+    explicit ScanObjectParallelVisitor(ServerMarkStackTask* chunk_task) ALWAYS_INLINE
+        : chunk_task_(chunk_task) {}
+
+    void operator()(const mirror::Object* /* obj */, const mirror::Object* ref,
+                    MemberOffset& /* offset */, bool /* is_static */) const ALWAYS_INLINE
+        NO_THREAD_SAFETY_ANALYSIS {
+      if (ref != NULL) {
+        const mirror::Object* client_ref =
+            chunk_task_->mark_sweep_->MarkObjectParallel(ref);
+        if (client_ref != NULL) {
+          chunk_task_->Push(client_ref);
+        }
+      }
+    }
+
+   private:
+    ServerMarkStackTask* const chunk_task_;
+  };
+
+  virtual void Run(Thread* self) {
+    Drain(self);
+  }
+
+  // Called on a task that finished its own chunk.
+  virtual void StealFrom(Thread* self, WorkStealingTask* source) {
+    ServerMarkStackTask* _victim = down_cast<ServerMarkStackTask*>(source);
+    size_t _stolen = 0;
+    {
+      MutexLock mu(self, _victim->stack_lock_);
+      _stolen = _victim->mark_stack_pos_ / 2;
+      if (_stolen == 0) {
+        return;
+      }
+      // Leave the top of the stack to the owner, it is about to scan it.
+      std::copy(_victim->mark_stack_, _victim->mark_stack_ + _stolen, mark_stack_);
+      std::copy(_victim->mark_stack_ + _stolen,
+                _victim->mark_stack_ + _victim->mark_stack_pos_, _victim->mark_stack_);
+      _victim->mark_stack_pos_ -= _stolen;
+    }
+    {
+      MutexLock mu(self, stack_lock_);
+      mark_stack_pos_ = _stolen;
+    }
+    android_atomic_inc(&mark_sweep_->mark_chunks_stolen_);
+    Drain(self);
+  }
+
+  virtual void Finalize() {
+    delete this;
+  }
+
+ private:
+  void Drain(Thread* self) {
+    ScanObjectParallelVisitor visitor(this);
+    const mirror::Object* _batch[kScanBatchSize];
+    for (;;) {
+      if (pushed_pos_ != 0) {
+        Publish(self);
+      }
+      size_t _batch_size = 0;
+      {
+        MutexLock mu(self, stack_lock_);
+        while (mark_stack_pos_ != 0 && _batch_size < kScanBatchSize) {
+          _batch[_batch_size++] = mark_stack_[--mark_stack_pos_];
+        }
+      }
+      if (_batch_size == 0) {
+        break;
+      }
+      for (size_t i = 0; i < _batch_size; i++) {
+        mark_sweep_->ServerScanObjectVisit(_batch[i], visitor);
+      }
+    }
+  }
+
+  // Newly marked objects are collected without the lock and published to the
+  // chunk once per batch.
+  void Push(const mirror::Object* obj) ALWAYS_INLINE {
+    if (UNLIKELY(pushed_pos_ == kMaxSize)) {
+      Publish(Thread::Current());
+    }
+    pushed_[pushed_pos_++] = const_cast<mirror::Object*>(obj);
+  }
+
+  void Publish(Thread* self) {
+    ServerMarkStackTask* _overflow_task = NULL;
+    {
+      MutexLock mu(self, stack_lock_);
+      if (mark_stack_pos_ + pushed_pos_ > kMaxSize) {
+        // Chunk overflow, give the pushed objects to the pool as a new task.
+        _overflow_task = new ServerMarkStackTask(thread_pool_, mark_sweep_,
+                                                 pushed_pos_, pushed_);
+      } else {
+        std::copy(pushed_, pushed_ + pushed_pos_, mark_stack_ + mark_stack_pos_);
+        mark_stack_pos_ += pushed_pos_;
+      }
+      pushed_pos_ = 0;
+    }
+    // The task queue lock is at the same level as stack_lock_.
+    if (_overflow_task != NULL) {
+      thread_pool_->AddTask(self, _overflow_task);
+    }
+  }
+
+  IPCServerMarkerSweep* const mark_sweep_;
+  ThreadPool* const thread_pool_;
+  // Guards mark_stack_ against the workers stealing from this task.
+  Mutex stack_lock_;
+  mirror::Object* mark_stack_[kMaxSize];
+  size_t mark_stack_pos_;
+  // Objects marked by the owner since the last publish. Only the owner
+  // touches them.
+  mirror::Object* pushed_[kMaxSize];
+  size_t pushed_pos_;
+};//class ServerMarkStackTask
+
+
+COMPILE_ASSERT(kGCSrverTranslationSentinel == IPCServerMarkerSweep::KGCSpaceCount,
+               translation_sentinel_must_follow_the_spaces);
+
+void IPCServerMarkerSweep::UpdateTranslationTable(void) {
+  for(int i = KGCSpaceServerImageInd_; i <= KGCSpaceServerAllocInd_; i++) {
+    translation_.client_begin_[i] = reinterpret_cast<uintptr_t>(GetClientSpaceBegin(i));
+    translation_.client_size_[i] =
+        reinterpret_cast<uintptr_t>(GetClientSpaceEnd(i)) - translation_.client_begin_[i];
+    translation_.server_begin_[i] = reinterpret_cast<uintptr_t>(GetServerSpaceBegin(i));
+    translation_.server_size_[i] =
+        reinterpret_cast<uintptr_t>(GetServerSpaceEnd(i)) - translation_.server_begin_[i];
+    // The image space is mapped at the same address in both processes.
+    translation_.to_server_[i] = (i == KGCSpaceServerImageInd_) ? 0 : offset_;
+  }
+  translation_.client_begin_[kGCSrverTranslationSentinel] = 0;
+  translation_.client_size_[kGCSrverTranslationSentinel] = 0;
+  translation_.server_begin_[kGCSrverTranslationSentinel] = 0;
+  translation_.server_size_[kGCSrverTranslationSentinel] = 0;
+  translation_.to_server_[kGCSrverTranslationSentinel] = 0;
+}
+
+void IPCServerMarkerSweep::ResetClassCache(void) {
+  memset(class_cache_, 0, sizeof(class_cache_));
+}
+
 void IPCServerMarkerSweep::ResetStats(void) {
   memset(&cashed_stats_client_, 0, sizeof(space::GCSrvceCashedStatsCounters));
   pushed_back_to_stack_ = 0;
 }
 
 IPCServerMarkerSweep::IPCServerMarkerSweep(
-    gc::service::GCServiceClientRecord* client_record) :
+    gc::service::GCServiceClientRecord* client_record,
+    ThreadPool* mark_workers_pool) :
         client_rec_(client_record),
         heap_meta_(&(client_rec_->sharable_space_->heap_meta_)),
         offset_(static_cast<int32_t>(SERVER_SWEEP_CALC_OFFSET(
@@ -109,6 +286,12 @@ IPCServerMarkerSweep::IPCServerMarkerSweep(
         current_mark_bitmap_(NULL),
         current_live_bitmap_(NULL),
         mark_stack_(NULL),
+        mark_workers_pool_(mark_workers_pool),
+        references_lock_("server sweep references lock"),
+        parallel_marking_(false),
+        mark_chunks_created_(0),
+        mark_chunks_deleted_(0),
+        mark_chunks_stolen_(0),
   ref_referent_off_client_(heap_meta_->reference_offsets_.reference_referent_offset_),
   ref_queue_off_client_(heap_meta_->reference_offsets_.reference_queue_offset_),
   ref_queueNext_off_client_(heap_meta_->reference_offsets_.reference_queueNext_offset_),
@@ -144,6 +327,9 @@ IPCServerMarkerSweep::IPCServerMarkerSweep(
   spaces_[KGCSpaceServerImageInd_].base_ = heap_meta_->image_space_begin_;
   spaces_[KGCSpaceServerImageInd_].base_end_ = heap_meta_->image_space_end_;
 
+  UpdateTranslationTable();
+  class_cache_generation_ = -1;
+  ResetClassCache();
 
 
   for(int i = KGCSpaceServerImageInd_; i <= KGCSpaceServerAllocInd_; i++) {
@@ -188,7 +374,17 @@ size_t ServerAllocationSizeNonvirtual(const mirror::Object* obj) {
 
 static void ServerAllocationSizeNonvirtual(const mirror::Object* obj,
                                            size_t* nonVirtualNonOverhead,
-                                           size_t* nonVirtualOverhead) {
+                                           size_t* nonVirtualOverhead,
+                                           const space::SlabAllocator::SlabAllocatorData* slab_data,
+                                           const byte* space_base) {
+  if (slab_data != NULL &&
+      space::SlabAllocator::IsSlabPage(slab_data,
+                                       reinterpret_cast<const byte*>(obj) - space_base)) {
+    // Slab objects have no boundary tag.
+    *nonVirtualNonOverhead = space::SlabAllocator::ObjectSize(obj);
+    *nonVirtualOverhead = *nonVirtualNonOverhead;
+    return;
+  }
   *nonVirtualNonOverhead = mspace_usable_size(const_cast<void*>(reinterpret_cast<const void*>(obj)));
   *nonVirtualOverhead = *nonVirtualNonOverhead + kWordSize;
 }
@@ -203,6 +399,14 @@ size_t IPCServerMarkerSweep::ServerFreeSpaceList(Thread* self, size_t num_ptrs,
   size_t bytes_freed_no_overhead = 0;
   size_t _lastFreedBytesNoOverheads = 0;
   size_t _lastFreedBytes = 0;
+  // The slab page map lives in the client space: read it through our mapping.
+  const byte* _space_base = spaces_[KGCSpaceServerAllocInd_].base_;
+  const space::SlabAllocator::SlabAllocatorData* _slab_data = NULL;
+  void* _client_slab_data = client_rec_->sharable_space_->dlmalloc_space_data_.slab_data_;
+  if (_client_slab_data != NULL) {
+    _slab_data = reinterpret_cast<const space::SlabAllocator::SlabAllocatorData*>(_space_base +
+        (reinterpret_cast<byte*>(_client_slab_data) - spaces_[KGCSpaceServerAllocInd_].client_base_));
+  }
   for (size_t i = 0; i < num_ptrs; i++) {
     mirror::Object* ptr = ptrs[i];
     const size_t look_ahead = 8;
@@ -210,7 +414,8 @@ size_t IPCServerMarkerSweep::ServerFreeSpaceList(Thread* self, size_t num_ptrs,
       // The head of chunk for the allocation is sizeof(size_t) behind the allocation.
       __builtin_prefetch(reinterpret_cast<char*>(ptrs[i + look_ahead]) - sizeof(size_t));
     }
-    ServerAllocationSizeNonvirtual(ptr, &_lastFreedBytesNoOverheads, &_lastFreedBytes);
+    ServerAllocationSizeNonvirtual(ptr, &_lastFreedBytesNoOverheads, &_lastFreedBytes,
+                                   _slab_data, _space_base);
     bytes_freed_no_overhead += _lastFreedBytesNoOverheads;
     bytes_freed += _lastFreedBytes;
 //    //GCMMP_HANDLE_FINE_PRECISE_FREE(AllocationNoOverhead(ptr),ptr);
@@ -317,7 +522,10 @@ void IPCServerMarkerSweep::SweepSpaces(space::GCSrvSharableCollectorData* collec
 //    LOG(ERROR) << " ===== IPCServerMarkerSweep::SweepSpaces " << _collection_type
 //        << StringPrintf("; begin = 0x%08x, end = 0x%08x, %s", begin, end, partial? "true" : "false");
 
+    size_t _committed_segments = mark_stack_->GetSegmentsCount();
     mark_stack_->Reset();
+    IPC_MS_VLOG(INFO) << " ===== IPCServerMarkerSweep::SweepSpaces: mark stack peak depth = "
+        << mark_stack_->GetLastPeakDepth() << ", committed segments = " << _committed_segments;
     ResetStats();
     ServerSweepCallbackContext _server_sweep_context;
 
@@ -542,6 +750,37 @@ static bool ExternalScanObjectVisitRemoval(mirror::Object* obj,
 
 
 
+void IPCServerMarkerSweep::ProcessMarckStackParallel(size_t thread_count) {
+  Thread* self = Thread::Current();
+  const size_t _initial_size = mark_stack_->Size();
+  const size_t _chunk_size = std::min(_initial_size / thread_count + 1,
+                                      ServerMarkStackTask::kMaxSize);
+  parallel_marking_ = true;
+  mark_chunks_created_ = 0;
+  mark_chunks_deleted_ = 0;
+  mark_chunks_stolen_ = 0;
+  // Split the mapped mark stack up into work tasks.
+  for (mirror::Object **it = mark_stack_->Begin(), **end = mark_stack_->End();
+      it < end; ) {
+    const size_t _delta = std::min(static_cast<size_t>(end - it), _chunk_size);
+    mark_workers_pool_->AddTask(self,
+        new ServerMarkStackTask(mark_workers_pool_, this, _delta, it));
+    it += _delta;
+  }
+  mark_stack_->PopBackCount(static_cast<int32_t>(_initial_size));
+  mark_workers_pool_->SetMaxActiveWorkers(thread_count - 1);
+  mark_workers_pool_->StartWorkers(self);
+  mark_workers_pool_->Wait(self, true, true);
+  mark_workers_pool_->StopWorkers(self);
+  parallel_marking_ = false;
+  CHECK_EQ(mark_chunks_created_, mark_chunks_deleted_)
+      << " some of the server mark chunks were leaked";
+  IPC_MS_VLOG(INFO) << " ===== IPCServerMarkerSweep::ProcessMarckStackParallel: threads = "
+      << thread_count << ", initial stack = " << _initial_size
+      << ", chunks = " << mark_chunks_created_
+      << ", steals = " << mark_chunks_stolen_;
+}
+
 void IPCServerMarkerSweep::ProcessMarckStack() {
   //LOG(ERROR) << "%%%%%%%%%%%%%%%%%%%%%%%";
   //LOG(ERROR) << "IPCServerMarkerSweep::ProcessMarckStack....size:" << mark_stack_->Size();
@@ -562,8 +801,13 @@ void IPCServerMarkerSweep::ProcessMarckStack() {
   //LOG(ERROR) << "Calculated offset..." <<  calculated_offset;
 
 
+  const size_t _thread_count = (mark_workers_pool_ == NULL) ? 1 :
+      mark_workers_pool_->GetThreadCount();
   const mirror::Object* popped_oject = NULL;
-  if(true) {
+  if(_thread_count > 1 &&
+      mark_stack_->Size() >= kMinimumParallelMarkStackSize) {
+    ProcessMarckStackParallel(_thread_count);
+  } else {
     for (;;) {
       if (mark_stack_->IsEmpty()) {
         break;
@@ -581,6 +825,9 @@ void IPCServerMarkerSweep::ProcessMarckStack() {
     mark_stack_->OperateRemovalOnStack(ExternalScanObjectVisitRemoval, this);
 
 
+  IPC_MS_VLOG(INFO) << " ===== IPCServerMarkerSweep::ProcessMarckStack: class cache hits = "
+      << cashed_stats_client_.class_cache_hits_ << ", misses = "
+      << cashed_stats_client_.class_cache_misses_;
   UpdateStatsRecord(&curr_collector_ptr_->cashed_stats_, &cashed_stats_client_, true);
   UpdateClientCachedReferences(&curr_collector_ptr_->cashed_references_,
       &cashed_references_client_);
@@ -637,6 +884,8 @@ void IPCServerMarkerSweep::UpdateStatsRecord(space::GCSrvceCashedStatsCounters*
     android_atomic_add(src->other_count_, &dest->other_count_);
     android_atomic_add(src->reference_count_, &dest->reference_count_);
     android_atomic_add(src->cards_scanned_, &dest->cards_scanned_);
+    android_atomic_add(src->class_cache_hits_, &dest->class_cache_hits_);
+    android_atomic_add(src->class_cache_misses_, &dest->class_cache_misses_);
     android_atomic_add(src->freed_objects_, &dest->freed_objects_);
     android_atomic_add(src->freed_bytes_, &dest->freed_bytes_);
   } else {
@@ -790,6 +1039,14 @@ bool IPCServerMarkerSweep::InitMarkingPhase(space::GCSrvSharableCollectorData* c
 
   SetMarkHolders(collector_addr);
   curr_collector_ptr_ = collector_addr;
+  UpdateTranslationTable();
+  const int32_t _loaded_classes =
+      android_atomic_acquire_load(&heap_meta_->loaded_classes_count_);
+  if(_loaded_classes != class_cache_generation_) {
+    // The client loaded classes since the last cycle.
+    ResetClassCache();
+    class_cache_generation_ = _loaded_classes;
+  }
 
 
   UpdateCurrentMarkBitmap();
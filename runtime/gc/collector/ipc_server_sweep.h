@@ -2,10 +2,13 @@
 #define ART_RUNTIME_GC_COLLECTOR_IPC_SERVER_SWEEP_H_
 
 
+#include "cutils/atomic.h"
 #include "ipcfs/ipcfs.h"
 #include "scoped_thread_state_change.h"
 #include "thread_state.h"
 #include "thread.h"
+#include "thread_pool.h"
+#include "base/mutex.h"
 #include "gc/service/global_allocator.h"
 #include "gc/space/space.h"
 #include "gc/heap.h"
@@ -32,6 +35,36 @@ typedef struct GCSrverCollectorSpace_S {
   byte* client_end_;
 } __attribute__((aligned(8))) GCSrverCollectorSpace;
 
+/*
+ * Translation table between the client and the server views of the shared
+ * spaces. Entries are indexed by space index; the extra slot at
+ * kGCSrverTranslationSentinel stands for addresses outside all the spaces and
+ * translates them to themselves.
+ */
+static const int kGCSrverTranslationSentinel = 3;
+typedef struct GCSrverTranslationTable_S {
+  uintptr_t client_begin_[kGCSrverTranslationSentinel + 1];
+  uintptr_t client_size_[kGCSrverTranslationSentinel + 1];
+  uintptr_t server_begin_[kGCSrverTranslationSentinel + 1];
+  uintptr_t server_size_[kGCSrverTranslationSentinel + 1];
+  // server address = client address + to_server_[index]
+  intptr_t to_server_[kGCSrverTranslationSentinel + 1];
+} __attribute__((aligned(8))) GCSrverTranslationTable;
+
+/*
+ * Metadata of a mapped client class, copied out of the Class object so that
+ * scanning an instance does not touch the class cache lines again.
+ * seq_ is odd while a worker fills the entry.
+ */
+typedef struct GCSrverMappedClassInfo_S {
+  volatile int32_t seq_;
+  const mirror::Class* mapped_klass_;
+  uint32_t access_flags_;
+  uint32_t reference_instance_offsets_;
+  // 0: object array, 1: primitive array, 2: java.lang.Class, 3: other.
+  int32_t class_type_;
+} GCSrverMappedClassInfo;
+
 
 class IPCServerMarkerSweep {
  public:
@@ -47,6 +80,12 @@ class IPCServerMarkerSweep {
   static const int KGCSpaceServerZygoteMarkBMInd_   = 5;
   static const int KGCSpaceServerZygoteLiveBMInd_   = 6;
 
+  // Number of entries in the mapped-class cache. Must be a power of two.
+  static const size_t kClassCacheSize = 1024;
+
+  // Mark stacks smaller than this are drained on the calling thread.
+  static const size_t kMinimumParallelMarkStackSize = 128;
+
   static int passed_bitmap_tests_;
   static int pushed_back_to_stack_;
   static int is_reference_class_cnt_;
@@ -59,6 +98,10 @@ class IPCServerMarkerSweep {
 
 
   GCSrverCollectorSpace spaces_[KGCSpaceCount];
+  GCSrverTranslationTable translation_;
+  GCSrverMappedClassInfo class_cache_[kClassCacheSize];
+  // loaded_classes_count_ of the client when the cache was last reset.
+  int32_t class_cache_generation_;
   int marked_spaces_count_prof_[KGCSpaceCount];
   space::GCSrvSharableCollectorData* curr_collector_ptr_;
 
@@ -72,6 +115,17 @@ class IPCServerMarkerSweep {
 
   accounting::ServerStructuredObjectStack* mark_stack_;
 
+  // Pool used to drain the mark stack in parallel. NULL disables parallel
+  // marking.
+  ThreadPool* const mark_workers_pool_;
+  // Serializes the reference lists while several workers are scanning.
+  Mutex references_lock_;
+  // True while the pool workers are marking.
+  volatile bool parallel_marking_;
+  volatile int32_t mark_chunks_created_;
+  volatile int32_t mark_chunks_deleted_;
+  volatile int32_t mark_chunks_stolen_;
+
   // offset of java.lang.ref.Reference.referent
   MemberOffset ref_referent_off_client_;
   // offset of java.lang.ref.Reference.queue
@@ -91,7 +145,8 @@ class IPCServerMarkerSweep {
 
   //statistics
 
-  IPCServerMarkerSweep(gc::service::GCServiceClientRecord* client_record);
+  IPCServerMarkerSweep(gc::service::GCServiceClientRecord* client_record,
+      ThreadPool* mark_workers_pool = NULL);
   void SetCachedReferencesPointers(space::GCSrvceCashedReferences* dest,
       space::GCSrvceCashedReferences* src);
   void UpdateClientCachedReferences(space::GCSrvceCashedReferences* dest,
@@ -100,6 +155,14 @@ class IPCServerMarkerSweep {
       space::GCSrvceCashedStatsCounters* src, bool atomicCp);
   void ResetStats(void);
 
+  void UpdateTranslationTable(void);
+  // Branch-free lookups of the space holding an address. Return
+  // kGCSrverTranslationSentinel when no space contains it.
+  int ClientSpaceIndex(const void* client_address) const;
+  int ServerSpaceIndex(const void* server_address) const;
+  template <int kSpaceIndex, class referenceKlass>
+  const referenceKlass* TranslateToServer(const referenceKlass* ref_parm) const;
+
   mirror::Object* MapObjectAddress(mirror::Object* obj);
   bool ClientSpaceContains(mirror::Object* obj, GCSrverCollectorSpace* server_space);
 
@@ -123,6 +186,7 @@ class IPCServerMarkerSweep {
 
 
   void ProcessMarckStack(void);
+  void ProcessMarckStackParallel(size_t thread_count);
   bool ServerScanObjectRemoval(const mirror::Object* obj);
   void ServerScanObject(const mirror::Object* obj, uint32_t calculated_offset);
 
@@ -138,6 +202,10 @@ class IPCServerMarkerSweep {
 
   template <typename MarkVisitor>
   void ServerScanObjectVisit(const mirror::Object* obj, const MarkVisitor& visitor);
+  // Scans an object known to live in the client space kSpaceIndex.
+  template <int kSpaceIndex, typename MarkVisitor>
+  void ServerScanSpaceObjectVisit(const mirror::Object* obj,
+      const MarkVisitor& visitor);
   //void ExternalScanObjectVisit(mirror::Object* obj, void* calculated_offset);
   void MarkReachableObjects(space::GCSrvSharableCollectorData* collector_addr);
   void SweepSpaces(space::GCSrvSharableCollectorData* collector_addr);
@@ -164,6 +232,12 @@ class IPCServerMarkerSweep {
   const referenceKlass* MapReferenceToServer(const referenceKlass* const ref_parm);
 
   const mirror::Class* GetMappedObjectKlass(const mirror::Object* mapped_obj_parm);
+  void ResetClassCache(void);
+  // Fills klass_info with the metadata of a mapped class, going through the
+  // class cache.
+  void GetMappedClassInfo(const mirror::Class* mapped_klass,
+      GCSrverMappedClassInfo* klass_info);
+  bool IsMappedClassResolved(const mirror::Class* mapped_klass) const;
 //  template <class TypeRef>
 //  TypeRef* ServerMapHeapReference(TypeRef* ptr_param);
 
@@ -245,6 +319,16 @@ class IPCServerMarkerSweep {
 //  mirror::Class* GetClientClassFromObject(mirror::Object* obj);
   void MarkObject(const mirror::Object* obj);
   void MarkObjectNonNull(const mirror::Object* obj);
+  // Atomically marks a mapped object. Returns the client address to push on
+  // the worker's local stack, or NULL if the object was already marked.
+  const mirror::Object* MarkObjectParallel(const mirror::Object* obj);
+  void IncMarkCounter(volatile int32_t* counter) {
+    if (parallel_marking_) {
+      android_atomic_inc(counter);
+    } else {
+      *counter += 1;
+    }
+  }
   bool IsMappedObjectMarked(const mirror::Object* object);
 
   byte* GetClientSpaceEnd(int index) const;
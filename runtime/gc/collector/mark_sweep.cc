@@ -33,6 +33,7 @@
 #include "gc/space/image_space.h"
 #include "gc/space/large_object_space.h"
 #include "gc/space/space-inl.h"
+#include "gc_profiler/MProfiler.h"
 #include "indirect_reference_table.h"
 #include "intern_table.h"
 #include "jni_internal.h"
@@ -74,6 +75,11 @@ constexpr bool kParallelRecursiveMark = true;
 // ProcessMarkStack with very small mark stacks.
 constexpr size_t kMinimumParallelMarkStackSize = 128;
 constexpr bool kParallelProcessMarkStack = true;
+// Alloc spaces smaller than this are swept by the GC thread alone. Larger
+// ones are cut into kSweepStripesPerThread page aligned stripes per thread.
+constexpr bool kParallelSweep = true;
+constexpr size_t kMinimumParallelSweepSize = 1 * MB;
+constexpr size_t kSweepStripesPerThread = 4;
 
 // Profiling and information flags.
 constexpr bool kCountClassesMarked = false;
@@ -228,6 +234,8 @@ MarkSweep::MarkSweep(Heap* heap, bool is_concurrent,
       mark_stack_lock_("mark sweep mark stack lock", kMarkSweepMarkStackLock),
       is_concurrent_(is_concurrent),
       clear_soft_references_(false),
+      total_sweep_time_ns_(0),
+      total_swept_bytes_(0),
       cashed_references_record_(cashed_reference_record) {
   memset(cashed_references_record_, 0, sizeof(space::GCSrvceCashedReferences));
   SetCachedJavaLangClass(Class::GetJavaLangClass());
@@ -294,7 +302,9 @@ MarkSweep::MarkSweep(Heap* heap, bool is_concurrent, const std::string& name_pre
                large_object_lock_("mark sweep large object lock", kMarkSweepLargeObjectLock),
                mark_stack_lock_("mark sweep mark stack lock", kMarkSweepMarkStackLock),
                is_concurrent_(is_concurrent),
-               clear_soft_references_(false) {}
+               clear_soft_references_(false),
+               total_sweep_time_ns_(0),
+               total_swept_bytes_(0) {}
 
 
 
@@ -401,6 +411,8 @@ void MarkSweep::MarkingPhase() {
   // Process dirty cards and add dirty cards to mod union tables.
   heap_->ProcessCards(timings_);
 
+  RevokeThreadLocalBuffers(self);
+
   // Need to do this before the checkpoint since we don't want any threads to add references to
   // the live stack during the recursive mark.
   timings_.NewSplit("SwapStacks");
@@ -1456,6 +1468,41 @@ class CheckpointMarkThreadRoots : public Closure {
   MarkSweep* mark_sweep_;
 };
 
+class CheckpointRevokeThreadLocalBuffers : public Closure {
+ public:
+  explicit CheckpointRevokeThreadLocalBuffers(MarkSweep* mark_sweep) : mark_sweep_(mark_sweep) {}
+
+  virtual void Run(Thread* thread) NO_THREAD_SAFETY_ANALYSIS {
+    // Note: self is not necessarily equal to thread since thread may be suspended.
+    Thread* self = Thread::Current();
+    CHECK(thread == self || thread->IsSuspended() || thread->GetState() == kWaitingPerformingGc)
+        << thread->GetState() << " thread " << thread << " self " << self;
+    mark_sweep_->GetHeap()->RevokeThreadLocalBuffers(thread);
+    mark_sweep_->GetBarrier().Pass(self);
+  }
+
+ private:
+  MarkSweep* mark_sweep_;
+};
+
+void MarkSweep::RevokeThreadLocalBuffers(Thread* self) {
+  timings_.NewSplit("RevokeThreadLocalBuffers");
+  if (Locks::mutator_lock_->IsExclusiveHeld(self)) {
+    GetHeap()->RevokeAllThreadLocalBuffers();
+    return;
+  }
+  // Mutators are running: each thread hands its own buffer back at a checkpoint.
+  CheckpointRevokeThreadLocalBuffers check_point(this);
+  ThreadList* thread_list = Runtime::Current()->GetThreadList();
+  size_t barrier_count = thread_list->RunCheckpoint(&check_point);
+  Locks::mutator_lock_->SharedUnlock(self);
+  ThreadState old_state = self->SetState(kWaitingForCheckPointsToRun);
+  CHECK_EQ(old_state, kWaitingPerformingGc);
+  gc_barrier_->Increment(self, barrier_count);
+  self->SetState(kWaitingPerformingGc);
+  Locks::mutator_lock_->SharedLock(self);
+}
+
 void MarkSweep::MarkRootsCheckpoint(Thread* self) {
   CheckpointMarkThreadRoots check_point(this);
   timings_.StartSplit("MarkRootsCheckpoint");
@@ -1601,6 +1648,98 @@ void MarkSweep::SweepArray(accounting::ATOMIC_OBJ_STACK_T* allocations,
   timings_.EndSplit();
 }
 
+// Freed totals of the stripes of a parallel sweep.
+struct ParallelSweepCounters {
+  volatile int32_t freed_objects_;
+  volatile int32_t freed_bytes_;
+};
+
+// Sweeps a stripe of an alloc space. The garbage found by SweepWalk() is
+// queued in a private free list, which is handed to FreeList() once per
+// stripe: the space lock is taken once, and since the list is in address
+// order dlmalloc merges the adjacent chunks before putting them in its bins.
+class SweepStripeTask : public Task {
+ public:
+  SweepStripeTask(space::AllocSpace* space, accounting::SPACE_BITMAP* live_bitmap,
+                  accounting::SPACE_BITMAP* mark_bitmap, uintptr_t begin, uintptr_t end,
+                  ParallelSweepCounters* counters)
+      : space_(space),
+        live_bitmap_(live_bitmap),
+        mark_bitmap_(mark_bitmap),
+        begin_(begin),
+        end_(end),
+        counters_(counters) {
+  }
+
+  // Bounds the memory of the free list of very sparse stripes.
+  static const size_t kMaxFreeListSize = 16 * KB;
+
+  virtual void Run(Thread* self) NO_THREAD_SAFETY_ANALYSIS {
+    accounting::SPACE_BITMAP::SweepWalk(*live_bitmap_, *mark_bitmap_, begin_, end_,
+                                        &SweepStripeCallback, reinterpret_cast<void*>(this));
+    FlushFreeList(self);
+  }
+
+  virtual void Finalize() {
+    delete this;
+  }
+
+ private:
+  static void SweepStripeCallback(size_t num_ptrs, Object** ptrs, void* arg) {
+    SweepStripeTask* task = reinterpret_cast<SweepStripeTask*>(arg);
+    if (task->free_list_.size() + num_ptrs > kMaxFreeListSize) {
+      task->FlushFreeList(Thread::Current());
+    }
+    task->free_list_.insert(task->free_list_.end(), ptrs, ptrs + num_ptrs);
+  }
+
+  void FlushFreeList(Thread* self) {
+    if (free_list_.empty()) {
+      return;
+    }
+    size_t freed_objects = free_list_.size();
+    size_t freed_bytes = space_->FreeList(self, freed_objects, &free_list_[0]);
+    android_atomic_add(static_cast<int32_t>(freed_objects), &counters_->freed_objects_);
+    android_atomic_add(static_cast<int32_t>(freed_bytes), &counters_->freed_bytes_);
+    free_list_.clear();
+  }
+
+  space::AllocSpace* const space_;
+  accounting::SPACE_BITMAP* const live_bitmap_;
+  accounting::SPACE_BITMAP* const mark_bitmap_;
+  const uintptr_t begin_;
+  const uintptr_t end_;
+  ParallelSweepCounters* const counters_;
+  std::vector<Object*> free_list_;
+};
+
+void MarkSweep::SweepAllocSpaceParallel(space::AllocSpace* space,
+                                        accounting::SPACE_BITMAP* live_bitmap,
+                                        accounting::SPACE_BITMAP* mark_bitmap,
+                                        uintptr_t begin, uintptr_t end, size_t thread_count) {
+  Thread* self = Thread::Current();
+  ThreadPool* thread_pool = GetHeap()->GetThreadPool();
+  ParallelSweepCounters counters;
+  counters.freed_objects_ = 0;
+  counters.freed_bytes_ = 0;
+  // Page aligned stripes are card aligned and never share a bitmap word.
+  const size_t stripe_size = RoundUp((end - begin) / (thread_count * kSweepStripesPerThread) + 1,
+                                     kPageSize);
+  for (uintptr_t stripe_begin = begin; stripe_begin < end; stripe_begin += stripe_size) {
+    uintptr_t stripe_end = std::min(stripe_begin + stripe_size, end);
+    thread_pool->AddTask(self, new SweepStripeTask(space, live_bitmap, mark_bitmap, stripe_begin,
+                                                   stripe_end, &counters));
+  }
+  thread_pool->SetMaxActiveWorkers(thread_count - 1);
+  thread_pool->StartWorkers(self);
+  thread_pool->Wait(self, true, true);
+  thread_pool->StopWorkers(self);
+  // RecordFree updates the runtime stats which are not thread safe.
+  GetHeap()->RecordFree(counters.freed_objects_, counters.freed_bytes_);
+  IncFreedObjects(counters.freed_objects_);
+  IncFreedBytes(counters.freed_bytes_);
+}
+
 void MarkSweep::Sweep(bool swap_bitmaps) {
   //LOG(ERROR) << "MarkSweep::Sweep....";
 
@@ -1633,10 +1772,19 @@ void MarkSweep::Sweep(bool swap_bitmaps) {
       if (!space->IsZygoteSpace()) {
         base::TimingLogger::ScopedSplit split("SweepAllocSpace", &timings_);
         // Bitmaps are pre-swapped for optimization which enables sweeping with the heap unlocked.
-
-
-        accounting::SPACE_BITMAP::SweepWalk(*live_bitmap, *mark_bitmap, begin, end,
-                                             &SweepCallback, reinterpret_cast<void*>(&scc));
+        const uint64_t sweep_start = NanoTime();
+        const size_t thread_count = GetThreadCount(!IsConcurrent());
+        // The profiler's free hook runs outside the space lock and is not thread safe, so the
+        // stripes are only swept in parallel when it is not recording.
+        if (kParallelSweep && thread_count > 1 && end - begin >= kMinimumParallelSweepSize &&
+            !mprofiler::VMProfiler::IsMProfRunning()) {
+          SweepAllocSpaceParallel(scc.space, live_bitmap, mark_bitmap, begin, end, thread_count);
+        } else {
+          accounting::SPACE_BITMAP::SweepWalk(*live_bitmap, *mark_bitmap, begin, end,
+                                               &SweepCallback, reinterpret_cast<void*>(&scc));
+        }
+        total_sweep_time_ns_ += NanoTime() - sweep_start;
+        total_swept_bytes_ += end - begin;
 
       } else {
         base::TimingLogger::ScopedSplit split("SweepZygote", &timings_);
@@ -145,6 +145,12 @@ class MarkSweep : public GarbageCollector {
       EXCLUSIVE_LOCKS_REQUIRED(Locks::heap_bitmap_lock_)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
+  // Hands the thread-local allocation buffers of all threads back before the allocation
+  // stacks are swapped, so that their objects are swept by this cycle.
+  void RevokeThreadLocalBuffers(Thread* self)
+      LOCKS_EXCLUDED(Locks::heap_bitmap_lock_)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
   // Verify that image roots point to only marked objects within the alloc space.
   void VerifyImageRoots()
       EXCLUSIVE_LOCKS_REQUIRED(Locks::heap_bitmap_lock_)
@@ -189,6 +195,20 @@ class MarkSweep : public GarbageCollector {
   // Sweeps unmarked objects to complete the garbage collection.
   virtual void Sweep(bool swap_bitmaps) EXCLUSIVE_LOCKS_REQUIRED(Locks::heap_bitmap_lock_);
 
+  // Sweeps [begin, end) of an alloc space in stripes on the heap thread pool.
+  void SweepAllocSpaceParallel(space::AllocSpace* space, accounting::SPACE_BITMAP* live_bitmap,
+                               accounting::SPACE_BITMAP* mark_bitmap, uintptr_t begin,
+                               uintptr_t end, size_t thread_count)
+      EXCLUSIVE_LOCKS_REQUIRED(Locks::heap_bitmap_lock_);
+
+  uint64_t GetTotalSweepTimeNs() const {
+    return total_sweep_time_ns_;
+  }
+
+  uint64_t GetTotalSweptBytes() const {
+    return total_swept_bytes_;
+  }
+
   // Sweeps unmarked objects to complete the garbage collection.
   void SweepLargeObjects(bool swap_bitmaps) EXCLUSIVE_LOCKS_REQUIRED(Locks::heap_bitmap_lock_);
 
@@ -865,6 +885,10 @@ class MarkSweep : public GarbageCollector {
   const bool is_concurrent_;
   bool clear_soft_references_;
 
+  // Cumulative time spent sweeping alloc spaces and bytes of heap swept.
+  uint64_t total_sweep_time_ns_;
+  uint64_t total_swept_bytes_;
+
 #if (ART_GC_SERVICE)
   space::GCSrvceCashedReferences* cashed_references_record_;
 #else
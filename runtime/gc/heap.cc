@@ -19,6 +19,7 @@
 #define ATRACE_TAG ATRACE_TAG_DALVIK
 #include <cutils/trace.h>
 
+#include <algorithm>
 #include <limits>
 #include <vector>
 #include <valgrind.h>
@@ -168,7 +169,10 @@ Heap::Heap(size_t initial_size, size_t growth_limit, size_t min_free, size_t max
 #endif
       total_allocation_time_(0),
       verify_object_mode_(kHeapVerificationNotPermitted),
-      running_on_valgrind_(RUNNING_ON_VALGRIND) {
+      running_on_valgrind_(RUNNING_ON_VALGRIND),
+      use_thread_local_allocation_(kUseThreadLocalAllocation && !running_on_valgrind_ &&
+                                   kDesiredHeapVerification == kNoHeapVerification) {
+  memset(&alloc_space_frag_, 0, sizeof(alloc_space_frag_));
   if (VLOG_IS_ON(heap) || VLOG_IS_ON(startup)) {
     LOG(INFO) << "Heap() entering";
   }
@@ -241,6 +245,9 @@ Heap::Heap(size_t initial_size, size_t growth_limit, size_t min_free, size_t max
                                               requested_alloc_space_begin);
   CHECK(alloc_space_ != NULL) << "Failed to create alloc space";
   alloc_space_->SetFootprintLimit(alloc_space_->Capacity());
+  if (kUseSlabAllocation && !running_on_valgrind_ && !Runtime::Current()->IsZygote()) {
+    alloc_space_->EnableSlabAllocation();
+  }
   AddContinuousSpace(alloc_space_);
 
   //DumpSpaces();
@@ -671,6 +678,14 @@ void Heap::DumpGcPerformanceInfo(std::ostream& os) {
          << " objects with total size " << PrettySize(freed_bytes) << "\n"
          << collector->GetName() << " throughput: " << freed_objects / seconds << "/s / "
          << PrettySize(freed_bytes / seconds) << "/s\n";
+      const uint64_t sweep_ns = collector->GetTotalSweepTimeNs();
+      if (sweep_ns != 0) {
+        const double sweep_seconds = static_cast<double>(sweep_ns) / 1000000000.0;
+        const double swept_mb = static_cast<double>(collector->GetTotalSweptBytes()) / MB;
+        os << collector->GetName() << " sweep time: " << PrettyDuration(sweep_ns) << "\n"
+           << collector->GetName() << " sweep throughput: " << swept_mb / sweep_seconds
+           << "MB/s\n";
+      }
       total_duration += total_ns;
       total_paused_time += total_pause_ns;
     }
@@ -822,6 +837,7 @@ mirror::Object* Heap::AllocObject(Thread* self, mirror::Class* c, size_t byte_co
   // range. This also means that we rely on SetClass not dirtying the object's card.
   bool large_object_allocation =
       byte_count >= large_object_threshold_ && have_zygote_space_ && c->IsPrimitiveArray();
+  bool thread_local_allocation = false;
   if (UNLIKELY(large_object_allocation)) {
     obj = Allocate(self, large_object_space_, byte_count, &bytes_allocated);
     // Make sure that our large object didn't get placed anywhere within the space interval or else
@@ -829,6 +845,11 @@ mirror::Object* Heap::AllocObject(Thread* self, mirror::Class* c, size_t byte_co
     DCHECK(obj == NULL ||
            reinterpret_cast<byte*>(obj) < continuous_spaces_.front()->Begin() ||
            reinterpret_cast<byte*>(obj) >= continuous_spaces_.back()->End());
+  } else if (use_thread_local_allocation_ &&
+             byte_count <= space::DlMallocTlab::kMaxObjectSize) {
+    thread_local_allocation = true;
+    obj = AllocateThreadLocal(self, byte_count, &bytes_allocated);
+    DCHECK(obj == NULL || !have_zygote_space_ || !FindSpaceFromObject(obj, false)->IsZygoteSpace());
   } else {
     obj = Allocate(self, alloc_space_, byte_count, &bytes_allocated);
     // Ensure that we did not allocate into a zygote space.
@@ -840,7 +861,11 @@ mirror::Object* Heap::AllocObject(Thread* self, mirror::Class* c, size_t byte_co
 
     // Record allocation after since we want to use the atomic add for the atomic fence to guard
     // the SetClass since we do not want the class to appear NULL in another thread.
-    RecordAllocation(bytes_allocated, obj);
+    if (thread_local_allocation) {
+      RecordThreadLocalAllocation(self, bytes_allocated, obj);
+    } else {
+      RecordAllocation(bytes_allocated, obj);
+    }
 
     if (Dbg::IsAllocTrackingEnabled()) {
       Dbg::RecordAllocation(c, byte_count);
@@ -1078,9 +1103,7 @@ void Heap::VerifyHeap() {
   GetLiveBitmap()->Walk(Heap::VerificationCallback, this);
 }
 
-inline void Heap::RecordAllocation(size_t size, mirror::Object* obj) {
-  DCHECK(obj != NULL);
-  DCHECK_GT(size, 0u);
+inline void Heap::RecordAllocationStats(size_t size) {
   IncAtomicBytesAllocated(size);
 
   if (Runtime::Current()->HasStatsEnabled()) {
@@ -1093,25 +1116,33 @@ inline void Heap::RecordAllocation(size_t size, mirror::Object* obj) {
     ++global_stats->allocated_objects;
     global_stats->allocated_bytes += size;
   }
+}
+
+void Heap::HandleAllocationStackOverflow() {
+  GCP_MARK_START_ALLOC_GC_HW_EVENT;
+  GCP_MARK_START_GC_HAT_TIME_EVENT(Thread::Current());
+#if (ART_GC_SERVICE)
+  LOG(FATAL) << "Heap::RecordAllocation-START..AtomicPushBack..allocation stack is " << allocation_stack_->Capacity();
+  //service::GCServiceClient::RequestAllocateGC();
+  LOG(ERROR) << "Heap::RecordAllocation-----AtomicPushBack";
+#else
+  CollectGarbageInternal(collector::kGcTypeSticky, kGcCauseForAlloc, false);
+#endif
+  GCP_MARK_END_GC_HAT_TIME_EVENT(Thread::Current());
+  GCP_MARK_END_ALLOC_GC_HW_EVENT;
+}
+
+inline void Heap::RecordAllocation(size_t size, mirror::Object* obj) {
+  DCHECK(obj != NULL);
+  DCHECK_GT(size, 0u);
+  RecordAllocationStats(size);
 
   // This is safe to do since the GC will never free objects which are neither in the allocation
   // stack or the live bitmap.
 //  Thread* self = Thread::Current();
 
   while (!allocation_stack_->AtomicPushBack(obj)) {
-
-
-    GCP_MARK_START_ALLOC_GC_HW_EVENT;
-    GCP_MARK_START_GC_HAT_TIME_EVENT(Thread::Current());
-#if (ART_GC_SERVICE)
-    LOG(FATAL) << "Heap::RecordAllocation-START..AtomicPushBack..allocation stack is " << allocation_stack_->Capacity();
-    //service::GCServiceClient::RequestAllocateGC();
-    LOG(ERROR) << "Heap::RecordAllocation-----AtomicPushBack";
-#else
-    CollectGarbageInternal(collector::kGcTypeSticky, kGcCauseForAlloc, false);
-#endif
-    GCP_MARK_END_GC_HAT_TIME_EVENT(Thread::Current());
-    GCP_MARK_END_ALLOC_GC_HW_EVENT;
+    HandleAllocationStackOverflow();
   }
 
 #if (ART_GC_SERVICE)
@@ -1126,6 +1157,70 @@ inline void Heap::RecordAllocation(size_t size, mirror::Object* obj) {
 
 }
 
+inline void Heap::RecordThreadLocalAllocation(Thread* self, size_t size, mirror::Object* obj) {
+  DCHECK(obj != NULL);
+  DCHECK_GT(size, 0u);
+  RecordAllocationStats(size);
+
+  // Until the record is flushed the object is neither in the allocation stack nor in the live
+  // bitmap, so the GC cannot free it.
+  if (UNLIKELY(self->GetDlMallocTlab()->AddRecord(obj))) {
+    FlushThreadLocalAllocationRecords(self);
+  }
+}
+
+bool Heap::TryPushThreadLocalRecords(space::DlMallocTlab* tlab) {
+  if (tlab->records_count_ == 0) {
+    return true;
+  }
+  mirror::Object** start = NULL;
+  mirror::Object** end = NULL;
+  if (!allocation_stack_->AtomicBumpBack(tlab->records_count_, &start, &end)) {
+    return false;
+  }
+  std::copy(tlab->records_, tlab->records_ + tlab->records_count_, start);
+  tlab->records_count_ = 0;
+  return true;
+}
+
+void Heap::FlushThreadLocalAllocationRecords(Thread* self) {
+  space::DlMallocTlab* tlab = self->GetDlMallocTlab();
+  if (tlab == NULL) {
+    return;
+  }
+  // A GC triggered by the overflow revokes the TLAB of self, which empties the records.
+  while (!TryPushThreadLocalRecords(tlab)) {
+    HandleAllocationStackOverflow();
+  }
+#if (ART_GC_SERVICE)
+  if(GCServiceClient::ShouldNotifyAllocationCapacity(allocation_stack_->Size(),
+                                                  allocation_stack_->Capacity())) {
+    GCServiceClient::RequestAllocateGC();
+  }
+#endif
+}
+
+void Heap::RevokeThreadLocalBuffers(Thread* thread) {
+  space::DlMallocTlab* tlab = thread->GetDlMallocTlab();
+  if (tlab == NULL) {
+    return;
+  }
+  if (!TryPushThreadLocalRecords(tlab)) {
+    // Keep the records, the thread pushes them on its next allocation.
+    LOG(WARNING) << "Allocation stack is full, deferring " << tlab->records_count_
+                 << " allocation records of " << *thread;
+  }
+  alloc_space_->RevokeTlabChunks(Thread::Current(), tlab);
+}
+
+void Heap::RevokeAllThreadLocalBuffers() {
+  MutexLock mu(Thread::Current(), *Locks::thread_list_lock_);
+  std::list<Thread*> thread_list = Runtime::Current()->GetThreadList()->GetList();
+  for (Thread* thread : thread_list) {
+    RevokeThreadLocalBuffers(thread);
+  }
+}
+
 void Heap::RecordFree(size_t freed_objects, size_t freed_bytes) {
   DCHECK_LE(freed_bytes, static_cast<size_t>(GetBytesAllocated()));
   IncAtomicBytesAllocated(-freed_bytes);
@@ -1181,6 +1276,25 @@ inline mirror::Object* Heap::TryToAllocate(Thread* self, space::DL_MALLOC_SPACE*
   }
 }
 
+inline mirror::Object* Heap::AllocateThreadLocal(Thread* self, size_t alloc_size,
+                                                 size_t* bytes_allocated) {
+  DCHECK_EQ(self->GetState(), kRunnable);
+  space::DlMallocTlab* tlab = self->GetDlMallocTlab();
+  if (UNLIKELY(tlab == NULL)) {
+    tlab = new space::DlMallocTlab();
+    self->SetDlMallocTlab(tlab);
+  }
+  if (LIKELY(!IsOutOfMemoryOnAllocation(alloc_size, false))) {
+    mirror::Object* ptr = alloc_space_->AllocThreadLocal(self, tlab, alloc_size,
+                                                         bytes_allocated);
+    if (ptr != NULL) {
+      return ptr;
+    }
+  }
+  // The TLAB could not be refilled, take the shared path which may collect garbage.
+  return Allocate(self, alloc_space_, alloc_size, bytes_allocated);
+}
+
 template <class T>
 inline mirror::Object* Heap::Allocate(Thread* self, T* space, size_t alloc_size,
                                       size_t* bytes_allocated) {
@@ -1623,10 +1737,13 @@ void Heap::PostZygoteForkWithSpaceFork(bool shared_space) {
         }
 
 
-        static const size_t default_mark_stack_size = std::max(256 * KB,max_allocation_stack_size_) ;
+        // The shared mark stack commits one segment up front and chains the
+        // other segments of its reservation only when marking overflows.
+        static const size_t kSharedMarkStackSegments = 16;
+        static const size_t default_mark_stack_size = std::max(64 * KB, max_allocation_stack_size_ / 4);
         mark_stack_.reset(accounting::ATOMIC_OBJ_STACK_T::ShareStack(mark_stack_.release(),
             &(_struct_alloc_space->heap_meta_.mark_stack_data_), true,
-            default_mark_stack_size));
+            default_mark_stack_size, kSharedMarkStackSegments));
         alloc_space_ = zygote_space->CreateSharableZygoteSpace("alloc space",
             _struct_alloc_space, shared_space);
 
@@ -1641,6 +1758,9 @@ void Heap::PostZygoteForkWithSpaceFork(bool shared_space) {
     alloc_space_ = zygote_space->CreateZygoteSpace("alloc space", shared_space);
   }
   alloc_space_->SetFootprintLimit(alloc_space_->Capacity());
+  if (kUseSlabAllocation && !running_on_valgrind_) {
+    alloc_space_->EnableSlabAllocation();
+  }
 
   // Change the GC retention policy of the zygote space to only collect when full.
   zygote_space->SetGcRetentionPolicy(space::kGcRetentionPolicyFullCollect);
@@ -1726,6 +1846,9 @@ void Heap::PreZygoteFork() {
   space::DLMALLOC_SPACE_T* zygote_space = alloc_space_;
   alloc_space_ = zygote_space->CreateZygoteSpace("alloc space");
   alloc_space_->SetFootprintLimit(alloc_space_->Capacity());
+  if (kUseSlabAllocation && !running_on_valgrind_) {
+    alloc_space_->EnableSlabAllocation();
+  }
 
   // Change the GC retention policy of the zygote space to only collect when full.
   zygote_space->SetGcRetentionPolicy(space::kGcRetentionPolicyFullCollect);
@@ -1745,6 +1868,7 @@ void Heap::PreZygoteFork() {
 }
 
 void Heap::FlushAllocStack() {
+  RevokeAllThreadLocalBuffers();
   MarkAllocStack(alloc_space_->GetLiveBitmap(), GC_HEAP_SRVCE_NO_LOS ? NULL : large_object_space_->GetLiveObjects(),
                  allocation_stack_.get());
   allocation_stack_->Reset();
@@ -2970,6 +3094,13 @@ bool Heap::RequestHeapTrimIfNeeded(size_t adjusted_max_free,
     return false;
   }
 
+  // Sampling walks the space, so it counts as a trim for the two seconds rule.
+  SetLastTimeTrim(ms_time);
+  if (!SampleAllocSpaceFragmentation()) {
+    // The free pages are scattered in runs too short to madvise.
+    return false;
+  }
+
 
 
 #if (ART_GC_SERVICE)
@@ -3065,6 +3196,11 @@ size_t Heap::Trim() {
   return _trimmed;
 }
 
+bool Heap::SampleAllocSpaceFragmentation() {
+  alloc_space_->SampleFragmentation(&alloc_space_frag_);
+  return alloc_space_frag_.trimmable_bytes_ >= kMinTrimmableBytes;
+}
+
 bool Heap::IsGCRequestPending() const {
  // size_t return_val = 0;
  // if(!art::gc::service::GCServiceClient::GetConcStartBytes(&return_val)) {
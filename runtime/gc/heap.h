@@ -98,6 +98,7 @@ namespace space {
   class AllocSpace;
   class DiscontinuousSpace;
   class DL_MALLOC_SPACE;
+  class DlMallocTlab;
   class DLMALLOC_SPACE_T;
   class ImageSpace;
   class LargeObjectSpace;
@@ -156,6 +157,16 @@ class Heap {
   // Used so that we don't overflow the allocation time atomic integer.
   static constexpr size_t kTimeAdjust = 1024;
 
+  // Serve small allocations from per-thread buffers carved out of the alloc space.
+  static constexpr bool kUseThreadLocalAllocation = true;
+
+  // Serve objects of up to SlabAllocator::kMaxObjectSize bytes from size
+  // segregated slabs of the alloc space. The zygote space never uses slabs.
+  static constexpr bool kUseSlabAllocation = true;
+
+  // A heap trim is not requested unless it can madvise at least this much.
+  static constexpr size_t kMinTrimmableBytes = 64 * KB;
+
   // Create a heap with the requested sizes. The possible empty
   // image_file_names names specify Spaces to load based on
   // ImageWriter output.
@@ -542,6 +553,14 @@ class Heap {
 
   size_t Trim();
 
+  // Samples the fragmentation of the alloc space, walking it under its lock.
+  // Returns true if a trim has enough whole free pages to be worth it.
+  bool SampleAllocSpaceFragmentation();
+
+  const space::DlMallocFragmentation& GetAllocSpaceFragmentation() const {
+    return alloc_space_frag_;
+  }
+
 #if (ART_GC_SERVICE)
   accounting::BaseHeapBitmap* GetLiveBitmap() SHARED_LOCKS_REQUIRED(Locks::heap_bitmap_lock_) {
     return live_bitmap_.get();
@@ -572,6 +591,24 @@ class Heap {
   // Mark and empty stack.
   void FlushAllocStack()
       EXCLUSIVE_LOCKS_REQUIRED(Locks::heap_bitmap_lock_);
+
+  bool UseThreadLocalAllocation() const {
+    return use_thread_local_allocation_;
+  }
+
+  void SetUseThreadLocalAllocation(bool use_thread_local_allocation) {
+    use_thread_local_allocation_ = use_thread_local_allocation;
+  }
+
+  // Push the objects recorded in the TLAB of self on the allocation stack,
+  // collecting garbage if the stack is full.
+  void FlushThreadLocalAllocationRecords(Thread* self)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+  // Record the objects of the TLAB of thread and free its cached chunks.
+  // thread has to be suspended or be the caller.
+  void RevokeThreadLocalBuffers(Thread* thread);
+  // Revoke the TLABs of all the threads. Mutators have to be suspended.
+  void RevokeAllThreadLocalBuffers() LOCKS_EXCLUDED(Locks::thread_list_lock_);
 #if (ART_GC_SERVICE)
   void PostZygoteForkWithSpaceFork(bool);
   void SetSubHeapMetaData(space::GCSrvcHeapSubRecord* new_address);
@@ -717,6 +754,25 @@ class Heap {
       LOCKS_EXCLUDED(GlobalSynchronization::heap_bitmap_lock_)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
+  // Like RecordAllocation but the object is pushed on the allocation stack
+  // lazily from the TLAB of self.
+  void RecordThreadLocalAllocation(Thread* self, size_t size, mirror::Object* object)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  void RecordAllocationStats(size_t size);
+
+  // Called when the allocation stack has no room for a new record.
+  void HandleAllocationStackOverflow()
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  // Returns false if the allocation stack could not fit the records of tlab.
+  bool TryPushThreadLocalRecords(space::DlMallocTlab* tlab);
+
+  // Allocate from the TLAB of self, falls back to Allocate when it is exhausted.
+  mirror::Object* AllocateThreadLocal(Thread* self, size_t alloc_size, size_t* bytes_allocated)
+      LOCKS_EXCLUDED(Locks::thread_suspend_count_lock_)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
   // Sometimes CollectGarbageInternal decides to run a different Gc than you requested. Returns
   // which type of Gc was actually ran.
   collector::GcType CollectGarbageInternal(collector::GcType gc_plan, GcCause gc_cause,
@@ -1272,6 +1328,12 @@ class Heap {
 
   const bool running_on_valgrind_;
 
+  // Whether small objects are allocated from thread-local allocation buffers.
+  bool use_thread_local_allocation_;
+
+  // Last fragmentation sample of the alloc space.
+  space::DlMallocFragmentation alloc_space_frag_;
+
   friend class collector::MarkSweep;
   friend class collector::IPCHeap;
   friend class VerifyReferenceCardVisitor;
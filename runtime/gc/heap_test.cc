@@ -14,13 +14,16 @@
  * limitations under the License.
  */
 
+#include "atomic_integer.h"
 #include "common_test.h"
 #include "gc/accounting/card_table-inl.h"
 #include "gc/accounting/space_bitmap-inl.h"
+#include "gc/space/dlmalloc_tlab.h"
 #include "mirror/class-inl.h"
 #include "mirror/object-inl.h"
 #include "mirror/object_array-inl.h"
 #include "sirt_ref.h"
+#include "thread_pool.h"
 
 namespace art {
 namespace gc {
@@ -67,5 +70,76 @@ TEST_F(HeapTest, HeapBitmapCapacityTest) {
   bitmap->Set(fake_end_of_heap_object);
 }
 
+class AllocationTask : public Task {
+ public:
+  AllocationTask(mirror::Class* klass, size_t num_objects, AtomicInteger* refills)
+      : klass_(klass), num_objects_(num_objects), refills_(refills) {}
+
+  void Run(Thread* self) {
+    ScopedObjectAccess soa(self);
+    Heap* heap = Runtime::Current()->GetHeap();
+    size_t refills_before = 0;
+    if (self->GetDlMallocTlab() != NULL) {
+      refills_before = self->GetDlMallocTlab()->refills_;
+    }
+    for (size_t i = 0; i < num_objects_; ++i) {
+      heap->AllocObject(self, klass_, klass_->GetObjectSize());
+    }
+    if (self->GetDlMallocTlab() != NULL) {
+      refills_->fetch_add(self->GetDlMallocTlab()->refills_ - refills_before);
+    }
+    heap->FlushThreadLocalAllocationRecords(self);
+    heap->RevokeThreadLocalBuffers(self);
+  }
+
+  void Finalize() {
+    delete this;
+  }
+
+ private:
+  mirror::Class* const klass_;
+  const size_t num_objects_;
+  AtomicInteger* const refills_;
+};
+
+// Allocates small objects from several threads with and without TLABs and
+// reports how many bucket refills the TLAB path needed.
+TEST_F(HeapTest, ThreadLocalAllocationBenchmark) {
+  static const size_t kNumThreads = 4;
+  static const size_t kObjectsPerThread = 100000;
+  Thread* self = Thread::Current();
+  Heap* heap = Runtime::Current()->GetHeap();
+  mirror::Class* klass;
+  {
+    ScopedObjectAccess soa(self);
+    klass = class_linker_->FindSystemClass("Ljava/lang/Object;");
+  }
+  ASSERT_TRUE(klass != NULL);
+  const bool use_tlab = heap->UseThreadLocalAllocation();
+  for (int tlab = 0; tlab < 2; ++tlab) {
+    heap->SetUseThreadLocalAllocation(tlab == 1);
+    ThreadPool thread_pool(kNumThreads);
+    AtomicInteger refills(0);
+    for (size_t i = 0; i < kNumThreads; ++i) {
+      thread_pool.AddTask(self, new AllocationTask(klass, kObjectsPerThread, &refills));
+    }
+    uint64_t start = NanoTime();
+    thread_pool.StartWorkers(self);
+    thread_pool.Wait(self, true, false);
+    uint64_t elapsed = NanoTime() - start;
+    const size_t num_objects = kNumThreads * kObjectsPerThread;
+    if (tlab == 1) {
+      // Each refill takes the alloc space lock once; nothing else on the TLAB path does.
+      LOG(INFO) << "TLAB allocation: " << num_objects << " objects in "
+                << PrettyDuration(elapsed) << ", " << refills.load() << " bucket refills";
+      EXPECT_LT(static_cast<size_t>(refills.load()), num_objects / 16);
+    } else {
+      LOG(INFO) << "shared allocation: " << num_objects << " objects in "
+                << PrettyDuration(elapsed);
+    }
+  }
+  heap->SetUseThreadLocalAllocation(use_tlab);
+}
+
 }  // namespace gc
 }  // namespace art
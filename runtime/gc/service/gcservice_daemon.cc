@@ -4,9 +4,14 @@
  *  Created on: Sep 28, 2015
  *      Author: hussein
  */
+#include <sys/mman.h>
+#include <unistd.h>
+#include <limits>
+#include <sstream>
 #include <string>
 #include <cutils/ashmem.h>
 #include "gc/service/global_allocator.h"
+#include "gc/service/proc_sampler.h"
 #include "gc/collector/ipc_server_sweep.h"
 #include "gc/space/space.h"
 #include "ScopedLocalRef.h"
@@ -26,11 +31,6 @@ namespace service {
 
 GCServiceProcess* GCServiceProcess::process_ = NULL;
 
-const char * GCServiceDaemon::meminfo_args_[] = {
-    "--oom"
-};
-
-
 long GCSrvcMemInfoOOM::total_ram_ = 0;
 long GCSrvcMemInfoOOM::free_ram_[] = {0, 0, 0, 0};
 
@@ -48,7 +48,7 @@ GCSrvcMemInfoOOM GCSrvcMemInfoOOM::mem_info_oom_list_[] = {
     GCSrvcMemInfoOOM(6, "Home"),
     GCSrvcMemInfoOOM(7, "Previous"),
     GCSrvcMemInfoOOM(8, "B Services"),
-    GCSrvcMemInfoOOM(15, "Cached"),
+    GCSrvcMemInfoOOM(9, "Cached"),
 };
 
 
@@ -57,118 +57,49 @@ GCSrvcMemInfoOOM::GCSrvcMemInfoOOM(int adj, const char * label) :
 
 }
 
-int GCSrvcMemInfoOOM::parseMemInfo(const char* file_path) {
-
-  FILE *f;
-  f = fopen(file_path, "r");
-  if (!f)
+/*
+ * Samples procfs for the registered agents only and regroups them by the
+ * oom bucket matching their current oom_score_adj. Agents whose process is
+ * gone are returned in gone_pids for the caller to unregister.
+ */
+int GCSrvcMemInfoOOM::sampleMemInfo(GCSrvcProcSampler* sampler,
+                                    ClientAgentsMap* agents,
+                                    std::vector<int>* gone_pids) {
+  static const int _buckets_count =
+      sizeof(mem_info_oom_list_) / sizeof(mem_info_oom_list_[0]);
+  GCSrvcSystemSample _sys_sample;
+  if(!sampler->SampleSystem(&_sys_sample)) {
     return 0;
+  }
+  total_ram_ = _sys_sample.total_kb_;
+  free_ram_[0] = _sys_sample.free_kb_ + _sys_sample.cached_kb_;
+  free_ram_[1] = 0;
+  free_ram_[2] = _sys_sample.cached_kb_;
+  free_ram_[3] = _sys_sample.free_kb_;
+
+  for(int i = 0; i < _buckets_count; i++) {
+    mem_info_oom_list_[i].resetMemInfo();
+    mem_info_oom_list_[i].agents_list_.clear();
+  }
 
-  char line[256];
-  int _read_res = 0;
-  int _stage = 0;
-  int pid = 0;
-  char _label[256];
-  long _memory_size = 0;
-
-  GCSrvcMemInfoOOM*  _meminfoP = NULL;
-
-  int _curr_index = 0;
-  _meminfoP = &(GCSrvcMemInfoOOM::mem_info_oom_list_[_curr_index]);
-
-  while (fgets(line, 256, f)) {
-
-    if(_stage ==1) {
-      _read_res  = GCSrvcMemInfoOOM::parseOOMRecString(line,
-                                                       &_memory_size, &pid);
-
-      if(_read_res == 100) {
-        GCSrvceAgent* _agent = GCServiceProcess::process_->daemon_->GetAgentByPid(pid);
-        if(_agent != NULL) {
-
-
-          _agent->updateOOMLabel(_meminfoP->oom_adj_, _memory_size);
-
-          AgentMemInfo* _meminfo_app_rec = _agent->meminfo_rec_;
-
-          if(false) {
-
-            LOG(ERROR) << "---1-" << pid << ", "
-                << _meminfo_app_rec->memory_size_ << " kB, "
-                << _meminfo_app_rec->oom_label_ << "...." << line;
-          }
-          _meminfoP->agents_list_.push_back(_agent);
-        }
-
-        continue;
-      }
-    }
-
-    if(_stage  <= 1) {
-      if(strlen(line) == 1) {
-        _stage |= 2;
-        continue;
-      }
-      _read_res  = GCSrvcMemInfoOOM::parseOOMHeaderString(line, _label, &_memory_size);
-      if(_read_res == 100) {
-        while(_curr_index < 13) {
-          _meminfoP = &(GCSrvcMemInfoOOM::mem_info_oom_list_[_curr_index]);
-          _meminfoP->resetMemInfo();
-          _meminfoP->agents_list_.clear();
-          _curr_index++;
-          if(strcmp(_meminfoP->oom_label_, _label) == 0) {
-            _meminfoP->aggregate_memory_ = _memory_size;
-            break;
-          }
-        }
-        _stage |= 1;
-        continue;
-      }
-
-
+  GCSrvcProcessSample _proc_sample;
+  for(ClientAgentsMap::iterator it = agents->begin(); it != agents->end(); ++it) {
+    GCSrvceAgent* _agent = it->second;
+    if(!sampler->SampleProcess(_agent->process_id_, &_proc_sample)) {
+      gone_pids->push_back(_agent->process_id_);
+      continue;
     }
-    if(_stage == 3) {
-      _read_res = GCSrvcMemInfoOOM::readTotalMemory(line);
-      if(_read_res == 100) {
-        _stage |= 4;
-        continue;
-      }
-    }
-    if(_stage == 7) {
-      _read_res = GCSrvcMemInfoOOM::readFreeMemory(line);
-      if(_read_res == 100) {
-        _stage |= 8;
-        break;
-      }
+    int _bucket = 0;
+    while(_bucket + 1 < _buckets_count &&
+        mem_info_oom_list_[_bucket + 1].oom_adj_ <= _proc_sample.oom_adj_) {
+      _bucket++;
     }
+    GCSrvcMemInfoOOM* _meminfoP = &(mem_info_oom_list_[_bucket]);
+    _agent->updateOOMLabel(_meminfoP->oom_adj_, _proc_sample.rss_kb_);
+    _meminfoP->aggregate_memory_ += _proc_sample.rss_kb_;
+    _meminfoP->agents_list_.push_back(_agent);
   }
-  fclose(f);
   return 1;
-
-}
-
-
-int GCSrvcMemInfoOOM::readTotalMemory(char* line) {
-  int result = sscanf(line, " Total RAM: %ld kB", &total_ram_);
-  if(result == 1) {
-    return 100;
-  }
-  if(result == EOF)
-    return EOF;
-  return 0;
-}
-
-int GCSrvcMemInfoOOM::readFreeMemory(char* line) {
-  int _index = 0;
-  int result = sscanf(line, " Free RAM: %ld kB (%ld cached pss + %ld cached + %ld free)",
-                      &free_ram_[_index], &free_ram_[_index+1], &free_ram_[_index+2],
-                      &free_ram_[_index+3]);
-  if(result == 4 ) {
-    return 100;
-  }
-  if(result == EOF)
-    return EOF;
-  return 0;
 }
 
 
@@ -178,6 +109,7 @@ GCServiceDaemon* GCServiceDaemon::CreateServiceDaemon(GCServiceProcess* process)
 
 
 GCSrvceAgent* GCServiceDaemon::GetAgentByPid(int pid) {
+  MutexLock mu(Thread::Current(), *agents_mu_);
   auto result = agents_map_.find(pid);
   if (result == agents_map_.end()) {
     return NULL;
@@ -187,6 +119,58 @@ GCSrvceAgent* GCServiceDaemon::GetAgentByPid(int pid) {
 
 }
 
+void GCServiceDaemon::RegisterAgent(GCSrvceAgent* agent) {
+  MutexLock mu(Thread::Current(), *agents_mu_);
+  auto result = agents_map_.find(agent->process_id_);
+  if(result != agents_map_.end()) {
+    retired_agents_.push_back(result->second);
+    agents_map_.erase(result);
+    proc_sampler_->ForgetProcess(agent->process_id_);
+  }
+  agents_map_.Put(agent->process_id_, agent);
+}
+
+void GCServiceDaemon::UnregisterAgent(int pid) {
+  MutexLock mu(Thread::Current(), *agents_mu_);
+  auto result = agents_map_.find(pid);
+  if(result == agents_map_.end())
+    return;
+  retired_agents_.push_back(result->second);
+  agents_map_.erase(result);
+  proc_sampler_->ForgetProcess(pid);
+}
+
+
+/*
+ * An agent is kept while its collector still serves a request, so that
+ * joining the collector does not wait on the phases of a client that is
+ * gone. The collector kicks the daemon back here once it is done.
+ */
+void GCServiceDaemon::ReapRetiredAgents(void) {
+  Thread* self = Thread::Current();
+  std::vector<GCSrvceAgent*> _retired;
+  {
+    MutexLock mu(self, *agents_mu_);
+    if(retired_agents_.empty())
+      return;
+    _retired.swap(retired_agents_);
+  }
+  std::vector<GCSrvceAgent*> _busy;
+  for(size_t i = 0; i < _retired.size(); i++) {
+    if(!_retired[i]->collector_->IsIdle()) {
+      _busy.push_back(_retired[i]);
+      continue;
+    }
+    IPC_MS_VLOG(INFO) << "GCServiceDaemon: deleting the agent of process "
+                      << _retired[i]->process_id_;
+    delete _retired[i];
+  }
+  if(!_busy.empty()) {
+    MutexLock mu(self, *agents_mu_);
+    retired_agents_.insert(retired_agents_.end(), _busy.begin(), _busy.end());
+  }
+}
+
 
 void* GCServiceDaemon::RunDaemon(void* arg) {
   GCServiceDaemon* _daemonObj = reinterpret_cast<GCServiceDaemon*>(arg);
@@ -219,7 +203,6 @@ void* GCServiceDaemon::RunDaemon(void* arg) {
     IPMutexLock interProcMu(self, *_processObj->service_meta_->mu_);
     _daemonObj->thread_ = self;
     _daemonObj->initWorkerPool();
-    _daemonObj->SetMemInfoDumpFile();
     _processObj->service_meta_->status_ = GCSERVICE_STATUS_RUNNING;
     _processObj->service_meta_->cond_->Broadcast(self);
   }
@@ -233,6 +216,9 @@ void* GCServiceDaemon::RunDaemon(void* arg) {
 
   IPC_MS_VLOG(INFO) << "GCServiceDaemon left the main loop: " <<
       _daemonObj->thread_->GetTid();
+  std::ostringstream _lanes_os;
+  _daemonObj->DumpLaneStats(_lanes_os);
+  IPC_MS_VLOG(INFO) << _lanes_os.str();
 
   return NULL;
 }
@@ -267,14 +253,21 @@ void GCServiceDaemon::setThreadAffinity(Thread* th, int cpu_id, bool complementa
 }
 
 GCServiceDaemon::GCServiceDaemon(GCServiceProcess* process) :
-         thread_(NULL), processed_index_(0), mem_info_fd_(-1),
-         req_counts_(0), last_global_update_time_ns_(0) {
+         thread_(NULL), processed_index_(0), pending_records_index_(0),
+         pending_count_(0), inflight_gcs_(0), inflight_fg_gcs_(0),
+         dispatch_blocked_(false), out_of_records_(false), req_counts_(0),
+         last_global_update_time_ns_(0),
+         proc_sampler_(new GCSrvcProcSampler("/proc")),
+         agents_mu_(new Mutex("gcService agents")) {
   Thread* self = Thread::Current();
+  memset(pending_records_, 0, sizeof(pending_records_));
+  memset(lanes_stats_, 0, sizeof(lanes_stats_));
   {
     IPMutexLock interProcMu(self, *process->service_meta_->mu_);
     process->service_meta_->status_ = GCSERVICE_STATUS_STARTING;
     pool_size_ = GCServiceGlobalAllocator::allocator_instant_->getWorkerPoolSize();
     workers_pool_ = new WorkStealingThreadPool(pool_size_);
+    max_inflight_gcs_ = GCServiceGlobalAllocator::allocator_instant_->getServiceCores();
     //    registered_apps_.reset(accounting::ATOMIC_MAPPED_STACK_T::Create("registered_apps",
     //        64, false));
     initShutDownSignals();
@@ -315,17 +308,6 @@ bool GCServiceDaemon::waitShutDownSignals(void) {
 }
 
 
-void GCServiceDaemon::SetMemInfoDumpFile(void) {
-  int fd = open("/data/anr/meminfo.data", O_RDWR | O_CREAT, 0777);
-  if (fd == -1) {
-    PLOG(ERROR) << "Unable to open stack trace file '" << "/data/anr/meminfo.data" << "'";
-    return;
-  }
-  mem_info_fd_ = fd;
-
-
-}
-
 class GlobalStatusUpdaterTask : public WorkStealingTask {
  public:
   GCServiceDaemon* service_daemon_;
@@ -357,27 +339,14 @@ class GlobalStatusUpdaterTask : public WorkStealingTask {
       return;
     service_daemon_->last_global_update_time_ns_ = _curr_time;
 
-    //std::string _meminfo_lines;
-
-    service_daemon_->SetMemInfoDumpFile();
-    bool mem_info_result =
-        GCServiceProcess::process_->fileMapperSvc_->UpdateMemInfo(service_daemon_->mem_info_fd_,
-                                                                  "meminfo",
-                                                                  GCServiceDaemon::meminfo_args_,
-                                                                  1);
-    close(service_daemon_->mem_info_fd_);
-
-    if(mem_info_result) {
-
-
-      if(GCSrvcMemInfoOOM::parseMemInfo("/data/anr/meminfo.data")) {
-
-        //      LOG(ERROR) << "total_ram=" << GCSrvcMemInfoOOM::total_ram_ << "\n" <<
-        //          "free_rams: " << GCSrvcMemInfoOOM::free_ram_[0] <<
-        //          "," << GCSrvcMemInfoOOM::free_ram_[1] <<
-        //          "," << GCSrvcMemInfoOOM::free_ram_[2] <<
-        //          "," << GCSrvcMemInfoOOM::free_ram_[3];
-      }
+    std::vector<int> _gone_pids;
+    {
+      MutexLock mu(self, *service_daemon_->agents_mu_);
+      GCSrvcMemInfoOOM::sampleMemInfo(service_daemon_->proc_sampler_,
+                                      &service_daemon_->agents_map_, &_gone_pids);
+    }
+    for(size_t i = 0; i < _gone_pids.size(); i++) {
+      service_daemon_->UnregisterAgent(_gone_pids[i]);
     }
   }
 
@@ -409,7 +378,202 @@ void GCServiceDaemon::UpdateGlobalProcessStates(GC_SERVICE_TASK srvc_task) {
 }
 
 
+GC_SERVICE_REQ_LANE GCServiceDaemon::GetRequestLane(GCServiceReq* entry) {
+  switch(entry->req_type_) {
+    case GC_SERVICE_TASK_GC_ALLOC:
+      return GC_SERVICE_LANE_ALLOC;
+    case GC_SERVICE_TASK_TRIM:
+      return GC_SERVICE_LANE_TRIM;
+    case GC_SERVICE_TASK_STATS:
+      return GC_SERVICE_LANE_STATS;
+    default:
+      break;
+  }
+  GCSrvceAgent* _agent = GetAgentByPid(entry->pid_);
+  if(_agent != NULL &&
+      (GCSrvcMemInfoOOM::CareAboutPauseTimes(_agent->meminfo_rec_) ||
+          _agent->meminfo_rec_->oom_label_ <= 1)) {
+    /* foreground and visible apps */
+    return GC_SERVICE_LANE_FOREGROUND;
+  }
+  return GC_SERVICE_LANE_BACKGROUND;
+}
+
+
+/* Returns NULL when every record is still queued or being served. */
+GCServiceReq* GCServiceDaemon::AllocPendingRecord(void) {
+  for(int i = 0; i < kcGCSrvcPendingCapacity; i++) {
+    GCServiceReq* _rec = &pending_records_[pending_records_index_];
+    pending_records_index_ = (pending_records_index_ + 1) % kcGCSrvcPendingCapacity;
+    int _status = android_atomic_acquire_load(&_rec->status_);
+    if(_status == GC_SERVICE_REQ_NONE || _status == GC_SERVICE_REQ_COMPLETE) {
+      return _rec;
+    }
+  }
+  return NULL;
+}
+
+
+/*
+ * Copies a request out of the shared ring into the lane matching its task
+ * and the oom label of the client. A CONC or TRIM request from a pid that
+ * already has one of the same type waiting is coalesced into it. Fails when
+ * the pending records are exhausted so that the caller leaves the request in
+ * the ring: the clients then block on the full ring instead of the daemon
+ * aborting.
+ */
+bool GCServiceDaemon::EnqueuePendingRequest(GCServiceReq* entry) {
+  GC_SERVICE_REQ_LANE _lane = GetRequestLane(entry);
+  std::deque<GCServiceReq*>* _lane_queue = &pending_lanes_[_lane];
+  if(entry->req_type_ == GC_SERVICE_TASK_CONC ||
+      entry->req_type_ == GC_SERVICE_TASK_TRIM) {
+    for(std::deque<GCServiceReq*>::iterator it = _lane_queue->begin();
+        it != _lane_queue->end(); ++it) {
+      if((*it)->pid_ == entry->pid_ && (*it)->req_type_ == entry->req_type_) {
+        lanes_stats_[_lane].coalesced_count_++;
+        entry->status_ = GC_SERVICE_REQ_NONE;
+        return true;
+      }
+    }
+  }
+  GCServiceReq* _rec = AllocPendingRecord();
+  out_of_records_ = (_rec == NULL);
+  if(out_of_records_)
+    return false;
+  _rec->pid_ = entry->pid_;
+  _rec->req_type_ = entry->req_type_;
+  _rec->data_addr_ = entry->data_addr_;
+  _rec->enqueue_ns_ = entry->enqueue_ns_;
+  _rec->lane_ = _lane;
+  _rec->status_ = GC_SERVICE_REQ_NEW;
+  _lane_queue->push_back(_rec);
+  pending_count_++;
+  return true;
+}
+
+
+/*
+ * A collection lane is served only while fewer than max_inflight_gcs_
+ * collections are running. Background collections also wait for all the
+ * foreground (and allocation) collections to finish.
+ */
+bool GCServiceDaemon::CanDispatchLane(int lane) {
+  if(!IsCollectionLane(lane))
+    return true;
+  if(android_atomic_acquire_load(&inflight_gcs_) >= max_inflight_gcs_)
+    return false;
+  if(lane == GC_SERVICE_LANE_BACKGROUND &&
+      android_atomic_acquire_load(&inflight_fg_gcs_) > 0)
+    return false;
+  return true;
+}
+
+
+/*
+ * Picks the request to serve from a lane. Requests of an agent that already
+ * has a collection running are skipped since its collector would merge them.
+ * The foreground and background lanes are ordered by the reclaimable bytes
+ * per service-ms of the agents; the other lanes are FIFO.
+ */
+std::deque<GCServiceReq*>::iterator GCServiceDaemon::SelectFromLane(int lane) {
+  std::deque<GCServiceReq*>* _lane_queue = &pending_lanes_[lane];
+  if(!IsCollectionLane(lane))
+    return _lane_queue->begin();
+  bool _by_rate = (lane != GC_SERVICE_LANE_ALLOC);
+  std::deque<GCServiceReq*>::iterator _selected = _lane_queue->end();
+  double _selected_rate = 0.0;
+  for(std::deque<GCServiceReq*>::iterator it = _lane_queue->begin();
+      it != _lane_queue->end(); ++it) {
+    GCSrvceAgent* _agent = GetAgentByPid((*it)->pid_);
+    if(_agent == NULL)
+      return it;
+    if(android_atomic_acquire_load(&_agent->gc_inflight_lane_) >= 0)
+      continue;
+    if(!_by_rate)
+      return it;
+    double _rate = _agent->GetReclaimRate();
+    if(_selected == _lane_queue->end() || _rate > _selected_rate) {
+      _selected = it;
+      _selected_rate = _rate;
+    }
+  }
+  return _selected;
+}
+
+
+GCServiceReq* GCServiceDaemon::DequeuePendingRequest(void) {
+  for(int _lane = 0; _lane < GC_SERVICE_LANE_MAX_LIMIT; _lane++) {
+    if(pending_lanes_[_lane].empty())
+      continue;
+    GCSrvcLaneStats* _stats = &lanes_stats_[_lane];
+    std::deque<GCServiceReq*>::iterator _it = pending_lanes_[_lane].end();
+    if(CanDispatchLane(_lane))
+      _it = SelectFromLane(_lane);
+    if(_it == pending_lanes_[_lane].end()) {
+      _stats->deferred_count_++;
+      continue;
+    }
+    GCServiceReq* _rec = *_it;
+    pending_lanes_[_lane].erase(_it);
+    pending_count_--;
+    uint64_t _curr_time = NanoTime();
+    uint64_t _wait_ns =
+        (_curr_time > _rec->enqueue_ns_) ? (_curr_time - _rec->enqueue_ns_) : 0;
+    _stats->processed_count_++;
+    _stats->total_wait_ns_ += _wait_ns;
+    _stats->max_wait_ns_ = std::max(_stats->max_wait_ns_, _wait_ns);
+    dispatch_blocked_ = false;
+    return _rec;
+  }
+  /* everything left has to wait for a running collection to finish */
+  dispatch_blocked_ = (pending_count_ > 0);
+  return NULL;
+}
+
+
+/* Called by the daemon right before the request is handed to the collector. */
+void GCServiceDaemon::CollectionStarted(GCSrvceAgent* agent, GCServiceReq* req) {
+  int32_t _lane = req->lane_;
+  android_atomic_release_store(_lane, &agent->gc_inflight_lane_);
+  android_atomic_inc(&inflight_gcs_);
+  if(_lane != GC_SERVICE_LANE_BACKGROUND)
+    android_atomic_inc(&inflight_fg_gcs_);
+}
+
+
+/* Called by the collector thread of the agent once its collection completes. */
+void GCServiceDaemon::CollectionFinished(GCSrvceAgent* agent) {
+  int32_t _lane = android_atomic_acquire_load(&agent->gc_inflight_lane_);
+  if(_lane < 0)
+    return;
+  android_atomic_release_store(-1, &agent->gc_inflight_lane_);
+  if(_lane != GC_SERVICE_LANE_BACKGROUND)
+    android_atomic_dec(&inflight_fg_gcs_);
+  android_atomic_dec(&inflight_gcs_);
+  GCServiceProcess::process_->handShake_->requests_ring_.Kick();
+}
+
+
+void GCServiceDaemon::DumpLaneStats(std::ostream& os) {
+  static const char* _lanes_names[] = {
+      "alloc", "foreground", "background", "trim", "stats"
+  };
+  for(int _lane = 0; _lane < GC_SERVICE_LANE_MAX_LIMIT; _lane++) {
+    GCSrvcLaneStats* _stats = &lanes_stats_[_lane];
+    uint64_t _mean_wait = (_stats->processed_count_ == 0) ? 0 :
+        _stats->total_wait_ns_ / _stats->processed_count_;
+    os << "GCService lane " << _lanes_names[_lane]
+       << ": processed=" << _stats->processed_count_
+       << ", coalesced=" << _stats->coalesced_count_
+       << ", mean queue wait=" << PrettyDuration(_mean_wait)
+       << ", max queue wait=" << PrettyDuration(_stats->max_wait_ns_)
+       << ", deferred=" << _stats->deferred_count_ << "\n";
+  }
+}
+
+
 void GCServiceDaemon::mainLoop(void) {
+  ReapRetiredAgents();
   GCServiceProcess::process_->handShake_->ListenToRequests(this);
 }
 
@@ -452,12 +616,31 @@ GCSrvceAgent::GCSrvceAgent(android::MappedPairProcessFD* mappedPair) {
     hist_rec->heap_size_ = 0;
     hist_rec->memory_size_ = 0;
     hist_rec->oom_label_ = 0;
+    hist_rec->gc_freed_bytes_ = 0;
+    hist_rec->gc_cost_ns_ = 0;
   }
 
   srvc_requests_ = 0;
+  gc_inflight_lane_ = -1;
 
 }
 
+GCSrvceAgent::~GCSrvceAgent() {
+  collector_->Stop();
+  delete collector_;
+  android::FileMapperParameters* _maps = binding_.pair_mapps_->second;
+  for(int i = 0; i < _maps->fd_count_; i++) {
+    android::IPCAShmemMap* _map = &(_maps->mem_maps_[i]);
+    if(munmap(reinterpret_cast<void*>(_map->begin_), _map->size_) == -1) {
+      PLOG(ERROR) << "GCSrvceAgent: munmap failed for fd " << _map->fd_;
+    }
+    close(_map->fd_);
+  }
+  free(binding_.pair_mapps_->first);
+  free(_maps);
+  delete binding_.pair_mapps_;
+}
+
 void GCSrvceAgent::UpdateRequestStatus(GCServiceReq* request_addr) {
   if(request_addr->status_ == GC_SERVICE_REQ_STARTED) {
     //    LOG(ERROR) << " GCSrvceAgent::UpdateRequestStatus A..addr="
@@ -497,10 +680,43 @@ void GCSrvceAgent::updateOOMLabel(int new_label, long memory_size) {
   }
 
   hist_rec->oom_label_ = new_label;
+  hist_rec->gc_freed_bytes_ = 0;
+  hist_rec->gc_cost_ns_ = 0;
   meminfo_rec_->last_update_ns_ = NanoTime();
 }
 
 
+/*
+ * Accounts a finished collection to the current history window. The windows
+ * are rotated by the sampler concurrently, so the counters are estimates.
+ */
+void GCSrvceAgent::RecordCollection(uint64_t freed_bytes, uint64_t cost_ns) {
+  int _curr_window =
+      (meminfo_rec_->histor_tail_ + history_size_ - 1) % history_size_;
+  AgentMemInfoHistory* hist_rec = &(meminfo_rec_->history_wins_[_curr_window]);
+  hist_rec->gc_freed_bytes_ += freed_bytes;
+  hist_rec->gc_cost_ns_ += cost_ns;
+}
+
+
+/*
+ * Bytes reclaimed per ms of service time over the history windows. An agent
+ * that was never collected gets the highest rate so it is measured first.
+ */
+double GCSrvceAgent::GetReclaimRate(void) {
+  uint64_t _freed_bytes = 0;
+  uint64_t _cost_ns = 0;
+  for(int i = 0; i < history_size_; i++) {
+    AgentMemInfoHistory* hist_rec = &(meminfo_rec_->history_wins_[i]);
+    _freed_bytes += hist_rec->gc_freed_bytes_;
+    _cost_ns += hist_rec->gc_cost_ns_;
+  }
+  if(_cost_ns == 0)
+    return std::numeric_limits<double>::max();
+  return (_freed_bytes * 1000000.0) / _cost_ns;
+}
+
+
 bool GCSrvceAgent::signalMyCollectorDaemon(GCServiceReq* gcsrvc_req) {
 
   if(false) {
@@ -555,10 +771,10 @@ bool GCServiceProcess::initSvcFD(void) {
   IPMutexLock interProcMu(thread_, *service_meta_->mu_);
   if(fileMapperSvc_ == NULL) {
     fileMapperSvc_ =
-        android::FileMapperService::CreateFileMapperSvc();
-    returnRes = android::FileMapperService::IsServiceReady();
+        GCSrvcFileMapper::CreateFileMapperSvc();
+    returnRes = GCSrvcFileMapper::IsServiceReady();
   } else {
-    returnRes = android::FileMapperService::Reconnect();
+    returnRes = GCSrvcFileMapper::Reconnect();
   }
 
   if(returnRes) {
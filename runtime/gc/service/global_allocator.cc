@@ -62,6 +62,7 @@ void GCServiceGlobalAllocator::InitGCSrvcOptions(GCSrvc_Options* opts_addr) {
   opts_addr->add_conc_remote_latency_ = GC_SERVICE_OPTS_LATENCY_ADD;
   opts_addr->save_mem_profile_ = GC_SERVICE_OPTS_SAVE_PROF_DISABLE;
   opts_addr->work_stealing_workers_ = 3;
+  opts_addr->service_cores_ = 0;
   opts_addr->power_strategies_ = GC_SERVICE_OPTS_POWER_POLICY_NONE;
 
   opts_addr->info_history_size_ = MEM_INFO_WINDOW_SIZE;
@@ -156,6 +157,9 @@ bool GCServiceGlobalAllocator::GCSrvcOption(const std::string& option, GCSrvc_Op
       } else if (gcsrvc_options[i] == "workers") {
         opts_addr->work_stealing_workers_ = atoi(gcsrvc_options[++i].c_str());
         return true;
+      } else if (gcsrvc_options[i] == "cores") {
+        opts_addr->service_cores_ = atoi(gcsrvc_options[++i].c_str());
+        return true;
       } else if (gcsrvc_options[i] == "power") {
         opts_addr->power_strategies_ = atoi(gcsrvc_options[++i].c_str());
         return true;
@@ -357,7 +361,7 @@ GCServiceGlobalAllocator::GCServiceGlobalAllocator(/*int pages*/) :
 
   int flags = MAP_SHARED;
 
-  fileDescript = ashmem_create_region("GlobalAllocator", memory_size);
+  fileDescript = CreateServiceSharedRegion("GlobalAllocator", memory_size);
 
   byte* begin =
       reinterpret_cast<byte*>(mmap(NULL, memory_size, prot, flags,
@@ -416,19 +420,12 @@ byte* GCServiceGlobalAllocator::AllocateSharableSpace(int* index_p) {
 }
 
 
-void GCSrvcClientHandShake::ResetRequestEntry(GCServiceReq* entry) {
-  memset(entry, 0, sizeof(GCServiceReq));
-}
-
 void GCSrvcClientHandShake::ResetProcessMap(android::FileMapperParameters* record) {
   memset(record, 0, sizeof(android::FileMapperParameters));
 }
 
 void GCSrvcClientHandShake::Init() {
-  gcservice_data_->available_ = KGCRequestBufferCapacity;
-  gcservice_data_->queued_ = 0;
-  gcservice_data_->tail_ = 0;
-  gcservice_data_->head_ = KGCRequestBufferCapacity - 1;
+  requests_ring_.Init();
 
   SharedFutexData* _futexAddress = &gcservice_data_->lock_.futex_head_;
   SharedConditionVarData* _condAddress = &gcservice_data_->lock_.cond_var_;
@@ -442,11 +439,6 @@ void GCSrvcClientHandShake::Init() {
   for(int i = 0; i < KProcessMapperCapacity; i++) {
     ResetProcessMap(&(gcservice_data_->process_mappers_[i]));
   }
-
-  for(int i = 0; i < KGCRequestBufferCapacity; i++) {
-    ResetRequestEntry(&(gcservice_data_->entries_[i]));
-  }
-
 }
 
 
@@ -456,135 +448,128 @@ void GCSrvcClientHandShake::Init() {
 
 
 GCSrvcClientHandShake::GCSrvcClientHandShake(GCServiceRequestsBuffer* alloc_mem) :
-    gcservice_data_(alloc_mem) {
+    gcservice_data_(alloc_mem),
+    requests_ring_(&alloc_mem->requests_ring_) {
   Init();
 }
 
 
-
-#define GC_BUFFER_PUSH_REQUEST(ENTRY, THREAD) \
-    ScopedThreadStateChange tsc(THREAD, kWaitingForGCProcess);  \
-    IPMutexLock interProcMu(THREAD, *gcservice_data_->mu_);\
-    while(gcservice_data_->available_ == 0) {\
-      LOG(ERROR) << "Push: no space available";\
-      gcservice_data_->cond_->Wait(THREAD);\
-    }\
-    GCSERVICE_ALLOC_VLOG(ERROR) << "passed the condition of the available space";\
-    gcservice_data_->head_ = ((gcservice_data_->head_ + 1) %  KGCRequestBufferCapacity); \
-    gcservice_data_->available_ = gcservice_data_->available_ - 1;\
-    gcservice_data_->queued_ = gcservice_data_->queued_ + 1;\
-    GCSERVICE_ALLOC_VLOG(ERROR) << "push: updating entry# " << gcservice_data_->head_;\
-    ENTRY = &(gcservice_data_->entries_[gcservice_data_->head_]);\
-    ENTRY->pid_ = getpid();\
-    ENTRY->status_ = GC_SERVICE_REQ_NEW;
-
-
-GCServiceReq* GCSrvcClientHandShake::ReqConcCollection(void* args) {
+/*
+ * Claims a slot in the lock-free ring, fills it and publishes it. The daemon
+ * is only woken up when it is sleeping on an empty ring.
+ */
+GCServiceReq* GCSrvcClientHandShake::PushRequest(GC_SERVICE_TASK req_type,
+                                                 uintptr_t data_addr) {
   Thread* self = Thread::Current();
+  int32_t _ticket = 0;
   GCServiceReq* _entry = NULL;
+  {
+    ScopedThreadStateChange tsc(self, kWaitingForGCProcess);
+    _entry = requests_ring_.ClaimRequest(&_ticket);
+  }
+  GCSERVICE_ALLOC_VLOG(ERROR) << "push: updating ticket# " << _ticket;
+  _entry->pid_ = getpid();
+  _entry->req_type_ = req_type;
+  _entry->data_addr_ = data_addr;
+  _entry->enqueue_ns_ = NanoTime();
+  _entry->status_ = GC_SERVICE_REQ_NEW;
+  requests_ring_.PublishRequest(_ticket);
+  return _entry;
+}
 
-  GC_BUFFER_PUSH_REQUEST(_entry, self);
-
-  _entry->req_type_ = GC_SERVICE_TASK_CONC;
-  _entry->data_addr_ = (uintptr_t)args;
 
-  gcservice_data_->cond_->Broadcast(self);
-  return _entry;
+GCServiceReq* GCSrvcClientHandShake::ReqConcCollection(void* args) {
+  return PushRequest(GC_SERVICE_TASK_CONC, (uintptr_t)args);
 }
 
 
 GCServiceReq* GCSrvcClientHandShake::ReqAllocationGC(void* args) {
-  Thread* self = Thread::Current();
-  GCServiceReq* _entry = NULL;
-  GC_BUFFER_PUSH_REQUEST(_entry, self);
-
-  _entry->req_type_ = GC_SERVICE_TASK_GC_ALLOC;
-  _entry->data_addr_ = (uintptr_t)args;
-  gcservice_data_->cond_->Broadcast(self);
-  return _entry;
+  return PushRequest(GC_SERVICE_TASK_GC_ALLOC, (uintptr_t)args);
 }
 
 GCServiceReq* GCSrvcClientHandShake::ReqExplicitCollection(void* args) {
-  Thread* self = Thread::Current();
-  GCServiceReq* _entry = NULL;
-
-  GC_BUFFER_PUSH_REQUEST(_entry, self);
-
-  _entry->req_type_ = GC_SERVICE_TASK_EXPLICIT;
-  _entry->data_addr_ = (uintptr_t)args;
-
-
-  gcservice_data_->cond_->Broadcast(self);
-  return _entry;
+  return PushRequest(GC_SERVICE_TASK_EXPLICIT, (uintptr_t)args);
 }
 
 GCServiceReq* GCSrvcClientHandShake::ReqHeapTrim() {
-  Thread* self = Thread::Current();
-  GCServiceReq* _entry = NULL;
-
-  GC_BUFFER_PUSH_REQUEST(_entry, self);
-
-  _entry->req_type_ = GC_SERVICE_TASK_TRIM;
-
-  gcservice_data_->cond_->Broadcast(self);
-
-  return _entry;
+  return PushRequest(GC_SERVICE_TASK_TRIM, 0);
 }
 
 void GCSrvcClientHandShake::ReqUpdateStats(void) {
+  PushRequest(GC_SERVICE_TASK_STATS, 0);
+}
+
+
+/*
+ * Claims the next mapper record. The record stays owned by the client until
+ * it is published with PublishMapperRecord.
+ */
+android::FileMapperParameters* GCSrvcClientHandShake::ClaimMapperRecord(void) {
   Thread* self = Thread::Current();
-  GCServiceReq* _entry = NULL;
+  ScopedThreadStateChange tsc(self, kWaitingForGCProcess);
+  IPMutexLock interProcMu(self, *gcservice_data_->mu_);
+  gcservice_data_->mapper_head_ =
+      ((gcservice_data_->mapper_head_ + 1) % KProcessMapperCapacity);
+  return &(gcservice_data_->process_mappers_[gcservice_data_->mapper_head_]);
+}
 
-  GC_BUFFER_PUSH_REQUEST(_entry, self);
 
-  _entry->req_type_ = GC_SERVICE_TASK_STATS;
+void GCSrvcClientHandShake::PublishMapperRecord(android::FileMapperParameters* rec) {
+  bool _svcRes =
+    GCSrvcFileMapper::MapFds(rec);
+  if(_svcRes) {
+    GCSERVICE_ALLOC_VLOG(ERROR) << " __________ GCSrvcClientHandShake::GetMapperRecord:  succeeded; " <<
+        rec->process_id_ << ", "<< rec->space_index_ <<", "<< rec->fd_count_
+        <<", "<< rec->mem_maps_[0].fd_;
 
 
+  } else {
+    LOG(FATAL) << " __________ GCSrvcClientHandShake::GetMapperRecord:  Failed";
+  }
 
-  gcservice_data_->cond_->Broadcast(self);
-  return;
+  /* publish the request only after the mapper record is filled */
+  PushRequest(GC_SERVICE_TASK_REG, reinterpret_cast<uintptr_t>(rec));
 }
 
 
 void GCSrvcClientHandShake::ReqRegistration(void* params) {
-  Thread* self = Thread::Current();
-  GCServiceReq* _entry = NULL;
-
-  GC_BUFFER_PUSH_REQUEST(_entry, self);
-
-  _entry->req_type_ = GC_SERVICE_TASK_REG;
-
-
   GCSrvSharableDlMallocSpace* _shared_space =
       reinterpret_cast<GCSrvSharableDlMallocSpace*>(params);
 
-
-  gcservice_data_->mapper_head_ =
-      ((gcservice_data_->mapper_head_ + 1) % KProcessMapperCapacity);
-  android::FileMapperParameters* _rec =
-      &(gcservice_data_->process_mappers_[gcservice_data_->mapper_head_]);
+  android::FileMapperParameters* _rec = ClaimMapperRecord();
   _rec->process_id_  = getpid();
   _rec->space_index_ = _shared_space->space_index_;
   _rec->fd_count_ = IPC_FILE_MAPPER_CAPACITY;
   _rec->shared_space_addr_ = _shared_space;
   //_rec->java_lang_Class_cached_ = Class::GetJavaLangClass();
 
-  _entry->data_addr_ = reinterpret_cast<uintptr_t>(_rec);
-
   GCServiceClient::service_client_->FillMemMapData(_rec);
-  bool _svcRes =
-    android::FileMapperService::MapFds(_rec);
-  if(_svcRes) {
-    GCSERVICE_ALLOC_VLOG(ERROR) << " __________ GCSrvcClientHandShake::GetMapperRecord:  succeeded; " <<
-        _rec->process_id_ << ", "<< _rec->space_index_ <<", "<< _rec->fd_count_
-        <<", "<< _rec->mem_maps_[0].fd_;
+  PublishMapperRecord(_rec);
+}
 
 
-  } else {
-    LOG(FATAL) << " __________ GCSrvcClientHandShake::GetMapperRecord:  Failed";
+/*
+ * Copies the mapper record of a REG request into rec, frees its slot and
+ * swaps the client's descriptors for the fds received by the file mapper.
+ */
+bool GCSrvcClientHandShake::ImportMapperRecord(GCServiceReq* entry,
+                                               android::FileMapperParameters* rec) {
+  android::FileMapperParameters* _fMapsP =
+      reinterpret_cast<android::FileMapperParameters*>(entry->data_addr_);
+  {
+    IPMutexLock interProcMu(Thread::Current(), *gcservice_data_->mu_);
+    gcservice_data_->mapper_tail_ =
+        ((gcservice_data_->mapper_tail_ + 1) % KProcessMapperCapacity);
   }
-
-  gcservice_data_->cond_->Broadcast(self);
+  rec->process_id_ = _fMapsP->process_id_;
+  rec->space_index_ = _fMapsP->space_index_;
+  rec->fd_count_ = _fMapsP->fd_count_;
+  rec->shared_space_addr_ = _fMapsP->shared_space_addr_;
+  for(int i = 0; i < rec->fd_count_; i++) {
+    memcpy((void*)&(rec->mem_maps_[i]), &(_fMapsP->mem_maps_[i]),
+        sizeof(android::IPCAShmemMap));
+  }
+  return GCSrvcFileMapper::GetMapFds(rec);
 }
 
 
@@ -602,10 +587,9 @@ void GCSrvcClientHandShake::ReqRegistration(void* params) {
     } \
   } while (false)
 
-GC_SERVICE_TASK GCSrvcClientHandShake::ProcessGCRequest(void* args) {
-  GCServiceReq* _entry = NULL;
+GC_SERVICE_TASK GCSrvcClientHandShake::ProcessGCRequest(GCServiceReq* _entry,
+                                                        void* args) {
   GC_SERVICE_TASK _process_result = GC_SERVICE_TASK_NOP;
-  _entry = &(gcservice_data_->entries_[gcservice_data_->tail_]);
 
   if(_entry->status_ == GC_SERVICE_REQ_NEW) {
     _entry->status_ = GC_SERVICE_REQ_STARTED;
@@ -615,14 +599,6 @@ GC_SERVICE_TASK GCSrvcClientHandShake::ProcessGCRequest(void* args) {
     }
   }
 
-  gcservice_data_->tail_ =
-      ((gcservice_data_->tail_ + 1) % KGCRequestBufferCapacity);
-  gcservice_data_->available_ = gcservice_data_->available_ + 1;
-  gcservice_data_->queued_ = gcservice_data_->queued_ - 1;
-
-
-
-
   GC_SERVICE_TASK _req_type =
       static_cast<GC_SERVICE_TASK>(_entry->req_type_);
 
@@ -632,9 +608,6 @@ GC_SERVICE_TASK GCSrvcClientHandShake::ProcessGCRequest(void* args) {
     android::FileMapperParameters* _fMapsP =
         reinterpret_cast<android::FileMapperParameters*>(_entry->data_addr_);
 
-    gcservice_data_->mapper_tail_ =
-        ((gcservice_data_->mapper_tail_ + 1) % KProcessMapperCapacity);
-
     android::FileMapperParameters* _f_map_params_a =
         reinterpret_cast<android::FileMapperParameters*>(calloc(1,
             sizeof(android::FileMapperParameters)));
@@ -652,17 +625,7 @@ GC_SERVICE_TASK GCSrvcClientHandShake::ProcessGCRequest(void* args) {
         sizeof(android::FileMapperParameters));
     android::FileMapperParameters* _recSecond = _newPairEntry->second;
 
-
-    _recSecond->process_id_ = _fMapsP->process_id_;
-    _recSecond->space_index_ = _fMapsP->space_index_;
-    _recSecond->fd_count_ = _fMapsP->fd_count_;
-    _recSecond->shared_space_addr_ = _fMapsP->shared_space_addr_;
-    for(int i = 0; i < _recSecond->fd_count_; i++) {
-      memcpy((void*)&(_recSecond->mem_maps_[i]), &(_fMapsP->mem_maps_[i]),
-          sizeof(android::IPCAShmemMap));
-    }
-    bool _svcRes =
-        android::FileMapperService::GetMapFds(_recSecond);
+    bool _svcRes = ImportMapperRecord(_entry, _recSecond);
     uintptr_t _mapping_addr = (uintptr_t) 0x00000000;
     if(_svcRes) {
       /*GCServiceProcess::process_->import_address_*/;
@@ -796,8 +759,7 @@ GC_SERVICE_TASK GCSrvcClientHandShake::ProcessGCRequest(void* args) {
         }
       }
      // _daemon->client_agents_.push_back(new GCSrvceAgent(_newPairEntry));
-      _daemon->agents_map_.Put(_newPairEntry->first->process_id_,
-                               new GCSrvceAgent(_newPairEntry));
+      _daemon->RegisterAgent(new GCSrvceAgent(_newPairEntry));
       _entry->status_ = GC_SERVICE_REQ_NONE;
       _process_result = GC_SERVICE_TASK_REG;
     } else {
@@ -827,6 +789,9 @@ GC_SERVICE_TASK GCSrvcClientHandShake::ProcessGCRequest(void* args) {
            _fwd_request = false;
          }*/
          if(_fwd_request) {
+           if((_req_type & GC_SERVICE_TASK_GC_ANY) > 0) {
+             _dmon->CollectionStarted(_agent, _entry);
+           }
            if(_agent->signalMyCollectorDaemon(_entry)) {
              _process_result = _req_type;
            }
@@ -842,21 +807,54 @@ GC_SERVICE_TASK GCSrvcClientHandShake::ProcessGCRequest(void* args) {
 
 void GCSrvcClientHandShake::ListenToRequests(void* args) {
   Thread* self = Thread::Current();
-  GC_SERVICE_TASK _srvc_task;
+  GCServiceDaemon* _daemon = reinterpret_cast<GCServiceDaemon*>(args);
+  GC_SERVICE_TASK _srvc_task = GC_SERVICE_TASK_NOP;
   ScopedThreadStateChange tsc(self, kWaitingForGcToComplete);
-  {
-    IPMutexLock interProcMu(self, *gcservice_data_->mu_);
-    while(gcservice_data_->queued_ == 0) {
-      gcservice_data_->cond_->Wait(self);
-
-    }
-    _srvc_task = ProcessGCRequest(args);
-    gcservice_data_->cond_->Broadcast(self);
-    if(_srvc_task != GC_SERVICE_TASK_NOP) {
-      GCServiceProcess::process_->daemon_->UpdateGlobalProcessStates(_srvc_task);
+  GCServiceReq* _entry = NULL;
+  if(_daemon->IsOutOfRecords() &&
+      (_daemon->IsDispatchBlocked() || !_daemon->HasPendingRequests())) {
+    /* nothing can leave the ring before a served request frees its record */
+    requests_ring_.WaitForKick();
+    _entry = requests_ring_.TryPeekRequest();
+  } else if(_daemon->IsDispatchBlocked()) {
+    /* the pending requests wait for a collection to finish */
+    _entry = requests_ring_.WaitForRequestOrKick();
+  } else if(_daemon->HasPendingRequests()) {
+    _entry = requests_ring_.TryPeekRequest();
+  } else {
+    _entry = requests_ring_.WaitForRequest();
+  }
+  /*
+   * Drain everything published so far into the priority lanes of the daemon.
+   * Registrations are handled right away so that the following requests
+   * find their agents.
+   */
+  while(_entry != NULL) {
+    if(_entry->req_type_ == GC_SERVICE_TASK_REG) {
+      _srvc_task = ProcessGCRequest(_entry, args);
+      if(_srvc_task != GC_SERVICE_TASK_NOP) {
+        _daemon->UpdateGlobalProcessStates(_srvc_task);
+      }
+    } else if(!_daemon->EnqueuePendingRequest(_entry)) {
+      /* out of pending records: the request stays in the ring */
+      break;
     }
+    requests_ring_.ReleaseRequest();
+    _entry = requests_ring_.TryPeekRequest();
   }
 
+  _entry = _daemon->DequeuePendingRequest();
+  if(_entry == NULL)
+    return;
+  _srvc_task = ProcessGCRequest(_entry, args);
+  if(_srvc_task != GC_SERVICE_TASK_NOP) {
+    _daemon->UpdateGlobalProcessStates(_srvc_task);
+  }
+  if(_entry->status_ != GC_SERVICE_REQ_STARTED ||
+      _srvc_task == GC_SERVICE_TASK_NOP) {
+    /* the request was not forwarded to a collector: recycle its record */
+    _entry->status_ = GC_SERVICE_REQ_NONE;
+  }
 }
 
 
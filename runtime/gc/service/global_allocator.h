@@ -8,6 +8,7 @@
 #ifndef ART_RUNTIME_GC_SERVICE_GLOBAL_ALLOCATOR_H_
 #define ART_RUNTIME_GC_SERVICE_GLOBAL_ALLOCATOR_H_
 
+#include <deque>
 #include <set>
 #include <vector>
 #include "safe_map.h"
@@ -18,11 +19,11 @@
 #include "runtime.h"
 #include "thread_pool.h"
 #include "gc/space/space.h"
+#include "gc/service/host_ipc.h"
+#include "gc/service/request_ring.h"
 
 #if (ART_GC_SERVICE)
 
-#define GC_SERVICE_BUFFER_REQ_CAP   128
-
 
 #define GCSERVICE_ALLOC_VLOG_ON 0
 #define GCSERVICE_ALLOC_VLOG(severity)  if (GCSERVICE_ALLOC_VLOG_ON) ::art::LogMessage(__FILE__, __LINE__, severity, -1).stream()
@@ -71,6 +72,17 @@ typedef enum {
 } GC_SERVICE_REQ_STATUS;
 
 
+/* priority lanes used by the daemon to order pending requests */
+typedef enum {
+  GC_SERVICE_LANE_ALLOC = 0,
+  GC_SERVICE_LANE_FOREGROUND,
+  GC_SERVICE_LANE_BACKGROUND,
+  GC_SERVICE_LANE_TRIM,
+  GC_SERVICE_LANE_STATS,
+  GC_SERVICE_LANE_MAX_LIMIT
+} GC_SERVICE_REQ_LANE;
+
+
 typedef enum {
   GC_SERVICE_HANDLE_ALLOC_NONE = 0,
   GC_SERVICE_HANDLE_ALLOC_MUT,
@@ -137,24 +149,13 @@ typedef enum {
 //  volatile int head_;
 //} __attribute__((aligned(8))) GCServiceClientHandShake;
 
-typedef struct GCServiceConcReq_S {
-  volatile int pid_;
-  volatile int req_type_;
-  volatile int status_;
-  volatile uintptr_t data_addr_;
-} __attribute__((aligned(8))) GCServiceReq;
-
 typedef struct GCServiceRequestsBuffer_S {
+  /* GC requests are pushed without locking through the ring */
+  GCServiceReqRing requests_ring_;
+  /* the lock only guards the process mappers used for registration */
   SynchronizedLockHead lock_;
-  GCServiceReq entries_[GC_SERVICE_BUFFER_REQ_CAP];
   android::FileMapperParameters process_mappers_[IPC_PROCESS_MAPPER_CAPACITY];
 
-  volatile int head_;
-  volatile int tail_;
-  volatile int queued_;
-  volatile int available_;
-
-
   InterProcessMutex* mu_;
   InterProcessConditionVariable* cond_;
 
@@ -205,17 +206,21 @@ class GCSrvcClientHandShake {
   GCServiceReq* ReqExplicitCollection(void*);
   GCServiceReq* ReqAllocationGC(void*);
   void ReqRegistration(void*);
+  android::FileMapperParameters* ClaimMapperRecord(void);
+  void PublishMapperRecord(android::FileMapperParameters* rec);
+  bool ImportMapperRecord(GCServiceReq* entry, android::FileMapperParameters* rec);
   GCServiceReq* ReqHeapTrim(void);
   void ReqUpdateStats(void);
 
   void ListenToRequests(void*);
-  GC_SERVICE_TASK ProcessGCRequest(void* args);
+  GC_SERVICE_TASK ProcessGCRequest(GCServiceReq* entry, void* args);
   //GCServiceClientHandShake* mem_data_;
   GCServiceRequestsBuffer* gcservice_data_;
+  GCSrvcRequestRing requests_ring_;
  private:
   void Init();
   void ResetProcessMap(android::FileMapperParameters*);
-  void ResetRequestEntry(GCServiceReq* entry);
+  GCServiceReq* PushRequest(GC_SERVICE_TASK req_type, uintptr_t data_addr);
 
 }; //class GCSrvcClientHandShake
 
@@ -257,6 +262,12 @@ typedef struct GCSrvc_Options_S {
   /* number of threads in the work stealing pool to serve the GCDaemon */
   int work_stealing_workers_;
 
+  /*
+   * number of cores given to the service. Caps the collections running at
+   * the same time. 0 means all the online cores.
+   */
+  int service_cores_;
+
   /* configuration of the strategy used to manage for power profiling */
   int power_strategies_;
 
@@ -296,6 +307,13 @@ class GCServiceGlobalAllocator {
     return srvc_options_.work_stealing_workers_;
   }
 
+  int getServiceCores(void) const {
+    if(srvc_options_.service_cores_ > 0)
+      return srvc_options_.service_cores_;
+    long _online_cores = sysconf(_SC_NPROCESSORS_ONLN);
+    return (_online_cores > 0) ? static_cast<int>(_online_cores) : 1;
+  }
+
   bool isAddRemoteConcLatency() const {
     return (srvc_options_.add_conc_remote_latency_ == GC_SERVICE_OPTS_LATENCY_ADD);
   }
@@ -379,6 +397,7 @@ class GCServiceGlobalAllocator {
 
 class GCServiceProcess;
 class GCSrvceAgent;
+class GCSrvcProcSampler;
 
 
 typedef struct GCServiceClientRecord_S {
@@ -393,8 +412,13 @@ class ServerCollector {
  public:
   ServerCollector(GCServiceClientRecord* client_rec,
       space::GCSrvSharableHeapData* meta_alloc);
+  ~ServerCollector();
 
   void Run(void);
+  /* asks the collector thread to leave Run and joins it */
+  void Stop(void) LOCKS_EXCLUDED(run_mu_);
+  /* true when no request is queued for or being served by the collector */
+  bool IsIdle(void) LOCKS_EXCLUDED(run_mu_);
   void InitPool(void);
   space::GCSrvSharableHeapData* heap_data_;
   Mutex run_mu_ DEFAULT_MUTEX_ACQUIRED_AFTER;
@@ -403,6 +427,8 @@ class ServerCollector {
   pthread_t pthread_ GUARDED_BY(run_mu_);
 
   volatile int status_ GUARDED_BY(run_mu_);
+  bool stop_requested_ GUARDED_BY(run_mu_);
+  bool serving_ GUARDED_BY(run_mu_);
 
 
   InterProcessMutex* phase_mu_;
@@ -433,6 +459,8 @@ class ServerCollector {
   static ServerCollector* CreateServerCollector(void* args);
 
   ThreadPool* gc_workers_pool_;
+  /* drains the client mark stack; gc_workers_pool_ is busy with the phase tasks */
+  ThreadPool* mark_workers_pool_;
   /*********** task queues ************/
   Mutex shake_hand_mu_ DEFAULT_MUTEX_ACQUIRED_AFTER;
   ConditionVariable shake_hand_cond_ GUARDED_BY(shake_hand_mu_);
@@ -461,6 +489,8 @@ class GCSrvceAgent {
  public:
 
   GCSrvceAgent(android::MappedPairProcessFD*);
+  /* stops the collector and unmaps the spaces of the client */
+  ~GCSrvceAgent();
   ServerCollector* collector_;
   GCServiceClientRecord binding_;
   volatile int process_id_;
@@ -475,12 +505,23 @@ class GCSrvceAgent {
   std::vector<GCServiceReq*> active_requests_;
   void UpdateRequestStatus(GCServiceReq*);
 
+  /*
+   * lane of the collection forwarded to the collector of the agent, or -1
+   * when the collector is idle. Written by the daemon and by the collector.
+   */
+  volatile int32_t gc_inflight_lane_;
+  void RecordCollection(uint64_t freed_bytes, uint64_t cost_ns);
+  double GetReclaimRate(void);
+
 
  private:
 
 };//class GCSrvceAgent
 
 
+typedef SafeMap<volatile int32_t, GCSrvceAgent*> ClientAgentsMap;
+
+
 class GCSrvcMemInfoOOM {
  public:
 
@@ -500,25 +541,8 @@ class GCSrvcMemInfoOOM {
     aggregate_memory_ = 0;
   }
 
-  static int readTotalMemory(char* line);
-  static int readFreeMemory(char* line);
-  static int parseMemInfo(const char* file_path);
-
-  static int parseOOMRecString(char* line, long* mem_size, int* pid) {
-    int result = sscanf(line, " %ld kB: %*s (pid %d",  mem_size, pid);
-
-    if(result == 2)
-      return 100;
-    return 0;
-  }
-
-  static int parseOOMHeaderString(char* line, char* label, long* mem_size) {
-    int result = sscanf(line, " %ld kB: %[^\n]s",  mem_size, label);
-
-    if(result == 2)
-      return 100;
-    return 0;
-  }
+  static int sampleMemInfo(GCSrvcProcSampler* sampler, ClientAgentsMap* agents,
+                           std::vector<int>* gone_pids);
 
   static double GetResizeFactor(gc::space::AgentMemInfo* mem_info_rec) {
     double _fact = mem_info_rec->resize_factor_;
@@ -551,11 +575,22 @@ class GCSrvcMemInfoOOM {
 
 
 
-typedef SafeMap<volatile int32_t, GCSrvceAgent*> ClientAgentsMap;
+
+
+typedef struct GCSrvcLaneStats_S {
+  uint64_t processed_count_;
+  uint64_t coalesced_count_;
+  uint64_t total_wait_ns_;
+  uint64_t max_wait_ns_;
+  /* times a request of the lane was held back by the scheduler */
+  uint64_t deferred_count_;
+} GCSrvcLaneStats;
 
 class GCServiceDaemon {
   /* each five request we will read the global update */
   static const int kcGCSrvcBulkRequestsThreshold = 128;
+  /* records owned by the daemon for requests waiting in the lanes */
+  static const int kcGCSrvcPendingCapacity = 4 * GC_SERVICE_BUFFER_REQ_CAP;
 
 
   Thread*   thread_;
@@ -575,30 +610,87 @@ class GCServiceDaemon {
   void initWorkerPool();
   void initShutDownSignals(void);
   void setThreadAffinity(Thread* th, int cpu_id, bool complementary);
+  GC_SERVICE_REQ_LANE GetRequestLane(GCServiceReq* entry);
+  GCServiceReq* AllocPendingRecord(void);
+  /*
+   * agents dropped from the registry. They are deleted by the daemon thread,
+   * the only one holding agent pointers, once their collector is idle.
+   */
+  std::vector<GCSrvceAgent*> retired_agents_ GUARDED_BY(agents_mu_);
+
+  GCServiceReq pending_records_[kcGCSrvcPendingCapacity];
+  int pending_records_index_;
+  std::deque<GCServiceReq*> pending_lanes_[GC_SERVICE_LANE_MAX_LIMIT];
+  int pending_count_;
+
+  /*
+   * scheduler state: collections forwarded to the collectors and not
+   * finished yet. Decremented by the collector threads.
+   */
+  volatile int32_t inflight_gcs_;
+  volatile int32_t inflight_fg_gcs_;
+  int max_inflight_gcs_;
+  /* set when the pending requests could not be dispatched */
+  bool dispatch_blocked_;
+  /* set when the last request from the ring found no free pending record */
+  bool out_of_records_;
+
+  bool IsCollectionLane(int lane) const {
+    return (lane == GC_SERVICE_LANE_ALLOC || lane == GC_SERVICE_LANE_FOREGROUND ||
+        lane == GC_SERVICE_LANE_BACKGROUND);
+  }
+  bool CanDispatchLane(int lane);
+  std::deque<GCServiceReq*>::iterator SelectFromLane(int lane);
 
 public:
 //  static GCServiceDaemon* gcdaemon_inst_;
   //GCServiceProcess* process_;
   //std::vector<GCSrvceAgent*> client_agents_;
   // The last time a heap trim occurred.
-  int mem_info_fd_;
   int req_counts_;
   uint64_t last_global_update_time_ns_;
-  ClientAgentsMap agents_map_;
+  ClientAgentsMap agents_map_ GUARDED_BY(agents_mu_);
+  /* reads the memory state of the registered agents from procfs */
+  GCSrvcProcSampler* proc_sampler_;
+  /* guards agents_map_ between the daemon and the status updater task */
+  Mutex* agents_mu_;
 
   int pool_size_;
   ThreadPool* workers_pool_;
 
-  static const char * meminfo_args_[];
-
   static GCServiceDaemon* CreateServiceDaemon(GCServiceProcess*);
   bool waitShutDownSignals(void);
   GCSrvceAgent* GetAgentByPid(int pid);
+  // Adds an agent to the registry, replacing a gone process with the same pid.
+  void RegisterAgent(GCSrvceAgent* agent);
+  // Drops an agent from the registry and closes its procfs files. The agent
+  // is retired and deleted later by ReapRetiredAgents.
+  void UnregisterAgent(int pid);
+  // Stops, joins and deletes the retired agents whose collector is idle.
+  // Called by the daemon thread only.
+  void ReapRetiredAgents(void);
   //void UpdateGlobalState(void);
   void UpdateGlobalProcessStates(GC_SERVICE_TASK);
 
+  bool HasPendingRequests(void) const {
+    return pending_count_ > 0;
+  }
+  bool IsDispatchBlocked(void) const {
+    return dispatch_blocked_;
+  }
+  bool IsOutOfRecords(void) const {
+    return out_of_records_;
+  }
+  void CollectionStarted(GCSrvceAgent* agent, GCServiceReq* req);
+  void CollectionFinished(GCSrvceAgent* agent);
+  // Returns false when all the pending records are taken; the request then
+  // stays in the ring.
+  bool EnqueuePendingRequest(GCServiceReq* entry);
+  GCServiceReq* DequeuePendingRequest(void);
+  void DumpLaneStats(std::ostream& os);
+
+  GCSrvcLaneStats lanes_stats_[GC_SERVICE_LANE_MAX_LIMIT];
 
-  void SetMemInfoDumpFile();
 
 
 };//class GCServiceDaemon
@@ -617,7 +709,7 @@ public:
   static GCServiceProcess* process_;
   byte* import_address_;
   int enable_trimming_;
-  android::FileMapperService* fileMapperSvc_;
+  GCSrvcFileMapper* fileMapperSvc_;
 private:
 
 
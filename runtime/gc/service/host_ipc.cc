@@ -0,0 +1,294 @@
+/*
+ * host_ipc.cc
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: hussein
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stddef.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+#include "base/logging.h"
+#include "base/stringprintf.h"
+#include "gc/service/host_ipc.h"
+
+namespace art {
+namespace gc {
+namespace service {
+
+const int GCSrvcHostIPC::kMaxFds;
+std::string GCSrvcHostFileMapper::socket_name_("gcservice-mapper");
+GCSrvcHostFileMapper* GCSrvcHostFileMapper::service_ = NULL;
+
+
+int GCSrvcHostIPC::CreateSharedRegion(const char* name, size_t byte_count) {
+  int _fd = -1;
+#if defined(__NR_memfd_create)
+  _fd = syscall(__NR_memfd_create, name, 0);
+#endif
+#if !defined(HAVE_ANDROID_OS)
+  if(_fd == -1) {
+    /* kernels older than 3.17: an shm object that is unlinked right away */
+    static volatile int32_t _regions_count = 0;
+    std::string _shm_name = StringPrintf("/%s-%d-%d", name, getpid(),
+                                         __sync_fetch_and_add(&_regions_count, 1));
+    for(size_t i = 1; i < _shm_name.size(); i++) {
+      if(_shm_name[i] == '/')
+        _shm_name[i] = '_';
+    }
+    _fd = shm_open(_shm_name.c_str(), O_RDWR | O_CREAT | O_EXCL, S_IRUSR | S_IWUSR);
+    if(_fd == -1) {
+      PLOG(ERROR) << "GCSrvcHostIPC: shm_open failed for " << _shm_name;
+      return -1;
+    }
+    shm_unlink(_shm_name.c_str());
+  }
+#endif
+  if(_fd == -1) {
+    PLOG(ERROR) << "GCSrvcHostIPC: cannot create a shared region for " << name;
+    return -1;
+  }
+  if(ftruncate(_fd, byte_count) != 0) {
+    PLOG(ERROR) << "GCSrvcHostIPC: ftruncate failed for " << name;
+    close(_fd);
+    return -1;
+  }
+  return _fd;
+}
+
+
+bool GCSrvcHostIPC::SendFds(int sock, int32_t tag, const int* fds, int count) {
+  CHECK_LE(count, kMaxFds);
+  char _control[CMSG_SPACE(sizeof(int) * kMaxFds)];
+  memset(_control, 0, sizeof(_control));
+  struct iovec _iov;
+  _iov.iov_base = &tag;
+  _iov.iov_len = sizeof(tag);
+  struct msghdr _msg;
+  memset(&_msg, 0, sizeof(_msg));
+  _msg.msg_iov = &_iov;
+  _msg.msg_iovlen = 1;
+  if(count > 0) {
+    _msg.msg_control = _control;
+    _msg.msg_controllen = CMSG_SPACE(sizeof(int) * count);
+    struct cmsghdr* _cmsg = CMSG_FIRSTHDR(&_msg);
+    _cmsg->cmsg_level = SOL_SOCKET;
+    _cmsg->cmsg_type = SCM_RIGHTS;
+    _cmsg->cmsg_len = CMSG_LEN(sizeof(int) * count);
+    memcpy(CMSG_DATA(_cmsg), fds, sizeof(int) * count);
+  }
+  ssize_t _res = TEMP_FAILURE_RETRY(sendmsg(sock, &_msg, 0));
+  if(_res != static_cast<ssize_t>(sizeof(tag))) {
+    PLOG(ERROR) << "GCSrvcHostIPC: sendmsg failed";
+    return false;
+  }
+  return true;
+}
+
+
+int GCSrvcHostIPC::ReceiveFds(int sock, int32_t* tag, int* fds, int max_count) {
+  char _control[CMSG_SPACE(sizeof(int) * kMaxFds)];
+  struct iovec _iov;
+  _iov.iov_base = tag;
+  _iov.iov_len = sizeof(*tag);
+  struct msghdr _msg;
+  memset(&_msg, 0, sizeof(_msg));
+  _msg.msg_iov = &_iov;
+  _msg.msg_iovlen = 1;
+  _msg.msg_control = _control;
+  _msg.msg_controllen = sizeof(_control);
+  ssize_t _res = TEMP_FAILURE_RETRY(recvmsg(sock, &_msg, 0));
+  if(_res != static_cast<ssize_t>(sizeof(*tag))) {
+    if(_res != 0)
+      PLOG(ERROR) << "GCSrvcHostIPC: recvmsg failed";
+    return -1;
+  }
+  int _count = 0;
+  for(struct cmsghdr* _cmsg = CMSG_FIRSTHDR(&_msg); _cmsg != NULL;
+      _cmsg = CMSG_NXTHDR(&_msg, _cmsg)) {
+    if(_cmsg->cmsg_level != SOL_SOCKET || _cmsg->cmsg_type != SCM_RIGHTS)
+      continue;
+    int _received = (_cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+    const int* _data = reinterpret_cast<const int*>(CMSG_DATA(_cmsg));
+    for(int i = 0; i < _received; i++) {
+      if(_count < max_count) {
+        fds[_count++] = _data[i];
+      } else {
+        close(_data[i]);
+      }
+    }
+  }
+  return _count;
+}
+
+
+/* abstract unix socket: nothing to clean up in the file system */
+static void FillSocketAddress(const std::string& name, struct sockaddr_un* addr,
+                              socklen_t* addr_len) {
+  memset(addr, 0, sizeof(*addr));
+  addr->sun_family = AF_UNIX;
+  size_t _len = std::min(name.size(), sizeof(addr->sun_path) - 2);
+  memcpy(addr->sun_path + 1, name.c_str(), _len);
+  *addr_len = offsetof(struct sockaddr_un, sun_path) + 1 + _len;
+}
+
+
+GCSrvcHostFileMapper::GCSrvcHostFileMapper() : listen_fd_(-1) {
+}
+
+
+void GCSrvcHostFileMapper::SetSocketName(const std::string& name) {
+  socket_name_ = name;
+}
+
+
+bool GCSrvcHostFileMapper::Listen(void) {
+  listen_fd_ = socket(AF_UNIX, SOCK_STREAM, 0);
+  if(listen_fd_ == -1) {
+    PLOG(ERROR) << "GCSrvcHostFileMapper: socket failed";
+    return false;
+  }
+  struct sockaddr_un _addr;
+  socklen_t _addr_len;
+  FillSocketAddress(socket_name_, &_addr, &_addr_len);
+  if(bind(listen_fd_, reinterpret_cast<struct sockaddr*>(&_addr), _addr_len) != 0 ||
+      listen(listen_fd_, SOMAXCONN) != 0) {
+    PLOG(ERROR) << "GCSrvcHostFileMapper: cannot listen on " << socket_name_;
+    close(listen_fd_);
+    listen_fd_ = -1;
+    return false;
+  }
+  return true;
+}
+
+
+int GCSrvcHostFileMapper::Connect(void) {
+  int _sock = socket(AF_UNIX, SOCK_STREAM, 0);
+  if(_sock == -1) {
+    PLOG(ERROR) << "GCSrvcHostFileMapper: socket failed";
+    return -1;
+  }
+  struct sockaddr_un _addr;
+  socklen_t _addr_len;
+  FillSocketAddress(socket_name_, &_addr, &_addr_len);
+  if(TEMP_FAILURE_RETRY(connect(_sock, reinterpret_cast<struct sockaddr*>(&_addr),
+                                _addr_len)) != 0) {
+    PLOG(ERROR) << "GCSrvcHostFileMapper: cannot connect to " << socket_name_;
+    close(_sock);
+    return -1;
+  }
+  return _sock;
+}
+
+
+GCSrvcHostFileMapper* GCSrvcHostFileMapper::CreateFileMapperSvc(void) {
+  if(service_ == NULL) {
+    GCSrvcHostFileMapper* _service = new GCSrvcHostFileMapper();
+    if(!_service->Listen()) {
+      delete _service;
+      return NULL;
+    }
+    service_ = _service;
+  }
+  return service_;
+}
+
+
+bool GCSrvcHostFileMapper::IsServiceReady(void) {
+  return (service_ != NULL && service_->listen_fd_ != -1);
+}
+
+
+bool GCSrvcHostFileMapper::Reconnect(void) {
+  return IsServiceReady();
+}
+
+
+bool GCSrvcHostFileMapper::MapFds(int32_t pid, const int* fds, int count) {
+  int _sock = Connect();
+  if(_sock == -1)
+    return false;
+  /* the kernel keeps the fds in flight alive after we close our end */
+  bool _res = GCSrvcHostIPC::SendFds(_sock, pid, fds, count);
+  close(_sock);
+  return _res;
+}
+
+
+int GCSrvcHostFileMapper::GetMapFds(int32_t pid, int* fds, int max_count) {
+  if(!IsServiceReady())
+    return -1;
+  std::map<int32_t, std::vector<int> >& _received = service_->received_;
+  while(_received.find(pid) == _received.end()) {
+    int _sock = TEMP_FAILURE_RETRY(accept(service_->listen_fd_, NULL, NULL));
+    if(_sock == -1) {
+      PLOG(ERROR) << "GCSrvcHostFileMapper: accept failed";
+      return -1;
+    }
+    int32_t _tag = 0;
+    int _fds[GCSrvcHostIPC::kMaxFds];
+    int _count = GCSrvcHostIPC::ReceiveFds(_sock, &_tag, _fds, GCSrvcHostIPC::kMaxFds);
+    close(_sock);
+    if(_count < 0)
+      continue;
+    // A client that reconnects replaces the fds it sent before.
+    std::map<int32_t, std::vector<int> >::iterator _old = _received.find(_tag);
+    if(_old != _received.end()) {
+      for(size_t i = 0; i < _old->second.size(); i++) {
+        close(_old->second[i]);
+      }
+    }
+    _received[_tag] = std::vector<int>(_fds, _fds + _count);
+  }
+  std::vector<int> _pid_fds = _received[pid];
+  _received.erase(pid);
+  int _count = 0;
+  for(size_t i = 0; i < _pid_fds.size(); i++) {
+    if(_count < max_count) {
+      fds[_count++] = _pid_fds[i];
+    } else {
+      close(_pid_fds[i]);
+    }
+  }
+  return _count;
+}
+
+
+bool GCSrvcHostFileMapper::MapFds(android::FileMapperParameters* rec) {
+  int _fds[GCSrvcHostIPC::kMaxFds];
+  int _count = std::min(static_cast<int>(rec->fd_count_),
+                        static_cast<int>(GCSrvcHostIPC::kMaxFds));
+  for(int i = 0; i < _count; i++) {
+    _fds[i] = rec->mem_maps_[i].fd_;
+  }
+  return MapFds(rec->process_id_, _fds, _count);
+}
+
+
+bool GCSrvcHostFileMapper::GetMapFds(android::FileMapperParameters* rec) {
+  int _fds[GCSrvcHostIPC::kMaxFds];
+  int _count = GetMapFds(rec->process_id_, _fds, GCSrvcHostIPC::kMaxFds);
+  if(_count != rec->fd_count_) {
+    LOG(ERROR) << "GCSrvcHostFileMapper: expected " << rec->fd_count_ <<
+        " fds from " << rec->process_id_ << ", received " << _count;
+    return false;
+  }
+  for(int i = 0; i < _count; i++) {
+    rec->mem_maps_[i].fd_ = _fds[i];
+  }
+  return true;
+}
+
+}  // namespace service
+}  // namespace gc
+}  // namespace art
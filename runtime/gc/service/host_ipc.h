@@ -0,0 +1,118 @@
+/*
+ * host_ipc.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: hussein
+ */
+
+#ifndef ART_RUNTIME_GC_SERVICE_HOST_IPC_H_
+#define ART_RUNTIME_GC_SERVICE_HOST_IPC_H_
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#if defined(HAVE_ANDROID_OS)
+#include <cutils/ashmem.h>
+#endif
+
+#include "base/macros.h"
+#include "ipcfs/ipcfs.h"
+
+namespace art {
+namespace gc {
+namespace service {
+
+/*
+ * Linux host backend for the IPC primitives of the GC service.
+ * On the device, shared regions come from ashmem and their descriptors are
+ * handed to the service by the binder based android::FileMapperService.
+ * On the host, regions are memfds (or unlinked POSIX shm objects on kernels
+ * without memfd) and descriptors travel as SCM_RIGHTS over a unix socket.
+ * InterProcessMutex needs nothing extra: it is built on shared futexes.
+ */
+class GCSrvcHostIPC {
+ public:
+  static const int kMaxFds = 16;
+
+  // Returns an fd of a shared region of byte_count bytes, or -1.
+  static int CreateSharedRegion(const char* name, size_t byte_count);
+
+  // Sends count descriptors and a tag over a connected unix socket.
+  static bool SendFds(int sock, int32_t tag, const int* fds, int count);
+
+  // Receives the descriptors sent by SendFds. Returns their count or -1.
+  static int ReceiveFds(int sock, int32_t* tag, int* fds, int max_count);
+
+ private:
+  DISALLOW_IMPLICIT_CONSTRUCTORS(GCSrvcHostIPC);
+};//class GCSrvcHostIPC
+
+
+/*
+ * Host stand-in for android::FileMapperService with the same static entry
+ * points. The service listens on an abstract unix socket; each client
+ * connects once and sends the descriptors of its shared spaces tagged with
+ * its pid. GetMapFds() accepts connections until the record of the requested
+ * pid arrives and keeps the records of the other clients for later.
+ */
+class GCSrvcHostFileMapper {
+ public:
+  static GCSrvcHostFileMapper* CreateFileMapperSvc(void);
+  static bool IsServiceReady(void);
+  static bool Reconnect(void);
+
+  // Client side: sends the fds of rec->mem_maps_ to the service.
+  static bool MapFds(android::FileMapperParameters* rec);
+  // Service side: replaces the fds of rec->mem_maps_ by the received ones.
+  static bool GetMapFds(android::FileMapperParameters* rec);
+
+  // Has to be called before the service and the clients are forked.
+  static void SetSocketName(const std::string& name);
+
+  static bool MapFds(int32_t pid, const int* fds, int count);
+  static int GetMapFds(int32_t pid, int* fds, int max_count);
+
+ private:
+  GCSrvcHostFileMapper();
+  bool Listen(void);
+  static int Connect(void);
+
+  static std::string socket_name_;
+  static GCSrvcHostFileMapper* service_;
+
+  int listen_fd_;
+  // fds received from clients that were not asked for yet.
+  std::map<int32_t, std::vector<int> > received_;
+
+  DISALLOW_COPY_AND_ASSIGN(GCSrvcHostFileMapper);
+};//class GCSrvcHostFileMapper
+
+
+/*
+ * Creates a region that can be shared with the service by its fd: ashmem on
+ * the device and GCSrvcHostIPC::CreateSharedRegion() on the host.
+ */
+static inline int CreateServiceSharedRegion(const char* name, size_t byte_count) {
+#if defined(HAVE_ANDROID_OS)
+  return ashmem_create_region(name, byte_count);
+#else
+  return GCSrvcHostIPC::CreateSharedRegion(name, byte_count);
+#endif
+}
+
+
+#if defined(HAVE_ANDROID_OS)
+typedef android::FileMapperService GCSrvcFileMapper;
+#else
+typedef GCSrvcHostFileMapper GCSrvcFileMapper;
+#endif
+
+}  // namespace service
+}  // namespace gc
+}  // namespace art
+
+#endif  // ART_RUNTIME_GC_SERVICE_HOST_IPC_H_
@@ -0,0 +1,150 @@
+/*
+ * proc_sampler.cc
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: hussein
+ */
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "base/logging.h"
+#include "base/stringprintf.h"
+#include "gc/service/proc_sampler.h"
+
+namespace art {
+namespace gc {
+namespace service {
+
+/* same constants the kernel uses to convert between the two interfaces */
+static const int kOomDisable = -17;
+static const int kOomAdjustMax = 15;
+static const int kOomScoreAdjMax = 1000;
+
+GCSrvcProcSampler::GCSrvcProcSampler(const std::string& proc_root) :
+    proc_root_(proc_root), meminfo_fd_(-1) {
+  page_size_kb_ = sysconf(_SC_PAGESIZE) / 1024;
+  std::string _meminfo_path = proc_root_ + "/meminfo";
+  meminfo_fd_ = TEMP_FAILURE_RETRY(open(_meminfo_path.c_str(), O_RDONLY));
+  if(meminfo_fd_ == -1) {
+    PLOG(ERROR) << "GCSrvcProcSampler: unable to open " << _meminfo_path;
+  }
+}
+
+GCSrvcProcSampler::~GCSrvcProcSampler() {
+  if(meminfo_fd_ != -1) {
+    close(meminfo_fd_);
+  }
+  while(!process_files_.empty()) {
+    ForgetProcess(process_files_.begin()->first);
+  }
+}
+
+int GCSrvcProcSampler::OomScoreAdjToOomAdj(int oom_score_adj) {
+  if(oom_score_adj == kOomScoreAdjMax) {
+    return kOomAdjustMax;
+  }
+  /* the kernel truncates adj * 1000 / 17: round back to the nearest adj */
+  int _scaled = oom_score_adj * -kOomDisable;
+  if(_scaled < 0) {
+    return (_scaled - kOomScoreAdjMax / 2) / kOomScoreAdjMax;
+  }
+  return (_scaled + kOomScoreAdjMax / 2) / kOomScoreAdjMax;
+}
+
+ssize_t GCSrvcProcSampler::ReadFromStart(int fd) {
+  ssize_t _bytes = TEMP_FAILURE_RETRY(pread(fd, read_buffer_, kReadBufferSize - 1, 0));
+  if(_bytes < 0) {
+    _bytes = 0;
+  }
+  read_buffer_[_bytes] = '\0';
+  return _bytes;
+}
+
+bool GCSrvcProcSampler::OpenProcessFiles(int pid, ProcessFiles* files) {
+  std::string _statm_path = StringPrintf("%s/%d/statm", proc_root_.c_str(), pid);
+  std::string _oom_path = StringPrintf("%s/%d/oom_score_adj", proc_root_.c_str(), pid);
+  files->statm_fd_ = TEMP_FAILURE_RETRY(open(_statm_path.c_str(), O_RDONLY));
+  if(files->statm_fd_ == -1) {
+    return false;
+  }
+  files->oom_score_fd_ = TEMP_FAILURE_RETRY(open(_oom_path.c_str(), O_RDONLY));
+  if(files->oom_score_fd_ == -1) {
+    close(files->statm_fd_);
+    return false;
+  }
+  return true;
+}
+
+void GCSrvcProcSampler::ForgetProcess(int pid) {
+  auto _it = process_files_.find(pid);
+  if(_it == process_files_.end())
+    return;
+  close(_it->second.statm_fd_);
+  close(_it->second.oom_score_fd_);
+  process_files_.erase(_it);
+}
+
+bool GCSrvcProcSampler::SampleProcess(int pid, GCSrvcProcessSample* sample) {
+  auto _it = process_files_.find(pid);
+  if(_it == process_files_.end()) {
+    ProcessFiles _files;
+    if(!OpenProcessFiles(pid, &_files)) {
+      return false;
+    }
+    process_files_.Put(pid, _files);
+    _it = process_files_.find(pid);
+  }
+  const ProcessFiles& _files = _it->second;
+
+  long _size_pages = 0;
+  long _resident_pages = 0;
+  if(ReadFromStart(_files.statm_fd_) == 0 ||
+      sscanf(read_buffer_, "%ld %ld", &_size_pages, &_resident_pages) != 2) {
+    /* the process died since the last sample */
+    ForgetProcess(pid);
+    return false;
+  }
+  int _oom_score_adj = 0;
+  if(ReadFromStart(_files.oom_score_fd_) == 0 ||
+      sscanf(read_buffer_, "%d", &_oom_score_adj) != 1) {
+    ForgetProcess(pid);
+    return false;
+  }
+  sample->rss_kb_ = _resident_pages * page_size_kb_;
+  sample->oom_score_adj_ = _oom_score_adj;
+  sample->oom_adj_ = OomScoreAdjToOomAdj(_oom_score_adj);
+  return true;
+}
+
+bool GCSrvcProcSampler::SampleSystem(GCSrvcSystemSample* sample) {
+  if(meminfo_fd_ == -1 || ReadFromStart(meminfo_fd_) == 0) {
+    return false;
+  }
+  int _found = 0;
+  char* _line = read_buffer_;
+  while(_line != NULL && *_line != '\0' && _found != 7) {
+    long _value = 0;
+    if(sscanf(_line, "MemTotal: %ld kB", &_value) == 1) {
+      sample->total_kb_ = _value;
+      _found |= 1;
+    } else if(sscanf(_line, "MemFree: %ld kB", &_value) == 1) {
+      sample->free_kb_ = _value;
+      _found |= 2;
+    } else if(sscanf(_line, "Cached: %ld kB", &_value) == 1) {
+      sample->cached_kb_ = _value;
+      _found |= 4;
+    }
+    _line = strchr(_line, '\n');
+    if(_line != NULL)
+      _line++;
+  }
+  return _found == 7;
+}
+
+}  // namespace service
+}  // namespace gc
+}  // namespace art
@@ -0,0 +1,84 @@
+/*
+ * proc_sampler.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: hussein
+ */
+
+#ifndef ART_RUNTIME_GC_SERVICE_PROC_SAMPLER_H_
+#define ART_RUNTIME_GC_SERVICE_PROC_SAMPLER_H_
+
+#include <string>
+
+#include "base/macros.h"
+#include "safe_map.h"
+
+namespace art {
+namespace gc {
+namespace service {
+
+typedef struct GCSrvcProcessSample_S {
+  /* resident set size in kB */
+  long rss_kb_;
+  /* raw value of /proc/<pid>/oom_score_adj */
+  int oom_score_adj_;
+  /* oom_score_adj scaled back to the legacy oom_adj range [-17, 15] */
+  int oom_adj_;
+} GCSrvcProcessSample;
+
+typedef struct GCSrvcSystemSample_S {
+  long total_kb_;
+  long free_kb_;
+  long cached_kb_;
+} GCSrvcSystemSample;
+
+/*
+ * Samples memory information of registered processes straight from procfs.
+ * The files of each sampled process are opened once and reread with pread so
+ * that a sample costs two small reads per process and no temporary files.
+ * The proc root is configurable so that the sampler can be tested against a
+ * fake /proc tree.
+ */
+class GCSrvcProcSampler {
+ public:
+  explicit GCSrvcProcSampler(const std::string& proc_root);
+  ~GCSrvcProcSampler();
+
+  // Returns false when the process is gone. Its files are closed then.
+  bool SampleProcess(int pid, GCSrvcProcessSample* sample);
+  bool SampleSystem(GCSrvcSystemSample* sample);
+  // Closes the cached files of a process that is no longer registered.
+  void ForgetProcess(int pid);
+
+  size_t GetTrackedProcessesCount() const {
+    return process_files_.size();
+  }
+
+  static int OomScoreAdjToOomAdj(int oom_score_adj);
+
+ private:
+  typedef struct ProcessFiles_S {
+    int statm_fd_;
+    int oom_score_fd_;
+  } ProcessFiles;
+
+  static const size_t kReadBufferSize = 1024;
+
+  bool OpenProcessFiles(int pid, ProcessFiles* files);
+  // Reads the whole file into read_buffer_, returns the number of bytes.
+  ssize_t ReadFromStart(int fd);
+
+  const std::string proc_root_;
+  int meminfo_fd_;
+  long page_size_kb_;
+  SafeMap<int, ProcessFiles> process_files_;
+  char read_buffer_[kReadBufferSize];
+
+  DISALLOW_COPY_AND_ASSIGN(GCSrvcProcSampler);
+};//class GCSrvcProcSampler
+
+}  // namespace service
+}  // namespace gc
+}  // namespace art
+
+#endif  // ART_RUNTIME_GC_SERVICE_PROC_SAMPLER_H_
@@ -0,0 +1,134 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "gc/service/proc_sampler.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+
+#include "base/logging.h"
+#include "base/stringprintf.h"
+#include "gtest/gtest.h"
+
+namespace art {
+namespace gc {
+namespace service {
+
+// Builds a fake procfs tree so that the sampler can be exercised on a host.
+class ProcSamplerTest : public testing::Test {
+ protected:
+  virtual void SetUp() {
+#if defined(HAVE_ANDROID_OS)
+    proc_root_ = "/data/local/tmp/fake-proc-XXXXXX";
+#else
+    proc_root_ = "/tmp/fake-proc-XXXXXX";
+#endif
+    ASSERT_TRUE(mkdtemp(&proc_root_[0]) != NULL);
+    WriteFile("meminfo",
+              "MemTotal:        2048000 kB\n"
+              "MemFree:          100000 kB\n"
+              "Buffers:           20000 kB\n"
+              "Cached:           300000 kB\n"
+              "SwapCached:            0 kB\n");
+  }
+
+  virtual void TearDown() {
+    for (size_t i = files_.size(); i > 0; --i) {
+      const std::string& path = files_[i - 1];
+      if (unlink(path.c_str()) != 0) {
+        rmdir(path.c_str());
+      }
+    }
+    rmdir(proc_root_.c_str());
+  }
+
+  void WriteFile(const std::string& name, const std::string& content) {
+    std::string path = proc_root_ + "/" + name;
+    FILE* f = fopen(path.c_str(), "w");
+    ASSERT_TRUE(f != NULL);
+    fputs(content.c_str(), f);
+    fclose(f);
+    files_.push_back(path);
+  }
+
+  void AddProcess(int pid, long resident_pages, int oom_score_adj) {
+    std::string dir = proc_root_ + StringPrintf("/%d", pid);
+    if (mkdir(dir.c_str(), 0700) == 0) {
+      files_.push_back(dir);
+    }
+    WriteFile(StringPrintf("%d/statm", pid),
+              StringPrintf("%ld %ld 100 10 0 500 0\n", resident_pages * 2, resident_pages));
+    WriteFile(StringPrintf("%d/oom_score_adj", pid), StringPrintf("%d\n", oom_score_adj));
+  }
+
+  std::string proc_root_;
+  std::vector<std::string> files_;
+};
+
+TEST_F(ProcSamplerTest, OomScoreAdjConversion) {
+  EXPECT_EQ(0, GCSrvcProcSampler::OomScoreAdjToOomAdj(0));
+  // Scores the kernel writes for adj 1, 2, 9 and -16.
+  EXPECT_EQ(1, GCSrvcProcSampler::OomScoreAdjToOomAdj(58));
+  EXPECT_EQ(2, GCSrvcProcSampler::OomScoreAdjToOomAdj(117));
+  EXPECT_EQ(9, GCSrvcProcSampler::OomScoreAdjToOomAdj(529));
+  EXPECT_EQ(-16, GCSrvcProcSampler::OomScoreAdjToOomAdj(-941));
+  EXPECT_EQ(15, GCSrvcProcSampler::OomScoreAdjToOomAdj(1000));
+  EXPECT_EQ(-17, GCSrvcProcSampler::OomScoreAdjToOomAdj(-1000));
+}
+
+TEST_F(ProcSamplerTest, SampleSystem) {
+  GCSrvcProcSampler sampler(proc_root_);
+  GCSrvcSystemSample sample;
+  ASSERT_TRUE(sampler.SampleSystem(&sample));
+  EXPECT_EQ(2048000, sample.total_kb_);
+  EXPECT_EQ(100000, sample.free_kb_);
+  EXPECT_EQ(300000, sample.cached_kb_);
+}
+
+TEST_F(ProcSamplerTest, SampleProcesses) {
+  long page_kb = sysconf(_SC_PAGESIZE) / 1024;
+  AddProcess(1234, 1000, 0);
+  AddProcess(5678, 50, 1000);
+  GCSrvcProcSampler sampler(proc_root_);
+  GCSrvcProcessSample sample;
+
+  ASSERT_TRUE(sampler.SampleProcess(1234, &sample));
+  EXPECT_EQ(1000 * page_kb, sample.rss_kb_);
+  EXPECT_EQ(0, sample.oom_adj_);
+  ASSERT_TRUE(sampler.SampleProcess(5678, &sample));
+  EXPECT_EQ(50 * page_kb, sample.rss_kb_);
+  EXPECT_EQ(15, sample.oom_adj_);
+  EXPECT_EQ(2U, sampler.GetTrackedProcessesCount());
+
+  // Later samples reread the files that were kept open.
+  AddProcess(1234, 2000, 117);
+  ASSERT_TRUE(sampler.SampleProcess(1234, &sample));
+  EXPECT_EQ(2000 * page_kb, sample.rss_kb_);
+  EXPECT_EQ(1, sample.oom_adj_);
+
+  EXPECT_FALSE(sampler.SampleProcess(42, &sample));
+  sampler.ForgetProcess(5678);
+  EXPECT_EQ(1U, sampler.GetTrackedProcessesCount());
+}
+
+}  // namespace service
+}  // namespace gc
+}  // namespace art
@@ -0,0 +1,286 @@
+/*
+ * request_ring.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: hussein
+ */
+
+#ifndef ART_RUNTIME_GC_SERVICE_REQUEST_RING_H_
+#define ART_RUNTIME_GC_SERVICE_REQUEST_RING_H_
+
+#include <errno.h>
+#include <sched.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <linux/futex.h>
+
+#include "cutils/atomic.h"
+#include "cutils/atomic-inline.h"
+#include "base/macros.h"
+
+#define GC_SERVICE_BUFFER_REQ_CAP   128
+
+namespace art {
+namespace gc {
+namespace service {
+
+typedef struct GCServiceConcReq_S {
+  volatile int pid_;
+  volatile int req_type_;
+  volatile int status_;
+  volatile uintptr_t data_addr_;
+  /* monotonic time at which the client published the request */
+  volatile uint64_t enqueue_ns_;
+  /* lane the daemon queued the request in. Only used by the daemon */
+  volatile int lane_;
+} __attribute__((aligned(8))) GCServiceReq;
+
+/*
+ * A slot of the requests ring. sequence_ is the only field used for
+ * synchronization: it equals the ticket of the producer allowed to fill the
+ * slot, ticket + 1 once the request is published, and ticket + capacity once
+ * the daemon has consumed it.
+ */
+typedef struct GCServiceReqSlot_S {
+  volatile int32_t sequence_;
+  GCServiceReq req_;
+} __attribute__((aligned(8))) GCServiceReqSlot;
+
+/*
+ * Multi-producer/single-consumer ring shared between all the client VMs and
+ * the GC service daemon. Producers claim a ticket by CAS on enqueue_pos_ and
+ * never take a lock. The daemon only sleeps (futex on daemon_idle_) when the
+ * ring is empty, so producers pay a syscall only when the daemon is idle.
+ * Producers that find the ring full sleep on dequeue_pos_.
+ */
+typedef struct GCServiceReqRing_S {
+  volatile int32_t enqueue_pos_;
+  char pad_enqueue_[60];
+  volatile int32_t dequeue_pos_;
+  volatile int32_t daemon_idle_;
+  volatile int32_t space_waiters_;
+  /* set when the daemon has to re-evaluate its deferred requests */
+  volatile int32_t daemon_kicked_;
+  char pad_dequeue_[48];
+
+  /* statistics */
+  volatile int32_t enqueued_count_;
+  volatile int32_t daemon_wakeups_;
+  volatile int32_t full_waits_;
+
+  GCServiceReqSlot slots_[GC_SERVICE_BUFFER_REQ_CAP];
+} __attribute__((aligned(64))) GCServiceReqRing;
+
+
+class GCSrvcRequestRing {
+ public:
+  static const int32_t kCapacity = GC_SERVICE_BUFFER_REQ_CAP;
+  static const int32_t kIndexMask = GC_SERVICE_BUFFER_REQ_CAP - 1;
+  /* number of times we retry before going to sleep on a futex */
+  static const int kSpinIterations = 64;
+
+  explicit GCSrvcRequestRing(GCServiceReqRing* ring_data) :
+      ring_data_(ring_data) {
+    COMPILE_ASSERT((GC_SERVICE_BUFFER_REQ_CAP & (GC_SERVICE_BUFFER_REQ_CAP - 1)) == 0,
+                   ring_capacity_must_be_power_of_two);
+  }
+
+  /* Has to be called once by the process creating the shared region. */
+  void Init(void) {
+    memset((void*)ring_data_, 0, sizeof(GCServiceReqRing));
+    for (int32_t i = 0; i < kCapacity; i++) {
+      ring_data_->slots_[i].sequence_ = i;
+    }
+  }
+
+  /*
+   * Claims a free slot for the caller. Blocks while the ring is full.
+   * The returned request has to be published by PublishRequest().
+   */
+  GCServiceReq* ClaimRequest(int32_t* ticket) {
+    int _spins = 0;
+    while (true) {
+      int32_t _pos = android_atomic_acquire_load(&ring_data_->enqueue_pos_);
+      GCServiceReqSlot* _slot = &ring_data_->slots_[_pos & kIndexMask];
+      int32_t _seq = android_atomic_acquire_load(&_slot->sequence_);
+      int32_t _diff = static_cast<int32_t>(static_cast<uint32_t>(_seq) -
+                                           static_cast<uint32_t>(_pos));
+      if (_diff == 0) {
+        if (android_atomic_cas(_pos, _pos + 1, &ring_data_->enqueue_pos_) == 0) {
+          *ticket = _pos;
+          return &_slot->req_;
+        }
+      } else if (_diff < 0) {
+        /* the daemon did not consume this slot yet: the ring is full. */
+        if (++_spins < kSpinIterations) {
+          sched_yield();
+        } else {
+          WaitForSpace(_pos);
+          _spins = 0;
+        }
+      }
+    }
+  }
+
+  /* Makes the request visible to the daemon and wakes it up if it is idle. */
+  void PublishRequest(int32_t ticket) {
+    GCServiceReqSlot* _slot = &ring_data_->slots_[ticket & kIndexMask];
+    android_atomic_release_store(ticket + 1, &_slot->sequence_);
+    android_atomic_inc(&ring_data_->enqueued_count_);
+    ANDROID_MEMBAR_FULL();
+    if (android_atomic_acquire_load(&ring_data_->daemon_idle_) != 0) {
+      if (android_atomic_cas(1, 0, &ring_data_->daemon_idle_) == 0) {
+        android_atomic_inc(&ring_data_->daemon_wakeups_);
+        futex(&ring_data_->daemon_idle_, FUTEX_WAKE, 1);
+      }
+    }
+  }
+
+  /* Returns the next published request, or NULL if there is none. */
+  GCServiceReq* TryPeekRequest(void) {
+    int32_t _pos = ring_data_->dequeue_pos_;
+    GCServiceReqSlot* _slot = &ring_data_->slots_[_pos & kIndexMask];
+    if (android_atomic_acquire_load(&_slot->sequence_) == _pos + 1) {
+      return &_slot->req_;
+    }
+    return NULL;
+  }
+
+  /* Single consumer: blocks the daemon until a request is published. */
+  GCServiceReq* WaitForRequest(void) {
+    int _spins = 0;
+    while (true) {
+      GCServiceReq* _req = TryPeekRequest();
+      if (_req != NULL) {
+        return _req;
+      }
+      if (++_spins < kSpinIterations) {
+        continue;
+      }
+      android_atomic_acquire_store(1, &ring_data_->daemon_idle_);
+      /* recheck after announcing that we are idle to close the race with
+       * a producer that published without seeing the flag. */
+      _req = TryPeekRequest();
+      if (_req != NULL) {
+        android_atomic_release_store(0, &ring_data_->daemon_idle_);
+        return _req;
+      }
+      futex(&ring_data_->daemon_idle_, FUTEX_WAIT, 1);
+      android_atomic_release_store(0, &ring_data_->daemon_idle_);
+      _spins = 0;
+    }
+  }
+
+  /*
+   * Single consumer: like WaitForRequest() but also returns NULL once Kick()
+   * has been called since the last time the daemon checked.
+   */
+  GCServiceReq* WaitForRequestOrKick(void) {
+    int _spins = 0;
+    while (true) {
+      GCServiceReq* _req = TryPeekRequest();
+      if (_req != NULL) {
+        return _req;
+      }
+      if (android_atomic_cas(1, 0, &ring_data_->daemon_kicked_) == 0) {
+        return NULL;
+      }
+      if (++_spins < kSpinIterations) {
+        continue;
+      }
+      android_atomic_acquire_store(1, &ring_data_->daemon_idle_);
+      _req = TryPeekRequest();
+      if (_req != NULL ||
+          android_atomic_acquire_load(&ring_data_->daemon_kicked_) != 0) {
+        android_atomic_release_store(0, &ring_data_->daemon_idle_);
+        continue;
+      }
+      futex(&ring_data_->daemon_idle_, FUTEX_WAIT, 1);
+      android_atomic_release_store(0, &ring_data_->daemon_idle_);
+      _spins = 0;
+    }
+  }
+
+  /*
+   * Single consumer: blocks until Kick() is called, leaving the published
+   * requests in the ring. Used while the daemon cannot take any of them.
+   */
+  void WaitForKick(void) {
+    int _spins = 0;
+    while (android_atomic_cas(1, 0, &ring_data_->daemon_kicked_) != 0) {
+      if (++_spins < kSpinIterations) {
+        continue;
+      }
+      android_atomic_acquire_store(1, &ring_data_->daemon_idle_);
+      if (android_atomic_acquire_load(&ring_data_->daemon_kicked_) == 0) {
+        futex(&ring_data_->daemon_idle_, FUTEX_WAIT, 1);
+      }
+      android_atomic_release_store(0, &ring_data_->daemon_idle_);
+      _spins = 0;
+    }
+  }
+
+  /*
+   * Wakes the daemon without publishing a request. The kick is latched so
+   * it is not lost if the daemon is not sleeping yet.
+   */
+  void Kick(void) {
+    android_atomic_release_store(1, &ring_data_->daemon_kicked_);
+    ANDROID_MEMBAR_FULL();
+    if (android_atomic_acquire_load(&ring_data_->daemon_idle_) != 0) {
+      if (android_atomic_cas(1, 0, &ring_data_->daemon_idle_) == 0) {
+        android_atomic_inc(&ring_data_->daemon_wakeups_);
+        futex(&ring_data_->daemon_idle_, FUTEX_WAKE, 1);
+      }
+    }
+  }
+
+  /* Single consumer: hands the slot returned by WaitForRequest back. */
+  void ReleaseRequest(void) {
+    int32_t _pos = ring_data_->dequeue_pos_;
+    GCServiceReqSlot* _slot = &ring_data_->slots_[_pos & kIndexMask];
+    android_atomic_release_store(_pos + kCapacity, &_slot->sequence_);
+    android_atomic_release_store(_pos + 1, &ring_data_->dequeue_pos_);
+    ANDROID_MEMBAR_FULL();
+    if (android_atomic_acquire_load(&ring_data_->space_waiters_) > 0) {
+      futex(&ring_data_->dequeue_pos_, FUTEX_WAKE, INT32_MAX);
+    }
+  }
+
+  int32_t GetQueuedCount(void) const {
+    return android_atomic_acquire_load(&ring_data_->enqueue_pos_) -
+        android_atomic_acquire_load(&ring_data_->dequeue_pos_);
+  }
+
+  GCServiceReqRing* ring_data_;
+
+ private:
+  void WaitForSpace(int32_t observed_pos) {
+    int32_t _deq_pos = android_atomic_acquire_load(&ring_data_->dequeue_pos_);
+    android_atomic_inc(&ring_data_->space_waiters_);
+    android_atomic_inc(&ring_data_->full_waits_);
+    /* recheck the slot after registering as a waiter. */
+    GCServiceReqSlot* _slot = &ring_data_->slots_[observed_pos & kIndexMask];
+    if (android_atomic_acquire_load(&_slot->sequence_) != observed_pos) {
+      futex(&ring_data_->dequeue_pos_, FUTEX_WAIT, _deq_pos);
+    }
+    android_atomic_dec(&ring_data_->space_waiters_);
+  }
+
+  /* Shared (non-private) futexes since the ring lives in ashmem. */
+  static int futex(volatile int32_t* uaddr, int op, int val) {
+    int _res = syscall(SYS_futex, uaddr, op, val, NULL, NULL, 0);
+    if (_res != 0 && errno != EAGAIN && errno != EINTR) {
+      return -1;
+    }
+    return _res;
+  }
+};//class GCSrvcRequestRing
+
+}  // namespace service
+}  // namespace gc
+}  // namespace art
+
+#endif  // ART_RUNTIME_GC_SERVICE_REQUEST_RING_H_
@@ -0,0 +1,200 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "gc/service/request_ring.h"
+
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "base/logging.h"
+#include "gtest/gtest.h"
+#include "utils.h"
+
+namespace art {
+namespace gc {
+namespace service {
+
+// Per-client latency accounting written by the forked clients.
+struct RingClientStats {
+  volatile uint64_t total_enqueue_ns_;
+  volatile uint64_t max_enqueue_ns_;
+};
+
+struct RingTestRegion {
+  GCServiceReqRing ring_;
+  RingClientStats clients_[64];
+};
+
+class RequestRingTest : public testing::Test {
+ protected:
+  virtual void SetUp() {
+    void* addr = mmap(NULL, sizeof(RingTestRegion), PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    ASSERT_NE(MAP_FAILED, addr);
+    region_ = reinterpret_cast<RingTestRegion*>(addr);
+    memset(region_, 0, sizeof(RingTestRegion));
+    GCSrvcRequestRing ring(&region_->ring_);
+    ring.Init();
+  }
+
+  virtual void TearDown() {
+    munmap(region_, sizeof(RingTestRegion));
+  }
+
+  // Forks num_clients processes that each push requests_per_client requests
+  // and drains them from the current process. Returns the elapsed time.
+  uint64_t RunClients(int num_clients, int requests_per_client) {
+    CHECK_LE(num_clients, 64);
+    std::vector<pid_t> children;
+    for (int c = 0; c < num_clients; ++c) {
+      pid_t pid = fork();
+      CHECK_NE(pid, -1);
+      if (pid == 0) {
+        GCSrvcRequestRing ring(&region_->ring_);
+        RingClientStats* stats = &region_->clients_[c];
+        for (int i = 0; i < requests_per_client; ++i) {
+          uint64_t start = NanoTime();
+          int32_t ticket = 0;
+          GCServiceReq* req = ring.ClaimRequest(&ticket);
+          req->pid_ = c;
+          req->req_type_ = i;
+          req->data_addr_ = 0;
+          ring.PublishRequest(ticket);
+          uint64_t elapsed = NanoTime() - start;
+          stats->total_enqueue_ns_ += elapsed;
+          if (elapsed > stats->max_enqueue_ns_) {
+            stats->max_enqueue_ns_ = elapsed;
+          }
+        }
+        _exit(0);
+      }
+      children.push_back(pid);
+    }
+
+    GCSrvcRequestRing ring(&region_->ring_);
+    std::vector<int> next_seq(num_clients, 0);
+    uint64_t start = NanoTime();
+    for (int i = 0; i < num_clients * requests_per_client; ++i) {
+      GCServiceReq* req = ring.WaitForRequest();
+      // Requests of a single client have to be received in order.
+      EXPECT_EQ(next_seq[req->pid_], req->req_type_);
+      next_seq[req->pid_] = req->req_type_ + 1;
+      ring.ReleaseRequest();
+    }
+    uint64_t elapsed = NanoTime() - start;
+
+    for (size_t i = 0; i < children.size(); ++i) {
+      int status = 0;
+      EXPECT_EQ(children[i], waitpid(children[i], &status, 0));
+      EXPECT_TRUE(WIFEXITED(status));
+    }
+    EXPECT_EQ(0, ring.GetQueuedCount());
+    return elapsed;
+  }
+
+  RingTestRegion* region_;
+};
+
+TEST_F(RequestRingTest, SingleProcess) {
+  GCSrvcRequestRing ring(&region_->ring_);
+  EXPECT_TRUE(ring.TryPeekRequest() == NULL);
+  for (int round = 0; round < 3; ++round) {
+    for (int i = 0; i < GCSrvcRequestRing::kCapacity; ++i) {
+      int32_t ticket = 0;
+      GCServiceReq* req = ring.ClaimRequest(&ticket);
+      req->req_type_ = i;
+      ring.PublishRequest(ticket);
+    }
+    EXPECT_EQ(GCSrvcRequestRing::kCapacity, ring.GetQueuedCount());
+    for (int i = 0; i < GCSrvcRequestRing::kCapacity; ++i) {
+      GCServiceReq* req = ring.TryPeekRequest();
+      ASSERT_TRUE(req != NULL);
+      EXPECT_EQ(i, req->req_type_);
+      ring.ReleaseRequest();
+    }
+    EXPECT_TRUE(ring.TryPeekRequest() == NULL);
+  }
+}
+
+TEST_F(RequestRingTest, KickIsLatched) {
+  GCSrvcRequestRing ring(&region_->ring_);
+  // A kick sent while the daemon is busy is seen by its next wait.
+  ring.Kick();
+  EXPECT_TRUE(ring.WaitForRequestOrKick() == NULL);
+  // Published requests take precedence over a pending kick.
+  int32_t ticket = 0;
+  GCServiceReq* req = ring.ClaimRequest(&ticket);
+  req->req_type_ = 7;
+  ring.PublishRequest(ticket);
+  ring.Kick();
+  req = ring.WaitForRequestOrKick();
+  ASSERT_TRUE(req != NULL);
+  EXPECT_EQ(7, req->req_type_);
+  ring.ReleaseRequest();
+  EXPECT_TRUE(ring.WaitForRequestOrKick() == NULL);
+  EXPECT_EQ(0, region_->ring_.daemon_kicked_);
+}
+
+TEST_F(RequestRingTest, WaitForKickLeavesRequests) {
+  GCSrvcRequestRing ring(&region_->ring_);
+  int32_t ticket = 0;
+  GCServiceReq* req = ring.ClaimRequest(&ticket);
+  req->req_type_ = 3;
+  ring.PublishRequest(ticket);
+  // The daemon is out of records: it sleeps on the kick, not on the request.
+  ring.Kick();
+  ring.WaitForKick();
+  EXPECT_EQ(0, region_->ring_.daemon_kicked_);
+  EXPECT_EQ(1, ring.GetQueuedCount());
+  req = ring.TryPeekRequest();
+  ASSERT_TRUE(req != NULL);
+  EXPECT_EQ(3, req->req_type_);
+  ring.ReleaseRequest();
+}
+
+// Drives several simulated client VMs against one daemon and reports the
+// enqueue latency seen by the clients and the throughput of the daemon.
+TEST_F(RequestRingTest, MultiProcessThroughput) {
+  static const int kClientCounts[] = { 1, 4, 16, 48 };
+  static const int kRequestsPerClient = 20000;
+  for (size_t n = 0; n < arraysize(kClientCounts); ++n) {
+    GCSrvcRequestRing ring(&region_->ring_);
+    ring.Init();
+    memset(region_->clients_, 0, sizeof(region_->clients_));
+    int clients = kClientCounts[n];
+    uint64_t elapsed = RunClients(clients, kRequestsPerClient);
+    uint64_t total_ns = 0;
+    uint64_t max_ns = 0;
+    for (int c = 0; c < clients; ++c) {
+      total_ns += region_->clients_[c].total_enqueue_ns_;
+      max_ns = std::max(max_ns, static_cast<uint64_t>(region_->clients_[c].max_enqueue_ns_));
+    }
+    uint64_t requests = static_cast<uint64_t>(clients) * kRequestsPerClient;
+    LOG(INFO) << "clients=" << clients
+              << " daemon throughput=" << (requests * 1000000000ULL) / std::max<uint64_t>(elapsed, 1)
+              << " req/s, mean enqueue=" << PrettyDuration(total_ns / requests)
+              << ", max enqueue=" << PrettyDuration(max_ns)
+              << ", daemon wakeups=" << region_->ring_.daemon_wakeups_
+              << ", full waits=" << region_->ring_.full_waits_;
+  }
+}
+
+}  // namespace service
+}  // namespace gc
+}  // namespace art
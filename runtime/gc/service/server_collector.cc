@@ -21,6 +21,8 @@ ServerCollector::ServerCollector(GCServiceClientRecord* client_rec,
     run_cond_("ServerLock::cond_", run_mu_),
     thread_(NULL),
     status_(0),
+    stop_requested_(false),
+    serving_(false),
     shake_hand_mu_("shake_hand"),
     shake_hand_cond_("ServerLock::cond_", shake_hand_mu_),
     curr_collector_addr_(NULL),
@@ -64,7 +66,8 @@ ServerCollector::ServerCollector(GCServiceClientRecord* client_rec,
     }
 
     if(true) {
-      ipc_msweep_ = new collector::IPCServerMarkerSweep(client_rec);
+      ipc_msweep_ = new collector::IPCServerMarkerSweep(client_rec,
+                                                        mark_workers_pool_);
       ScopedThreadStateChange tsc(self, kWaitingForGCProcess);
       {
         IPMutexLock interProcMu(self, *(conc_req_cond_mu_));
@@ -77,6 +80,34 @@ ServerCollector::ServerCollector(GCServiceClientRecord* client_rec,
 }
 
 
+ServerCollector::~ServerCollector() {
+  delete ipc_msweep_;
+  delete gc_complete_cond_;
+  delete gc_complete_mu_;
+  delete conc_req_cond_;
+  delete conc_req_cond_mu_;
+  delete phase_cond_;
+  delete phase_mu_;
+}
+
+
+void ServerCollector::Stop(void) {
+  Thread* self = Thread::Current();
+  {
+    MutexLock mu(self, run_mu_);
+    stop_requested_ = true;
+    run_cond_.Broadcast(self);
+  }
+  CHECK_PTHREAD_CALL(pthread_join, (pthread_, NULL), "Server-Collector shutdown");
+}
+
+
+bool ServerCollector::IsIdle(void) {
+  MutexLock mu(Thread::Current(), run_mu_);
+  return !serving_ && android_atomic_acquire_load(&status_) == 0;
+}
+
+
 void ServerCollector::SignalCollector(GCSrvceAgent* curr_srvc_agent,
                                       GCServiceReq* gcsrvc_req) {
   Thread* self = Thread::Current();
@@ -120,6 +151,8 @@ int ServerCollector::WaitForRequest(void) {
       MutexLock mu(self, run_mu_);
       int32_t _status_barrier = 0;
       while((_status_barrier = android_atomic_release_load(&status_)) <= 0) {
+        if(stop_requested_)
+          return GC_SERVICE_TASK_NOP;
         run_cond_.Wait(self);
       }
       _result = _status_barrier;
@@ -130,6 +163,7 @@ int ServerCollector::WaitForRequest(void) {
       while (android_atomic_cas(_status_barrier, 0U, &status_) != 0) {
         _status_barrier = android_atomic_release_load(&status_);
       }
+      serving_ = true;
      // LOG(ERROR) << "ServerCollector::WaitForRequest:: leaving WaitForRequest; status=" << status_;
       run_cond_.Broadcast(self);
     }
@@ -180,10 +214,13 @@ class ServerMarkReachableTask : public WorkStealingTask {
       }
       //LOG(ERROR) << " ++++ Phase TASK noticed change  ++++ " << self->GetTid()
       //    << " phase=" << curr_collector_addr_->gc_phase_;
-
-      if(true)
-        server_instant_->ipc_msweep_->MarkReachableObjects(curr_collector_addr_);
-
+    }
+    // Mark without the phase lock: the marking workers take locks of the
+    // same level, and the phase stays MARK_REACHABLES until we publish it.
+    if(true)
+      server_instant_->ipc_msweep_->MarkReachableObjects(curr_collector_addr_);
+    {
+      IPMutexLock interProcMu(self, *(server_instant_->phase_mu_));
      // LOG(ERROR) << " ++++ post Phase TASK updated the phase of the GC: "
      //     << self->GetTid() << ", phase:" << curr_collector_addr_->gc_phase_;
       curr_collector_addr_->gc_phase_ = space::IPC_GC_PHASE_MARK_RECURSIVE;
@@ -379,6 +416,8 @@ void ServerCollector::BlockOnCollectorAddress(Thread* self) {
 }
 
 void ServerCollector::FinalizeGC(Thread* self, GCServiceReq* srvcReq) {
+  /* the record is recycled once its status is updated */
+  int _req_type = srvcReq->req_type_;
   ScopedThreadStateChange tsc(self, kWaitingForGCProcess);
   {
     IPMutexLock interProcMu(self, *(conc_req_cond_mu_));
@@ -386,6 +425,12 @@ void ServerCollector::FinalizeGC(Thread* self, GCServiceReq* srvcReq) {
     heap_data_->conc_flag_ = 0;
     conc_req_cond_->Broadcast(self);
   }
+  if((_req_type & GC_SERVICE_TASK_GC_ANY) > 0) {
+    GCServiceProcess::process_->daemon_->CollectionFinished(curr_srvc_agent_);
+  } else {
+    /* the daemon may be waiting for a free pending record */
+    GCServiceProcess::process_->handShake_->requests_ring_.Kick();
+  }
 }
 
 
@@ -423,6 +468,8 @@ void ServerCollector::ExecuteGC(GC_SERVICE_TASK gc_type, GCServiceReq* srvcReq)
     curr_collector_addr_ = NULL;
     cycles_count_++;
   }
+  uint64_t _start_ns = NanoTime();
+  size_t _freed_before = heap_data_->sub_record_meta_.total_bytes_freed_ever_;
 //  LOG(ERROR) << "ServerCollector::ExecuteGC.." << gc_type;
   gc_workers_pool_->AddTask(self, new ServerIPCListenerTask(this));
   gc_workers_pool_->AddTask(self, new ServerMarkReachableTask(this));
@@ -440,6 +487,10 @@ void ServerCollector::ExecuteGC(GC_SERVICE_TASK gc_type, GCServiceReq* srvcReq)
   gc_workers_pool_->Wait(self, true, true);
 
   gc_workers_pool_->StopWorkers(self);
+  size_t _freed_after = heap_data_->sub_record_meta_.total_bytes_freed_ever_;
+  curr_srvc_agent_->RecordCollection(
+      (_freed_after > _freed_before) ? (_freed_after - _freed_before) : 0,
+      NanoTime() - _start_ns);
   FinalizeGC(self, srvcReq);
 //  LOG(ERROR) << "ServerCollector::ExecuteGC..ENDING.." << gc_type;
 }
@@ -449,6 +500,7 @@ void ServerCollector::ExecuteGC(GC_SERVICE_TASK gc_type, GCServiceReq* srvcReq)
 void ServerCollector::InitPool(void) {
   pool_size_ = GCServiceGlobalAllocator::allocator_instant_->getWorkerPoolSize();
   gc_workers_pool_ = new WorkStealingThreadPool(pool_size_);
+  mark_workers_pool_ = new WorkStealingThreadPool(pool_size_);
   bool propagate = false;
   int cpu_id = 0;
   bool _setAffin =
@@ -462,6 +514,7 @@ void ServerCollector::InitPool(void) {
 
   if(_setAffin) {
     gc_workers_pool_->setThreadsAffinity(cpu_id);
+    mark_workers_pool_->setThreadsAffinity(cpu_id);
   }
 }
 
@@ -474,6 +527,10 @@ void ServerCollector::Run(void) {
     //int old_priority = -999;
 
     _gc_type = static_cast<GC_SERVICE_TASK>(WaitForRequest());
+    if(_gc_type == GC_SERVICE_TASK_NOP) {
+      /* Stop() was called */
+      break;
+    }
     if(_gc_type == GC_SERVICE_TASK_TRIM) {
       int _index = GetServiceIndex(_gc_type);
       ExecuteTrim(curr_srvc_reqs_[_index]);
@@ -492,6 +549,10 @@ void ServerCollector::Run(void) {
 //      LOG(ERROR) << "REstoring old priority: " << old_priority;
 //      Thread::Current()->SetNativePriority(old_priority);
 //    }
+    {
+      MutexLock mu(Thread::Current(), run_mu_);
+      serving_ = false;
+    }
   }
 }
 
@@ -512,6 +573,11 @@ void* ServerCollector::RunCollectorDaemon(void* args) {
 
   _server->Run();
 
+  delete _server->gc_workers_pool_;
+  _server->gc_workers_pool_ = NULL;
+  delete _server->mark_workers_pool_;
+  _server->mark_workers_pool_ = NULL;
+  runtime->DetachCurrentThread();
   return NULL;
 }
 
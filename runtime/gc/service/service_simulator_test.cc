@@ -0,0 +1,361 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "gc/service/global_allocator.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "base/logging.h"
+#include "base/mutex.h"
+#include "base/stringprintf.h"
+#include "cutils/atomic.h"
+#include "gc/service/host_ipc.h"
+#include "globals.h"
+#include "gtest/gtest.h"
+#include "locks.h"
+#include "utils.h"
+
+namespace art {
+namespace gc {
+namespace service {
+
+static const int kSimMaxClients = 64;
+static const size_t kSimHeapBytes = 256 * KB;
+// A simulation that has not finished by then has a stuck client.
+static const uint64_t kSimTimeoutNs = 120 * 1000000000ULL;
+static const useconds_t kSimPollUs = 10 * 1000;
+
+// Shared region each mini-runtime creates and hands to the service by fd,
+// standing in for the GCSrvSharableHeapData of a real client.
+struct SimClientRegion {
+  SynchronizedLockHead conc_lock_;
+  volatile int32_t conc_flag_;
+  volatile int32_t collections_;
+  byte heap_[kSimHeapBytes];
+};
+
+struct SimClientStats {
+  volatile uint64_t total_gc_ns_;
+  volatile uint64_t max_gc_ns_;
+};
+
+// Region created before forking: the requests buffer of the handshake and
+// the client stats.
+struct SimServiceRegion {
+  GCServiceRequestsBuffer buffer_;
+  // Registrations claimed but not yet imported by the service. Claiming
+  // does not wait for the service to free a mapper record.
+  volatile int32_t registering_;
+  SimClientStats clients_[kSimMaxClients];
+};
+
+// Reaps the mini-runtimes and kicks the service loop out of the ring when
+// one of them dies or the simulation runs past its deadline.
+struct SimWatchdog {
+  GCSrvcRequestRing* ring_;
+  std::vector<pid_t> children_;
+  std::vector<int> status_;
+  uint64_t deadline_ns_;
+  volatile int32_t failed_;
+
+  static void* Run(void* arg) {
+    SimWatchdog* dog = reinterpret_cast<SimWatchdog*>(arg);
+    size_t running = dog->children_.size();
+    while (running > 0) {
+      for (size_t i = 0; i < dog->children_.size(); ++i) {
+        if (dog->children_[i] == 0) {
+          continue;
+        }
+        int status = 0;
+        pid_t pid = waitpid(dog->children_[i], &status, WNOHANG);
+        if (pid == 0) {
+          continue;
+        }
+        dog->children_[i] = 0;
+        dog->status_[i] = status;
+        --running;
+        if (pid == -1 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+          LOG(ERROR) << "ServiceSimulatorTest: client " << i << " died, status=" << status;
+          dog->failed_ = 1;
+        }
+      }
+      if (running > 0 && NanoTime() > dog->deadline_ns_) {
+        LOG(ERROR) << "ServiceSimulatorTest: timed out with " << running << " clients left";
+        dog->failed_ = 1;
+      }
+      if (dog->failed_) {
+        dog->ring_->Kick();
+        return NULL;
+      }
+      usleep(kSimPollUs);
+    }
+    return NULL;
+  }
+};
+
+// Forks mini-runtimes that register their heap with the service through
+// GCSrvcClientHandShake and the host GCSrvcFileMapper, then request
+// concurrent collections through the handshake, waiting for each to
+// complete on an InterProcessConditionVariable. The test process drains
+// the requests ring of the handshake the way GCSrvcClientHandShake's
+// ListenToRequests does. The daemon itself needs client runtimes with
+// sharable spaces, so the collections are simulated.
+class ServiceSimulatorTest : public testing::Test {
+ protected:
+  virtual void SetUp() {
+    // The handshake takes the runtime shutdown lock to change thread states.
+    Locks::Init();
+    GCSrvcHostFileMapper::SetSocketName(StringPrintf("gcservice-sim-%d", getpid()));
+    ASSERT_TRUE(GCSrvcHostFileMapper::CreateFileMapperSvc() != NULL);
+    int fd = GCSrvcHostIPC::CreateSharedRegion("gcservice-sim", sizeof(SimServiceRegion));
+    ASSERT_NE(-1, fd);
+    void* addr = mmap(NULL, sizeof(SimServiceRegion), PROT_READ | PROT_WRITE,
+                      MAP_SHARED, fd, 0);
+    close(fd);
+    ASSERT_NE(MAP_FAILED, addr);
+    region_ = reinterpret_cast<SimServiceRegion*>(addr);
+    handshake_ = NULL;
+  }
+
+  virtual void TearDown() {
+    munmap(region_, sizeof(SimServiceRegion));
+  }
+
+  void RunClient(int index, int collections) {
+    int fd = GCSrvcHostIPC::CreateSharedRegion("gcservice-sim-heap", sizeof(SimClientRegion));
+    CHECK_NE(fd, -1);
+    SimClientRegion* client = reinterpret_cast<SimClientRegion*>(
+        mmap(NULL, sizeof(SimClientRegion), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0));
+    CHECK(client != MAP_FAILED);
+    InterProcessMutex* mu =
+        new InterProcessMutex("sim conc lock", &client->conc_lock_.futex_head_);
+    InterProcessConditionVariable* cond =
+        new InterProcessConditionVariable("sim conc cond", *mu, &client->conc_lock_.cond_var_);
+
+    while (android_atomic_inc(&region_->registering_) >=
+           GCSrvcClientHandShake::KProcessMapperCapacity) {
+      android_atomic_dec(&region_->registering_);
+      sched_yield();
+    }
+    android::FileMapperParameters* rec = handshake_->ClaimMapperRecord();
+    rec->process_id_ = getpid();
+    rec->space_index_ = index;
+    rec->fd_count_ = 1;
+    rec->shared_space_addr_ = client;
+    rec->mem_maps_[0].fd_ = fd;
+    rec->mem_maps_[0].size_ = sizeof(SimClientRegion);
+    rec->mem_maps_[0].prot_ = PROT_READ | PROT_WRITE;
+    rec->mem_maps_[0].flags_ = MAP_SHARED;
+    handshake_->PublishMapperRecord(rec);
+
+    SimClientStats* stats = &region_->clients_[index];
+    for (int i = 0; i < collections; ++i) {
+      // Dirty the heap so that the service has something to sweep.
+      memset(client->heap_, 0xff, kSimHeapBytes / 4);
+      uint64_t start = NanoTime();
+      {
+        IPMutexLock interProcMu(NULL, *mu);
+        client->conc_flag_ = 1;
+      }
+      handshake_->ReqConcCollection(reinterpret_cast<void*>(static_cast<uintptr_t>(index)));
+      {
+        IPMutexLock interProcMu(NULL, *mu);
+        while (client->conc_flag_ != 0) {
+          cond->Wait(NULL);
+        }
+      }
+      uint64_t elapsed = NanoTime() - start;
+      stats->total_gc_ns_ += elapsed;
+      stats->max_gc_ns_ = std::max(static_cast<uint64_t>(stats->max_gc_ns_), elapsed);
+    }
+    CHECK_EQ(collections, client->collections_);
+    _exit(0);
+  }
+
+  // Serves num_clients mini-runtimes until each has done its collections.
+  // Returns the elapsed time.
+  uint64_t RunSimulation(int num_clients, int collections_per_client) {
+    CHECK_LE(num_clients, kSimMaxClients);
+    memset(region_, 0, sizeof(SimServiceRegion));
+    // Created before forking, as the zygote does, so that the clients
+    // inherit the handshake locks.
+    handshake_ = new GCSrvcClientHandShake(&region_->buffer_);
+    SimWatchdog dog;
+    dog.ring_ = &handshake_->requests_ring_;
+    dog.status_.resize(num_clients, 0);
+    dog.failed_ = 0;
+    for (int c = 0; c < num_clients; ++c) {
+      pid_t pid = fork();
+      CHECK_NE(pid, -1);
+      if (pid == 0) {
+        RunClient(c, collections_per_client);
+      }
+      dog.children_.push_back(pid);
+    }
+    std::vector<pid_t> children(dog.children_);
+    dog.deadline_ns_ = NanoTime() + kSimTimeoutNs;
+    pthread_t watchdog;
+    CHECK_EQ(0, pthread_create(&watchdog, NULL, &SimWatchdog::Run, &dog));
+
+    std::vector<SimClientRegion*> clients(num_clients, static_cast<SimClientRegion*>(NULL));
+    std::vector<InterProcessMutex*> mutexes(num_clients, static_cast<InterProcessMutex*>(NULL));
+    std::vector<InterProcessConditionVariable*> conds(num_clients,
+        static_cast<InterProcessConditionVariable*>(NULL));
+    GCSrvcRequestRing* ring = &handshake_->requests_ring_;
+    uint64_t start = NanoTime();
+    int pending = num_clients * (collections_per_client + 1);
+    while (pending > 0) {
+      GCServiceReq* req = ring->WaitForRequestOrKick();
+      if (req == NULL) {
+        // Kicked by the watchdog: a client will never send its requests.
+        break;
+      }
+      if (req->req_type_ == GC_SERVICE_TASK_REG) {
+        android::FileMapperParameters rec;
+        memset(&rec, 0, sizeof(rec));
+        EXPECT_TRUE(handshake_->ImportMapperRecord(req, &rec));
+        android_atomic_dec(&region_->registering_);
+        int index = rec.space_index_;
+        EXPECT_EQ(req->pid_, rec.process_id_);
+        EXPECT_EQ(1, rec.fd_count_);
+        android::IPCAShmemMap* map = &rec.mem_maps_[0];
+        clients[index] = reinterpret_cast<SimClientRegion*>(
+            mmap(NULL, map->size_, map->prot_, map->flags_, map->fd_, 0));
+        close(map->fd_);
+        CHECK(clients[index] != MAP_FAILED);
+        // The client initialized the lock words: attach without resetting them.
+        mutexes[index] = new InterProcessMutex(&clients[index]->conc_lock_.futex_head_,
+                                               "sim conc lock");
+        conds[index] = new InterProcessConditionVariable(*mutexes[index], "sim conc cond",
+                                                         &clients[index]->conc_lock_.cond_var_);
+      } else {
+        EXPECT_EQ(static_cast<int>(GC_SERVICE_TASK_CONC), req->req_type_);
+        int index = static_cast<int>(req->data_addr_);
+        SimClientRegion* client = clients[index];
+        CHECK(client != NULL) << "collection before registration";
+        // Simulated sweep: count the marked bytes and clear them.
+        size_t marked = 0;
+        for (size_t i = 0; i < kSimHeapBytes; ++i) {
+          marked += (client->heap_[i] != 0);
+        }
+        memset(client->heap_, 0, kSimHeapBytes);
+        EXPECT_EQ(kSimHeapBytes / 4, marked);
+        IPMutexLock interProcMu(NULL, *mutexes[index]);
+        client->collections_++;
+        client->conc_flag_ = 0;
+        conds[index]->Broadcast(NULL);
+      }
+      ring->ReleaseRequest();
+      --pending;
+    }
+    uint64_t elapsed = NanoTime() - start;
+
+    CHECK_EQ(0, pthread_join(watchdog, NULL));
+    EXPECT_EQ(0, dog.failed_);
+    EXPECT_EQ(0, pending);
+    for (size_t i = 0; i < children.size(); ++i) {
+      if (dog.children_[i] != 0) {
+        // Still blocked on a collection that the service gave up on.
+        kill(children[i], SIGKILL);
+        waitpid(children[i], NULL, 0);
+      }
+      delete conds[i];
+      delete mutexes[i];
+      if (clients[i] != NULL) {
+        munmap(clients[i], sizeof(SimClientRegion));
+      }
+    }
+    if (!dog.failed_) {
+      EXPECT_EQ(0, ring->GetQueuedCount());
+    }
+    delete region_->buffer_.cond_;
+    delete region_->buffer_.mu_;
+    delete handshake_;
+    handshake_ = NULL;
+    return elapsed;
+  }
+
+  SimServiceRegion* region_;
+  GCSrvcClientHandShake* handshake_;
+};
+
+TEST_F(ServiceSimulatorTest, SharedRegionAcrossFork) {
+  int fds[2];
+  ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+  int region_fd = GCSrvcHostIPC::CreateSharedRegion("gcservice-sim-fd", kPageSize);
+  ASSERT_NE(-1, region_fd);
+  pid_t pid = fork();
+  ASSERT_NE(-1, pid);
+  if (pid == 0) {
+    // The child gets the descriptor only through SCM_RIGHTS.
+    int32_t tag = 0;
+    int fd = -1;
+    CHECK_EQ(1, GCSrvcHostIPC::ReceiveFds(fds[1], &tag, &fd, 1));
+    int32_t* word = reinterpret_cast<int32_t*>(
+        mmap(NULL, kPageSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0));
+    CHECK(word != MAP_FAILED);
+    *word = tag;
+    _exit(0);
+  }
+  ASSERT_TRUE(GCSrvcHostIPC::SendFds(fds[0], 0x5eed, &region_fd, 1));
+  int status = 0;
+  ASSERT_EQ(pid, waitpid(pid, &status, 0));
+  int32_t* word = reinterpret_cast<int32_t*>(
+      mmap(NULL, kPageSize, PROT_READ | PROT_WRITE, MAP_SHARED, region_fd, 0));
+  ASSERT_NE(MAP_FAILED, word);
+  EXPECT_EQ(0x5eed, *word);
+  munmap(word, kPageSize);
+  close(region_fd);
+  close(fds[0]);
+  close(fds[1]);
+}
+
+// Reports the collection round-trip seen by the mini-runtimes and the
+// throughput of the service as the number of clients grows.
+TEST_F(ServiceSimulatorTest, MultiProcessThroughput) {
+  static const int kClientCounts[] = { 1, 4, 16, 48 };
+  static const int kCollectionsPerClient = 200;
+  for (size_t n = 0; n < arraysize(kClientCounts); ++n) {
+    int clients = kClientCounts[n];
+    uint64_t elapsed = RunSimulation(clients, kCollectionsPerClient);
+    uint64_t total_ns = 0;
+    uint64_t max_ns = 0;
+    for (int c = 0; c < clients; ++c) {
+      total_ns += region_->clients_[c].total_gc_ns_;
+      max_ns = std::max(max_ns, static_cast<uint64_t>(region_->clients_[c].max_gc_ns_));
+    }
+    uint64_t collections = static_cast<uint64_t>(clients) * kCollectionsPerClient;
+    LOG(INFO) << "clients=" << clients
+              << " service throughput="
+              << (collections * 1000000000ULL) / std::max<uint64_t>(elapsed, 1)
+              << " gc/s, mean round trip=" << PrettyDuration(total_ns / collections)
+              << ", max round trip=" << PrettyDuration(max_ns)
+              << ", daemon wakeups=" << region_->buffer_.requests_ring_.daemon_wakeups_;
+  }
+}
+
+}  // namespace service
+}  // namespace gc
+}  // namespace art
@@ -42,6 +42,24 @@ inline mirror::Object* DlMallocSpace::AllocNonvirtual(Thread* self, size_t num_b
 }
 
 
+inline mirror::Object* DlMallocSpace::AllocThreadLocal(Thread* self, DlMallocTlab* tlab,
+                                                       size_t num_bytes,
+                                                       size_t* bytes_allocated) {
+  DCHECK_LE(num_bytes, DlMallocTlab::kMaxObjectSize);
+  const size_t index = DlMallocTlab::BucketIndex(num_bytes);
+  mirror::Object* obj = tlab->PopChunk(index);
+  if (UNLIKELY(obj == NULL)) {
+    if (!RefillTlabBucket(tlab, index)) {
+      return NULL;
+    }
+    obj = tlab->PopChunk(index);
+  }
+  // The chunk is owned by this thread, no need for the lock to read its size.
+  *bytes_allocated = AllocationSizeNonvirtual(obj);
+  memset(obj, 0, num_bytes);
+  return obj;
+}
+
 
 inline mirror::Object* DlMallocSpace::AllocWithoutGrowthLocked(size_t num_bytes,
                                                                size_t* bytes_allocated) {
@@ -49,8 +67,14 @@ inline mirror::Object* DlMallocSpace::AllocWithoutGrowthLocked(size_t num_bytes,
 	size_t calculatedSize  = 0;
 	size_t checkingSize = 0;
 	GCP_ADD_EXTRA_BYTES(num_bytes, extendedSize);
-  mirror::Object* result =
-      reinterpret_cast<mirror::Object*>(mspace_malloc(GetMspace(), extendedSize));
+  mirror::Object* result = NULL;
+  if (slab_allocator_.IsEnabled() && extendedSize <= SlabAllocator::kMaxObjectSize) {
+    size_t _slab_bytes = 0;
+    result = slab_allocator_.Alloc(extendedSize, &_slab_bytes);
+  }
+  if (result == NULL) {
+    result = reinterpret_cast<mirror::Object*>(mspace_malloc(GetMspace(), extendedSize));
+  }
   if (result != NULL) {
     if (kDebugSpaces) {
       CHECK(Contains(result)) << "Allocation (" << reinterpret_cast<void*>(result)
@@ -68,7 +92,9 @@ inline mirror::Object* DlMallocSpace::AllocWithoutGrowthLocked(size_t num_bytes,
 
     size_t tempSize = AllocationNoOverhead(result);
     GCP_REMOVE_EXTRA_BYTES(tempSize, calculatedSize);
-    GCP_REMOVE_EXTRA_BYTES(allocation_size - kChunkOverhead, checkingSize);
+    // Slab objects have no boundary tag.
+    GCP_REMOVE_EXTRA_BYTES(allocation_size - (slab_allocator_.Owns(result) ? 0 : kChunkOverhead),
+                           checkingSize);
 
     if(calculatedSize != checkingSize)
     	LOG(ERROR) << "NumBytes= " << num_bytes << ", Usable size:" << tempSize <<
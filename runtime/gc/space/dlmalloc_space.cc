@@ -22,6 +22,7 @@
 #include "thread.h"
 #include "utils.h"
 
+#include <algorithm>
 #include <valgrind.h>
 #include <../memcheck/memcheck.h>
 #include "gc/service/service_space.h"
@@ -554,11 +555,34 @@ size_t DlMallocSpace::Free(Thread* self, mirror::Object* ptr) {
   if (kRecentFreeCount > 0) {
     RegisterRecentFree(ptr);
   }
-  mspace_free(GetMspace(), ptr);
+  if (slab_allocator_.Owns(ptr)) {
+    slab_allocator_.Free(ptr);
+  } else {
+    mspace_free(GetMspace(), ptr);
+  }
   return bytes_freed;
 }
 
 
+size_t DlMallocSpace::FreeSlabObjectsLocked(size_t num_ptrs, mirror::Object** ptrs) {
+  if (!slab_allocator_.IsEnabled()) {
+    return num_ptrs;
+  }
+  size_t _chunks_count = 0;
+  for (size_t i = 0; i < num_ptrs; i++) {
+    mirror::Object* _ptr = ptrs[i];
+    // Clear the entry like mspace_bulk_free does.
+    ptrs[i] = NULL;
+    if (slab_allocator_.Owns(_ptr)) {
+      slab_allocator_.Free(_ptr);
+    } else {
+      ptrs[_chunks_count++] = _ptr;
+    }
+  }
+  return _chunks_count;
+}
+
+
 #if (ART_GC_SERVICE)
 
 size_t DlMallocSpace::FreeListAgent(Thread* self, size_t num_ptrs, mirror::Object** ptrs){
@@ -589,7 +613,8 @@ size_t DlMallocSpace::FreeListAgent(Thread* self, size_t num_ptrs, mirror::Objec
   //      ", bytes_freed=" << bytes_freed << ", conv_int = "<< _conv_bytes_freed;
      UpdateBytesAllocated(_conv_bytes_freed);
     UpdateObjectsAllocated(-num_ptrs);
-    mspace_bulk_free(GetMspace(), reinterpret_cast<void**>(ptrs), num_ptrs);
+    size_t _chunks_count = FreeSlabObjectsLocked(num_ptrs, ptrs);
+    mspace_bulk_free(GetMspace(), reinterpret_cast<void**>(ptrs), _chunks_count);
 
 //    Heap* heap = Runtime::Current()->GetHeap();
 //    heap->IncAtomicBytesAllocated(_conv_bytes_freed);
@@ -634,7 +659,7 @@ size_t DlMallocSpace::FreeList(Thread* self, size_t num_ptrs, mirror::Object** p
         num_broken_ptrs++;
         LOG(ERROR) << "FreeList[" << i << "] (" << ptrs[i] << ") not in bounds of heap " << *this;
       } else {
-        size_t size = mspace_usable_size(ptrs[i]);
+        size_t size = AllocationNoOverhead(ptrs[i]);
         memset(ptrs[i], 0xEF, size);
       }
     }
@@ -646,11 +671,48 @@ size_t DlMallocSpace::FreeList(Thread* self, size_t num_ptrs, mirror::Object** p
     int _conv_bytes_freed = -(static_cast<int>(bytes_freed));
     UpdateBytesAllocated(_conv_bytes_freed);
     UpdateObjectsAllocated(-(static_cast<int>(num_ptrs)));//num_objects_allocated_ -= num_ptrs;
-    mspace_bulk_free(GetMspace(), reinterpret_cast<void**>(ptrs), num_ptrs);
+    size_t _chunks_count = FreeSlabObjectsLocked(num_ptrs, ptrs);
+    mspace_bulk_free(GetMspace(), reinterpret_cast<void**>(ptrs), _chunks_count);
     return bytes_freed;
   }
 }
 
+bool DlMallocSpace::RefillTlabBucket(DlMallocTlab* tlab, size_t index) {
+  DlMallocTlab::Bucket* _bucket = &tlab->buckets_[index];
+  DCHECK_EQ(_bucket->count_, 0U);
+  const size_t _chunk_size = DlMallocTlab::BucketSize(index);
+  const size_t _chunks = DlMallocTlab::ChunksPerRefill(index);
+  size_t _carved = 0;
+  {
+    DLMALLOC_SPACE_LOCK_MACRO;
+    for (; _carved < _chunks; _carved++) {
+      size_t _bytes_allocated = 0;
+      mirror::Object* _chunk = AllocWithoutGrowthLocked(_chunk_size, &_bytes_allocated);
+      if (_chunk == NULL) {
+        break;
+      }
+      _bucket->chunks_[_carved] = _chunk;
+    }
+  }
+  // Hand out the chunks in address order.
+  std::reverse(_bucket->chunks_, _bucket->chunks_ + _carved);
+  _bucket->count_ = _carved;
+  tlab->refills_++;
+  return _carved != 0;
+}
+
+size_t DlMallocSpace::RevokeTlabChunks(Thread* self, DlMallocTlab* tlab) {
+  size_t _bytes_freed = 0;
+  for (size_t i = 0; i < DlMallocTlab::kBucketsCount; i++) {
+    DlMallocTlab::Bucket* _bucket = &tlab->buckets_[i];
+    if (_bucket->count_ != 0) {
+      _bytes_freed += FreeList(self, _bucket->count_, _bucket->chunks_);
+      _bucket->count_ = 0;
+    }
+  }
+  return _bytes_freed;
+}
+
 // Callback from dlmalloc when it needs to increase the footprint
 extern "C" void* art_heap_morecore(void* mspace, intptr_t increment) {
   Heap* heap = Runtime::Current()->GetHeap();
@@ -705,14 +767,66 @@ size_t DlMallocSpace::GCPGetAllocationSize(const mirror::Object* obj){
 //	return AllocationNoOverhead(obj);
 //}
 
+// Free runs shorter than this are left resident on a trim: they are likely
+// to be reused before the next one and refaulting them costs more than the
+// pages they give back.
+static const size_t kTrimMinRunPages = 4;
+
+static size_t TrimmableRunBytes(void* start, void* end) {
+  uintptr_t _begin = RoundUp(reinterpret_cast<uintptr_t>(start), kPageSize);
+  uintptr_t _end = RoundDown(reinterpret_cast<uintptr_t>(end), kPageSize);
+  if (_end < _begin + kTrimMinRunPages * kPageSize) {
+    return 0;
+  }
+  return _end - _begin;
+}
+
+static void DlMallocSpaceMadviseCallback(void* start, void* end, size_t used_bytes, void* arg) {
+  if (used_bytes == 0 && TrimmableRunBytes(start, end) != 0) {
+    DlmallocMadviseCallback(start, end, used_bytes, arg);
+  }
+}
+
+static void DlMallocSpaceFragCallback(void* start, void* end, size_t used_bytes, void* arg) {
+  // Skip chunks in use and the end marker of Walk().
+  if (used_bytes != 0 || start == NULL) {
+    return;
+  }
+  DlMallocFragmentation* _frag_info = reinterpret_cast<DlMallocFragmentation*>(arg);
+  size_t _chunk_size = reinterpret_cast<uint8_t*>(end) - reinterpret_cast<uint8_t*>(start);
+  _frag_info->free_bytes_ += _chunk_size;
+  _frag_info->largest_free_ = std::max(_frag_info->largest_free_, _chunk_size);
+  _frag_info->trimmable_bytes_ += TrimmableRunBytes(start, end);
+  _frag_info->free_chunks_++;
+}
+
+void DlMallocSpace::SampleFragmentation(DlMallocFragmentation* frag_info) {
+  memset(frag_info, 0, sizeof(*frag_info));
+  DLMALLOC_SPACE_LOCK_MACRO;
+  mspace_inspect_all(GetMspace(), DlMallocSpaceFragCallback, frag_info);
+}
+
+bool DlMallocSpace::EnableSlabAllocation() {
+  DLMALLOC_SPACE_LOCK_MACRO;
+  DCHECK(!slab_allocator_.IsEnabled());
+  if (!slab_allocator_.Init(GetMspace(), Begin(), NonGrowthLimitCapacity())) {
+    return false;
+  }
+#if (ART_GC_SERVICE)
+  // The service finds the slab pages through the shared space data.
+  dlmalloc_space_data_->slab_data_ = slab_allocator_.GetData();
+#endif
+  return true;
+}
+
 size_t DlMallocSpace::Trim() {
   GCP_MARK_START_TRIM_HW_EVENT;
 	DLMALLOC_SPACE_LOCK_MACRO;
   // Trim to release memory at the end of the space.
   mspace_trim(GetMspace(), 0);
-  // Visit space looking for page-sized holes to advise the kernel we don't need.
+  // Visit space looking for runs of free pages to advise the kernel we don't need.
   size_t reclaimed = 0;
-  mspace_inspect_all(GetMspace(), DlmallocMadviseCallback, &reclaimed);
+  mspace_inspect_all(GetMspace(), DlMallocSpaceMadviseCallback, &reclaimed);
   GCP_MARK_END_TRIM_HW_EVENT;
   return reclaimed;
 }
@@ -22,6 +22,8 @@
 #include "gc/heap.h"
 #include "gc/allocator/dlmalloc.h"
 #include "gc/accounting/space_bitmap.h"
+#include "gc/space/dlmalloc_tlab.h"
+#include "gc/space/slab_allocator.h"
 #include "gc_profiler/MProfiler.h"
 
 
@@ -50,6 +52,17 @@ namespace space {
 
 //class SharedDlMallocSpace;
 
+// Fragmentation of a dlmalloc space, sampled by a single inspect_all pass.
+typedef struct DlMallocFragmentation_S {
+  // Bytes in free chunks, including the top chunk.
+  size_t free_bytes_;
+  // The largest allocation that succeeds without growing the footprint.
+  size_t largest_free_;
+  // Whole pages inside free chunks long enough to be worth madvising.
+  size_t trimmable_bytes_;
+  size_t free_chunks_;
+} DlMallocFragmentation;
+
 #if (ART_GC_SERVICE)
 
 
@@ -126,20 +139,40 @@ class DlMallocSpace : public MemMapSpace, public IDlMallocSpace//, public AllocS
 
   mirror::Object* AllocNonvirtual(Thread* self, size_t num_bytes, size_t* bytes_allocated);
 
+  // Allocate num_bytes from the thread-local allocation buffer, refilling the
+  // size bucket from the mspace when it is empty. Does not take the space lock
+  // on the fast path.
+  mirror::Object* AllocThreadLocal(Thread* self, DlMallocTlab* tlab, size_t num_bytes,
+                                   size_t* bytes_allocated);
+
+  // Free the chunks cached in tlab. Returns the number of bytes released.
+  size_t RevokeTlabChunks(Thread* self, DlMallocTlab* tlab);
+
   size_t AllocationSizeNonvirtual(const mirror::Object* obj) {
+    if (slab_allocator_.Owns(obj)) {
+      return SlabAllocator::ObjectSize(obj);
+    }
     return mspace_usable_size(const_cast<void*>(reinterpret_cast<const void*>(obj))) +
         kChunkOverhead;
   }
 
 
   void AllocationSizes(const mirror::Object* obj, size_t* nonVirtualNoOverhead, size_t* nonVirtual) {
+    if (slab_allocator_.Owns(obj)) {
+      *nonVirtualNoOverhead = SlabAllocator::ObjectSize(obj);
+      *nonVirtual = *nonVirtualNoOverhead;
+      return;
+    }
     *nonVirtualNoOverhead = mspace_usable_size(const_cast<void*>(reinterpret_cast<const void*>(obj)));
     *nonVirtual = *nonVirtualNoOverhead + kChunkOverhead;
   }
 
-//  size_t AllocationNoOverhead(const mirror::Object* obj) {
-//    return mspace_usable_size(const_cast<void*>(reinterpret_cast<const void*>(obj)));
-//  }
+  size_t AllocationNoOverhead(const mirror::Object* obj) {
+    if (slab_allocator_.Owns(obj)) {
+      return SlabAllocator::ObjectSize(obj);
+    }
+    return mspace_usable_size(const_cast<void*>(reinterpret_cast<const void*>(obj)));
+  }
 
   size_t GCPGetAllocationSize(const mirror::Object*);
 
@@ -156,6 +189,17 @@ class DlMallocSpace : public MemMapSpace, public IDlMallocSpace//, public AllocS
   // in use, indicated by num_bytes equaling zero.
   void Walk(WalkCallback callback, void* arg) LOCKS_EXCLUDED(getMu());
 
+  // Fills frag_info from the free chunks of the space.
+  void SampleFragmentation(DlMallocFragmentation* frag_info) LOCKS_EXCLUDED(getMu());
+
+  // Serves objects of up to SlabAllocator::kMaxObjectSize bytes from slabs.
+  // Has to be called before the first allocation from the space.
+  bool EnableSlabAllocation() LOCKS_EXCLUDED(getMu());
+
+  const SlabAllocator& GetSlabAllocator() const {
+    return slab_allocator_;
+  }
+
   // Returns the number of bytes that the space has currently obtained from the system. This is
   // greater or equal to the amount of live data in the space.
   size_t GetFootprint();
@@ -318,6 +362,13 @@ class DlMallocSpace : public MemMapSpace, public IDlMallocSpace//, public AllocS
       EXCLUSIVE_LOCKS_REQUIRED(getMu());
   bool Init(size_t initial_size, size_t maximum_size, size_t growth_size, byte* requested_base);
   void RegisterRecentFree(mirror::Object* ptr);
+  bool RefillTlabBucket(DlMallocTlab* tlab, size_t index);
+  // Frees the slab objects of ptrs and moves the others to its front.
+  // Returns the number of the remaining dlmalloc chunks.
+  size_t FreeSlabObjectsLocked(size_t num_ptrs, mirror::Object** ptrs);
+
+  // Small objects allocator. Disabled unless EnableSlabAllocation() is called.
+  SlabAllocator slab_allocator_;
 
 
 //  UniquePtr<accounting::SPACE_BITMAP> live_bitmap_;
@@ -453,16 +504,36 @@ class DlMallocSpace : public MemMapSpace, public AllocSpace
 
   mirror::Object* AllocNonvirtual(Thread* self, size_t num_bytes, size_t* bytes_allocated);
 
+  // Allocate num_bytes from the thread-local allocation buffer, refilling the
+  // size bucket from the mspace when it is empty. Does not take the space lock
+  // on the fast path.
+  mirror::Object* AllocThreadLocal(Thread* self, DlMallocTlab* tlab, size_t num_bytes,
+                                   size_t* bytes_allocated);
+
+  // Free the chunks cached in tlab. Returns the number of bytes released.
+  size_t RevokeTlabChunks(Thread* self, DlMallocTlab* tlab);
+
   size_t AllocationSizeNonvirtual(const mirror::Object* obj) {
+    if (slab_allocator_.Owns(obj)) {
+      return SlabAllocator::ObjectSize(obj);
+    }
     return mspace_usable_size(const_cast<void*>(reinterpret_cast<const void*>(obj))) +
         kChunkOverhead;
   }
 
   size_t AllocationNoOverhead(const mirror::Object* obj) {
+    if (slab_allocator_.Owns(obj)) {
+      return SlabAllocator::ObjectSize(obj);
+    }
     return mspace_usable_size(const_cast<void*>(reinterpret_cast<const void*>(obj)));
   }
 
   void AllocationSizes(const mirror::Object* obj, size_t* nonVirtualNoOverhead, size_t* nonVirtual) {
+    if (slab_allocator_.Owns(obj)) {
+      *nonVirtualNoOverhead = SlabAllocator::ObjectSize(obj);
+      *nonVirtual = *nonVirtualNoOverhead;
+      return;
+    }
     *nonVirtualNoOverhead = mspace_usable_size(const_cast<void*>(reinterpret_cast<const void*>(obj)));
     *nonVirtual = *nonVirtualNoOverhead + kChunkOverhead;
   }
@@ -482,6 +553,17 @@ class DlMallocSpace : public MemMapSpace, public AllocSpace
   // in use, indicated by num_bytes equaling zero.
   void Walk(WalkCallback callback, void* arg) LOCKS_EXCLUDED(lock_);
 
+  // Fills frag_info from the free chunks of the space.
+  void SampleFragmentation(DlMallocFragmentation* frag_info) LOCKS_EXCLUDED(lock_);
+
+  // Serves objects of up to SlabAllocator::kMaxObjectSize bytes from slabs.
+  // Has to be called before the first allocation from the space.
+  bool EnableSlabAllocation() LOCKS_EXCLUDED(lock_);
+
+  const SlabAllocator& GetSlabAllocator() const {
+    return slab_allocator_;
+  }
+
   // Returns the number of bytes that the space has currently obtained from the system. This is
   // greater or equal to the amount of live data in the space.
   size_t GetFootprint();
@@ -616,6 +698,13 @@ class DlMallocSpace : public MemMapSpace, public AllocSpace
       EXCLUSIVE_LOCKS_REQUIRED(lock_);
   bool Init(size_t initial_size, size_t maximum_size, size_t growth_size, byte* requested_base);
   void RegisterRecentFree(mirror::Object* ptr);
+  bool RefillTlabBucket(DlMallocTlab* tlab, size_t index);
+  // Frees the slab objects of ptrs and moves the others to its front.
+  // Returns the number of the remaining dlmalloc chunks.
+  size_t FreeSlabObjectsLocked(size_t num_ptrs, mirror::Object** ptrs);
+
+  // Small objects allocator. Disabled unless EnableSlabAllocation() is called.
+  SlabAllocator slab_allocator_;
 
 
   UniquePtr<accounting::SPACE_BITMAP> live_bitmap_;
@@ -0,0 +1,102 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_RUNTIME_GC_SPACE_DLMALLOC_TLAB_H_
+#define ART_RUNTIME_GC_SPACE_DLMALLOC_TLAB_H_
+
+#include <string.h>
+
+#include "globals.h"
+#include "base/macros.h"
+
+namespace art {
+namespace mirror {
+  class Object;
+}  // namespace mirror
+
+namespace gc {
+namespace space {
+
+/*
+ * Thread-local allocation buffer of a DlMallocSpace.
+ * The sweepers free every object with mspace_free, so a TLAB cannot be a raw
+ * bump region. Instead each size bucket holds a run of dlmalloc chunks that
+ * were carved out of the space under a single lock acquisition, and the
+ * thread hands them out without the space lock.
+ * Objects handed out are recorded in the allocation stack lazily, a whole
+ * batch at a time, when records_ fills up or when the TLAB is revoked.
+ */
+class DlMallocTlab {
+ public:
+  static const size_t kSizeGranularity = 16;
+  static const size_t kMaxObjectSize = 256;
+  static const size_t kBucketsCount = kMaxObjectSize / kSizeGranularity;
+  // Bytes carved from the space on each refill of a bucket.
+  static const size_t kRefillBytes = 4 * KB;
+  static const size_t kMaxChunksPerRefill = 64;
+  static const size_t kRecordsCapacity = 64;
+
+  typedef struct Bucket_S {
+    size_t count_;
+    mirror::Object* chunks_[kMaxChunksPerRefill];
+  } Bucket;
+
+  DlMallocTlab() : records_count_(0), refills_(0) {
+    memset(buckets_, 0, sizeof(buckets_));
+  }
+
+  static size_t BucketIndex(size_t num_bytes) {
+    return (num_bytes - 1) / kSizeGranularity;
+  }
+
+  static size_t BucketSize(size_t index) {
+    return (index + 1) * kSizeGranularity;
+  }
+
+  static size_t ChunksPerRefill(size_t index) {
+    size_t _chunks = kRefillBytes / BucketSize(index);
+    return _chunks > kMaxChunksPerRefill ? kMaxChunksPerRefill : _chunks;
+  }
+
+  mirror::Object* PopChunk(size_t index) {
+    Bucket* _bucket = &buckets_[index];
+    if (_bucket->count_ == 0)
+      return NULL;
+    return _bucket->chunks_[--_bucket->count_];
+  }
+
+  // Returns true when records_ is full and has to be flushed.
+  bool AddRecord(mirror::Object* obj) {
+    records_[records_count_++] = obj;
+    return records_count_ == kRecordsCapacity;
+  }
+
+  Bucket buckets_[kBucketsCount];
+  // Objects handed out but not pushed on the allocation stack yet.
+  mirror::Object* records_[kRecordsCapacity];
+  size_t records_count_;
+  // Number of times the thread had to take the space lock to refill.
+  size_t refills_;
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(DlMallocTlab);
+};//class DlMallocTlab
+
+}  // namespace space
+}  // namespace gc
+}  // namespace art
+
+#endif  // ART_RUNTIME_GC_SPACE_DLMALLOC_TLAB_H_
@@ -0,0 +1,143 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "gc/allocator/dlmalloc.h"
+#include "gc/space/slab_allocator.h"
+
+namespace art {
+namespace gc {
+namespace space {
+
+const size_t SlabAllocator::kSlabSize;
+const size_t SlabAllocator::kMaxObjectSize;
+const size_t SlabAllocator::kClassesCount;
+
+
+bool SlabAllocator::Init(void* mspace, byte* begin, size_t capacity) {
+  CHECK_GE(kBitmapWords * 32, (kSlabSize - ObjectsOffset()) / kSizeGranularity);
+  const size_t _pages_count = RoundUp(capacity, kSlabSize) / kSlabSize;
+  SlabAllocatorData* _data = reinterpret_cast<SlabAllocatorData*>(
+      mspace_malloc(mspace, sizeof(SlabAllocatorData) + _pages_count));
+  if (_data == NULL) {
+    LOG(ERROR) << "SlabAllocator: cannot allocate the page map of " << _pages_count << " pages";
+    return false;
+  }
+  memset(_data, 0, sizeof(SlabAllocatorData) + _pages_count);
+  _data->pages_count_ = _pages_count;
+  mspace_ = mspace;
+  begin_ = begin;
+  data_ = _data;
+  return true;
+}
+
+
+void SlabAllocator::LinkSlab(Slab* slab) {
+  Slab** _head = &data_->partial_[slab->class_index_];
+  slab->prev_ = NULL;
+  slab->next_ = *_head;
+  if (*_head != NULL) {
+    (*_head)->prev_ = slab;
+  }
+  *_head = slab;
+}
+
+
+void SlabAllocator::UnlinkSlab(Slab* slab) {
+  if (slab->prev_ != NULL) {
+    slab->prev_->next_ = slab->next_;
+  } else {
+    data_->partial_[slab->class_index_] = slab->next_;
+  }
+  if (slab->next_ != NULL) {
+    slab->next_->prev_ = slab->prev_;
+  }
+  slab->next_ = NULL;
+  slab->prev_ = NULL;
+}
+
+
+SlabAllocator::Slab* SlabAllocator::NewSlab(size_t index) {
+  Slab* _slab = reinterpret_cast<Slab*>(mspace_memalign(mspace_, kSlabSize, kSlabSize));
+  if (_slab == NULL) {
+    return NULL;
+  }
+  const size_t _capacity = (kSlabSize - ObjectsOffset()) / ClassSize(index);
+  memset(_slab, 0, sizeof(Slab));
+  _slab->class_index_ = index;
+  _slab->capacity_ = _capacity;
+  _slab->free_count_ = _capacity;
+  for (size_t i = 0; i < _capacity / 32; i++) {
+    _slab->free_bits_[i] = ~0U;
+  }
+  if (_capacity % 32 != 0) {
+    _slab->free_bits_[_capacity / 32] = (1U << (_capacity % 32)) - 1;
+  }
+  data_->page_map_[(reinterpret_cast<byte*>(_slab) - begin_) / kSlabSize] = 1;
+  data_->slabs_count_++;
+  LinkSlab(_slab);
+  return _slab;
+}
+
+
+mirror::Object* SlabAllocator::Alloc(size_t num_bytes, size_t* bytes_allocated) {
+  DCHECK_LE(num_bytes, kMaxObjectSize);
+  const size_t _index = ClassIndex(num_bytes);
+  Slab* _slab = data_->partial_[_index];
+  if (_slab == NULL) {
+    _slab = NewSlab(_index);
+    if (_slab == NULL) {
+      return NULL;
+    }
+  }
+  size_t _word = 0;
+  while (_slab->free_bits_[_word] == 0) {
+    _word++;
+  }
+  const size_t _bit = CTZ(_slab->free_bits_[_word]);
+  _slab->free_bits_[_word] &= ~(1U << _bit);
+  if (--_slab->free_count_ == 0) {
+    UnlinkSlab(_slab);
+  }
+  const size_t _class_size = ClassSize(_index);
+  *bytes_allocated = _class_size;
+  return reinterpret_cast<mirror::Object*>(reinterpret_cast<byte*>(_slab) + ObjectsOffset() +
+                                           (_word * 32 + _bit) * _class_size);
+}
+
+
+size_t SlabAllocator::Free(mirror::Object* obj) {
+  Slab* _slab = SlabOf(obj);
+  const size_t _class_size = ClassSize(_slab->class_index_);
+  const size_t _slot = (reinterpret_cast<byte*>(obj) - reinterpret_cast<byte*>(_slab) -
+                        ObjectsOffset()) / _class_size;
+  DCHECK_EQ(_slab->free_bits_[_slot / 32] & (1U << (_slot % 32)), 0U) << "double free " << obj;
+  _slab->free_bits_[_slot / 32] |= (1U << (_slot % 32));
+  if (_slab->free_count_++ == 0) {
+    LinkSlab(_slab);
+  } else if (_slab->free_count_ == _slab->capacity_ &&
+             (_slab->prev_ != NULL || _slab->next_ != NULL)) {
+    // Keep the last slab of each class to avoid trashing on the boundary.
+    UnlinkSlab(_slab);
+    data_->page_map_[(reinterpret_cast<byte*>(_slab) - begin_) / kSlabSize] = 0;
+    data_->slabs_count_--;
+    mspace_free(mspace_, _slab);
+  }
+  return _class_size;
+}
+
+}  // namespace space
+}  // namespace gc
+}  // namespace art
@@ -0,0 +1,147 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_RUNTIME_GC_SPACE_SLAB_ALLOCATOR_H_
+#define ART_RUNTIME_GC_SPACE_SLAB_ALLOCATOR_H_
+
+#include <stdint.h>
+#include <string.h>
+
+#include "base/logging.h"
+#include "base/macros.h"
+#include "globals.h"
+#include "utils.h"
+
+namespace art {
+namespace mirror {
+  class Object;
+}  // namespace mirror
+
+namespace gc {
+namespace space {
+
+/*
+ * Size-segregated allocator for the small objects of a DlMallocSpace.
+ * Objects of up to kMaxObjectSize bytes are carved from page sized slabs
+ * holding a single size class. A slab is one page aligned dlmalloc chunk of
+ * the space with its free bitmap inline in the header, so slab objects carry
+ * no boundary tag and freeing one clears a bit.
+ * The page map telling slab pages from dlmalloc chunks is allocated in the
+ * mspace too: the whole state lives in the space memory, where the GC
+ * service reads it through its own mapping (see ObjectSize()).
+ * Callers hold the space lock.
+ */
+class SlabAllocator {
+ public:
+  static const size_t kSlabSize = kPageSize;
+  static const size_t kSizeGranularity = 8;
+  static const size_t kMaxObjectSize = 64;
+  static const size_t kClassesCount = kMaxObjectSize / kSizeGranularity;
+  static const size_t kBitmapWords = 16;
+
+  typedef struct Slab_S {
+    uint16_t class_index_;
+    uint16_t capacity_;
+    uint16_t free_count_;
+    uint16_t pad_;
+    struct Slab_S* next_;
+    struct Slab_S* prev_;
+    // A set bit is a free slot.
+    uint32_t free_bits_[kBitmapWords];
+  } Slab;
+
+  typedef struct SlabAllocatorData_S {
+    // Slabs with free slots; allocation is from the head.
+    Slab* partial_[kClassesCount];
+    size_t slabs_count_;
+    size_t pages_count_;
+    // One byte per page of the space, set for slab pages.
+    byte page_map_[0];
+  } SlabAllocatorData;
+
+  SlabAllocator() : data_(NULL), begin_(NULL), mspace_(NULL) {}
+
+  // Allocates the shared state in mspace for a space of capacity bytes.
+  bool Init(void* mspace, byte* begin, size_t capacity);
+
+  bool IsEnabled() const {
+    return data_ != NULL;
+  }
+
+  SlabAllocatorData* GetData() const {
+    return data_;
+  }
+
+  static size_t ClassIndex(size_t num_bytes) {
+    return (num_bytes - 1) / kSizeGranularity;
+  }
+
+  static size_t ClassSize(size_t index) {
+    return (index + 1) * kSizeGranularity;
+  }
+
+  static size_t ObjectsOffset() {
+    return RoundUp(sizeof(Slab), kSizeGranularity);
+  }
+
+  static Slab* SlabOf(const void* obj) {
+    return reinterpret_cast<Slab*>(RoundDown(reinterpret_cast<uintptr_t>(obj), kSlabSize));
+  }
+
+  // Size of a slab object. Only reads the slab header, so it works on any
+  // page aligned mapping of the space.
+  static size_t ObjectSize(const void* obj) {
+    return ClassSize(SlabOf(obj)->class_index_);
+  }
+
+  // Whether the page at offset from the beginning of the space is a slab.
+  static bool IsSlabPage(const SlabAllocatorData* data, uintptr_t offset) {
+    const size_t _page = offset / kSlabSize;
+    return _page < data->pages_count_ && data->page_map_[_page] != 0;
+  }
+
+  bool Owns(const mirror::Object* obj) const {
+    return data_ != NULL &&
+        IsSlabPage(data_, reinterpret_cast<uintptr_t>(obj) - reinterpret_cast<uintptr_t>(begin_));
+  }
+
+  // Returns NULL when no slab can be carved from the mspace.
+  mirror::Object* Alloc(size_t num_bytes, size_t* bytes_allocated);
+
+  // Returns the bytes released to the space.
+  size_t Free(mirror::Object* obj);
+
+  size_t GetSlabsCount() const {
+    return data_ == NULL ? 0 : data_->slabs_count_;
+  }
+
+ private:
+  Slab* NewSlab(size_t index);
+  void LinkSlab(Slab* slab);
+  void UnlinkSlab(Slab* slab);
+
+  SlabAllocatorData* data_;
+  byte* begin_;
+  void* mspace_;
+
+  DISALLOW_COPY_AND_ASSIGN(SlabAllocator);
+};//class SlabAllocator
+
+}  // namespace space
+}  // namespace gc
+}  // namespace art
+
+#endif  // ART_RUNTIME_GC_SPACE_SLAB_ALLOCATOR_H_
@@ -148,6 +148,10 @@ typedef struct GCSrvDlMallocSpace_S {
   // Used to ensure mutual exclusion when the allocation spaces data structures are being modified.
   BaseMutex* lock_ ;//DEFAULT_MUTEX_ACQUIRED_AFTER;
 
+  // Page map of the small objects slabs, in the client address space.
+  // NULL when the space does not use slabs.
+  void* slab_data_;
+
 
 }__attribute__((aligned(8))) GCSrvDlMallocSpace;
 
@@ -211,6 +215,10 @@ typedef struct GCSrvceCashedStatsCounters_S {
   volatile int32_t reference_count_;
   volatile int32_t cards_scanned_;
 
+  // Lookups of the server's mapped-class metadata cache.
+  volatile int32_t class_cache_hits_;
+  volatile int32_t class_cache_misses_;
+
 
   GCSrvceCollectorTimeStats total_stats_;
 }__attribute__((aligned(8))) GCSrvceCashedStatsCounters;
@@ -320,6 +328,9 @@ typedef struct AgentMemInfoHistory_S {
   int oom_label_;
   long memory_size_;
   size_t heap_size_;
+  /* bytes freed and service time spent by the collections done in the window */
+  uint64_t gc_freed_bytes_;
+  uint64_t gc_cost_ns_;
 } AgentMemInfoHistory;
 
 typedef enum {
@@ -453,6 +464,12 @@ typedef struct GCSrvSharableHeapData_S {
    */
   volatile int process_state_;
 
+  /*
+   * number of classes loaded by the client class linker when the last
+   * marking phase started. The service drops its cached class metadata
+   * when it changes.
+   */
+  volatile int32_t loaded_classes_count_;
 
 
 } __attribute__((aligned(8))) GCSrvSharableHeapData;
@@ -23,6 +23,8 @@
 
 #include <stdint.h>
 
+#include <vector>
+
 namespace art {
 namespace gc {
 namespace space {
@@ -303,6 +305,88 @@ TEST_F(SpaceTest, AllocAndFreeList) {
   }
 }
 
+TEST_F(SpaceTest, SlabAllocation) {
+  DL_MALLOC_SPACE* space(DlMallocSpace::Create("test", 4 * MB, 16 * MB, 16 * MB, NULL));
+  ASSERT_TRUE(space != NULL);
+  ASSERT_TRUE(space->EnableSlabAllocation());
+
+  // Make space findable to the heap, will also delete space when runtime is cleaned up
+  AddContinuousSpace(space);
+  Thread* self = Thread::Current();
+
+  // Small objects come from slabs and are rounded to their size class.
+  mirror::Object* lots_of_objects[1024];
+  for (size_t i = 0; i < arraysize(lots_of_objects); i++) {
+    size_t num_bytes = 8 + (i % 8) * 8;
+    size_t allocation_size = 0;
+    lots_of_objects[i] = space->Alloc(self, num_bytes, &allocation_size);
+    ASSERT_TRUE(lots_of_objects[i] != NULL);
+    EXPECT_TRUE(space->GetSlabAllocator().Owns(lots_of_objects[i]));
+    EXPECT_EQ(num_bytes, allocation_size);
+    EXPECT_EQ(allocation_size, space->AllocationSize(lots_of_objects[i]));
+    EXPECT_TRUE(IsAligned<kObjectAlignment>(lots_of_objects[i]));
+  }
+  EXPECT_LE(8U, space->GetSlabAllocator().GetSlabsCount());
+
+  // Larger objects still come from dlmalloc.
+  size_t large_size = 0;
+  mirror::Object* large = space->Alloc(self, SlabAllocator::kMaxObjectSize + 1, &large_size);
+  ASSERT_TRUE(large != NULL);
+  EXPECT_FALSE(space->GetSlabAllocator().Owns(large));
+  space->Free(self, large);
+
+  // Free a mix of slab objects and chunks, and check pointers are NULL.
+  lots_of_objects[0] = space->Alloc(self, 128, &large_size);
+  ASSERT_TRUE(lots_of_objects[0] != NULL);
+  space->FreeList(self, arraysize(lots_of_objects), lots_of_objects);
+  for (size_t i = 0; i < arraysize(lots_of_objects); i++) {
+    EXPECT_TRUE(lots_of_objects[i] == NULL);
+  }
+  // Only the last slab of each class is kept once empty.
+  EXPECT_GE(SlabAllocator::kClassesCount, space->GetSlabAllocator().GetSlabsCount());
+  EXPECT_EQ(0U, space->GetBytesAllocated());
+}
+
+// Compares the allocation throughput, the per-object overhead and the time
+// to free a swept batch of small objects with and without slabs.
+TEST_F(SpaceTest, SlabAllocationBenchmark) {
+  static const size_t kObjectsCount = 64 * KB;
+  static const size_t kObjectSizes[] = { 16, 32, 64 };
+  Thread* self = Thread::Current();
+  std::vector<mirror::Object*> objects(kObjectsCount);
+  for (size_t s = 0; s < arraysize(kObjectSizes); s++) {
+    for (int use_slabs = 0; use_slabs < 2; use_slabs++) {
+      DL_MALLOC_SPACE* space(DlMallocSpace::Create("test", 4 * MB, 16 * MB, 16 * MB, NULL));
+      ASSERT_TRUE(space != NULL);
+      if (use_slabs != 0) {
+        ASSERT_TRUE(space->EnableSlabAllocation());
+      }
+      AddContinuousSpace(space);
+      size_t footprint = space->GetFootprint();
+      uint64_t start = NanoTime();
+      for (size_t i = 0; i < kObjectsCount; i++) {
+        size_t allocation_size = 0;
+        objects[i] = space->AllocWithGrowth(self, kObjectSizes[s], &allocation_size);
+        ASSERT_TRUE(objects[i] != NULL);
+      }
+      uint64_t alloc_ns = NanoTime() - start;
+      size_t overhead = space->GetFootprint() - footprint - kObjectsCount * kObjectSizes[s];
+      // Free every other object, the way a sweep frees a fragmented run.
+      size_t freed_count = 0;
+      for (size_t i = 0; i < kObjectsCount; i += 2) {
+        objects[freed_count++] = objects[i];
+      }
+      start = NanoTime();
+      space->FreeList(self, freed_count, &objects[0]);
+      uint64_t free_ns = NanoTime() - start;
+      LOG(INFO) << (use_slabs != 0 ? "slabs" : "dlmalloc") << " objects of " << kObjectSizes[s]
+                << "B: alloc " << PrettyDuration(alloc_ns / kObjectsCount) << "/object"
+                << ", overhead " << overhead / kObjectsCount << "B/object"
+                << ", FreeList " << PrettyDuration(free_ns / freed_count) << "/object";
+    }
+  }
+}
+
 void SpaceTest::SizeFootPrintGrowthLimitAndTrimBody(DL_MALLOC_SPACE* space, intptr_t object_size,
                                                     int round, size_t growth_limit) {
   if (((object_size > 0 && object_size >= static_cast<intptr_t>(growth_limit))) ||
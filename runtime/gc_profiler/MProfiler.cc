@@ -1940,12 +1940,12 @@ void VMProfiler::ProcessSignalCatcher(int signalVal) {
 		GCMMP_VLOG(INFO) << "VMProfiler: Sent the signal " << self->GetTid() ;
 
 		if(false) {
-      LOG(ERROR) << "-------Calling executing compaction--------";
+      LOG(ERROR) << "-------Estimating a compaction of the alloc space--------";
       gc::collector::SpaceCompactor* compactor =
           new gc::collector::SpaceCompactor(Runtime::Current()->GetHeap());
       compactor->startCompaction();
       compactor->FinalizeCompaction();
-      LOG(ERROR) << "-------Done executing compaction--------";
+      LOG(ERROR) << "-------Done estimating the compaction--------";
 		}
 	}
 }
@@ -2033,7 +2033,7 @@ void VMProfiler::PreForkPreparation() {
 /*
  * Return true only when the MProfiler is Running
  */
-inline bool VMProfiler::IsMProfRunning() {
+bool VMProfiler::IsMProfRunning() {
 	VMProfiler* mP = Runtime::Current()->GetVMProfiler();
 	if(mP != NULL && mP->IsProfilingEnabled())
 		return mP->IsProfilingRunning();
@@ -2265,6 +2265,10 @@ void FragGCProfiler::gcpLogPerfData() {
       heap_->GetBytesAllocated() << ", concBytes: " <<
       heap_->GetConcStartBytes(true) << ", footPrint: " <<
       heap_->GetMaxAllowedFootPrint();
+  const gc::space::DlMallocFragmentation& _frag = heap_->GetAllocSpaceFragmentation();
+  LOG(ERROR) << "Frag: free=" << _frag.free_bytes_ << ", largest=" <<
+      _frag.largest_free_ << ", trimmable=" << _frag.trimmable_bytes_ <<
+      ", chunks=" << _frag.free_chunks_;
 
   GCHistogramObjSizesManager* _histManager = getFragHistograms();
   if(_histManager != NULL)
@@ -2342,6 +2346,7 @@ void FragGCProfiler::gcpPostMarkCollection(void) {
   heapIntegral_.gcpPostCollectionMark(&allocatedBytesData_);
 
   Runtime::Current()->GetHeap()->GetMaxContigAlloc(this);
+  Runtime::Current()->GetHeap()->SampleAllocSpaceFragmentation();
 
   //we do not need to aggregate since we have only one histogram
   hitogramsData_->calculatePercentiles();
@@ -24,7 +24,6 @@
 
 #include "hprof.h"
 
-#include <cutils/open_memstream.h>
 #include <errno.h>
 #include <fcntl.h>
 #include <stdio.h>
@@ -34,8 +33,10 @@
 #include <time.h>
 #include <time.h>
 #include <unistd.h>
+#include <zlib.h>
 
 #include <set>
+#include <vector>
 
 #include "base/logging.h"
 #include "base/stringprintf.h"
@@ -176,6 +177,187 @@ typedef std::set<mirror::Class*>::iterator ClassSetIterator;
 typedef SafeMap<std::string, size_t> StringMap;
 typedef SafeMap<std::string, size_t>::iterator StringMapIterator;
 
+// Destination of the dump. Records are written through a sink instead of
+// being collected in memory; see Hprof::Dump() for the two walks this takes.
+class HprofOutput {
+ public:
+  HprofOutput() : length_(0), failed_(false) {}
+  virtual ~HprofOutput() {}
+
+  bool Write(const void* data, size_t length) {
+    length_ += length;
+    if (!failed_ && !DoWrite(data, length)) {
+      failed_ = true;
+    }
+    return !failed_;
+  }
+
+  // Flushes what is buffered. Returns false if any write failed.
+  bool Finish() {
+    if (!failed_ && !DoFinish()) {
+      failed_ = true;
+    }
+    return !failed_;
+  }
+
+  // Bytes of the dump, before any compression.
+  size_t Length() const {
+    return length_;
+  }
+
+ protected:
+  virtual bool DoWrite(const void* data, size_t length) = 0;
+  virtual bool DoFinish() {
+    return true;
+  }
+
+ private:
+  size_t length_;
+  bool failed_;
+
+  DISALLOW_COPY_AND_ASSIGN(HprofOutput);
+};
+
+// Drops the records; the first walk only collects strings and classes.
+class HprofCountingOutput : public HprofOutput {
+ public:
+  HprofCountingOutput() {}
+
+ protected:
+  bool DoWrite(const void*, size_t) {
+    return true;
+  }
+};
+
+// Keeps the dump in memory for DDMS, which takes it as a single chunk.
+class HprofMemoryOutput : public HprofOutput {
+ public:
+  HprofMemoryOutput() {}
+
+  std::vector<uint8_t>& GetData() {
+    return data_;
+  }
+
+ protected:
+  bool DoWrite(const void* data, size_t length) {
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+    data_.insert(data_.end(), bytes, bytes + length);
+    return true;
+  }
+
+ private:
+  std::vector<uint8_t> data_;
+};
+
+// Streams the dump to a file through a fixed size buffer, gzip compressed
+// on the fly if requested.
+class HprofFileOutput : public HprofOutput {
+ public:
+  static const size_t kBufferSize = 64 * KB;
+
+  HprofFileOutput(File* file, bool compress)
+      : file_(file), compress_(compress), buffer_(new uint8_t[kBufferSize]), used_(0),
+        written_(0) {
+    memset(&zstream_, 0, sizeof(zstream_));
+  }
+
+  ~HprofFileOutput() {
+    if (compress_) {
+      deflateEnd(&zstream_);
+    }
+  }
+
+  bool Init() {
+    // 16 added to the window bits selects the gzip wrapper.
+    if (compress_ && deflateInit2(&zstream_, Z_DEFAULT_COMPRESSION, Z_DEFLATED, MAX_WBITS + 16,
+                                  8, Z_DEFAULT_STRATEGY) != Z_OK) {
+      compress_ = false;
+      return false;
+    }
+    return true;
+  }
+
+  // Bytes written to the file.
+  size_t Written() const {
+    return written_;
+  }
+
+ protected:
+  bool DoWrite(const void* data, size_t length) {
+    if (compress_) {
+      zstream_.next_in = reinterpret_cast<Bytef*>(const_cast<void*>(data));
+      zstream_.avail_in = length;
+      while (zstream_.avail_in != 0) {
+        if (!Deflate(Z_NO_FLUSH)) {
+          return false;
+        }
+      }
+      return true;
+    }
+    if (used_ + length > kBufferSize && !FlushBuffer()) {
+      return false;
+    }
+    if (length >= kBufferSize) {
+      written_ += length;
+      return file_->WriteFully(data, length);
+    }
+    memcpy(buffer_.get() + used_, data, length);
+    used_ += length;
+    return true;
+  }
+
+  bool DoFinish() {
+    if (compress_) {
+      zstream_.next_in = NULL;
+      zstream_.avail_in = 0;
+      int rc;
+      do {
+        zstream_.next_out = buffer_.get() + used_;
+        zstream_.avail_out = kBufferSize - used_;
+        rc = deflate(&zstream_, Z_FINISH);
+        if (rc == Z_STREAM_ERROR) {
+          return false;
+        }
+        used_ = kBufferSize - zstream_.avail_out;
+        if (!FlushBuffer()) {
+          return false;
+        }
+      } while (rc != Z_STREAM_END);
+      return true;
+    }
+    return FlushBuffer();
+  }
+
+ private:
+  // Compresses the pending input into the buffer, flushing it once full.
+  bool Deflate(int flush) {
+    zstream_.next_out = buffer_.get() + used_;
+    zstream_.avail_out = kBufferSize - used_;
+    if (deflate(&zstream_, flush) == Z_STREAM_ERROR) {
+      return false;
+    }
+    used_ = kBufferSize - zstream_.avail_out;
+    return used_ < kBufferSize || FlushBuffer();
+  }
+
+  bool FlushBuffer() {
+    if (used_ == 0) {
+      return true;
+    }
+    written_ += used_;
+    bool okay = file_->WriteFully(buffer_.get(), used_);
+    used_ = 0;
+    return okay;
+  }
+
+  UniquePtr<File> file_;
+  bool compress_;
+  UniquePtr<uint8_t[]> buffer_;
+  size_t used_;
+  size_t written_;
+  z_stream zstream_;
+};
+
 // Represents a top-level hprof record, whose serialized format is:
 // U1  TAG: denoting the type of the record
 // U4  TIME: number of microseconds since the time stamp in the header
@@ -187,20 +369,20 @@ class HprofRecord {
     dirty_ = false;
     alloc_length_ = 128;
     body_ = reinterpret_cast<unsigned char*>(malloc(alloc_length_));
-    fp_ = NULL;
+    out_ = NULL;
   }
 
   ~HprofRecord() {
     free(body_);
   }
 
-  int StartNewRecord(FILE* fp, uint8_t tag, uint32_t time) {
+  int StartNewRecord(HprofOutput* out, uint8_t tag, uint32_t time) {
     int rc = Flush();
     if (rc != 0) {
       return rc;
     }
 
-    fp_ = fp;
+    out_ = out;
     tag_ = tag;
     time_ = time;
     length_ = 0;
@@ -216,12 +398,7 @@ class HprofRecord {
       U4_TO_BUF_BE(headBuf, 1, time_);
       U4_TO_BUF_BE(headBuf, 5, length_);
 
-      int nb = fwrite(headBuf, 1, sizeof(headBuf), fp_);
-      if (nb != sizeof(headBuf)) {
-        return UNIQUE_ERROR;
-      }
-      nb = fwrite(body_, 1, length_, fp_);
-      if (nb != static_cast<int>(length_)) {
+      if (!out_->Write(headBuf, sizeof(headBuf)) || !out_->Write(body_, length_)) {
         return UNIQUE_ERROR;
       }
 
@@ -355,7 +532,7 @@ class HprofRecord {
   size_t alloc_length_;
   unsigned char* body_;
 
-  FILE* fp_;
+  HprofOutput* out_;
   uint8_t tag_;
   uint32_t time_;
   size_t length_;
@@ -376,75 +553,36 @@ class Hprof {
         gc_scan_state_(0),
         current_heap_(HPROF_HEAP_DEFAULT),
         objects_in_segment_(0),
-        header_fp_(NULL),
-        header_data_ptr_(NULL),
-        header_data_size_(0),
-        body_fp_(NULL),
-        body_data_ptr_(NULL),
-        body_data_size_(0),
+        output_(NULL),
         next_string_id_(0x400000) {
     LOG(INFO) << "hprof: heap dump \"" << filename_ << "\" starting...";
-
-    header_fp_ = open_memstream(&header_data_ptr_, &header_data_size_);
-    if (header_fp_ == NULL) {
-      PLOG(FATAL) << "header open_memstream failed";
-    }
-
-    body_fp_ = open_memstream(&body_data_ptr_, &body_data_size_);
-    if (body_fp_ == NULL) {
-      PLOG(FATAL) << "body open_memstream failed";
-    }
-  }
-
-  ~Hprof() {
-    if (header_fp_ != NULL) {
-      fclose(header_fp_);
-    }
-    if (body_fp_ != NULL) {
-      fclose(body_fp_);
-    }
-    free(header_data_ptr_);
-    free(body_data_ptr_);
   }
 
+  // The string and class tables have to precede the records referring to
+  // them (jhat requires it), but they are only known once the heap has been
+  // walked. Rather than keeping the records in memory, the heap is walked
+  // twice: the first walk only collects the strings and classes, the second
+  // streams the records after the tables.
   void Dump()
       EXCLUSIVE_LOCKS_REQUIRED(Locks::mutator_lock_)
       LOCKS_EXCLUDED(Locks::heap_bitmap_lock_) {
-    // Walk the roots and the heap.
-    current_record_.StartNewRecord(body_fp_, HPROF_TAG_HEAP_DUMP_SEGMENT, HPROF_TIME);
-    Runtime::Current()->VisitRoots(RootVisitor, this, false, false);
     Thread* self = Thread::Current();
     {
       WriterMutexLock mu(self, *Locks::heap_bitmap_lock_);
       Runtime::Current()->GetHeap()->FlushAllocStack();
     }
-    {
-      ReaderMutexLock mu(self, *Locks::heap_bitmap_lock_);
-      Runtime::Current()->GetHeap()->GetLiveBitmap()->Walk(HeapBitmapCallback, this);
-    }
-    current_record_.StartNewRecord(body_fp_, HPROF_TAG_HEAP_DUMP_END, HPROF_TIME);
-    current_record_.Flush();
-    fflush(body_fp_);
-
-    // Write the header.
-    WriteFixedHeader();
-    // Write the string and class tables, and any stack traces, to the header.
-    // (jhat requires that these appear before any of the data in the body that refers to them.)
-    WriteStringTable();
-    WriteClassTable();
-    WriteStackTraces();
-    current_record_.Flush();
-    fflush(header_fp_);
-
-    bool okay = true;
+    HprofCountingOutput counting_output;
+    output_ = &counting_output;
+    WalkHeap();
+    const size_t strings_count = strings_.size();
+    const size_t classes_count = classes_.size();
+
+    UniquePtr<HprofOutput> output;
+    HprofMemoryOutput* memory_output = NULL;
+    HprofFileOutput* file_output = NULL;
     if (direct_to_ddms_) {
-      // Send the data off to DDMS.
-      iovec iov[2];
-      iov[0].iov_base = header_data_ptr_;
-      iov[0].iov_len = header_data_size_;
-      iov[1].iov_base = body_data_ptr_;
-      iov[1].iov_len = body_data_size_;
-      Dbg::DdmSendChunkV(CHUNK_TYPE("HPDS"), iov, 2);
+      memory_output = new HprofMemoryOutput();
+      output.reset(memory_output);
     } else {
       // Where exactly are we writing to?
       int out_fd;
@@ -462,25 +600,51 @@ class Hprof {
           return;
         }
       }
-
-      UniquePtr<File> file(new File(out_fd, filename_));
-      okay = file->WriteFully(header_data_ptr_, header_data_size_) &&
-          file->WriteFully(body_data_ptr_, body_data_size_);
-      if (!okay) {
-        std::string msg(StringPrintf("Couldn't dump heap; writing \"%s\" failed: %s",
-                                     filename_.c_str(), strerror(errno)));
-        ThrowRuntimeException("%s", msg.c_str());
-        LOG(ERROR) << msg;
+      // A ".gz" file name asks for a compressed dump.
+      bool compress = EndsWith(filename_, ".gz");
+      file_output = new HprofFileOutput(new File(out_fd, filename_), compress);
+      output.reset(file_output);
+      if (!file_output->Init()) {
+        LOG(WARNING) << "hprof: cannot compress \"" << filename_ << "\", writing it uncompressed";
       }
     }
+    output_ = output.get();
+
+    // Write the header.
+    WriteFixedHeader();
+    // Write the string and class tables, and any stack traces.
+    WriteStringTable();
+    WriteClassTable();
+    WriteStackTraces();
+    WalkHeap();
+    CHECK_EQ(strings_count, strings_.size());
+    CHECK_EQ(classes_count, classes_.size());
+
+    bool okay = output->Finish();
+    if (direct_to_ddms_) {
+      // Send the data off to DDMS.
+      std::vector<uint8_t>& data = memory_output->GetData();
+      iovec iov[1];
+      iov[0].iov_base = &data[0];
+      iov[0].iov_len = data.size();
+      Dbg::DdmSendChunkV(CHUNK_TYPE("HPDS"), iov, 1);
+    } else if (!okay) {
+      std::string msg(StringPrintf("Couldn't dump heap; writing \"%s\" failed: %s",
+                                   filename_.c_str(), strerror(errno)));
+      ThrowRuntimeException("%s", msg.c_str());
+      LOG(ERROR) << msg;
+    }
 
     // Throw out a log message for the benefit of "runhat".
     if (okay) {
       uint64_t duration = NanoTime() - start_ns_;
       LOG(INFO) << "hprof: heap dump completed ("
-          << PrettySize(header_data_size_ + body_data_size_ + 1023)
+          << PrettySize(output->Length() + 1023)
+          << (file_output != NULL && file_output->Written() != output->Length() ?
+              StringPrintf(", %s written", PrettySize(file_output->Written()).c_str()) : "")
           << ") in " << PrettyDuration(duration);
     }
+    output_ = NULL;
   }
 
  private:
@@ -506,6 +670,21 @@ class Hprof {
   void Finish() {
   }
 
+  // Emits the roots and the objects as heap dump segments.
+  void WalkHeap() EXCLUSIVE_LOCKS_REQUIRED(Locks::mutator_lock_)
+      LOCKS_EXCLUDED(Locks::heap_bitmap_lock_) {
+    gc_scan_state_ = 0;
+    gc_thread_serial_number_ = 0;
+    StartNewHeapDumpSegment();
+    Runtime::Current()->VisitRoots(RootVisitor, this, false, false);
+    {
+      ReaderMutexLock mu(Thread::Current(), *Locks::heap_bitmap_lock_);
+      Runtime::Current()->GetHeap()->GetLiveBitmap()->Walk(HeapBitmapCallback, this);
+    }
+    current_record_.StartNewRecord(output_, HPROF_TAG_HEAP_DUMP_END, HPROF_TIME);
+    current_record_.Flush();
+  }
+
   int WriteClassTable() SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
     HprofRecord* rec = &current_record_;
     uint32_t nextSerialNumber = 1;
@@ -514,7 +693,7 @@ class Hprof {
       const mirror::Class* c = *it;
       CHECK(c != NULL);
 
-      int err = current_record_.StartNewRecord(header_fp_, HPROF_TAG_LOAD_CLASS, HPROF_TIME);
+      int err = current_record_.StartNewRecord(output_, HPROF_TAG_LOAD_CLASS, HPROF_TIME);
       if (err != 0) {
         return err;
       }
@@ -540,7 +719,7 @@ class Hprof {
       std::string string((*it).first);
       size_t id = (*it).second;
 
-      int err = current_record_.StartNewRecord(header_fp_, HPROF_TAG_STRING, HPROF_TIME);
+      int err = current_record_.StartNewRecord(output_, HPROF_TAG_STRING, HPROF_TIME);
       if (err != 0) {
         return err;
       }
@@ -564,7 +743,7 @@ class Hprof {
 
   void StartNewHeapDumpSegment() {
     // This flushes the old segment and starts a new one.
-    current_record_.StartNewRecord(body_fp_, HPROF_TAG_HEAP_DUMP_SEGMENT, HPROF_TIME);
+    current_record_.StartNewRecord(output_, HPROF_TAG_HEAP_DUMP_SEGMENT, HPROF_TIME);
     objects_in_segment_ = 0;
 
     // Starting a new HEAP_DUMP resets the heap to default.
@@ -619,11 +798,11 @@ class Hprof {
 
     // Write the file header.
     // U1: NUL-terminated magic string.
-    fwrite(magic, 1, sizeof(magic), header_fp_);
+    output_->Write(magic, sizeof(magic));
 
     // U4: size of identifiers.  We're using addresses as IDs, so make sure a pointer fits.
     U4_TO_BUF_BE(buf, 0, sizeof(void*));
-    fwrite(buf, 1, sizeof(uint32_t), header_fp_);
+    output_->Write(buf, sizeof(uint32_t));
 
     // The current time, in milliseconds since 0:00 GMT, 1/1/70.
     timeval now;
@@ -636,19 +815,20 @@ class Hprof {
 
     // U4: high word of the 64-bit time.
     U4_TO_BUF_BE(buf, 0, (uint32_t)(nowMs >> 32));
-    fwrite(buf, 1, sizeof(uint32_t), header_fp_);
+    output_->Write(buf, sizeof(uint32_t));
 
     // U4: low word of the 64-bit time.
     U4_TO_BUF_BE(buf, 0, (uint32_t)(nowMs & 0xffffffffULL));
-    fwrite(buf, 1, sizeof(uint32_t), header_fp_);  // xxx fix the time
+    output_->Write(buf, sizeof(uint32_t));  // xxx fix the time
   }
 
   void WriteStackTraces() {
     // Write a dummy stack trace record so the analysis tools don't freak out.
-    current_record_.StartNewRecord(header_fp_, HPROF_TAG_STACK_TRACE, HPROF_TIME);
+    current_record_.StartNewRecord(output_, HPROF_TAG_STACK_TRACE, HPROF_TIME);
     current_record_.AddU4(HPROF_NULL_STACK_TRACE);
     current_record_.AddU4(HPROF_NULL_THREAD);
     current_record_.AddU4(0);    // no frames
+    current_record_.Flush();
   }
 
   // If direct_to_ddms_ is set, "filename_" and "fd" will be ignored.
@@ -667,13 +847,9 @@ class Hprof {
   HprofHeapId current_heap_;  // Which heap we're currently dumping.
   size_t objects_in_segment_;
 
-  FILE* header_fp_;
-  char* header_data_ptr_;
-  size_t header_data_size_;
-
-  FILE* body_fp_;
-  char* body_data_ptr_;
-  size_t body_data_size_;
+  // Where the records go: nowhere on the first walk, the file or the DDMS
+  // buffer on the second.
+  HprofOutput* output_;
 
   ClassSet classes_;
   size_t next_string_id_;
@@ -16,6 +16,8 @@
 
 #include "intern_table.h"
 
+#include <algorithm>
+
 #include "gc_profiler/MProfiler.h"
 #include "gc/space/image_space.h"
 #include "mirror/dex_cache.h"
@@ -25,68 +27,169 @@
 #include "thread.h"
 #include "UniquePtr.h"
 #include "utf.h"
+#include "utils.h"
 
 namespace art {
 
-InternTable::InternTable()
-    : intern_table_lock_("InternTable lock"), is_dirty_(false), allow_new_interns_(true),
-      new_intern_condition_("New intern condition", intern_table_lock_) {
+InternTable::StringSet::StringSet() : size_(0), used_(0) {
 }
 
-size_t InternTable::Size() const {
-  MutexLock mu(Thread::Current(), intern_table_lock_);
-  return strong_interns_.size() + weak_interns_.size();
+mirror::String* InternTable::StringSet::Lookup(mirror::String* s, uint32_t hash_code) const {
+  if (size_ == 0) {
+    return NULL;
+  }
+  const size_t mask = slots_.size() - 1;
+  for (size_t i = MixHash(hash_code) & mask; slots_[i].string_ != NULL; i = (i + 1) & mask) {
+    const Slot& slot = slots_[i];
+    if (slot.hash_code_ == hash_code && slot.string_ != Tombstone() &&
+        slot.string_->Equals(s)) {
+      return slot.string_;
+    }
+  }
+  return NULL;
 }
 
-void InternTable::DumpForSigQuit(std::ostream& os) const {
-  MutexLock mu(Thread::Current(), intern_table_lock_);
-  os << "Intern table: " << strong_interns_.size() << " strong; "
-     << weak_interns_.size() << " weak\n";
+void InternTable::StringSet::Insert(mirror::String* s, uint32_t hash_code) {
+  // Keep the load, tombstones included, under 3/4.
+  if ((used_ + 1) * 4 > slots_.size() * 3) {
+    size_t capacity = std::max(slots_.size(), kMinCapacity);
+    while ((size_ + 1) * 2 > capacity) {
+      capacity *= 2;
+    }
+    Resize(capacity);
+  }
+  const size_t mask = slots_.size() - 1;
+  size_t i = MixHash(hash_code) & mask;
+  while (IsLive(slots_[i])) {
+    i = (i + 1) & mask;
+  }
+  if (slots_[i].string_ == NULL) {
+    used_++;
+  }
+  slots_[i].string_ = s;
+  slots_[i].hash_code_ = hash_code;
+  size_++;
 }
 
-void InternTable::VisitRoots(RootVisitor* visitor, void* arg,
-                             bool only_dirty, bool clean_dirty) {
-  MutexLock mu(Thread::Current(), intern_table_lock_);
-  if (!only_dirty || is_dirty_) {
-    for (const auto& strong_intern : strong_interns_) {
-      visitor(strong_intern.second, arg);
+void InternTable::StringSet::Remove(const mirror::String* s, uint32_t hash_code) {
+  if (size_ == 0) {
+    return;
+  }
+  const size_t mask = slots_.size() - 1;
+  for (size_t i = MixHash(hash_code) & mask; slots_[i].string_ != NULL; i = (i + 1) & mask) {
+    if (slots_[i].string_ == s) {
+      slots_[i].string_ = Tombstone();
+      size_--;
+      return;
     }
-    if (clean_dirty) {
-      is_dirty_ = false;
+  }
+}
+
+void InternTable::StringSet::VisitRoots(RootVisitor* visitor, void* arg) const {
+  for (size_t i = 0; i < slots_.size(); i++) {
+    if (IsLive(slots_[i])) {
+      visitor(slots_[i].string_, arg);
     }
   }
-  // Note: we deliberately don't visit the weak_interns_ table and the immutable
-  // image roots.
 }
 
-mirror::String* InternTable::Lookup(Table& table, mirror::String* s,
-                                    uint32_t hash_code) {
-  intern_table_lock_.AssertHeld(Thread::Current());
-  for (auto it = table.find(hash_code), end = table.end(); it != end; ++it) {
-    mirror::String* existing_string = it->second;
-    if (existing_string->Equals(s)) {
-      return existing_string;
+void InternTable::StringSet::Sweep(IsMarkedTester is_marked, void* arg) {
+  bool swept = false;
+  for (size_t i = 0; i < slots_.size(); i++) {
+    Slot& slot = slots_[i];
+    if (IsLive(slot) && !is_marked(slot.string_, arg)) {
+      slot.string_ = Tombstone();
+      size_--;
+      swept = true;
     }
   }
-  return NULL;
+  if (swept || used_ != size_) {
+    // Rehash in place of leaving the tombstones on the probe sequences.
+    size_t capacity = kMinCapacity;
+    while (size_ * 2 > capacity) {
+      capacity *= 2;
+    }
+    Resize(capacity);
+  }
 }
 
-mirror::String* InternTable::Insert(Table& table, mirror::String* s,
-                                    uint32_t hash_code) {
-  intern_table_lock_.AssertHeld(Thread::Current());
-  table.insert(std::make_pair(hash_code, s));
-  return s;
+void InternTable::StringSet::Resize(size_t capacity) {
+  DCHECK(IsPowerOfTwo(capacity));
+  std::vector<Slot> old_slots(capacity);
+  old_slots.swap(slots_);
+  for (size_t i = 0; i < slots_.size(); i++) {
+    slots_[i].string_ = NULL;
+    slots_[i].hash_code_ = 0;
+  }
+  const size_t mask = capacity - 1;
+  for (size_t j = 0; j < old_slots.size(); j++) {
+    if (!IsLive(old_slots[j])) {
+      continue;
+    }
+    size_t i = MixHash(old_slots[j].hash_code_) & mask;
+    while (slots_[i].string_ != NULL) {
+      i = (i + 1) & mask;
+    }
+    slots_[i] = old_slots[j];
+  }
+  used_ = size_;
 }
 
-void InternTable::Remove(Table& table, const mirror::String* s,
-                         uint32_t hash_code) {
-  intern_table_lock_.AssertHeld(Thread::Current());
-  for (auto it = table.find(hash_code), end = table.end(); it != end; ++it) {
-    if (it->second == s) {
-      table.erase(it);
-      return;
+InternTable::Stripe::Stripe()
+    : lock_("InternTable lock"), is_dirty_(false), allow_new_interns_(true),
+      new_intern_condition_("New intern condition", lock_) {
+}
+
+InternTable::InternTable() {
+  for (size_t i = 0; i < kStripesCount; i++) {
+    stripes_[i] = new Stripe();
+  }
+}
+
+InternTable::~InternTable() {
+  for (size_t i = 0; i < kStripesCount; i++) {
+    delete stripes_[i];
+  }
+}
+
+size_t InternTable::Size() const {
+  Thread* self = Thread::Current();
+  size_t size = 0;
+  for (size_t i = 0; i < kStripesCount; i++) {
+    MutexLock mu(self, stripes_[i]->lock_);
+    size += stripes_[i]->strong_interns_.Size() + stripes_[i]->weak_interns_.Size();
+  }
+  return size;
+}
+
+void InternTable::DumpForSigQuit(std::ostream& os) const {
+  Thread* self = Thread::Current();
+  size_t strong = 0;
+  size_t weak = 0;
+  for (size_t i = 0; i < kStripesCount; i++) {
+    MutexLock mu(self, stripes_[i]->lock_);
+    strong += stripes_[i]->strong_interns_.Size();
+    weak += stripes_[i]->weak_interns_.Size();
+  }
+  os << "Intern table: " << strong << " strong; " << weak << " weak\n";
+}
+
+void InternTable::VisitRoots(RootVisitor* visitor, void* arg,
+                             bool only_dirty, bool clean_dirty) {
+  Thread* self = Thread::Current();
+  for (size_t i = 0; i < kStripesCount; i++) {
+    Stripe* stripe = stripes_[i];
+    MutexLock mu(self, stripe->lock_);
+    // Stripes are dirtied independently: a clean stripe has no new roots.
+    if (!only_dirty || stripe->is_dirty_) {
+      stripe->strong_interns_.VisitRoots(visitor, arg);
+      if (clean_dirty) {
+        stripe->is_dirty_ = false;
+      }
     }
   }
+  // Note: we deliberately don't visit the weak_interns_ table and the immutable
+  // image roots.
 }
 
 static mirror::String* LookupStringFromImage(mirror::String* s)
@@ -116,75 +219,88 @@ static mirror::String* LookupStringFromImage(mirror::String* s)
 
 void InternTable::AllowNewInterns() {
   Thread* self = Thread::Current();
-  MutexLock mu(self, intern_table_lock_);
-  allow_new_interns_ = true;
-  new_intern_condition_.Broadcast(self);
+  for (size_t i = 0; i < kStripesCount; i++) {
+    MutexLock mu(self, stripes_[i]->lock_);
+    stripes_[i]->allow_new_interns_ = true;
+    stripes_[i]->new_intern_condition_.Broadcast(self);
+  }
 }
 
 void InternTable::DisallowNewInterns() {
   Thread* self = Thread::Current();
-  MutexLock mu(self, intern_table_lock_);
-  allow_new_interns_ = false;
+  for (size_t i = 0; i < kStripesCount; i++) {
+    MutexLock mu(self, stripes_[i]->lock_);
+    stripes_[i]->allow_new_interns_ = false;
+  }
 }
 
 
 mirror::String* InternTable::Insert(mirror::String* s, bool is_strong) {
-  Thread* self = Thread::Current();
-  MutexLock mu(self, intern_table_lock_);
-
   DCHECK(s != NULL);
   uint32_t hash_code = s->GetHashCode();
 
-  while (UNLIKELY(!allow_new_interns_)) {
-    new_intern_condition_.WaitHoldingLocks(self);
+  Thread* self = Thread::Current();
+  Stripe* stripe = StripeOf(hash_code);
+  MutexLock mu(self, stripe->lock_);
+
+  while (UNLIKELY(!stripe->allow_new_interns_)) {
+    stripe->new_intern_condition_.WaitHoldingLocks(self);
   }
 
+  StringSet& strong_interns = stripe->strong_interns_;
+  StringSet& weak_interns = stripe->weak_interns_;
+
   if (is_strong) {
     // Check the strong table for a match.
-    mirror::String* strong = Lookup(strong_interns_, s, hash_code);
+    mirror::String* strong = strong_interns.Lookup(s, hash_code);
     if (strong != NULL) {
       return strong;
     }
 
     // Mark as dirty so that we rescan the roots.
-    is_dirty_ = true;
+    stripe->is_dirty_ = true;
 
     // Check the image for a match.
     mirror::String* image = LookupStringFromImage(s);
     if (image != NULL) {
-      return Insert(strong_interns_, image, hash_code);
+      strong_interns.Insert(image, hash_code);
+      return image;
     }
 
     // There is no match in the strong table, check the weak table.
-    mirror::String* weak = Lookup(weak_interns_, s, hash_code);
+    mirror::String* weak = weak_interns.Lookup(s, hash_code);
     if (weak != NULL) {
       // A match was found in the weak table. Promote to the strong table.
-      Remove(weak_interns_, weak, hash_code);
-      return Insert(strong_interns_, weak, hash_code);
+      weak_interns.Remove(weak, hash_code);
+      strong_interns.Insert(weak, hash_code);
+      return weak;
     }
 
     // No match in the strong table or the weak table. Insert into the strong
     // table.
-    return Insert(strong_interns_, s, hash_code);
+    strong_interns.Insert(s, hash_code);
+    return s;
   }
 
   // Check the strong table for a match.
-  mirror::String* strong = Lookup(strong_interns_, s, hash_code);
+  mirror::String* strong = strong_interns.Lookup(s, hash_code);
   if (strong != NULL) {
     return strong;
   }
   // Check the image for a match.
   mirror::String* image = LookupStringFromImage(s);
   if (image != NULL) {
-    return Insert(weak_interns_, image, hash_code);
+    weak_interns.Insert(image, hash_code);
+    return image;
   }
   // Check the weak table for a match.
-  mirror::String* weak = Lookup(weak_interns_, s, hash_code);
+  mirror::String* weak = weak_interns.Lookup(s, hash_code);
   if (weak != NULL) {
     return weak;
   }
   // Insert into the weak table.
-  return Insert(weak_interns_, s, hash_code);
+  weak_interns.Insert(s, hash_code);
+  return s;
 }
 
 
@@ -237,21 +353,18 @@ mirror::String* InternTable::InternWeak(mirror::String* s) {
 }
 
 bool InternTable::ContainsWeak(mirror::String* s) {
-  MutexLock mu(Thread::Current(), intern_table_lock_);
-  const mirror::String* found = Lookup(weak_interns_, s, s->GetHashCode());
+  uint32_t hash_code = s->GetHashCode();
+  Stripe* stripe = StripeOf(hash_code);
+  MutexLock mu(Thread::Current(), stripe->lock_);
+  const mirror::String* found = stripe->weak_interns_.Lookup(s, hash_code);
   return found == s;
 }
 
 void InternTable::SweepInternTableWeaks(IsMarkedTester is_marked, void* arg) {
-  MutexLock mu(Thread::Current(), intern_table_lock_);
-  // TODO: std::remove_if + lambda.
-  for (auto it = weak_interns_.begin(), end = weak_interns_.end(); it != end;) {
-    mirror::Object* object = it->second;
-    if (!is_marked(object, arg)) {
-      weak_interns_.erase(it++);
-    } else {
-      ++it;
-    }
+  Thread* self = Thread::Current();
+  for (size_t i = 0; i < kStripesCount; i++) {
+    MutexLock mu(self, stripes_[i]->lock_);
+    stripes_[i]->weak_interns_.Sweep(is_marked, arg);
   }
 }
 
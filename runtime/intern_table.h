@@ -21,6 +21,7 @@
 #include "root_visitor.h"
 #include "gc_profiler/MProfilerTypes.h"
 #include <map>
+#include <vector>
 
 namespace art {
 namespace mirror {
@@ -36,10 +37,16 @@ class String;
  * String.intern. Some code (XML parsers being a prime example) relies on being able to intern
  * arbitrarily many strings for the duration of a parse without permanently increasing the memory
  * footprint.
+ *
+ * Strings are spread over kStripesCount stripes by their hash code. A stripe
+ * owns its lock and the strong and weak sets of the strings hashing to it, so
+ * interns of unrelated strings proceed in parallel while the lookup, the
+ * image check and the weak to strong promotion of one string stay atomic.
  */
 class InternTable {
  public:
   InternTable();
+  ~InternTable();
 
   // Interns a potentially new string in the 'strong' table. (See above.)
   mirror::String* InternStrong(int32_t utf16_length, const char* utf8_data)
@@ -73,24 +80,82 @@ class InternTable {
   typedef std::multimap<uint64_t, mprofiler::GCPHistRecData*> ClassTable;
   ClassTable classTableProf_;
  private:
-  typedef std::multimap<int32_t, mirror::String*> Table;
-
+  static const size_t kStripesBits = 4;
+  static const size_t kStripesCount = 1 << kStripesBits;
+
+  // Open addressing set of strings keyed by their hash code, with linear
+  // probing. Removed entries leave a tombstone until the next resize.
+  class StringSet {
+   public:
+    StringSet();
+
+    mirror::String* Lookup(mirror::String* s, uint32_t hash_code) const
+        SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+    void Insert(mirror::String* s, uint32_t hash_code);
+    void Remove(const mirror::String* s, uint32_t hash_code);
+    void VisitRoots(RootVisitor* visitor, void* arg) const;
+    // Drops the unmarked strings and the tombstones.
+    void Sweep(IsMarkedTester is_marked, void* arg);
+
+    size_t Size() const {
+      return size_;
+    }
+
+   private:
+    struct Slot {
+      mirror::String* string_;
+      uint32_t hash_code_;
+    };
+
+    static const size_t kMinCapacity = 64;
+
+    static mirror::String* Tombstone() {
+      return reinterpret_cast<mirror::String*>(1);
+    }
+
+    static bool IsLive(const Slot& slot) {
+      return slot.string_ != NULL && slot.string_ != Tombstone();
+    }
+
+    void Resize(size_t capacity);
+
+    std::vector<Slot> slots_;
+    // Live strings, and live strings plus tombstones.
+    size_t size_;
+    size_t used_;
+  };
+
+  class Stripe {
+   public:
+    Stripe();
+
+    Mutex lock_;
+    bool is_dirty_ GUARDED_BY(lock_);
+    bool allow_new_interns_ GUARDED_BY(lock_);
+    ConditionVariable new_intern_condition_ GUARDED_BY(lock_);
+    StringSet strong_interns_ GUARDED_BY(lock_);
+    StringSet weak_interns_ GUARDED_BY(lock_);
+
+   private:
+    DISALLOW_COPY_AND_ASSIGN(Stripe);
+  };
+
+  // Spreads the Java hash codes, whose low bits are poor for short strings.
+  static uint32_t MixHash(uint32_t hash_code) {
+    uint32_t mixed = hash_code * 0x9E3779B1U;
+    return mixed ^ (mixed >> 16);
+  }
+
+  Stripe* StripeOf(uint32_t hash_code) const {
+    return stripes_[MixHash(hash_code) >> (32 - kStripesBits)];
+  }
 
   mirror::String* Insert(mirror::String* s, bool is_strong)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
-  mirror::String* Lookup(Table& table, mirror::String* s, uint32_t hash_code)
-      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
-  mirror::String* Insert(Table& table, mirror::String* s, uint32_t hash_code);
-  void Remove(Table& table, const mirror::String* s, uint32_t hash_code);
-
-  mutable Mutex intern_table_lock_;
-  bool is_dirty_ GUARDED_BY(intern_table_lock_);
-  bool allow_new_interns_ GUARDED_BY(intern_table_lock_);
-  ConditionVariable new_intern_condition_ GUARDED_BY(intern_table_lock_);
-  Table strong_interns_ GUARDED_BY(intern_table_lock_);
-  Table weak_interns_ GUARDED_BY(intern_table_lock_);
+  Stripe* stripes_[kStripesCount];
 
+  DISALLOW_COPY_AND_ASSIGN(InternTable);
 };
 
 }  // namespace art
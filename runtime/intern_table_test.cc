@@ -17,8 +17,10 @@
 #include "intern_table.h"
 
 #include "common_test.h"
+#include "dex_file.h"
 #include "mirror/object.h"
 #include "sirt_ref.h"
+#include "thread_pool.h"
 
 namespace art {
 
@@ -167,4 +169,67 @@ TEST_F(InternTableTest, ContainsWeak) {
   }
 }
 
+// Interns the strings of a dex file, starting at a different string for each
+// task so that the tasks race on the same strings.
+class InternDexStringsTask : public Task {
+ public:
+  InternDexStringsTask(InternTable* intern_table, const DexFile* dex_file, size_t first,
+                       std::vector<mirror::String*>* interned)
+      : intern_table_(intern_table), dex_file_(dex_file), first_(first), interned_(interned) {}
+
+  void Run(Thread* self) {
+    ScopedObjectAccess soa(self);
+    const size_t count = dex_file_->NumStringIds();
+    interned_->resize(count);
+    for (size_t i = 0; i < count; ++i) {
+      size_t idx = (first_ + i) % count;
+      uint32_t utf16_length;
+      const char* utf8_data = dex_file_->StringDataAndLengthByIdx(idx, &utf16_length);
+      (*interned_)[idx] = intern_table_->InternStrong(utf16_length, utf8_data);
+    }
+  }
+
+  void Finalize() {
+    delete this;
+  }
+
+ private:
+  InternTable* const intern_table_;
+  const DexFile* const dex_file_;
+  const size_t first_;
+  std::vector<mirror::String*>* const interned_;
+};
+
+// Interns the strings of core.jar from several threads. The strings go to the
+// runtime intern table, whose strong interns are GC roots.
+TEST_F(InternTableTest, InternDexStringsBenchmark) {
+  Thread* self = Thread::Current();
+  const DexFile* dex_file = java_lang_dex_file_;
+  const size_t count = dex_file->NumStringIds();
+  InternTable* intern_table = Runtime::Current()->GetInternTable();
+  static const size_t kThreadsCount[] = { 1, 4 };
+  for (size_t t = 0; t < arraysize(kThreadsCount); ++t) {
+    const size_t threads = kThreadsCount[t];
+    std::vector<std::vector<mirror::String*> > interned(threads);
+    ThreadPool thread_pool(threads - 1);
+    for (size_t i = 0; i < threads; ++i) {
+      thread_pool.AddTask(self, new InternDexStringsTask(intern_table, dex_file,
+                                                         i * count / threads, &interned[i]));
+    }
+    uint64_t start = NanoTime();
+    thread_pool.StartWorkers(self);
+    thread_pool.Wait(self, true, false);
+    uint64_t intern_ns = NanoTime() - start;
+    LOG(INFO) << "Interned " << count << " dex strings from " << threads << " threads in "
+              << PrettyDuration(intern_ns) << ", " << intern_table->Size() << " interns";
+    // Every thread got the same string for each index.
+    for (size_t i = 1; i < threads; ++i) {
+      ASSERT_EQ(count, interned[i].size());
+      for (size_t idx = 0; idx < count; ++idx) {
+        ASSERT_EQ(interned[0][idx], interned[i][idx]);
+      }
+    }
+  }
+}
+
 }  // namespace art
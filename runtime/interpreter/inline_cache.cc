@@ -0,0 +1,244 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+
+#include <algorithm>
+#include <ostream>
+#include <vector>
+
+#include "inline_cache.h"
+#include "cutils/atomic-inline.h"
+#include "dex_file.h"
+#include "dex_instruction-inl.h"
+#include "mirror/art_method-inl.h"
+#include "object_utils.h"
+#include "thread.h"
+#include "utils.h"
+
+namespace art {
+namespace interpreter {
+
+const size_t InlineCache::kEntries;
+const size_t InlineCacheTable::kMinCapacity;
+
+// Megamorphic sites listed by DumpForSigQuit.
+static const size_t kDumpedSitesCount = 16;
+
+static bool IsCachedInvoke(const Instruction* inst) {
+  switch (inst->Opcode()) {
+    case Instruction::INVOKE_VIRTUAL:
+    case Instruction::INVOKE_VIRTUAL_RANGE:
+    case Instruction::INVOKE_INTERFACE:
+    case Instruction::INVOKE_INTERFACE_RANGE:
+      return true;
+    default:
+      return false;
+  }
+}
+
+
+InlineCacheTable::InlineCacheTable()
+    : lock_("interpreter inline caches lock"), slots_(AllocSlots(kMinCapacity)), size_(0) {
+}
+
+
+InlineCacheTable::~InlineCacheTable() {
+  Slots* slots = slots_;
+  for (size_t i = 0; i <= slots->mask_; i++) {
+    free(slots->slots_[i]);
+  }
+  while (slots != NULL) {
+    Slots* retired = slots->retired_;
+    free(slots);
+    slots = retired;
+  }
+}
+
+
+InlineCacheTable::Slots* InlineCacheTable::AllocSlots(size_t capacity) {
+  DCHECK(IsPowerOfTwo(capacity));
+  Slots* slots = reinterpret_cast<Slots*>(calloc(1, sizeof(Slots) +
+                                                 capacity * sizeof(MethodCaches*)));
+  CHECK(slots != NULL) << "InlineCacheTable: cannot allocate " << capacity << " slots";
+  slots->mask_ = capacity - 1;
+  return slots;
+}
+
+
+InlineCacheTable::MethodCaches* InlineCacheTable::CreateMethodCaches(
+    Thread* self, const mirror::ArtMethod* method) {
+  MutexLock mu(self, lock_);
+  MethodCaches* caches = FindMethodCaches(method);
+  if (caches != NULL) {
+    return caches;
+  }
+  const DexFile::CodeItem* code_item = MethodHelper(method).GetCodeItem();
+  const uint16_t* const insns = code_item->insns_;
+  size_t count = 0;
+  for (uint32_t dex_pc = 0; dex_pc < code_item->insns_size_in_code_units_; ) {
+    const Instruction* inst = Instruction::At(insns + dex_pc);
+    if (IsCachedInvoke(inst)) {
+      count++;
+    }
+    dex_pc += inst->SizeInCodeUnits();
+  }
+  caches = reinterpret_cast<MethodCaches*>(calloc(1, sizeof(MethodCaches) +
+                                                  count * sizeof(InlineCache)));
+  CHECK(caches != NULL) << "InlineCacheTable: cannot allocate " << count << " caches";
+  caches->method_ = method;
+  caches->count_ = count;
+  size_t index = 0;
+  for (uint32_t dex_pc = 0; dex_pc < code_item->insns_size_in_code_units_; ) {
+    const Instruction* inst = Instruction::At(insns + dex_pc);
+    if (IsCachedInvoke(inst)) {
+      caches->caches_[index++].dex_pc_ = dex_pc;
+    }
+    dex_pc += inst->SizeInCodeUnits();
+  }
+  Insert(caches);
+  return caches;
+}
+
+
+void InlineCacheTable::Insert(MethodCaches* caches) {
+  // Keep the load under 1/2, there are no removals.
+  if ((size_ + 1) * 2 > slots_->mask_ + 1) {
+    Slots* old_slots = slots_;
+    Slots* new_slots = AllocSlots((old_slots->mask_ + 1) * 2);
+    for (size_t j = 0; j <= old_slots->mask_; j++) {
+      MethodCaches* moved = old_slots->slots_[j];
+      if (moved == NULL) {
+        continue;
+      }
+      size_t i = SlotOf(moved->method_, new_slots->mask_);
+      while (new_slots->slots_[i] != NULL) {
+        i = (i + 1) & new_slots->mask_;
+      }
+      new_slots->slots_[i] = moved;
+    }
+    // Readers may still walk the old array.
+    new_slots->retired_ = old_slots;
+    ANDROID_MEMBAR_STORE();
+    slots_ = new_slots;
+  }
+  Slots* slots = slots_;
+  size_t i = SlotOf(caches->method_, slots->mask_);
+  while (slots->slots_[i] != NULL) {
+    i = (i + 1) & slots->mask_;
+  }
+  // Publish the caches before the slot.
+  ANDROID_MEMBAR_STORE();
+  slots->slots_[i] = caches;
+  size_++;
+}
+
+
+void InlineCacheTable::Update(Thread* self, InlineCache* cache, mirror::Class* klass,
+                              mirror::ArtMethod* method) {
+  MutexLock mu(self, lock_);
+  for (size_t i = 0; i < InlineCache::kEntries; i++) {
+    InlineCache::Entry& entry = cache->entries_[i];
+    if (entry.klass_ == klass) {
+      // Another thread recorded it first.
+      return;
+    }
+    if (entry.klass_ == NULL) {
+      entry.method_ = method;
+      ANDROID_MEMBAR_STORE();
+      entry.klass_ = klass;
+      return;
+    }
+  }
+  cache->megamorphic_ = true;
+}
+
+
+void InlineCacheTable::GetStats(Thread* self, size_t* sites, uint64_t* hits, uint64_t* misses,
+                                size_t* megamorphic_sites) {
+  MutexLock mu(self, lock_);
+  *sites = 0;
+  *hits = 0;
+  *misses = 0;
+  *megamorphic_sites = 0;
+  const Slots* slots = slots_;
+  for (size_t j = 0; j <= slots->mask_; j++) {
+    const MethodCaches* caches = slots->slots_[j];
+    if (caches == NULL) {
+      continue;
+    }
+    for (size_t i = 0; i < caches->count_; i++) {
+      const InlineCache& cache = caches->caches_[i];
+      *sites += 1;
+      *hits += cache.hits_;
+      *misses += cache.misses_;
+      if (cache.megamorphic_) {
+        *megamorphic_sites += 1;
+      }
+    }
+  }
+}
+
+
+typedef std::pair<const mirror::ArtMethod*, const InlineCache*> CallSite;
+
+static bool MissesMore(const CallSite& a, const CallSite& b) {
+  return a.second->GetMisses() > b.second->GetMisses();
+}
+
+
+void InlineCacheTable::DumpForSigQuit(std::ostream& os) {
+  Thread* self = Thread::Current();
+  size_t sites;
+  uint64_t hits;
+  uint64_t misses;
+  size_t megamorphic_sites;
+  GetStats(self, &sites, &hits, &misses, &megamorphic_sites);
+  os << "Interpreter inline caches: " << sites << " call sites; " << hits << " hits; "
+     << misses << " misses; " << megamorphic_sites << " megamorphic\n";
+  if (megamorphic_sites == 0) {
+    return;
+  }
+  std::vector<CallSite> megamorphic;
+  {
+    MutexLock mu(self, lock_);
+    const Slots* slots = slots_;
+    for (size_t j = 0; j <= slots->mask_; j++) {
+      const MethodCaches* caches = slots->slots_[j];
+      if (caches == NULL) {
+        continue;
+      }
+      for (size_t i = 0; i < caches->count_; i++) {
+        if (caches->caches_[i].megamorphic_) {
+          megamorphic.push_back(std::make_pair(caches->method_, &caches->caches_[i]));
+        }
+      }
+    }
+  }
+  // The caches are never freed while the table lives.
+  size_t dumped = std::min(megamorphic.size(), kDumpedSitesCount);
+  std::partial_sort(megamorphic.begin(), megamorphic.begin() + dumped, megamorphic.end(),
+                    MissesMore);
+  for (size_t i = 0; i < dumped; i++) {
+    const InlineCache* cache = megamorphic[i].second;
+    os << "  " << PrettyMethod(megamorphic[i].first)
+       << StringPrintf(" @0x%04x: ", cache->GetDexPc())
+       << cache->GetHits() << " hits; " << cache->GetMisses() << " misses\n";
+  }
+}
+
+}  // namespace interpreter
+}  // namespace art
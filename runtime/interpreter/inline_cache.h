@@ -0,0 +1,217 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_RUNTIME_INTERPRETER_INLINE_CACHE_H_
+#define ART_RUNTIME_INTERPRETER_INLINE_CACHE_H_
+
+#include <stdint.h>
+
+#include <iosfwd>
+
+#include "base/macros.h"
+#include "base/mutex.h"
+
+namespace art {
+namespace mirror {
+  class ArtMethod;
+  class Class;
+}  // namespace mirror
+class Thread;
+
+namespace interpreter {
+
+/*
+ * Receiver class to target method cache of one invoke-virtual or
+ * invoke-interface call site of the interpreter. The site is monomorphic or
+ * polymorphic while it has seen up to kEntries receiver classes and
+ * megamorphic after that, when the classes it misses on go to full
+ * resolution.
+ * An entry is written once under the InlineCacheTable lock: the method is
+ * published before the class, and a reader that sees the class before the
+ * method treats the entry as a miss. Classes and methods are neither moved
+ * nor unloaded by this runtime, so the entries need no root visiting.
+ * The hit and miss counters are not atomic and only meant for statistics.
+ */
+class InlineCache {
+ public:
+  static const size_t kEntries = 4;
+
+  mirror::ArtMethod* Lookup(const mirror::Class* klass) {
+    for (size_t i = 0; i < kEntries; i++) {
+      const mirror::Class* cached = entries_[i].klass_;
+      if (cached == klass) {
+        mirror::ArtMethod* method = entries_[i].method_;
+        if (LIKELY(method != NULL)) {
+          hits_++;
+          return method;
+        }
+        break;
+      }
+      if (cached == NULL) {
+        break;
+      }
+    }
+    misses_++;
+    return NULL;
+  }
+
+  uint32_t GetDexPc() const {
+    return dex_pc_;
+  }
+
+  uint32_t GetHits() const {
+    return hits_;
+  }
+
+  uint32_t GetMisses() const {
+    return misses_;
+  }
+
+  bool IsMegamorphic() const {
+    return megamorphic_;
+  }
+
+ private:
+  struct Entry {
+    mirror::Class* volatile klass_;
+    mirror::ArtMethod* volatile method_;
+  };
+
+  Entry entries_[kEntries];
+  uint32_t dex_pc_;
+  uint32_t hits_;
+  uint32_t misses_;
+  bool megamorphic_;
+
+  friend class InlineCacheTable;
+};
+
+/*
+ * Inline caches of the interpreter, kept aside of the ArtMethods since the
+ * managed layout of ArtMethod is fixed by its Java peer. The caches of a
+ * method are created for all its virtual and interface invokes the first
+ * time one of them runs, and are sorted by dex pc. The same entry holds the
+ * hotness counter of the method, making it the interpreter profile of the
+ * method.
+ * The methods are found in an open addressing table keyed by the method
+ * pointer. Like ClassTable, readers take no lock and the arrays replaced on
+ * resize are only freed with the table; writers hold lock_.
+ */
+class InlineCacheTable {
+ public:
+  InlineCacheTable();
+  ~InlineCacheTable();
+
+  // Cache of the invoke at dex_pc of method, NULL if there is no cached
+  // invoke there.
+  InlineCache* Lookup(Thread* self, const mirror::ArtMethod* method, uint32_t dex_pc)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+    MethodCaches* caches = FindMethodCaches(method);
+    if (UNLIKELY(caches == NULL)) {
+      caches = CreateMethodCaches(self, method);
+    }
+    return caches->Find(dex_pc);
+  }
+
+  // Invocation and backward branch counter of method for the tiered
+  // compiler. Like the hit and miss counters it is updated without atomics.
+  uint32_t* GetHotnessCounter(Thread* self, const mirror::ArtMethod* method)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+    MethodCaches* caches = FindMethodCaches(method);
+    if (UNLIKELY(caches == NULL)) {
+      caches = CreateMethodCaches(self, method);
+    }
+    return &caches->hotness_;
+  }
+
+  // Records the target of a miss; a full cache becomes megamorphic.
+  void Update(Thread* self, InlineCache* cache, mirror::Class* klass, mirror::ArtMethod* method)
+      LOCKS_EXCLUDED(lock_);
+
+  void GetStats(Thread* self, size_t* sites, uint64_t* hits, uint64_t* misses,
+                size_t* megamorphic_sites) LOCKS_EXCLUDED(lock_);
+
+  // Totals and the megamorphic sites that missed the most.
+  void DumpForSigQuit(std::ostream& os) LOCKS_EXCLUDED(lock_);
+
+ private:
+  struct MethodCaches {
+    const mirror::ArtMethod* method_;
+    uint32_t hotness_;
+    size_t count_;
+    InlineCache caches_[0];
+
+    InlineCache* Find(uint32_t dex_pc) {
+      size_t low = 0;
+      size_t high = count_;
+      while (low < high) {
+        size_t mid = (low + high) / 2;
+        if (caches_[mid].dex_pc_ < dex_pc) {
+          low = mid + 1;
+        } else {
+          high = mid;
+        }
+      }
+      if (low < count_ && caches_[low].dex_pc_ == dex_pc) {
+        return &caches_[low];
+      }
+      return NULL;
+    }
+  };
+
+  struct Slots {
+    size_t mask_;
+    Slots* retired_;
+    MethodCaches* volatile slots_[0];
+  };
+
+  static const size_t kMinCapacity = 256;
+
+  static size_t SlotOf(const mirror::ArtMethod* method, size_t mask) {
+    uint32_t mixed = static_cast<uint32_t>(reinterpret_cast<uintptr_t>(method) >> 3) *
+        0x9E3779B1U;
+    return (mixed ^ (mixed >> 16)) & mask;
+  }
+
+  static Slots* AllocSlots(size_t capacity);
+
+  MethodCaches* FindMethodCaches(const mirror::ArtMethod* method) const {
+    const Slots* slots = slots_;
+    const size_t mask = slots->mask_;
+    for (size_t i = SlotOf(method, mask); ; i = (i + 1) & mask) {
+      MethodCaches* caches = slots->slots_[i];
+      if (caches == NULL || caches->method_ == method) {
+        return caches;
+      }
+    }
+  }
+
+  MethodCaches* CreateMethodCaches(Thread* self, const mirror::ArtMethod* method)
+      LOCKS_EXCLUDED(lock_) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  void Insert(MethodCaches* caches) EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  Mutex lock_;
+  Slots* volatile slots_;
+  size_t size_ GUARDED_BY(lock_);
+
+  DISALLOW_COPY_AND_ASSIGN(InlineCacheTable);
+};
+
+}  // namespace interpreter
+}  // namespace art
+
+#endif  // ART_RUNTIME_INTERPRETER_INLINE_CACHE_H_
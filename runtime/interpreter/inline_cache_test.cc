@@ -0,0 +1,137 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "interpreter/inline_cache.h"
+
+#include <vector>
+
+#include "common_test.h"
+#include "dex_instruction.h"
+#include "mirror/art_method-inl.h"
+#include "mirror/class-inl.h"
+#include "object_utils.h"
+
+namespace art {
+namespace interpreter {
+
+class InlineCacheTest : public CommonTest {};
+
+TEST_F(InlineCacheTest, CallSites) {
+  ScopedObjectAccess soa(Thread::Current());
+  mirror::Class* object_class = class_linker_->FindSystemClass("Ljava/lang/Object;");
+  ASSERT_TRUE(object_class != NULL);
+  mirror::ArtMethod* to_string = object_class->FindVirtualMethod("toString",
+                                                                 "()Ljava/lang/String;");
+  ASSERT_TRUE(to_string != NULL);
+  const DexFile::CodeItem* code_item = MethodHelper(to_string).GetCodeItem();
+  ASSERT_TRUE(code_item != NULL);
+
+  std::vector<uint32_t> invoke_pcs;
+  std::vector<uint32_t> other_pcs;
+  for (uint32_t dex_pc = 0; dex_pc < code_item->insns_size_in_code_units_; ) {
+    const Instruction* inst = Instruction::At(code_item->insns_ + dex_pc);
+    if (inst->Opcode() == Instruction::INVOKE_VIRTUAL ||
+        inst->Opcode() == Instruction::INVOKE_VIRTUAL_RANGE ||
+        inst->Opcode() == Instruction::INVOKE_INTERFACE ||
+        inst->Opcode() == Instruction::INVOKE_INTERFACE_RANGE) {
+      invoke_pcs.push_back(dex_pc);
+    } else {
+      other_pcs.push_back(dex_pc);
+    }
+    dex_pc += inst->SizeInCodeUnits();
+  }
+  ASSERT_FALSE(invoke_pcs.empty());
+
+  InlineCacheTable table;
+  for (size_t i = 0; i < invoke_pcs.size(); i++) {
+    InlineCache* cache = table.Lookup(soa.Self(), to_string, invoke_pcs[i]);
+    ASSERT_TRUE(cache != NULL);
+    EXPECT_EQ(invoke_pcs[i], cache->GetDexPc());
+    EXPECT_EQ(cache, table.Lookup(soa.Self(), to_string, invoke_pcs[i]));
+  }
+  for (size_t i = 0; i < other_pcs.size(); i++) {
+    EXPECT_TRUE(table.Lookup(soa.Self(), to_string, other_pcs[i]) == NULL);
+  }
+
+  size_t sites;
+  uint64_t hits;
+  uint64_t misses;
+  size_t megamorphic_sites;
+  table.GetStats(soa.Self(), &sites, &hits, &misses, &megamorphic_sites);
+  EXPECT_EQ(invoke_pcs.size(), sites);
+  EXPECT_EQ(0U, hits);
+  EXPECT_EQ(0U, misses);
+  EXPECT_EQ(0U, megamorphic_sites);
+}
+
+TEST_F(InlineCacheTest, Megamorphic) {
+  ScopedObjectAccess soa(Thread::Current());
+  const char* descriptors[] = {
+    "Ljava/lang/Object;",
+    "Ljava/lang/String;",
+    "Ljava/lang/Class;",
+    "Ljava/lang/Integer;",
+    "Ljava/lang/Long;",
+  };
+  const size_t count = sizeof(descriptors) / sizeof(descriptors[0]);
+  ASSERT_GT(count, InlineCache::kEntries);
+  mirror::Class* classes[count];
+  mirror::ArtMethod* methods[count];
+  for (size_t i = 0; i < count; i++) {
+    classes[i] = class_linker_->FindSystemClass(descriptors[i]);
+    ASSERT_TRUE(classes[i] != NULL);
+    methods[i] = classes[i]->FindVirtualMethod("toString", "()Ljava/lang/String;");
+    ASSERT_TRUE(methods[i] != NULL);
+  }
+  const DexFile::CodeItem* code_item = MethodHelper(methods[0]).GetCodeItem();
+  uint32_t dex_pc = 0;
+  while (Instruction::At(code_item->insns_ + dex_pc)->Opcode() != Instruction::INVOKE_VIRTUAL) {
+    dex_pc += Instruction::At(code_item->insns_ + dex_pc)->SizeInCodeUnits();
+    ASSERT_LT(dex_pc, code_item->insns_size_in_code_units_);
+  }
+
+  InlineCacheTable table;
+  InlineCache* cache = table.Lookup(soa.Self(), methods[0], dex_pc);
+  ASSERT_TRUE(cache != NULL);
+  for (size_t i = 0; i < count; i++) {
+    EXPECT_TRUE(cache->Lookup(classes[i]) == NULL);
+    table.Update(soa.Self(), cache, classes[i], methods[i]);
+    // Recording a class twice keeps a single entry.
+    table.Update(soa.Self(), cache, classes[i], methods[i]);
+  }
+  EXPECT_TRUE(cache->IsMegamorphic());
+  for (size_t i = 0; i < count; i++) {
+    if (i < InlineCache::kEntries) {
+      EXPECT_EQ(methods[i], cache->Lookup(classes[i]));
+    } else {
+      EXPECT_TRUE(cache->Lookup(classes[i]) == NULL);
+    }
+  }
+  EXPECT_EQ(InlineCache::kEntries, cache->GetHits());
+  EXPECT_EQ(count + count - InlineCache::kEntries, cache->GetMisses());
+
+  size_t sites;
+  uint64_t hits;
+  uint64_t misses;
+  size_t megamorphic_sites;
+  table.GetStats(soa.Self(), &sites, &hits, &misses, &megamorphic_sites);
+  EXPECT_EQ(InlineCache::kEntries, hits);
+  EXPECT_EQ(count + count - InlineCache::kEntries, misses);
+  EXPECT_EQ(1U, megamorphic_sites);
+}
+
+}  // namespace interpreter
+}  // namespace art
@@ -26,6 +26,7 @@
 #include "dex_instruction.h"
 #include "entrypoints/entrypoint_utils.h"
 #include "gc/accounting/card_table-inl.h"
+#include "interpreter/inline_cache.h"
 #include "invoke_arg_array_builder.h"
 #include "nth_caller_visitor.h"
 #include "mirror/art_field-inl.h"
@@ -39,6 +40,7 @@
 #include "ScopedLocalRef.h"
 #include "scoped_thread_state_change.h"
 #include "thread.h"
+#include "tiered_compiler.h"
 #include "well_known_classes.h"
 
 using ::art::mirror::ArtField;
@@ -427,16 +429,31 @@ static bool DoInvoke(Thread* self, ShadowFrame& shadow_frame,
   uint32_t method_idx = (is_range) ? inst->VRegB_3rc() : inst->VRegB_35c();
   uint32_t vregC = (is_range) ? inst->VRegC_3rc() : inst->VRegC_35c();
   Object* receiver = (type == kStatic) ? NULL : shadow_frame.GetVRegReference(vregC);
-  ArtMethod* method = FindMethodFromCode(method_idx, receiver, shadow_frame.GetMethod(), self,
-                                         do_access_check, type);
-  if (UNLIKELY(method == NULL)) {
-    CHECK(self->IsExceptionPending());
-    result->SetJ(0);
-    return false;
-  } else if (UNLIKELY(method->IsAbstract())) {
-    ThrowAbstractMethodError(method);
-    result->SetJ(0);
-    return false;
+  ArtMethod* method = NULL;
+  InlineCache* inline_cache = NULL;
+  if ((type == kVirtual || type == kInterface) && LIKELY(receiver != NULL)) {
+    inline_cache = Runtime::Current()->GetInlineCacheTable()->Lookup(self, shadow_frame.GetMethod(),
+                                                                     shadow_frame.GetDexPC());
+    if (LIKELY(inline_cache != NULL)) {
+      method = inline_cache->Lookup(receiver->GetClass());
+    }
+  }
+  if (method == NULL) {
+    method = FindMethodFromCode(method_idx, receiver, shadow_frame.GetMethod(), self,
+                                do_access_check, type);
+    if (UNLIKELY(method == NULL)) {
+      CHECK(self->IsExceptionPending());
+      result->SetJ(0);
+      return false;
+    } else if (UNLIKELY(method->IsAbstract())) {
+      ThrowAbstractMethodError(method);
+      result->SetJ(0);
+      return false;
+    }
+    if (inline_cache != NULL && !inline_cache->IsMegamorphic()) {
+      Runtime::Current()->GetInlineCacheTable()->Update(self, inline_cache,
+                                                        receiver->GetClass(), method);
+    }
   }
 
   MethodHelper mh(method);
@@ -1067,6 +1084,83 @@ static void UnexpectedOpcode(const Instruction* inst, MethodHelper& mh)
 // Code to run before each dex instruction.
 #define PREAMBLE()
 
+static void TraceExecution(const ShadowFrame& shadow_frame, const Instruction* inst,
+                           uint32_t dex_pc, MethodHelper& mh)
+    SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+  const bool kTracing = false;
+  if (kTracing) {
+#define TRACE_LOG std::cerr
+    TRACE_LOG << PrettyMethod(shadow_frame.GetMethod())
+              << StringPrintf("\n0x%x: ", dex_pc)
+              << inst->DumpString(&mh.GetDexFile()) << "\n";
+    for (size_t i = 0; i < shadow_frame.NumberOfVRegs(); ++i) {
+      uint32_t raw_value = shadow_frame.GetVReg(i);
+      Object* ref_value = shadow_frame.GetVRegReference(i);
+      TRACE_LOG << StringPrintf(" vreg%d=0x%08X", i, raw_value);
+      if (ref_value != NULL) {
+        if (ref_value->GetClass()->IsStringClass() &&
+            ref_value->AsString()->GetCharArray() != NULL) {
+          TRACE_LOG << "/java.lang.String \"" << ref_value->AsString()->ToModifiedUtf8() << "\"";
+        } else {
+          TRACE_LOG << "/" << PrettyTypeOf(ref_value);
+        }
+      }
+    }
+    TRACE_LOG << "\n";
+#undef TRACE_LOG
+  }
+}
+
+// Counts the entry of the method and its backward branches, the first
+// instruction is dispatched with dex_pc already set to its own pc.
+static inline void UpdateHotness(Thread* self, TieredCompiler* tiered_compiler, ArtMethod* method,
+                                 uint32_t* hotness_counter, uint32_t dex_pc, uint32_t next_dex_pc)
+    SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+  if (next_dex_pc <= dex_pc) {
+    uint32_t hotness = *hotness_counter + 1;
+    if (UNLIKELY(hotness >= tiered_compiler->GetHotnessThreshold())) {
+      hotness = 0;
+      tiered_compiler->MethodIsHot(self, method);
+    }
+    *hotness_counter = hotness;
+  }
+}
+
+// Bookkeeping done before dispatching each dex instruction.
+#define INSTRUCTION_PROLOGUE() \
+  if (UNLIKELY(hotness_counter != NULL)) { \
+    UpdateHotness(self, tiered_compiler, shadow_frame.GetMethod(), hotness_counter, dex_pc, \
+                  inst->GetDexPc(insns)); \
+  } \
+  dex_pc = inst->GetDexPc(insns); \
+  shadow_frame.SetDexPC(dex_pc); \
+  if (UNLIKELY(self->TestAllFlags())) { \
+    CheckSuspend(self); \
+  } \
+  if (UNLIKELY(instrumentation->HasDexPcListeners())) { \
+    instrumentation->DexPcMovedEvent(self, this_object_ref.get(), \
+                                     shadow_frame.GetMethod(), dex_pc); \
+  } \
+  TraceExecution(shadow_frame, inst, dex_pc, mh)
+
+// The handlers are the cases of the switch. With the threaded dispatch each
+// handler also carries a label and jumps to the handler of the next
+// instruction through kHandlersTable instead of going back to the switch,
+// which gives every handler its own indirect branch to predict. The body is
+// wrapped in a do-while so that its "break" ends the handler in both modes.
+#if ART_USE_COMPUTED_GOTO_INTERPRETER
+#define HANDLE_INSTRUCTION_START(opcode) case Instruction::opcode: op_##opcode: do {
+#define HANDLE_INSTRUCTION_END() \
+  } while (false); \
+  INSTRUCTION_PROLOGUE(); \
+  goto *kHandlersTable[inst->Opcode()]
+#define UNUSED_INSTRUCTION_LABEL(opcode) op_##opcode:
+#else
+#define HANDLE_INSTRUCTION_START(opcode) case Instruction::opcode: do {
+#define HANDLE_INSTRUCTION_END() } while (false); break
+#define UNUSED_INSTRUCTION_LABEL(opcode)
+#endif
+
 // TODO: should be SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) which is failing due to template
 // specialization.
 template<bool do_access_check>
@@ -1099,113 +1193,110 @@ static JValue ExecuteImpl(Thread* self, MethodHelper& mh, const DexFile::CodeIte
   }
   const uint16_t* const insns = code_item->insns_;
   const Instruction* inst = Instruction::At(insns + dex_pc);
+  // Methods that still need access checks did not verify and are not compiled.
+  TieredCompiler* const tiered_compiler =
+      do_access_check ? NULL : Runtime::Current()->GetTieredCompiler();
+  uint32_t* const hotness_counter = (tiered_compiler == NULL) ? NULL :
+      Runtime::Current()->GetInlineCacheTable()->GetHotnessCounter(self, shadow_frame.GetMethod());
+#if ART_USE_COMPUTED_GOTO_INTERPRETER
+  static const void* const kHandlersTable[kNumPackedOpcodes] = {
+#define INSTRUCTION_HANDLER(o, code, n, f, r, i, a, v) &&op_##code,
+#include "dex_instruction_list.h"
+    DEX_INSTRUCTION_LIST(INSTRUCTION_HANDLER)
+#undef DEX_INSTRUCTION_LIST
+#undef INSTRUCTION_HANDLER
+  };
+#endif
   while (true) {
-    dex_pc = inst->GetDexPc(insns);
-    shadow_frame.SetDexPC(dex_pc);
-    if (UNLIKELY(self->TestAllFlags())) {
-      CheckSuspend(self);
-    }
-    if (UNLIKELY(instrumentation->HasDexPcListeners())) {
-      instrumentation->DexPcMovedEvent(self, this_object_ref.get(),
-                                       shadow_frame.GetMethod(), dex_pc);
-    }
-    const bool kTracing = false;
-    if (kTracing) {
-#define TRACE_LOG std::cerr
-      TRACE_LOG << PrettyMethod(shadow_frame.GetMethod())
-                << StringPrintf("\n0x%x: ", dex_pc)
-                << inst->DumpString(&mh.GetDexFile()) << "\n";
-      for (size_t i = 0; i < shadow_frame.NumberOfVRegs(); ++i) {
-        uint32_t raw_value = shadow_frame.GetVReg(i);
-        Object* ref_value = shadow_frame.GetVRegReference(i);
-        TRACE_LOG << StringPrintf(" vreg%d=0x%08X", i, raw_value);
-        if (ref_value != NULL) {
-          if (ref_value->GetClass()->IsStringClass() &&
-              ref_value->AsString()->GetCharArray() != NULL) {
-            TRACE_LOG << "/java.lang.String \"" << ref_value->AsString()->ToModifiedUtf8() << "\"";
-          } else {
-            TRACE_LOG << "/" << PrettyTypeOf(ref_value);
-          }
-        }
-      }
-      TRACE_LOG << "\n";
-#undef TRACE_LOG
-    }
+    INSTRUCTION_PROLOGUE();
     switch (inst->Opcode()) {
-      case Instruction::NOP:
+      HANDLE_INSTRUCTION_START(NOP)
         PREAMBLE();
         inst = inst->Next_1xx();
         break;
-      case Instruction::MOVE:
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(MOVE)
         PREAMBLE();
         shadow_frame.SetVReg(inst->VRegA_12x(),
                              shadow_frame.GetVReg(inst->VRegB_12x()));
         inst = inst->Next_1xx();
         break;
-      case Instruction::MOVE_FROM16:
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(MOVE_FROM16)
         PREAMBLE();
         shadow_frame.SetVReg(inst->VRegA_22x(),
                              shadow_frame.GetVReg(inst->VRegB_22x()));
         inst = inst->Next_2xx();
         break;
-      case Instruction::MOVE_16:
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(MOVE_16)
         PREAMBLE();
         shadow_frame.SetVReg(inst->VRegA_32x(),
                              shadow_frame.GetVReg(inst->VRegB_32x()));
         inst = inst->Next_3xx();
         break;
-      case Instruction::MOVE_WIDE:
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(MOVE_WIDE)
         PREAMBLE();
         shadow_frame.SetVRegLong(inst->VRegA_12x(),
                                  shadow_frame.GetVRegLong(inst->VRegB_12x()));
         inst = inst->Next_1xx();
         break;
-      case Instruction::MOVE_WIDE_FROM16:
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(MOVE_WIDE_FROM16)
         PREAMBLE();
         shadow_frame.SetVRegLong(inst->VRegA_22x(),
                                  shadow_frame.GetVRegLong(inst->VRegB_22x()));
         inst = inst->Next_2xx();
         break;
-      case Instruction::MOVE_WIDE_16:
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(MOVE_WIDE_16)
         PREAMBLE();
         shadow_frame.SetVRegLong(inst->VRegA_32x(),
                                  shadow_frame.GetVRegLong(inst->VRegB_32x()));
         inst = inst->Next_3xx();
         break;
-      case Instruction::MOVE_OBJECT:
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(MOVE_OBJECT)
         PREAMBLE();
         shadow_frame.SetVRegReference(inst->VRegA_12x(),
                                       shadow_frame.GetVRegReference(inst->VRegB_12x()));
         inst = inst->Next_1xx();
         break;
-      case Instruction::MOVE_OBJECT_FROM16:
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(MOVE_OBJECT_FROM16)
         PREAMBLE();
         shadow_frame.SetVRegReference(inst->VRegA_22x(),
                                       shadow_frame.GetVRegReference(inst->VRegB_22x()));
         inst = inst->Next_2xx();
         break;
-      case Instruction::MOVE_OBJECT_16:
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(MOVE_OBJECT_16)
         PREAMBLE();
         shadow_frame.SetVRegReference(inst->VRegA_32x(),
                                       shadow_frame.GetVRegReference(inst->VRegB_32x()));
         inst = inst->Next_3xx();
         break;
-      case Instruction::MOVE_RESULT:
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(MOVE_RESULT)
         PREAMBLE();
         shadow_frame.SetVReg(inst->VRegA_11x(), result_register.GetI());
         inst = inst->Next_1xx();
         break;
-      case Instruction::MOVE_RESULT_WIDE:
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(MOVE_RESULT_WIDE)
         PREAMBLE();
         shadow_frame.SetVRegLong(inst->VRegA_11x(), result_register.GetJ());
         inst = inst->Next_1xx();
         break;
-      case Instruction::MOVE_RESULT_OBJECT:
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(MOVE_RESULT_OBJECT)
         PREAMBLE();
         shadow_frame.SetVRegReference(inst->VRegA_11x(), result_register.GetL());
         inst = inst->Next_1xx();
         break;
-      case Instruction::MOVE_EXCEPTION: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(MOVE_EXCEPTION) {
         PREAMBLE();
         Throwable* exception = self->GetException(NULL);
         self->ClearException();
@@ -1213,7 +1304,8 @@ static JValue ExecuteImpl(Thread* self, MethodHelper& mh, const DexFile::CodeIte
         inst = inst->Next_1xx();
         break;
       }
-      case Instruction::RETURN_VOID: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(RETURN_VOID) {
         PREAMBLE();
         JValue result;
         if (UNLIKELY(instrumentation->HasMethodExitListeners())) {
@@ -1223,7 +1315,8 @@ static JValue ExecuteImpl(Thread* self, MethodHelper& mh, const DexFile::CodeIte
         }
         return result;
       }
-      case Instruction::RETURN_VOID_BARRIER: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(RETURN_VOID_BARRIER) {
         PREAMBLE();
         ANDROID_MEMBAR_STORE();
         JValue result;
@@ -1234,7 +1327,8 @@ static JValue ExecuteImpl(Thread* self, MethodHelper& mh, const DexFile::CodeIte
         }
         return result;
       }
-      case Instruction::RETURN: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(RETURN) {
         PREAMBLE();
         JValue result;
         result.SetJ(0);
@@ -1246,7 +1340,8 @@ static JValue ExecuteImpl(Thread* self, MethodHelper& mh, const DexFile::CodeIte
         }
         return result;
       }
-      case Instruction::RETURN_WIDE: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(RETURN_WIDE) {
         PREAMBLE();
         JValue result;
         result.SetJ(shadow_frame.GetVRegLong(inst->VRegA_11x()));
@@ -1257,7 +1352,8 @@ static JValue ExecuteImpl(Thread* self, MethodHelper& mh, const DexFile::CodeIte
         }
         return result;
       }
-      case Instruction::RETURN_OBJECT: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(RETURN_OBJECT) {
         PREAMBLE();
         JValue result;
         Object* obj_result = shadow_frame.GetVRegReference(inst->VRegA_11x());
@@ -1286,7 +1382,8 @@ static JValue ExecuteImpl(Thread* self, MethodHelper& mh, const DexFile::CodeIte
         }
         return result;
       }
-      case Instruction::CONST_4: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(CONST_4) {
         PREAMBLE();
         uint4_t dst = inst->VRegA_11n();
         int4_t val = inst->VRegB_11n();
@@ -1297,7 +1394,8 @@ static JValue ExecuteImpl(Thread* self, MethodHelper& mh, const DexFile::CodeIte
         inst = inst->Next_1xx();
         break;
       }
-      case Instruction::CONST_16: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(CONST_16) {
         PREAMBLE();
         uint8_t dst = inst->VRegA_21s();
         int16_t val = inst->VRegB_21s();
@@ -1308,7 +1406,8 @@ static JValue ExecuteImpl(Thread* self, MethodHelper& mh, const DexFile::CodeIte
         inst = inst->Next_2xx();
         break;
       }
-      case Instruction::CONST: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(CONST) {
         PREAMBLE();
         uint8_t dst = inst->VRegA_31i();
         int32_t val = inst->VRegB_31i();
@@ -1319,7 +1418,8 @@ static JValue ExecuteImpl(Thread* self, MethodHelper& mh, const DexFile::CodeIte
         inst = inst->Next_3xx();
         break;
       }
-      case Instruction::CONST_HIGH16: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(CONST_HIGH16) {
         PREAMBLE();
         uint8_t dst = inst->VRegA_21h();
         int32_t val = static_cast<int32_t>(inst->VRegB_21h() << 16);
@@ -1330,27 +1430,32 @@ static JValue ExecuteImpl(Thread* self, MethodHelper& mh, const DexFile::CodeIte
         inst = inst->Next_2xx();
         break;
       }
-      case Instruction::CONST_WIDE_16:
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(CONST_WIDE_16)
         PREAMBLE();
         shadow_frame.SetVRegLong(inst->VRegA_21s(), inst->VRegB_21s());
         inst = inst->Next_2xx();
         break;
-      case Instruction::CONST_WIDE_32:
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(CONST_WIDE_32)
         PREAMBLE();
         shadow_frame.SetVRegLong(inst->VRegA_31i(), inst->VRegB_31i());
         inst = inst->Next_3xx();
         break;
-      case Instruction::CONST_WIDE:
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(CONST_WIDE)
         PREAMBLE();
         shadow_frame.SetVRegLong(inst->VRegA_51l(), inst->VRegB_51l());
         inst = inst->Next_51l();
         break;
-      case Instruction::CONST_WIDE_HIGH16:
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(CONST_WIDE_HIGH16)
         shadow_frame.SetVRegLong(inst->VRegA_21h(),
                                  static_cast<uint64_t>(inst->VRegB_21h()) << 48);
         inst = inst->Next_2xx();
         break;
-      case Instruction::CONST_STRING: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(CONST_STRING) {
         PREAMBLE();
         String* s = ResolveString(self, mh,  inst->VRegB_21c());
         if (UNLIKELY(s == NULL)) {
@@ -1361,7 +1466,8 @@ static JValue ExecuteImpl(Thread* self, MethodHelper& mh, const DexFile::CodeIte
         }
         break;
       }
-      case Instruction::CONST_STRING_JUMBO: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(CONST_STRING_JUMBO) {
         PREAMBLE();
         String* s = ResolveString(self, mh,  inst->VRegB_31c());
         if (UNLIKELY(s == NULL)) {
@@ -1372,7 +1478,8 @@ static JValue ExecuteImpl(Thread* self, MethodHelper& mh, const DexFile::CodeIte
         }
         break;
       }
-      case Instruction::CONST_CLASS: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(CONST_CLASS) {
         PREAMBLE();
         Class* c = ResolveVerifyAndClinit(inst->VRegB_21c(), shadow_frame.GetMethod(),
                                           self, false, do_access_check);
@@ -1384,7 +1491,8 @@ static JValue ExecuteImpl(Thread* self, MethodHelper& mh, const DexFile::CodeIte
         }
         break;
       }
-      case Instruction::MONITOR_ENTER: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(MONITOR_ENTER) {
         PREAMBLE();
         Object* obj = shadow_frame.GetVRegReference(inst->VRegA_11x());
         if (UNLIKELY(obj == NULL)) {
@@ -1396,7 +1504,8 @@ static JValue ExecuteImpl(Thread* self, MethodHelper& mh, const DexFile::CodeIte
         }
         break;
       }
-      case Instruction::MONITOR_EXIT: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(MONITOR_EXIT) {
         PREAMBLE();
         Object* obj = shadow_frame.GetVRegReference(inst->VRegA_11x());
         if (UNLIKELY(obj == NULL)) {
@@ -1408,7 +1517,8 @@ static JValue ExecuteImpl(Thread* self, MethodHelper& mh, const DexFile::CodeIte
         }
         break;
       }
-      case Instruction::CHECK_CAST: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(CHECK_CAST) {
         PREAMBLE();
         Class* c = ResolveVerifyAndClinit(inst->VRegB_21c(), shadow_frame.GetMethod(),
                                           self, false, do_access_check);
@@ -1425,7 +1535,8 @@ static JValue ExecuteImpl(Thread* self, MethodHelper& mh, const DexFile::CodeIte
         }
         break;
       }
-      case Instruction::INSTANCE_OF: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(INSTANCE_OF) {
         PREAMBLE();
         Class* c = ResolveVerifyAndClinit(inst->VRegC_22c(), shadow_frame.GetMethod(),
                                           self, false, do_access_check);
@@ -1438,7 +1549,8 @@ static JValue ExecuteImpl(Thread* self, MethodHelper& mh, const DexFile::CodeIte
         }
         break;
       }
-      case Instruction::ARRAY_LENGTH:  {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(ARRAY_LENGTH) {
         PREAMBLE();
         Object* array = shadow_frame.GetVRegReference(inst->VRegB_12x());
         if (UNLIKELY(array == NULL)) {
@@ -1450,7 +1562,8 @@ static JValue ExecuteImpl(Thread* self, MethodHelper& mh, const DexFile::CodeIte
         }
         break;
       }
-      case Instruction::NEW_INSTANCE: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(NEW_INSTANCE) {
         PREAMBLE();
         Object* obj = AllocObjectFromCode(inst->VRegB_21c(), shadow_frame.GetMethod(),
                                           self, do_access_check);
@@ -1462,7 +1575,8 @@ static JValue ExecuteImpl(Thread* self, MethodHelper& mh, const DexFile::CodeIte
         }
         break;
       }
-      case Instruction::NEW_ARRAY: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(NEW_ARRAY) {
         PREAMBLE();
         int32_t length = shadow_frame.GetVReg(inst->VRegB_22c());
         Object* obj = AllocArrayFromCode(inst->VRegC_22c(), shadow_frame.GetMethod(),
@@ -1475,21 +1589,24 @@ static JValue ExecuteImpl(Thread* self, MethodHelper& mh, const DexFile::CodeIte
         }
         break;
       }
-      case Instruction::FILLED_NEW_ARRAY: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(FILLED_NEW_ARRAY) {
         PREAMBLE();
         bool success = DoFilledNewArray<false, do_access_check>(inst, shadow_frame,
                                                                 self, &result_register);
         POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_3xx);
         break;
       }
-      case Instruction::FILLED_NEW_ARRAY_RANGE: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(FILLED_NEW_ARRAY_RANGE) {
         PREAMBLE();
         bool success = DoFilledNewArray<true, do_access_check>(inst, shadow_frame,
                                                                self, &result_register);
         POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_3xx);
         break;
       }
-      case Instruction::FILL_ARRAY_DATA: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(FILL_ARRAY_DATA) {
         PREAMBLE();
         Object* obj = shadow_frame.GetVRegReference(inst->VRegA_31t());
         if (UNLIKELY(obj == NULL)) {
@@ -1515,7 +1632,8 @@ static JValue ExecuteImpl(Thread* self, MethodHelper& mh, const DexFile::CodeIte
         inst = inst->Next_3xx();
         break;
       }
-      case Instruction::THROW: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(THROW) {
         PREAMBLE();
         Object* exception = shadow_frame.GetVRegReference(inst->VRegA_11x());
         if (UNLIKELY(exception == NULL)) {
@@ -1532,22 +1650,26 @@ static JValue ExecuteImpl(Thread* self, MethodHelper& mh, const DexFile::CodeIte
         HANDLE_PENDING_EXCEPTION();
         break;
       }
-      case Instruction::GOTO: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(GOTO) {
         PREAMBLE();
         inst = inst->RelativeAt(inst->VRegA_10t());
         break;
       }
-      case Instruction::GOTO_16: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(GOTO_16) {
         PREAMBLE();
         inst = inst->RelativeAt(inst->VRegA_20t());
         break;
       }
-      case Instruction::GOTO_32: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(GOTO_32) {
         PREAMBLE();
         inst = inst->RelativeAt(inst->VRegA_30t());
         break;
       }
-      case Instruction::PACKED_SWITCH: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(PACKED_SWITCH) {
         PREAMBLE();
         const uint16_t* switch_data = reinterpret_cast<const uint16_t*>(inst) + inst->VRegB_31t();
         int32_t test_val = shadow_frame.GetVReg(inst->VRegA_31t());
@@ -1567,12 +1689,14 @@ static JValue ExecuteImpl(Thread* self, MethodHelper& mh, const DexFile::CodeIte
         }
         break;
       }
-      case Instruction::SPARSE_SWITCH: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(SPARSE_SWITCH) {
         PREAMBLE();
         inst = DoSparseSwitch(inst, shadow_frame);
         break;
       }
-      case Instruction::CMPL_FLOAT: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(CMPL_FLOAT) {
         PREAMBLE();
         float val1 = shadow_frame.GetVRegFloat(inst->VRegB_23x());
         float val2 = shadow_frame.GetVRegFloat(inst->VRegC_23x());
@@ -1588,7 +1712,8 @@ static JValue ExecuteImpl(Thread* self, MethodHelper& mh, const DexFile::CodeIte
         inst = inst->Next_2xx();
         break;
       }
-      case Instruction::CMPG_FLOAT: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(CMPG_FLOAT) {
         PREAMBLE();
         float val1 = shadow_frame.GetVRegFloat(inst->VRegB_23x());
         float val2 = shadow_frame.GetVRegFloat(inst->VRegC_23x());
@@ -1604,7 +1729,8 @@ static JValue ExecuteImpl(Thread* self, MethodHelper& mh, const DexFile::CodeIte
         inst = inst->Next_2xx();
         break;
       }
-      case Instruction::CMPL_DOUBLE: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(CMPL_DOUBLE) {
         PREAMBLE();
         double val1 = shadow_frame.GetVRegDouble(inst->VRegB_23x());
         double val2 = shadow_frame.GetVRegDouble(inst->VRegC_23x());
@@ -1621,7 +1747,8 @@ static JValue ExecuteImpl(Thread* self, MethodHelper& mh, const DexFile::CodeIte
         break;
       }
 
-      case Instruction::CMPG_DOUBLE: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(CMPG_DOUBLE) {
         PREAMBLE();
         double val1 = shadow_frame.GetVRegDouble(inst->VRegB_23x());
         double val2 = shadow_frame.GetVRegDouble(inst->VRegC_23x());
@@ -1637,7 +1764,8 @@ static JValue ExecuteImpl(Thread* self, MethodHelper& mh, const DexFile::CodeIte
         inst = inst->Next_2xx();
         break;
       }
-      case Instruction::CMP_LONG: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(CMP_LONG) {
         PREAMBLE();
         int64_t val1 = shadow_frame.GetVRegLong(inst->VRegB_23x());
         int64_t val2 = shadow_frame.GetVRegLong(inst->VRegC_23x());
@@ -1653,7 +1781,8 @@ static JValue ExecuteImpl(Thread* self, MethodHelper& mh, const DexFile::CodeIte
         inst = inst->Next_2xx();
         break;
       }
-      case Instruction::IF_EQ: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(IF_EQ) {
         PREAMBLE();
         if (shadow_frame.GetVReg(inst->VRegA_22t()) == shadow_frame.GetVReg(inst->VRegB_22t())) {
           inst = inst->RelativeAt(inst->VRegC_22t());
@@ -1662,7 +1791,8 @@ static JValue ExecuteImpl(Thread* self, MethodHelper& mh, const DexFile::CodeIte
         }
         break;
       }
-      case Instruction::IF_NE: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(IF_NE) {
         PREAMBLE();
         if (shadow_frame.GetVReg(inst->VRegA_22t()) != shadow_frame.GetVReg(inst->VRegB_22t())) {
           inst = inst->RelativeAt(inst->VRegC_22t());
@@ -1671,7 +1801,8 @@ static JValue ExecuteImpl(Thread* self, MethodHelper& mh, const DexFile::CodeIte
         }
         break;
       }
-      case Instruction::IF_LT: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(IF_LT) {
         PREAMBLE();
         if (shadow_frame.GetVReg(inst->VRegA_22t()) < shadow_frame.GetVReg(inst->VRegB_22t())) {
           inst = inst->RelativeAt(inst->VRegC_22t());
@@ -1680,7 +1811,8 @@ static JValue ExecuteImpl(Thread* self, MethodHelper& mh, const DexFile::CodeIte
         }
         break;
       }
-      case Instruction::IF_GE: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(IF_GE) {
         PREAMBLE();
         if (shadow_frame.GetVReg(inst->VRegA_22t()) >= shadow_frame.GetVReg(inst->VRegB_22t())) {
           inst = inst->RelativeAt(inst->VRegC_22t());
@@ -1689,7 +1821,8 @@ static JValue ExecuteImpl(Thread* self, MethodHelper& mh, const DexFile::CodeIte
         }
         break;
       }
-      case Instruction::IF_GT: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(IF_GT) {
         PREAMBLE();
         if (shadow_frame.GetVReg(inst->VRegA_22t()) > shadow_frame.GetVReg(inst->VRegB_22t())) {
           inst = inst->RelativeAt(inst->VRegC_22t());
@@ -1698,7 +1831,8 @@ static JValue ExecuteImpl(Thread* self, MethodHelper& mh, const DexFile::CodeIte
         }
         break;
       }
-      case Instruction::IF_LE: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(IF_LE) {
         PREAMBLE();
         if (shadow_frame.GetVReg(inst->VRegA_22t()) <= shadow_frame.GetVReg(inst->VRegB_22t())) {
           inst = inst->RelativeAt(inst->VRegC_22t());
@@ -1707,7 +1841,8 @@ static JValue ExecuteImpl(Thread* self, MethodHelper& mh, const DexFile::CodeIte
         }
         break;
       }
-      case Instruction::IF_EQZ: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(IF_EQZ) {
         PREAMBLE();
         if (shadow_frame.GetVReg(inst->VRegA_21t()) == 0) {
           inst = inst->RelativeAt(inst->VRegB_21t());
@@ -1716,7 +1851,8 @@ static JValue ExecuteImpl(Thread* self, MethodHelper& mh, const DexFile::CodeIte
         }
         break;
       }
-      case Instruction::IF_NEZ: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(IF_NEZ) {
         PREAMBLE();
         if (shadow_frame.GetVReg(inst->VRegA_21t()) != 0) {
           inst = inst->RelativeAt(inst->VRegB_21t());
@@ -1725,7 +1861,8 @@ static JValue ExecuteImpl(Thread* self, MethodHelper& mh, const DexFile::CodeIte
         }
         break;
       }
-      case Instruction::IF_LTZ: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(IF_LTZ) {
         PREAMBLE();
         if (shadow_frame.GetVReg(inst->VRegA_21t()) < 0) {
           inst = inst->RelativeAt(inst->VRegB_21t());
@@ -1734,7 +1871,8 @@ static JValue ExecuteImpl(Thread* self, MethodHelper& mh, const DexFile::CodeIte
         }
         break;
       }
-      case Instruction::IF_GEZ: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(IF_GEZ) {
         PREAMBLE();
         if (shadow_frame.GetVReg(inst->VRegA_21t()) >= 0) {
           inst = inst->RelativeAt(inst->VRegB_21t());
@@ -1743,7 +1881,8 @@ static JValue ExecuteImpl(Thread* self, MethodHelper& mh, const DexFile::CodeIte
         }
         break;
       }
-      case Instruction::IF_GTZ: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(IF_GTZ) {
         PREAMBLE();
         if (shadow_frame.GetVReg(inst->VRegA_21t()) > 0) {
           inst = inst->RelativeAt(inst->VRegB_21t());
@@ -1752,7 +1891,8 @@ static JValue ExecuteImpl(Thread* self, MethodHelper& mh, const DexFile::CodeIte
         }
         break;
       }
-      case Instruction::IF_LEZ:  {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(IF_LEZ) {
         PREAMBLE();
         if (shadow_frame.GetVReg(inst->VRegA_21t()) <= 0) {
           inst = inst->RelativeAt(inst->VRegB_21t());
@@ -1761,7 +1901,8 @@ static JValue ExecuteImpl(Thread* self, MethodHelper& mh, const DexFile::CodeIte
         }
         break;
       }
-      case Instruction::AGET_BOOLEAN: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(AGET_BOOLEAN) {
         PREAMBLE();
         Object* a = shadow_frame.GetVRegReference(inst->VRegB_23x());
         if (UNLIKELY(a == NULL)) {
@@ -1779,7 +1920,8 @@ static JValue ExecuteImpl(Thread* self, MethodHelper& mh, const DexFile::CodeIte
         }
         break;
       }
-      case Instruction::AGET_BYTE: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(AGET_BYTE) {
         PREAMBLE();
         Object* a = shadow_frame.GetVRegReference(inst->VRegB_23x());
         if (UNLIKELY(a == NULL)) {
@@ -1797,7 +1939,8 @@ static JValue ExecuteImpl(Thread* self, MethodHelper& mh, const DexFile::CodeIte
         }
         break;
       }
-      case Instruction::AGET_CHAR: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(AGET_CHAR) {
         PREAMBLE();
         Object* a = shadow_frame.GetVRegReference(inst->VRegB_23x());
         if (UNLIKELY(a == NULL)) {
@@ -1815,7 +1958,8 @@ static JValue ExecuteImpl(Thread* self, MethodHelper& mh, const DexFile::CodeIte
         }
         break;
       }
-      case Instruction::AGET_SHORT: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(AGET_SHORT) {
         PREAMBLE();
         Object* a = shadow_frame.GetVRegReference(inst->VRegB_23x());
         if (UNLIKELY(a == NULL)) {
@@ -1833,7 +1977,8 @@ static JValue ExecuteImpl(Thread* self, MethodHelper& mh, const DexFile::CodeIte
         }
         break;
       }
-      case Instruction::AGET: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(AGET) {
         PREAMBLE();
         Object* a = shadow_frame.GetVRegReference(inst->VRegB_23x());
         if (UNLIKELY(a == NULL)) {
@@ -1851,7 +1996,8 @@ static JValue ExecuteImpl(Thread* self, MethodHelper& mh, const DexFile::CodeIte
         }
         break;
       }
-      case Instruction::AGET_WIDE:  {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(AGET_WIDE) {
         PREAMBLE();
         Object* a = shadow_frame.GetVRegReference(inst->VRegB_23x());
         if (UNLIKELY(a == NULL)) {
@@ -1869,7 +2015,8 @@ static JValue ExecuteImpl(Thread* self, MethodHelper& mh, const DexFile::CodeIte
         }
         break;
       }
-      case Instruction::AGET_OBJECT: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(AGET_OBJECT) {
         PREAMBLE();
         Object* a = shadow_frame.GetVRegReference(inst->VRegB_23x());
         if (UNLIKELY(a == NULL)) {
@@ -1887,7 +2034,8 @@ static JValue ExecuteImpl(Thread* self, MethodHelper& mh, const DexFile::CodeIte
         }
         break;
       }
-      case Instruction::APUT_BOOLEAN: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(APUT_BOOLEAN) {
         PREAMBLE();
         Object* a = shadow_frame.GetVRegReference(inst->VRegB_23x());
         if (UNLIKELY(a == NULL)) {
@@ -1906,7 +2054,8 @@ static JValue ExecuteImpl(Thread* self, MethodHelper& mh, const DexFile::CodeIte
         }
         break;
       }
-      case Instruction::APUT_BYTE: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(APUT_BYTE) {
         PREAMBLE();
         Object* a = shadow_frame.GetVRegReference(inst->VRegB_23x());
         if (UNLIKELY(a == NULL)) {
@@ -1925,7 +2074,8 @@ static JValue ExecuteImpl(Thread* self, MethodHelper& mh, const DexFile::CodeIte
         }
         break;
       }
-      case Instruction::APUT_CHAR: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(APUT_CHAR) {
         PREAMBLE();
         Object* a = shadow_frame.GetVRegReference(inst->VRegB_23x());
         if (UNLIKELY(a == NULL)) {
@@ -1944,7 +2094,8 @@ static JValue ExecuteImpl(Thread* self, MethodHelper& mh, const DexFile::CodeIte
         }
         break;
       }
-      case Instruction::APUT_SHORT: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(APUT_SHORT) {
         PREAMBLE();
         Object* a = shadow_frame.GetVRegReference(inst->VRegB_23x());
         if (UNLIKELY(a == NULL)) {
@@ -1963,7 +2114,8 @@ static JValue ExecuteImpl(Thread* self, MethodHelper& mh, const DexFile::CodeIte
         }
         break;
       }
-      case Instruction::APUT: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(APUT) {
         PREAMBLE();
         Object* a = shadow_frame.GetVRegReference(inst->VRegB_23x());
         if (UNLIKELY(a == NULL)) {
@@ -1982,7 +2134,8 @@ static JValue ExecuteImpl(Thread* self, MethodHelper& mh, const DexFile::CodeIte
         }
         break;
       }
-      case Instruction::APUT_WIDE: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(APUT_WIDE) {
         PREAMBLE();
         Object* a = shadow_frame.GetVRegReference(inst->VRegB_23x());
         if (UNLIKELY(a == NULL)) {
@@ -2001,7 +2154,8 @@ static JValue ExecuteImpl(Thread* self, MethodHelper& mh, const DexFile::CodeIte
         }
         break;
       }
-      case Instruction::APUT_OBJECT: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(APUT_OBJECT) {
         PREAMBLE();
         Object* a = shadow_frame.GetVRegReference(inst->VRegB_23x());
         if (UNLIKELY(a == NULL)) {
@@ -2020,343 +2174,402 @@ static JValue ExecuteImpl(Thread* self, MethodHelper& mh, const DexFile::CodeIte
         }
         break;
       }
-      case Instruction::IGET_BOOLEAN: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(IGET_BOOLEAN) {
         PREAMBLE();
         bool success = DoFieldGet<InstancePrimitiveRead, Primitive::kPrimBoolean, do_access_check>(self, shadow_frame, inst);
         POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_2xx);
         break;
       }
-      case Instruction::IGET_BYTE: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(IGET_BYTE) {
         PREAMBLE();
         bool success = DoFieldGet<InstancePrimitiveRead, Primitive::kPrimByte, do_access_check>(self, shadow_frame, inst);
         POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_2xx);
         break;
       }
-      case Instruction::IGET_CHAR: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(IGET_CHAR) {
         PREAMBLE();
         bool success = DoFieldGet<InstancePrimitiveRead, Primitive::kPrimChar, do_access_check>(self, shadow_frame, inst);
         POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_2xx);
         break;
       }
-      case Instruction::IGET_SHORT: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(IGET_SHORT) {
         PREAMBLE();
         bool success = DoFieldGet<InstancePrimitiveRead, Primitive::kPrimShort, do_access_check>(self, shadow_frame, inst);
         POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_2xx);
         break;
       }
-      case Instruction::IGET: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(IGET) {
         PREAMBLE();
         bool success = DoFieldGet<InstancePrimitiveRead, Primitive::kPrimInt, do_access_check>(self, shadow_frame, inst);
         POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_2xx);
         break;
       }
-      case Instruction::IGET_WIDE: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(IGET_WIDE) {
         PREAMBLE();
         bool success = DoFieldGet<InstancePrimitiveRead, Primitive::kPrimLong, do_access_check>(self, shadow_frame, inst);
         POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_2xx);
         break;
       }
-      case Instruction::IGET_OBJECT: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(IGET_OBJECT) {
         PREAMBLE();
         bool success = DoFieldGet<InstanceObjectRead, Primitive::kPrimNot, do_access_check>(self, shadow_frame, inst);
         POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_2xx);
         break;
       }
-      case Instruction::IGET_QUICK: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(IGET_QUICK) {
         PREAMBLE();
         bool success = DoIGetQuick<Primitive::kPrimInt>(self, shadow_frame, inst);
         POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_2xx);
         break;
       }
-      case Instruction::IGET_WIDE_QUICK: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(IGET_WIDE_QUICK) {
         PREAMBLE();
         bool success = DoIGetQuick<Primitive::kPrimLong>(self, shadow_frame, inst);
         POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_2xx);
         break;
       }
-      case Instruction::IGET_OBJECT_QUICK: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(IGET_OBJECT_QUICK) {
         PREAMBLE();
         bool success = DoIGetQuick<Primitive::kPrimNot>(self, shadow_frame, inst);
         POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_2xx);
         break;
       }
-      case Instruction::SGET_BOOLEAN: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(SGET_BOOLEAN) {
         PREAMBLE();
         bool success = DoFieldGet<StaticPrimitiveRead, Primitive::kPrimBoolean, do_access_check>(self, shadow_frame, inst);
         POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_2xx);
         break;
       }
-      case Instruction::SGET_BYTE: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(SGET_BYTE) {
         PREAMBLE();
         bool success = DoFieldGet<StaticPrimitiveRead, Primitive::kPrimByte, do_access_check>(self, shadow_frame, inst);
         POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_2xx);
         break;
       }
-      case Instruction::SGET_CHAR: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(SGET_CHAR) {
         PREAMBLE();
         bool success = DoFieldGet<StaticPrimitiveRead, Primitive::kPrimChar, do_access_check>(self, shadow_frame, inst);
         POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_2xx);
         break;
       }
-      case Instruction::SGET_SHORT: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(SGET_SHORT) {
         PREAMBLE();
         bool success = DoFieldGet<StaticPrimitiveRead, Primitive::kPrimShort, do_access_check>(self, shadow_frame, inst);
         POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_2xx);
         break;
       }
-      case Instruction::SGET: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(SGET) {
         PREAMBLE();
         bool success = DoFieldGet<StaticPrimitiveRead, Primitive::kPrimInt, do_access_check>(self, shadow_frame, inst);
         POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_2xx);
         break;
       }
-      case Instruction::SGET_WIDE: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(SGET_WIDE) {
         PREAMBLE();
         bool success = DoFieldGet<StaticPrimitiveRead, Primitive::kPrimLong, do_access_check>(self, shadow_frame, inst);
         POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_2xx);
         break;
       }
-      case Instruction::SGET_OBJECT: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(SGET_OBJECT) {
         PREAMBLE();
         bool success = DoFieldGet<StaticObjectRead, Primitive::kPrimNot, do_access_check>(self, shadow_frame, inst);
         POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_2xx);
         break;
       }
-      case Instruction::IPUT_BOOLEAN: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(IPUT_BOOLEAN) {
         PREAMBLE();
         bool success = DoFieldPut<InstancePrimitiveWrite, Primitive::kPrimBoolean, do_access_check>(self, shadow_frame, inst);
         POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_2xx);
         break;
       }
-      case Instruction::IPUT_BYTE: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(IPUT_BYTE) {
         PREAMBLE();
         bool success = DoFieldPut<InstancePrimitiveWrite, Primitive::kPrimByte, do_access_check>(self, shadow_frame, inst);
         POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_2xx);
         break;
       }
-      case Instruction::IPUT_CHAR: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(IPUT_CHAR) {
         PREAMBLE();
         bool success = DoFieldPut<InstancePrimitiveWrite, Primitive::kPrimChar, do_access_check>(self, shadow_frame, inst);
         POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_2xx);
         break;
       }
-      case Instruction::IPUT_SHORT: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(IPUT_SHORT) {
         PREAMBLE();
         bool success = DoFieldPut<InstancePrimitiveWrite, Primitive::kPrimShort, do_access_check>(self, shadow_frame, inst);
         POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_2xx);
         break;
       }
-      case Instruction::IPUT: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(IPUT) {
         PREAMBLE();
         bool success = DoFieldPut<InstancePrimitiveWrite, Primitive::kPrimInt, do_access_check>(self, shadow_frame, inst);
         POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_2xx);
         break;
       }
-      case Instruction::IPUT_WIDE: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(IPUT_WIDE) {
         PREAMBLE();
         bool success = DoFieldPut<InstancePrimitiveWrite, Primitive::kPrimLong, do_access_check>(self, shadow_frame, inst);
         POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_2xx);
         break;
       }
-      case Instruction::IPUT_OBJECT: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(IPUT_OBJECT) {
         PREAMBLE();
         bool success = DoFieldPut<InstanceObjectWrite, Primitive::kPrimNot, do_access_check>(self, shadow_frame, inst);
         POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_2xx);
         break;
       }
-      case Instruction::IPUT_QUICK: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(IPUT_QUICK) {
         PREAMBLE();
         bool success = DoIPutQuick<Primitive::kPrimInt>(self, shadow_frame, inst);
         POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_2xx);
         break;
       }
-      case Instruction::IPUT_WIDE_QUICK: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(IPUT_WIDE_QUICK) {
         PREAMBLE();
         bool success = DoIPutQuick<Primitive::kPrimLong>(self, shadow_frame, inst);
         POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_2xx);
         break;
       }
-      case Instruction::IPUT_OBJECT_QUICK: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(IPUT_OBJECT_QUICK) {
         PREAMBLE();
         bool success = DoIPutQuick<Primitive::kPrimNot>(self, shadow_frame, inst);
         POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_2xx);
         break;
       }
-      case Instruction::SPUT_BOOLEAN: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(SPUT_BOOLEAN) {
         PREAMBLE();
         bool success = DoFieldPut<StaticPrimitiveWrite, Primitive::kPrimBoolean, do_access_check>(self, shadow_frame, inst);
         POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_2xx);
         break;
       }
-      case Instruction::SPUT_BYTE: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(SPUT_BYTE) {
         PREAMBLE();
         bool success = DoFieldPut<StaticPrimitiveWrite, Primitive::kPrimByte, do_access_check>(self, shadow_frame, inst);
         POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_2xx);
         break;
       }
-      case Instruction::SPUT_CHAR: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(SPUT_CHAR) {
         PREAMBLE();
         bool success = DoFieldPut<StaticPrimitiveWrite, Primitive::kPrimChar, do_access_check>(self, shadow_frame, inst);
         POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_2xx);
         break;
       }
-      case Instruction::SPUT_SHORT: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(SPUT_SHORT) {
         PREAMBLE();
         bool success = DoFieldPut<StaticPrimitiveWrite, Primitive::kPrimShort, do_access_check>(self, shadow_frame, inst);
         POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_2xx);
         break;
       }
-      case Instruction::SPUT: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(SPUT) {
         PREAMBLE();
         bool success = DoFieldPut<StaticPrimitiveWrite, Primitive::kPrimInt, do_access_check>(self, shadow_frame, inst);
         POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_2xx);
         break;
       }
-      case Instruction::SPUT_WIDE: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(SPUT_WIDE) {
         PREAMBLE();
         bool success = DoFieldPut<StaticPrimitiveWrite, Primitive::kPrimLong, do_access_check>(self, shadow_frame, inst);
         POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_2xx);
         break;
       }
-      case Instruction::SPUT_OBJECT: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(SPUT_OBJECT) {
         PREAMBLE();
         bool success = DoFieldPut<StaticObjectWrite, Primitive::kPrimNot, do_access_check>(self, shadow_frame, inst);
         POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_2xx);
         break;
       }
-      case Instruction::INVOKE_VIRTUAL: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(INVOKE_VIRTUAL) {
         PREAMBLE();
         bool success = DoInvoke<kVirtual, false, do_access_check>(self, shadow_frame, inst, &result_register);
         POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_3xx);
         break;
       }
-      case Instruction::INVOKE_VIRTUAL_RANGE: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(INVOKE_VIRTUAL_RANGE) {
         PREAMBLE();
         bool success = DoInvoke<kVirtual, true, do_access_check>(self, shadow_frame, inst, &result_register);
         POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_3xx);
         break;
       }
-      case Instruction::INVOKE_SUPER: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(INVOKE_SUPER) {
         PREAMBLE();
         bool success = DoInvoke<kSuper, false, do_access_check>(self, shadow_frame, inst, &result_register);
         POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_3xx);
         break;
       }
-      case Instruction::INVOKE_SUPER_RANGE: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(INVOKE_SUPER_RANGE) {
         PREAMBLE();
         bool success = DoInvoke<kSuper, true, do_access_check>(self, shadow_frame, inst, &result_register);
         POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_3xx);
         break;
       }
-      case Instruction::INVOKE_DIRECT: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(INVOKE_DIRECT) {
         PREAMBLE();
         bool success = DoInvoke<kDirect, false, do_access_check>(self, shadow_frame, inst, &result_register);
         POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_3xx);
         break;
       }
-      case Instruction::INVOKE_DIRECT_RANGE: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(INVOKE_DIRECT_RANGE) {
         PREAMBLE();
         bool success = DoInvoke<kDirect, true, do_access_check>(self, shadow_frame, inst, &result_register);
         POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_3xx);
         break;
       }
-      case Instruction::INVOKE_INTERFACE: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(INVOKE_INTERFACE) {
         PREAMBLE();
         bool success = DoInvoke<kInterface, false, do_access_check>(self, shadow_frame, inst, &result_register);
         POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_3xx);
         break;
       }
-      case Instruction::INVOKE_INTERFACE_RANGE: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(INVOKE_INTERFACE_RANGE) {
         PREAMBLE();
         bool success = DoInvoke<kInterface, true, do_access_check>(self, shadow_frame, inst, &result_register);
         POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_3xx);
         break;
       }
-      case Instruction::INVOKE_STATIC: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(INVOKE_STATIC) {
         PREAMBLE();
         bool success = DoInvoke<kStatic, false, do_access_check>(self, shadow_frame, inst, &result_register);
         POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_3xx);
         break;
       }
-      case Instruction::INVOKE_STATIC_RANGE: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(INVOKE_STATIC_RANGE) {
         PREAMBLE();
         bool success = DoInvoke<kStatic, true, do_access_check>(self, shadow_frame, inst, &result_register);
         POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_3xx);
         break;
       }
-      case Instruction::INVOKE_VIRTUAL_QUICK: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(INVOKE_VIRTUAL_QUICK) {
         PREAMBLE();
         bool success = DoInvokeVirtualQuick<false>(self, shadow_frame, inst, &result_register);
         POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_3xx);
         break;
       }
-      case Instruction::INVOKE_VIRTUAL_RANGE_QUICK: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(INVOKE_VIRTUAL_RANGE_QUICK) {
         PREAMBLE();
         bool success = DoInvokeVirtualQuick<true>(self, shadow_frame, inst, &result_register);
         POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_3xx);
         break;
       }
-      case Instruction::NEG_INT:
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(NEG_INT)
         PREAMBLE();
         shadow_frame.SetVReg(inst->VRegA_12x(), -shadow_frame.GetVReg(inst->VRegB_12x()));
         inst = inst->Next_1xx();
         break;
-      case Instruction::NOT_INT:
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(NOT_INT)
         PREAMBLE();
         shadow_frame.SetVReg(inst->VRegA_12x(), ~shadow_frame.GetVReg(inst->VRegB_12x()));
         inst = inst->Next_1xx();
         break;
-      case Instruction::NEG_LONG:
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(NEG_LONG)
         PREAMBLE();
         shadow_frame.SetVRegLong(inst->VRegA_12x(), -shadow_frame.GetVRegLong(inst->VRegB_12x()));
         inst = inst->Next_1xx();
         break;
-      case Instruction::NOT_LONG:
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(NOT_LONG)
         PREAMBLE();
         shadow_frame.SetVRegLong(inst->VRegA_12x(), ~shadow_frame.GetVRegLong(inst->VRegB_12x()));
         inst = inst->Next_1xx();
         break;
-      case Instruction::NEG_FLOAT:
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(NEG_FLOAT)
         PREAMBLE();
         shadow_frame.SetVRegFloat(inst->VRegA_12x(), -shadow_frame.GetVRegFloat(inst->VRegB_12x()));
         inst = inst->Next_1xx();
         break;
-      case Instruction::NEG_DOUBLE:
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(NEG_DOUBLE)
         PREAMBLE();
         shadow_frame.SetVRegDouble(inst->VRegA_12x(), -shadow_frame.GetVRegDouble(inst->VRegB_12x()));
         inst = inst->Next_1xx();
         break;
-      case Instruction::INT_TO_LONG:
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(INT_TO_LONG)
         PREAMBLE();
         shadow_frame.SetVRegLong(inst->VRegA_12x(), shadow_frame.GetVReg(inst->VRegB_12x()));
         inst = inst->Next_1xx();
         break;
-      case Instruction::INT_TO_FLOAT:
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(INT_TO_FLOAT)
         PREAMBLE();
         shadow_frame.SetVRegFloat(inst->VRegA_12x(), shadow_frame.GetVReg(inst->VRegB_12x()));
         inst = inst->Next_1xx();
         break;
-      case Instruction::INT_TO_DOUBLE:
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(INT_TO_DOUBLE)
         PREAMBLE();
         shadow_frame.SetVRegDouble(inst->VRegA_12x(), shadow_frame.GetVReg(inst->VRegB_12x()));
         inst = inst->Next_1xx();
         break;
-      case Instruction::LONG_TO_INT:
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(LONG_TO_INT)
         PREAMBLE();
         shadow_frame.SetVReg(inst->VRegA_12x(), shadow_frame.GetVRegLong(inst->VRegB_12x()));
         inst = inst->Next_1xx();
         break;
-      case Instruction::LONG_TO_FLOAT:
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(LONG_TO_FLOAT)
         PREAMBLE();
         shadow_frame.SetVRegFloat(inst->VRegA_12x(), shadow_frame.GetVRegLong(inst->VRegB_12x()));
         inst = inst->Next_1xx();
         break;
-      case Instruction::LONG_TO_DOUBLE:
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(LONG_TO_DOUBLE)
         PREAMBLE();
         shadow_frame.SetVRegDouble(inst->VRegA_12x(), shadow_frame.GetVRegLong(inst->VRegB_12x()));
         inst = inst->Next_1xx();
         break;
-      case Instruction::FLOAT_TO_INT: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(FLOAT_TO_INT) {
         PREAMBLE();
         float val = shadow_frame.GetVRegFloat(inst->VRegB_12x());
         int32_t result;
@@ -2373,7 +2586,8 @@ static JValue ExecuteImpl(Thread* self, MethodHelper& mh, const DexFile::CodeIte
         inst = inst->Next_1xx();
         break;
       }
-      case Instruction::FLOAT_TO_LONG: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(FLOAT_TO_LONG) {
         PREAMBLE();
         float val = shadow_frame.GetVRegFloat(inst->VRegB_12x());
         int64_t result;
@@ -2390,12 +2604,14 @@ static JValue ExecuteImpl(Thread* self, MethodHelper& mh, const DexFile::CodeIte
         inst = inst->Next_1xx();
         break;
       }
-      case Instruction::FLOAT_TO_DOUBLE:
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(FLOAT_TO_DOUBLE)
         PREAMBLE();
         shadow_frame.SetVRegDouble(inst->VRegA_12x(), shadow_frame.GetVRegFloat(inst->VRegB_12x()));
         inst = inst->Next_1xx();
         break;
-      case Instruction::DOUBLE_TO_INT: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(DOUBLE_TO_INT) {
         PREAMBLE();
         double val = shadow_frame.GetVRegDouble(inst->VRegB_12x());
         int32_t result;
@@ -2412,7 +2628,8 @@ static JValue ExecuteImpl(Thread* self, MethodHelper& mh, const DexFile::CodeIte
         inst = inst->Next_1xx();
         break;
       }
-      case Instruction::DOUBLE_TO_LONG: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(DOUBLE_TO_LONG) {
         PREAMBLE();
         double val = shadow_frame.GetVRegDouble(inst->VRegB_12x());
         int64_t result;
@@ -2429,51 +2646,59 @@ static JValue ExecuteImpl(Thread* self, MethodHelper& mh, const DexFile::CodeIte
         inst = inst->Next_1xx();
         break;
       }
-      case Instruction::DOUBLE_TO_FLOAT:
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(DOUBLE_TO_FLOAT)
         PREAMBLE();
         shadow_frame.SetVRegFloat(inst->VRegA_12x(), shadow_frame.GetVRegDouble(inst->VRegB_12x()));
         inst = inst->Next_1xx();
         break;
-      case Instruction::INT_TO_BYTE:
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(INT_TO_BYTE)
         PREAMBLE();
         shadow_frame.SetVReg(inst->VRegA_12x(),
                              static_cast<int8_t>(shadow_frame.GetVReg(inst->VRegB_12x())));
         inst = inst->Next_1xx();
         break;
-      case Instruction::INT_TO_CHAR:
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(INT_TO_CHAR)
         PREAMBLE();
         shadow_frame.SetVReg(inst->VRegA_12x(),
                              static_cast<uint16_t>(shadow_frame.GetVReg(inst->VRegB_12x())));
         inst = inst->Next_1xx();
         break;
-      case Instruction::INT_TO_SHORT:
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(INT_TO_SHORT)
         PREAMBLE();
         shadow_frame.SetVReg(inst->VRegA_12x(),
                              static_cast<int16_t>(shadow_frame.GetVReg(inst->VRegB_12x())));
         inst = inst->Next_1xx();
         break;
-      case Instruction::ADD_INT:
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(ADD_INT)
         PREAMBLE();
         shadow_frame.SetVReg(inst->VRegA_23x(),
                              shadow_frame.GetVReg(inst->VRegB_23x()) +
                              shadow_frame.GetVReg(inst->VRegC_23x()));
         inst = inst->Next_2xx();
         break;
-      case Instruction::SUB_INT:
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(SUB_INT)
         PREAMBLE();
         shadow_frame.SetVReg(inst->VRegA_23x(),
                              shadow_frame.GetVReg(inst->VRegB_23x()) -
                              shadow_frame.GetVReg(inst->VRegC_23x()));
         inst = inst->Next_2xx();
         break;
-      case Instruction::MUL_INT:
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(MUL_INT)
         PREAMBLE();
         shadow_frame.SetVReg(inst->VRegA_23x(),
                              shadow_frame.GetVReg(inst->VRegB_23x()) *
                              shadow_frame.GetVReg(inst->VRegC_23x()));
         inst = inst->Next_2xx();
         break;
-      case Instruction::DIV_INT: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(DIV_INT) {
         PREAMBLE();
         bool success = DoIntDivide(shadow_frame, inst->VRegA_23x(),
                                    shadow_frame.GetVReg(inst->VRegB_23x()),
@@ -2481,7 +2706,8 @@ static JValue ExecuteImpl(Thread* self, MethodHelper& mh, const DexFile::CodeIte
         POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_2xx);
         break;
       }
-      case Instruction::REM_INT: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(REM_INT) {
         PREAMBLE();
         bool success = DoIntRemainder(shadow_frame, inst->VRegA_23x(),
                                       shadow_frame.GetVReg(inst->VRegB_23x()),
@@ -2489,196 +2715,224 @@ static JValue ExecuteImpl(Thread* self, MethodHelper& mh, const DexFile::CodeIte
         POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_2xx);
         break;
       }
-      case Instruction::SHL_INT:
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(SHL_INT)
         PREAMBLE();
         shadow_frame.SetVReg(inst->VRegA_23x(),
                              shadow_frame.GetVReg(inst->VRegB_23x()) <<
                              (shadow_frame.GetVReg(inst->VRegC_23x()) & 0x1f));
         inst = inst->Next_2xx();
         break;
-      case Instruction::SHR_INT:
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(SHR_INT)
         PREAMBLE();
         shadow_frame.SetVReg(inst->VRegA_23x(),
                              shadow_frame.GetVReg(inst->VRegB_23x()) >>
                              (shadow_frame.GetVReg(inst->VRegC_23x()) & 0x1f));
         inst = inst->Next_2xx();
         break;
-      case Instruction::USHR_INT:
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(USHR_INT)
         PREAMBLE();
         shadow_frame.SetVReg(inst->VRegA_23x(),
                              static_cast<uint32_t>(shadow_frame.GetVReg(inst->VRegB_23x())) >>
                              (shadow_frame.GetVReg(inst->VRegC_23x()) & 0x1f));
         inst = inst->Next_2xx();
         break;
-      case Instruction::AND_INT:
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(AND_INT)
         PREAMBLE();
         shadow_frame.SetVReg(inst->VRegA_23x(),
                              shadow_frame.GetVReg(inst->VRegB_23x()) &
                              shadow_frame.GetVReg(inst->VRegC_23x()));
         inst = inst->Next_2xx();
         break;
-      case Instruction::OR_INT:
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(OR_INT)
         PREAMBLE();
         shadow_frame.SetVReg(inst->VRegA_23x(),
                              shadow_frame.GetVReg(inst->VRegB_23x()) |
                              shadow_frame.GetVReg(inst->VRegC_23x()));
         inst = inst->Next_2xx();
         break;
-      case Instruction::XOR_INT:
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(XOR_INT)
         PREAMBLE();
         shadow_frame.SetVReg(inst->VRegA_23x(),
                              shadow_frame.GetVReg(inst->VRegB_23x()) ^
                              shadow_frame.GetVReg(inst->VRegC_23x()));
         inst = inst->Next_2xx();
         break;
-      case Instruction::ADD_LONG:
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(ADD_LONG)
         PREAMBLE();
         shadow_frame.SetVRegLong(inst->VRegA_23x(),
                                  shadow_frame.GetVRegLong(inst->VRegB_23x()) +
                                  shadow_frame.GetVRegLong(inst->VRegC_23x()));
         inst = inst->Next_2xx();
         break;
-      case Instruction::SUB_LONG:
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(SUB_LONG)
         PREAMBLE();
         shadow_frame.SetVRegLong(inst->VRegA_23x(),
                                  shadow_frame.GetVRegLong(inst->VRegB_23x()) -
                                  shadow_frame.GetVRegLong(inst->VRegC_23x()));
         inst = inst->Next_2xx();
         break;
-      case Instruction::MUL_LONG:
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(MUL_LONG)
         PREAMBLE();
         shadow_frame.SetVRegLong(inst->VRegA_23x(),
                                  shadow_frame.GetVRegLong(inst->VRegB_23x()) *
                                  shadow_frame.GetVRegLong(inst->VRegC_23x()));
         inst = inst->Next_2xx();
         break;
-      case Instruction::DIV_LONG:
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(DIV_LONG)
         PREAMBLE();
         DoLongDivide(shadow_frame, inst->VRegA_23x(),
                      shadow_frame.GetVRegLong(inst->VRegB_23x()),
                     shadow_frame.GetVRegLong(inst->VRegC_23x()));
         POSSIBLY_HANDLE_PENDING_EXCEPTION(self->IsExceptionPending(), Next_2xx);
         break;
-      case Instruction::REM_LONG:
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(REM_LONG)
         PREAMBLE();
         DoLongRemainder(shadow_frame, inst->VRegA_23x(),
                         shadow_frame.GetVRegLong(inst->VRegB_23x()),
                         shadow_frame.GetVRegLong(inst->VRegC_23x()));
         POSSIBLY_HANDLE_PENDING_EXCEPTION(self->IsExceptionPending(), Next_2xx);
         break;
-      case Instruction::AND_LONG:
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(AND_LONG)
         PREAMBLE();
         shadow_frame.SetVRegLong(inst->VRegA_23x(),
                                  shadow_frame.GetVRegLong(inst->VRegB_23x()) &
                                  shadow_frame.GetVRegLong(inst->VRegC_23x()));
         inst = inst->Next_2xx();
         break;
-      case Instruction::OR_LONG:
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(OR_LONG)
         PREAMBLE();
         shadow_frame.SetVRegLong(inst->VRegA_23x(),
                                  shadow_frame.GetVRegLong(inst->VRegB_23x()) |
                                  shadow_frame.GetVRegLong(inst->VRegC_23x()));
         inst = inst->Next_2xx();
         break;
-      case Instruction::XOR_LONG:
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(XOR_LONG)
         PREAMBLE();
         shadow_frame.SetVRegLong(inst->VRegA_23x(),
                                  shadow_frame.GetVRegLong(inst->VRegB_23x()) ^
                                  shadow_frame.GetVRegLong(inst->VRegC_23x()));
         inst = inst->Next_2xx();
         break;
-      case Instruction::SHL_LONG:
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(SHL_LONG)
         PREAMBLE();
         shadow_frame.SetVRegLong(inst->VRegA_23x(),
                                  shadow_frame.GetVRegLong(inst->VRegB_23x()) <<
                                  (shadow_frame.GetVReg(inst->VRegC_23x()) & 0x3f));
         inst = inst->Next_2xx();
         break;
-      case Instruction::SHR_LONG:
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(SHR_LONG)
         PREAMBLE();
         shadow_frame.SetVRegLong(inst->VRegA_23x(),
                                  shadow_frame.GetVRegLong(inst->VRegB_23x()) >>
                                  (shadow_frame.GetVReg(inst->VRegC_23x()) & 0x3f));
         inst = inst->Next_2xx();
         break;
-      case Instruction::USHR_LONG:
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(USHR_LONG)
         PREAMBLE();
         shadow_frame.SetVRegLong(inst->VRegA_23x(),
                                  static_cast<uint64_t>(shadow_frame.GetVRegLong(inst->VRegB_23x())) >>
                                  (shadow_frame.GetVReg(inst->VRegC_23x()) & 0x3f));
         inst = inst->Next_2xx();
         break;
-      case Instruction::ADD_FLOAT:
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(ADD_FLOAT)
         PREAMBLE();
         shadow_frame.SetVRegFloat(inst->VRegA_23x(),
                                   shadow_frame.GetVRegFloat(inst->VRegB_23x()) +
                                   shadow_frame.GetVRegFloat(inst->VRegC_23x()));
         inst = inst->Next_2xx();
         break;
-      case Instruction::SUB_FLOAT:
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(SUB_FLOAT)
         PREAMBLE();
         shadow_frame.SetVRegFloat(inst->VRegA_23x(),
                                   shadow_frame.GetVRegFloat(inst->VRegB_23x()) -
                                   shadow_frame.GetVRegFloat(inst->VRegC_23x()));
         inst = inst->Next_2xx();
         break;
-      case Instruction::MUL_FLOAT:
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(MUL_FLOAT)
         PREAMBLE();
         shadow_frame.SetVRegFloat(inst->VRegA_23x(),
                                   shadow_frame.GetVRegFloat(inst->VRegB_23x()) *
                                   shadow_frame.GetVRegFloat(inst->VRegC_23x()));
         inst = inst->Next_2xx();
         break;
-      case Instruction::DIV_FLOAT:
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(DIV_FLOAT)
         PREAMBLE();
         shadow_frame.SetVRegFloat(inst->VRegA_23x(),
                                   shadow_frame.GetVRegFloat(inst->VRegB_23x()) /
                                   shadow_frame.GetVRegFloat(inst->VRegC_23x()));
         inst = inst->Next_2xx();
         break;
-      case Instruction::REM_FLOAT:
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(REM_FLOAT)
         PREAMBLE();
         shadow_frame.SetVRegFloat(inst->VRegA_23x(),
                                   fmodf(shadow_frame.GetVRegFloat(inst->VRegB_23x()),
                                         shadow_frame.GetVRegFloat(inst->VRegC_23x())));
         inst = inst->Next_2xx();
         break;
-      case Instruction::ADD_DOUBLE:
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(ADD_DOUBLE)
         PREAMBLE();
         shadow_frame.SetVRegDouble(inst->VRegA_23x(),
                                    shadow_frame.GetVRegDouble(inst->VRegB_23x()) +
                                    shadow_frame.GetVRegDouble(inst->VRegC_23x()));
         inst = inst->Next_2xx();
         break;
-      case Instruction::SUB_DOUBLE:
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(SUB_DOUBLE)
         PREAMBLE();
         shadow_frame.SetVRegDouble(inst->VRegA_23x(),
                                    shadow_frame.GetVRegDouble(inst->VRegB_23x()) -
                                    shadow_frame.GetVRegDouble(inst->VRegC_23x()));
         inst = inst->Next_2xx();
         break;
-      case Instruction::MUL_DOUBLE:
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(MUL_DOUBLE)
         PREAMBLE();
         shadow_frame.SetVRegDouble(inst->VRegA_23x(),
                                    shadow_frame.GetVRegDouble(inst->VRegB_23x()) *
                                    shadow_frame.GetVRegDouble(inst->VRegC_23x()));
         inst = inst->Next_2xx();
         break;
-      case Instruction::DIV_DOUBLE:
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(DIV_DOUBLE)
         PREAMBLE();
         shadow_frame.SetVRegDouble(inst->VRegA_23x(),
                                    shadow_frame.GetVRegDouble(inst->VRegB_23x()) /
                                    shadow_frame.GetVRegDouble(inst->VRegC_23x()));
         inst = inst->Next_2xx();
         break;
-      case Instruction::REM_DOUBLE:
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(REM_DOUBLE)
         PREAMBLE();
         shadow_frame.SetVRegDouble(inst->VRegA_23x(),
                                    fmod(shadow_frame.GetVRegDouble(inst->VRegB_23x()),
                                         shadow_frame.GetVRegDouble(inst->VRegC_23x())));
         inst = inst->Next_2xx();
         break;
-      case Instruction::ADD_INT_2ADDR: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(ADD_INT_2ADDR) {
         PREAMBLE();
         uint4_t vregA = inst->VRegA_12x();
         shadow_frame.SetVReg(vregA,
@@ -2687,7 +2941,8 @@ static JValue ExecuteImpl(Thread* self, MethodHelper& mh, const DexFile::CodeIte
         inst = inst->Next_1xx();
         break;
       }
-      case Instruction::SUB_INT_2ADDR: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(SUB_INT_2ADDR) {
         PREAMBLE();
         uint4_t vregA = inst->VRegA_12x();
         shadow_frame.SetVReg(vregA,
@@ -2696,7 +2951,8 @@ static JValue ExecuteImpl(Thread* self, MethodHelper& mh, const DexFile::CodeIte
         inst = inst->Next_1xx();
         break;
       }
-      case Instruction::MUL_INT_2ADDR: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(MUL_INT_2ADDR) {
         PREAMBLE();
         uint4_t vregA = inst->VRegA_12x();
         shadow_frame.SetVReg(vregA,
@@ -2705,7 +2961,8 @@ static JValue ExecuteImpl(Thread* self, MethodHelper& mh, const DexFile::CodeIte
         inst = inst->Next_1xx();
         break;
       }
-      case Instruction::DIV_INT_2ADDR: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(DIV_INT_2ADDR) {
         PREAMBLE();
         uint4_t vregA = inst->VRegA_12x();
         bool success = DoIntDivide(shadow_frame, vregA, shadow_frame.GetVReg(vregA),
@@ -2713,7 +2970,8 @@ static JValue ExecuteImpl(Thread* self, MethodHelper& mh, const DexFile::CodeIte
         POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_1xx);
         break;
       }
-      case Instruction::REM_INT_2ADDR: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(REM_INT_2ADDR) {
         PREAMBLE();
         uint4_t vregA = inst->VRegA_12x();
         bool success = DoIntRemainder(shadow_frame, vregA, shadow_frame.GetVReg(vregA),
@@ -2721,7 +2979,8 @@ static JValue ExecuteImpl(Thread* self, MethodHelper& mh, const DexFile::CodeIte
         POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_1xx);
         break;
       }
-      case Instruction::SHL_INT_2ADDR: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(SHL_INT_2ADDR) {
         PREAMBLE();
         uint4_t vregA = inst->VRegA_12x();
         shadow_frame.SetVReg(vregA,
@@ -2730,7 +2989,8 @@ static JValue ExecuteImpl(Thread* self, MethodHelper& mh, const DexFile::CodeIte
         inst = inst->Next_1xx();
         break;
       }
-      case Instruction::SHR_INT_2ADDR: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(SHR_INT_2ADDR) {
         PREAMBLE();
         uint4_t vregA = inst->VRegA_12x();
         shadow_frame.SetVReg(vregA,
@@ -2739,7 +2999,8 @@ static JValue ExecuteImpl(Thread* self, MethodHelper& mh, const DexFile::CodeIte
         inst = inst->Next_1xx();
         break;
       }
-      case Instruction::USHR_INT_2ADDR: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(USHR_INT_2ADDR) {
         PREAMBLE();
         uint4_t vregA = inst->VRegA_12x();
         shadow_frame.SetVReg(vregA,
@@ -2748,7 +3009,8 @@ static JValue ExecuteImpl(Thread* self, MethodHelper& mh, const DexFile::CodeIte
         inst = inst->Next_1xx();
         break;
       }
-      case Instruction::AND_INT_2ADDR: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(AND_INT_2ADDR) {
         PREAMBLE();
         uint4_t vregA = inst->VRegA_12x();
         shadow_frame.SetVReg(vregA,
@@ -2757,7 +3019,8 @@ static JValue ExecuteImpl(Thread* self, MethodHelper& mh, const DexFile::CodeIte
         inst = inst->Next_1xx();
         break;
       }
-      case Instruction::OR_INT_2ADDR: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(OR_INT_2ADDR) {
         PREAMBLE();
         uint4_t vregA = inst->VRegA_12x();
         shadow_frame.SetVReg(vregA,
@@ -2766,7 +3029,8 @@ static JValue ExecuteImpl(Thread* self, MethodHelper& mh, const DexFile::CodeIte
         inst = inst->Next_1xx();
         break;
       }
-      case Instruction::XOR_INT_2ADDR: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(XOR_INT_2ADDR) {
         PREAMBLE();
         uint4_t vregA = inst->VRegA_12x();
         shadow_frame.SetVReg(vregA,
@@ -2775,7 +3039,8 @@ static JValue ExecuteImpl(Thread* self, MethodHelper& mh, const DexFile::CodeIte
         inst = inst->Next_1xx();
         break;
       }
-      case Instruction::ADD_LONG_2ADDR: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(ADD_LONG_2ADDR) {
         PREAMBLE();
         uint4_t vregA = inst->VRegA_12x();
         shadow_frame.SetVRegLong(vregA,
@@ -2784,7 +3049,8 @@ static JValue ExecuteImpl(Thread* self, MethodHelper& mh, const DexFile::CodeIte
         inst = inst->Next_1xx();
         break;
       }
-      case Instruction::SUB_LONG_2ADDR: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(SUB_LONG_2ADDR) {
         PREAMBLE();
         uint4_t vregA = inst->VRegA_12x();
         shadow_frame.SetVRegLong(vregA,
@@ -2793,7 +3059,8 @@ static JValue ExecuteImpl(Thread* self, MethodHelper& mh, const DexFile::CodeIte
         inst = inst->Next_1xx();
         break;
       }
-      case Instruction::MUL_LONG_2ADDR: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(MUL_LONG_2ADDR) {
         PREAMBLE();
         uint4_t vregA = inst->VRegA_12x();
         shadow_frame.SetVRegLong(vregA,
@@ -2802,7 +3069,8 @@ static JValue ExecuteImpl(Thread* self, MethodHelper& mh, const DexFile::CodeIte
         inst = inst->Next_1xx();
         break;
       }
-      case Instruction::DIV_LONG_2ADDR: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(DIV_LONG_2ADDR) {
         PREAMBLE();
         uint4_t vregA = inst->VRegA_12x();
         DoLongDivide(shadow_frame, vregA, shadow_frame.GetVRegLong(vregA),
@@ -2810,7 +3078,8 @@ static JValue ExecuteImpl(Thread* self, MethodHelper& mh, const DexFile::CodeIte
         POSSIBLY_HANDLE_PENDING_EXCEPTION(self->IsExceptionPending(), Next_1xx);
         break;
       }
-      case Instruction::REM_LONG_2ADDR: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(REM_LONG_2ADDR) {
         PREAMBLE();
         uint4_t vregA = inst->VRegA_12x();
         DoLongRemainder(shadow_frame, vregA, shadow_frame.GetVRegLong(vregA),
@@ -2818,7 +3087,8 @@ static JValue ExecuteImpl(Thread* self, MethodHelper& mh, const DexFile::CodeIte
         POSSIBLY_HANDLE_PENDING_EXCEPTION(self->IsExceptionPending(), Next_1xx);
         break;
       }
-      case Instruction::AND_LONG_2ADDR: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(AND_LONG_2ADDR) {
         PREAMBLE();
         uint4_t vregA = inst->VRegA_12x();
         shadow_frame.SetVRegLong(vregA,
@@ -2827,7 +3097,8 @@ static JValue ExecuteImpl(Thread* self, MethodHelper& mh, const DexFile::CodeIte
         inst = inst->Next_1xx();
         break;
       }
-      case Instruction::OR_LONG_2ADDR: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(OR_LONG_2ADDR) {
         PREAMBLE();
         uint4_t vregA = inst->VRegA_12x();
         shadow_frame.SetVRegLong(vregA,
@@ -2836,7 +3107,8 @@ static JValue ExecuteImpl(Thread* self, MethodHelper& mh, const DexFile::CodeIte
         inst = inst->Next_1xx();
         break;
       }
-      case Instruction::XOR_LONG_2ADDR: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(XOR_LONG_2ADDR) {
         PREAMBLE();
         uint4_t vregA = inst->VRegA_12x();
         shadow_frame.SetVRegLong(vregA,
@@ -2845,7 +3117,8 @@ static JValue ExecuteImpl(Thread* self, MethodHelper& mh, const DexFile::CodeIte
         inst = inst->Next_1xx();
         break;
       }
-      case Instruction::SHL_LONG_2ADDR: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(SHL_LONG_2ADDR) {
         PREAMBLE();
         uint4_t vregA = inst->VRegA_12x();
         shadow_frame.SetVRegLong(vregA,
@@ -2854,7 +3127,8 @@ static JValue ExecuteImpl(Thread* self, MethodHelper& mh, const DexFile::CodeIte
         inst = inst->Next_1xx();
         break;
       }
-      case Instruction::SHR_LONG_2ADDR: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(SHR_LONG_2ADDR) {
         PREAMBLE();
         uint4_t vregA = inst->VRegA_12x();
         shadow_frame.SetVRegLong(vregA,
@@ -2863,7 +3137,8 @@ static JValue ExecuteImpl(Thread* self, MethodHelper& mh, const DexFile::CodeIte
         inst = inst->Next_1xx();
         break;
       }
-      case Instruction::USHR_LONG_2ADDR: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(USHR_LONG_2ADDR) {
         PREAMBLE();
         uint4_t vregA = inst->VRegA_12x();
         shadow_frame.SetVRegLong(vregA,
@@ -2872,7 +3147,8 @@ static JValue ExecuteImpl(Thread* self, MethodHelper& mh, const DexFile::CodeIte
         inst = inst->Next_1xx();
         break;
       }
-      case Instruction::ADD_FLOAT_2ADDR: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(ADD_FLOAT_2ADDR) {
         PREAMBLE();
         uint4_t vregA = inst->VRegA_12x();
         shadow_frame.SetVRegFloat(vregA,
@@ -2881,7 +3157,8 @@ static JValue ExecuteImpl(Thread* self, MethodHelper& mh, const DexFile::CodeIte
         inst = inst->Next_1xx();
         break;
       }
-      case Instruction::SUB_FLOAT_2ADDR: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(SUB_FLOAT_2ADDR) {
         PREAMBLE();
         uint4_t vregA = inst->VRegA_12x();
         shadow_frame.SetVRegFloat(vregA,
@@ -2890,7 +3167,8 @@ static JValue ExecuteImpl(Thread* self, MethodHelper& mh, const DexFile::CodeIte
         inst = inst->Next_1xx();
         break;
       }
-      case Instruction::MUL_FLOAT_2ADDR: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(MUL_FLOAT_2ADDR) {
         PREAMBLE();
         uint4_t vregA = inst->VRegA_12x();
         shadow_frame.SetVRegFloat(vregA,
@@ -2899,7 +3177,8 @@ static JValue ExecuteImpl(Thread* self, MethodHelper& mh, const DexFile::CodeIte
         inst = inst->Next_1xx();
         break;
       }
-      case Instruction::DIV_FLOAT_2ADDR: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(DIV_FLOAT_2ADDR) {
         PREAMBLE();
         uint4_t vregA = inst->VRegA_12x();
         shadow_frame.SetVRegFloat(vregA,
@@ -2908,7 +3187,8 @@ static JValue ExecuteImpl(Thread* self, MethodHelper& mh, const DexFile::CodeIte
         inst = inst->Next_1xx();
         break;
       }
-      case Instruction::REM_FLOAT_2ADDR: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(REM_FLOAT_2ADDR) {
         PREAMBLE();
         uint4_t vregA = inst->VRegA_12x();
         shadow_frame.SetVRegFloat(vregA,
@@ -2917,7 +3197,8 @@ static JValue ExecuteImpl(Thread* self, MethodHelper& mh, const DexFile::CodeIte
         inst = inst->Next_1xx();
         break;
       }
-      case Instruction::ADD_DOUBLE_2ADDR: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(ADD_DOUBLE_2ADDR) {
         PREAMBLE();
         uint4_t vregA = inst->VRegA_12x();
         shadow_frame.SetVRegDouble(vregA,
@@ -2926,7 +3207,8 @@ static JValue ExecuteImpl(Thread* self, MethodHelper& mh, const DexFile::CodeIte
         inst = inst->Next_1xx();
         break;
       }
-      case Instruction::SUB_DOUBLE_2ADDR: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(SUB_DOUBLE_2ADDR) {
         PREAMBLE();
         uint4_t vregA = inst->VRegA_12x();
         shadow_frame.SetVRegDouble(vregA,
@@ -2935,7 +3217,8 @@ static JValue ExecuteImpl(Thread* self, MethodHelper& mh, const DexFile::CodeIte
         inst = inst->Next_1xx();
         break;
       }
-      case Instruction::MUL_DOUBLE_2ADDR: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(MUL_DOUBLE_2ADDR) {
         PREAMBLE();
         uint4_t vregA = inst->VRegA_12x();
         shadow_frame.SetVRegDouble(vregA,
@@ -2944,7 +3227,8 @@ static JValue ExecuteImpl(Thread* self, MethodHelper& mh, const DexFile::CodeIte
         inst = inst->Next_1xx();
         break;
       }
-      case Instruction::DIV_DOUBLE_2ADDR: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(DIV_DOUBLE_2ADDR) {
         PREAMBLE();
         uint4_t vregA = inst->VRegA_12x();
         shadow_frame.SetVRegDouble(vregA,
@@ -2953,7 +3237,8 @@ static JValue ExecuteImpl(Thread* self, MethodHelper& mh, const DexFile::CodeIte
         inst = inst->Next_1xx();
         break;
       }
-      case Instruction::REM_DOUBLE_2ADDR: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(REM_DOUBLE_2ADDR) {
         PREAMBLE();
         uint4_t vregA = inst->VRegA_12x();
         shadow_frame.SetVRegDouble(vregA,
@@ -2962,143 +3247,192 @@ static JValue ExecuteImpl(Thread* self, MethodHelper& mh, const DexFile::CodeIte
         inst = inst->Next_1xx();
         break;
       }
-      case Instruction::ADD_INT_LIT16:
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(ADD_INT_LIT16)
         PREAMBLE();
         shadow_frame.SetVReg(inst->VRegA_22s(),
                              shadow_frame.GetVReg(inst->VRegB_22s()) +
                              inst->VRegC_22s());
         inst = inst->Next_2xx();
         break;
-      case Instruction::RSUB_INT:
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(RSUB_INT)
         PREAMBLE();
         shadow_frame.SetVReg(inst->VRegA_22s(),
                              inst->VRegC_22s() -
                              shadow_frame.GetVReg(inst->VRegB_22s()));
         inst = inst->Next_2xx();
         break;
-      case Instruction::MUL_INT_LIT16:
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(MUL_INT_LIT16)
         PREAMBLE();
         shadow_frame.SetVReg(inst->VRegA_22s(),
                              shadow_frame.GetVReg(inst->VRegB_22s()) *
                              inst->VRegC_22s());
         inst = inst->Next_2xx();
         break;
-      case Instruction::DIV_INT_LIT16: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(DIV_INT_LIT16) {
         PREAMBLE();
         bool success = DoIntDivide(shadow_frame, inst->VRegA_22s(),
                                    shadow_frame.GetVReg(inst->VRegB_22s()), inst->VRegC_22s());
         POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_2xx);
         break;
       }
-      case Instruction::REM_INT_LIT16: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(REM_INT_LIT16) {
         PREAMBLE();
         bool success = DoIntRemainder(shadow_frame, inst->VRegA_22s(),
                                       shadow_frame.GetVReg(inst->VRegB_22s()), inst->VRegC_22s());
         POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_2xx);
         break;
       }
-      case Instruction::AND_INT_LIT16:
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(AND_INT_LIT16)
         PREAMBLE();
         shadow_frame.SetVReg(inst->VRegA_22s(),
                              shadow_frame.GetVReg(inst->VRegB_22s()) &
                              inst->VRegC_22s());
         inst = inst->Next_2xx();
         break;
-      case Instruction::OR_INT_LIT16:
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(OR_INT_LIT16)
         PREAMBLE();
         shadow_frame.SetVReg(inst->VRegA_22s(),
                              shadow_frame.GetVReg(inst->VRegB_22s()) |
                              inst->VRegC_22s());
         inst = inst->Next_2xx();
         break;
-      case Instruction::XOR_INT_LIT16:
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(XOR_INT_LIT16)
         PREAMBLE();
         shadow_frame.SetVReg(inst->VRegA_22s(),
                              shadow_frame.GetVReg(inst->VRegB_22s()) ^
                              inst->VRegC_22s());
         inst = inst->Next_2xx();
         break;
-      case Instruction::ADD_INT_LIT8:
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(ADD_INT_LIT8)
         PREAMBLE();
         shadow_frame.SetVReg(inst->VRegA_22b(),
                              shadow_frame.GetVReg(inst->VRegB_22b()) +
                              inst->VRegC_22b());
         inst = inst->Next_2xx();
         break;
-      case Instruction::RSUB_INT_LIT8:
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(RSUB_INT_LIT8)
         PREAMBLE();
         shadow_frame.SetVReg(inst->VRegA_22b(),
                              inst->VRegC_22b() -
                              shadow_frame.GetVReg(inst->VRegB_22b()));
         inst = inst->Next_2xx();
         break;
-      case Instruction::MUL_INT_LIT8:
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(MUL_INT_LIT8)
         PREAMBLE();
         shadow_frame.SetVReg(inst->VRegA_22b(),
                              shadow_frame.GetVReg(inst->VRegB_22b()) *
                              inst->VRegC_22b());
         inst = inst->Next_2xx();
         break;
-      case Instruction::DIV_INT_LIT8: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(DIV_INT_LIT8) {
         PREAMBLE();
         bool success = DoIntDivide(shadow_frame, inst->VRegA_22b(),
                                    shadow_frame.GetVReg(inst->VRegB_22b()), inst->VRegC_22b());
         POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_2xx);
         break;
       }
-      case Instruction::REM_INT_LIT8: {
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(REM_INT_LIT8) {
         PREAMBLE();
         bool success = DoIntRemainder(shadow_frame, inst->VRegA_22b(),
                                       shadow_frame.GetVReg(inst->VRegB_22b()), inst->VRegC_22b());
         POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_2xx);
         break;
       }
-      case Instruction::AND_INT_LIT8:
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(AND_INT_LIT8)
         PREAMBLE();
         shadow_frame.SetVReg(inst->VRegA_22b(),
                              shadow_frame.GetVReg(inst->VRegB_22b()) &
                              inst->VRegC_22b());
         inst = inst->Next_2xx();
         break;
-      case Instruction::OR_INT_LIT8:
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(OR_INT_LIT8)
         PREAMBLE();
         shadow_frame.SetVReg(inst->VRegA_22b(),
                              shadow_frame.GetVReg(inst->VRegB_22b()) |
                              inst->VRegC_22b());
         inst = inst->Next_2xx();
         break;
-      case Instruction::XOR_INT_LIT8:
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(XOR_INT_LIT8)
         PREAMBLE();
         shadow_frame.SetVReg(inst->VRegA_22b(),
                              shadow_frame.GetVReg(inst->VRegB_22b()) ^
                              inst->VRegC_22b());
         inst = inst->Next_2xx();
         break;
-      case Instruction::SHL_INT_LIT8:
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(SHL_INT_LIT8)
         PREAMBLE();
         shadow_frame.SetVReg(inst->VRegA_22b(),
                              shadow_frame.GetVReg(inst->VRegB_22b()) <<
                              (inst->VRegC_22b() & 0x1f));
         inst = inst->Next_2xx();
         break;
-      case Instruction::SHR_INT_LIT8:
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(SHR_INT_LIT8)
         PREAMBLE();
         shadow_frame.SetVReg(inst->VRegA_22b(),
                              shadow_frame.GetVReg(inst->VRegB_22b()) >>
                              (inst->VRegC_22b() & 0x1f));
         inst = inst->Next_2xx();
         break;
-      case Instruction::USHR_INT_LIT8:
+      HANDLE_INSTRUCTION_END();
+      HANDLE_INSTRUCTION_START(USHR_INT_LIT8)
         PREAMBLE();
         shadow_frame.SetVReg(inst->VRegA_22b(),
                              static_cast<uint32_t>(shadow_frame.GetVReg(inst->VRegB_22b())) >>
                              (inst->VRegC_22b() & 0x1f));
         inst = inst->Next_2xx();
         break;
+      HANDLE_INSTRUCTION_END();
       case Instruction::UNUSED_3E ... Instruction::UNUSED_43:
       case Instruction::UNUSED_EB ... Instruction::UNUSED_FF:
       case Instruction::UNUSED_79:
       case Instruction::UNUSED_7A:
+      UNUSED_INSTRUCTION_LABEL(UNUSED_3E)
+      UNUSED_INSTRUCTION_LABEL(UNUSED_3F)
+      UNUSED_INSTRUCTION_LABEL(UNUSED_40)
+      UNUSED_INSTRUCTION_LABEL(UNUSED_41)
+      UNUSED_INSTRUCTION_LABEL(UNUSED_42)
+      UNUSED_INSTRUCTION_LABEL(UNUSED_43)
+      UNUSED_INSTRUCTION_LABEL(UNUSED_79)
+      UNUSED_INSTRUCTION_LABEL(UNUSED_7A)
+      UNUSED_INSTRUCTION_LABEL(UNUSED_EB)
+      UNUSED_INSTRUCTION_LABEL(UNUSED_EC)
+      UNUSED_INSTRUCTION_LABEL(UNUSED_ED)
+      UNUSED_INSTRUCTION_LABEL(UNUSED_EE)
+      UNUSED_INSTRUCTION_LABEL(UNUSED_EF)
+      UNUSED_INSTRUCTION_LABEL(UNUSED_F0)
+      UNUSED_INSTRUCTION_LABEL(UNUSED_F1)
+      UNUSED_INSTRUCTION_LABEL(UNUSED_F2)
+      UNUSED_INSTRUCTION_LABEL(UNUSED_F3)
+      UNUSED_INSTRUCTION_LABEL(UNUSED_F4)
+      UNUSED_INSTRUCTION_LABEL(UNUSED_F5)
+      UNUSED_INSTRUCTION_LABEL(UNUSED_F6)
+      UNUSED_INSTRUCTION_LABEL(UNUSED_F7)
+      UNUSED_INSTRUCTION_LABEL(UNUSED_F8)
+      UNUSED_INSTRUCTION_LABEL(UNUSED_F9)
+      UNUSED_INSTRUCTION_LABEL(UNUSED_FA)
+      UNUSED_INSTRUCTION_LABEL(UNUSED_FB)
+      UNUSED_INSTRUCTION_LABEL(UNUSED_FC)
+      UNUSED_INSTRUCTION_LABEL(UNUSED_FD)
+      UNUSED_INSTRUCTION_LABEL(UNUSED_FE)
+      UNUSED_INSTRUCTION_LABEL(UNUSED_FF)
         UnexpectedOpcode(inst, mh);
     }
   }
@@ -30,6 +30,10 @@
 #include <cutils/ashmem.h>
 #endif
 
+#if (ART_GC_SERVICE)
+#include "gc/service/host_ipc.h"
+#endif
+
 namespace art {
 
 #if !defined(NDEBUG)
@@ -174,7 +178,8 @@ AShmemMap* MemBaseMap::CreateAShmemMap(AShmemMap* ashmem_mem_map,
   // prefixed "dalvik-".
   std::string debug_friendly_name("dalvik-");
   debug_friendly_name += ashmem_name;
-  _fd = ashmem_create_region(debug_friendly_name.c_str(), page_aligned_byte_count);
+  _fd = gc::service::CreateServiceSharedRegion(debug_friendly_name.c_str(),
+                                               page_aligned_byte_count);
   flags = MAP_PRIVATE;
   if(shareFlags) {
     flags = MAP_SHARED;
@@ -265,7 +270,7 @@ AShmemMap* MemBaseMap::ShareAShmemMap(AShmemMap* source_ashmem_mem_map,
   }
 
   int flags = MAP_SHARED | MAP_FIXED;
-  int _fd = ashmem_create_region(source_ashmem_mem_map->name_,
+  int _fd = gc::service::CreateServiceSharedRegion(source_ashmem_mem_map->name_,
       source_ashmem_mem_map->size_);
   if (_fd == -1) {
     PLOG(ERROR) << "ashmem_create_region failed (" << source_ashmem_mem_map->name_ << ")";
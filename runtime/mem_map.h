@@ -95,8 +95,19 @@ struct AtomicStackData {
   // Front index, used for implementing PopFront.
   volatile int32_t front_index_;
 
-  // Maximum number of elements.
-  size_t capacity_;
+  // Maximum number of elements. 32 bits wide so that shared stacks can grow
+  // it with android_atomic_cas.
+  volatile int32_t capacity_;
+
+  // Number of elements reserved in memory_. Shared stacks commit the
+  // reservation one segment at a time when they overflow.
+  size_t reserved_capacity_;
+  size_t segment_capacity_;
+
+  // Deepest back index reached since the last Reset, and the value of
+  // the previous cycle.
+  volatile int32_t peak_depth_;
+  volatile int32_t last_peak_depth_;
 
   // Whether or not the stack is sorted, only updated in debug mode to avoid performance overhead.
   int debug_is_sorted_;
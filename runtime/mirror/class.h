@@ -511,6 +511,10 @@ class MANAGED Class : public StaticStorageBase {
     return MemberOffset(OFFSET_OF_OBJECT_MEMBER(Class, access_flags_));
   }
 
+  static MemberOffset StatusOffset() {
+    return MemberOffset(OFFSET_OF_OBJECT_MEMBER(Class, status_));
+  }
+
   enum {
     kDumpClassFullDetail = 1,
     kDumpClassClassLoader = (1 << 1),
@@ -173,7 +173,12 @@ static void VMRuntime_trimHeap(JNIEnv*, jobject) {
   size_t alloc_space_size = alloc_space->Size();
   float managed_utilization =
       static_cast<float>(alloc_space->GetBytesAllocated()) / alloc_space_size;
-  size_t managed_reclaimed = heap->Trim();
+  // The trim was requested while pause times do not matter, so walking the alloc space to
+  // sample it is fine here. Free pages scattered in short runs are not worth madvising.
+  size_t managed_reclaimed = 0;
+  if (heap->SampleAllocSpaceFragmentation()) {
+    managed_reclaimed = heap->Trim();
+  }
 
   uint64_t gc_heap_end_ns = NanoTime();
 
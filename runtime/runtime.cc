@@ -50,6 +50,7 @@
 #include "image.h"
 #include "instrumentation.h"
 #include "intern_table.h"
+#include "interpreter/inline_cache.h"
 #include "invoke_arg_array_builder.h"
 #include "jni_internal.h"
 #include "mirror/art_field-inl.h"
@@ -67,6 +68,7 @@
 #include "sirt_ref.h"
 #include "thread.h"
 #include "thread_list.h"
+#include "tiered_compiler.h"
 #include "trace.h"
 #include "UniquePtr.h"
 #include "verifier/method_verifier.h"
@@ -97,6 +99,8 @@ Runtime::Runtime()
       monitor_list_(NULL),
       thread_list_(NULL),
       intern_table_(NULL),
+      inline_cache_table_(NULL),
+      tiered_compiler_(NULL),
       class_linker_(NULL),
       signal_catcher_(NULL),
       java_vm_(NULL),
@@ -140,6 +144,7 @@ Runtime::~Runtime() {
   // Make sure to let the GC complete if it is running.
   heap_->WaitForConcurrentGcToComplete(self, true);
   heap_->DeleteThreadPool();
+  delete tiered_compiler_;
 
   // Make sure our internal threads are dead before we start tearing down things they're using.
   Dbg::StopJdwp();
@@ -151,6 +156,7 @@ Runtime::~Runtime() {
   delete class_linker_;
   delete heap_;
   delete intern_table_;
+  delete inline_cache_table_;
   delete java_vm_;
   Thread::Shutdown();
   QuasiAtomic::Shutdown();
@@ -507,6 +513,11 @@ Runtime::ParsedOptions* Runtime::ParsedOptions::Create(const Options& options, b
   parsed->num_dex_methods_threshold_ = Runtime::kDefaultNumDexMethodsThreshold;
 
   parsed->sea_ir_mode_ = false;
+  parsed->linear_scan_mode_ = false;
+  parsed->gvn_licm_mode_ = false;
+  parsed->tiered_ = false;
+  parsed->tiered_threshold_ = TieredCompiler::kDefaultHotnessThreshold;
+  parsed->tiered_code_cache_size_ = TieredCompiler::kDefaultCodeCacheCapacity;
 //  gLogVerbosity.class_linker = true;  // TODO: don't check this in!
 //  gLogVerbosity.compiler = true;  // TODO: don't check this in!
 //  gLogVerbosity.verifier = true;  // TODO: don't check this in!
@@ -662,6 +673,25 @@ Runtime::ParsedOptions* Runtime::ParsedOptions::Create(const Options& options, b
       parsed->is_zygote_ = true;
     } else if (option == "-Xint") {
       parsed->interpreter_only_ = true;
+    } else if (option == "-Xtiered") {
+      parsed->tiered_ = true;
+    } else if (StartsWith(option, "-Xtieredthreshold:")) {
+      parsed->tiered_threshold_ = ParseIntegerOrDie(option);
+      if (parsed->tiered_threshold_ == 0) {
+        LOG(FATAL) << "Invalid tiered threshold: " << option;
+      }
+    } else if (StartsWith(option, "-Xtieredcodecachesize:")) {
+      size_t size =
+          ParseMemoryOption(option.substr(strlen("-Xtieredcodecachesize:")).c_str(), 1024);
+      if (size == 0) {
+        if (ignore_unrecognized) {
+          continue;
+        }
+        // TODO: usage
+        LOG(FATAL) << "Failed to parse " << option;
+        return NULL;
+      }
+      parsed->tiered_code_cache_size_ = size;
     } else if (StartsWith(option, "-Xgc:")) {
       std::vector<std::string> gc_options;
       Split(option.substr(strlen("-Xgc:")), ',', gc_options);
@@ -756,6 +786,10 @@ Runtime::ParsedOptions* Runtime::ParsedOptions::Create(const Options& options, b
       parsed->compiler_filter_ = kEverything;
     } else if (option == "-sea_ir") {
       parsed->sea_ir_mode_ = true;
+    } else if (option == "-linear-scan") {
+      parsed->linear_scan_mode_ = true;
+    } else if (option == "-gvn-licm") {
+      parsed->gvn_licm_mode_ = true;
     } else if (StartsWith(option, "-huge-method-max:")) {
       parsed->huge_method_threshold_ = ParseIntegerOrDie(option);
     } else if (StartsWith(option, "-large-method-max:")) {
@@ -1042,6 +1076,8 @@ bool Runtime::Init(const Options& raw_options, bool ignore_unrecognized) {
   num_dex_methods_threshold_ = options->num_dex_methods_threshold_;
 
   sea_ir_mode_ = options->sea_ir_mode_;
+  linear_scan_mode_ = options->linear_scan_mode_;
+  gvn_licm_mode_ = options->gvn_licm_mode_;
   vfprintf_ = options->hook_vfprintf_;
   exit_ = options->hook_exit_;
   abort_ = options->hook_abort_;
@@ -1052,7 +1088,16 @@ bool Runtime::Init(const Options& raw_options, bool ignore_unrecognized) {
   monitor_list_ = new MonitorList;
   thread_list_ = new ThreadList;
   intern_table_ = new InternTable;
-
+  inline_cache_table_ = new interpreter::InlineCacheTable;
+  if (options->tiered_ && !options->interpreter_only_ && !options->is_compiler_) {
+    tiered_compiler_ = new TieredCompiler(options->tiered_threshold_,
+                                          options->tiered_code_cache_size_);
+    if (!tiered_compiler_->LoadCompiler()) {
+      LOG(WARNING) << "Tiered compilation disabled";
+      delete tiered_compiler_;
+      tiered_compiler_ = NULL;
+    }
+  }
 
   if (options->interpreter_only_) {
     GetInstrumentation()->ForceInterpretOnly();
@@ -1217,9 +1262,18 @@ void Runtime::RegisterRuntimeNativeMethods(JNIEnv* env) {
 #undef REGISTER
 }
 
+void Runtime::SetTieredCompiler(TieredCompiler* tiered_compiler) {
+  delete tiered_compiler_;
+  tiered_compiler_ = tiered_compiler;
+}
+
 void Runtime::DumpForSigQuit(std::ostream& os) {
   GetClassLinker()->DumpForSigQuit(os);
   GetInternTable()->DumpForSigQuit(os);
+  GetInlineCacheTable()->DumpForSigQuit(os);
+  if (tiered_compiler_ != NULL) {
+    tiered_compiler_->DumpForSigQuit(os);
+  }
   GetJavaVM()->DumpForSigQuit(os);
   GetHeap()->DumpForSigQuit(os);
   os << "\n";
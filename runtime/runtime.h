@@ -60,10 +60,14 @@ namespace mirror {
 class ClassLinker;
 class DexFile;
 class InternTable;
+namespace interpreter {
+  class InlineCacheTable;
+}  // namespace interpreter
 struct JavaVMExt;
 class MonitorList;
 class SignalCatcher;
 class ThreadList;
+class TieredCompiler;
 class Trace;
 
 class Runtime {
@@ -137,6 +141,11 @@ class Runtime {
     size_t tiny_method_threshold_;
     size_t num_dex_methods_threshold_;
     bool sea_ir_mode_;
+    bool linear_scan_mode_;
+    bool gvn_licm_mode_;
+    bool tiered_;
+    size_t tiered_threshold_;
+    size_t tiered_code_cache_size_;
 
 
     mprofiler::GCMMP_Options vmprofiler_options_;
@@ -177,6 +186,22 @@ class Runtime {
     sea_ir_mode_ = sea_ir_mode;
   }
 
+  // Quick promotes Dalvik registers by linear scan over their live ranges
+  // instead of by use counts.
+  bool IsLinearScanMode() const {
+    return linear_scan_mode_;
+  }
+
+  // The MIR optimizer numbers values across the dominator tree and hoists
+  // loop invariant code before handing methods to Quick.
+  bool IsGvnLicmMode() const {
+    return gvn_licm_mode_;
+  }
+
+  void SetGvnLicmMode(bool gvn_licm_mode) {
+    gvn_licm_mode_ = gvn_licm_mode;
+  }
+
   CompilerFilter GetCompilerFilter() const {
     return compiler_filter_;
   }
@@ -298,6 +323,18 @@ class Runtime {
     return intern_table_;
   }
 
+  interpreter::InlineCacheTable* GetInlineCacheTable() const {
+    return inline_cache_table_;
+  }
+
+  // NULL unless hot methods of the interpreter are handed to Quick (-Xtiered).
+  TieredCompiler* GetTieredCompiler() const {
+    return tiered_compiler_;
+  }
+
+  // Takes ownership of tiered_compiler.
+  void SetTieredCompiler(TieredCompiler* tiered_compiler);
+
   JavaVMExt* GetJavaVM() const {
     return java_vm_;
   }
@@ -454,6 +491,10 @@ class Runtime {
 
   bool sea_ir_mode_;
 
+  bool linear_scan_mode_;
+
+  bool gvn_licm_mode_;
+
   // The host prefix is used during cross compilation. It is removed
   // from the start of host paths such as:
   //    $ANDROID_PRODUCT_OUT/system/framework/boot.oat
@@ -481,6 +522,10 @@ class Runtime {
 
   InternTable* intern_table_;
 
+  interpreter::InlineCacheTable* inline_cache_table_;
+
+  TieredCompiler* tiered_compiler_;
+
   ClassLinker* class_linker_;
 
   SignalCatcher* signal_catcher_;
@@ -42,6 +42,7 @@
 #include "gc_map.h"
 #include "gc/accounting/card_table-inl.h"
 #include "gc/heap.h"
+#include "gc/space/dlmalloc_tlab.h"
 #include "gc/space/space.h"
 #include "invoke_arg_array_builder.h"
 #include "jni_internal.h"
@@ -1002,7 +1003,8 @@ Thread::Thread(bool daemon)
       no_thread_suspension_(0),
       last_no_thread_suspension_cause_(NULL),
       checkpoint_function_(0),
-      thread_exit_check_count_(0) {
+      thread_exit_check_count_(0),
+      dlmalloc_tlab_(NULL) {
   CHECK_EQ((sizeof(Thread) % 4), 0U) << sizeof(Thread);
   state_and_flags_.as_struct.flags = 0;
   state_and_flags_.as_struct.state = kNative;
@@ -1068,6 +1070,14 @@ void Thread::Destroy() {
   if (jni_env_ != NULL) {
     jni_env_->monitors.VisitRoots(MonitorExitVisitor, self);
   }
+
+  // Record the objects of our TLAB and hand its chunks back before we are unregistered.
+  if (dlmalloc_tlab_ != NULL) {
+    ScopedObjectAccess soa(self);
+    gc::Heap* heap = Runtime::Current()->GetHeap();
+    heap->FlushThreadLocalAllocationRecords(self);
+    heap->RevokeThreadLocalBuffers(self);
+  }
 }
 
 Thread::~Thread() {
@@ -1096,6 +1106,7 @@ Thread::~Thread() {
   delete instrumentation_stack_;
   delete name_;
   delete stack_trace_sample_;
+  delete dlmalloc_tlab_;
 
   TearDownAlternateSignalStack();
 }
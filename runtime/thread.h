@@ -50,6 +50,12 @@ namespace mprofiler {
 	class GCMMPThreadProf;
 }  // namespace mprofiler
 
+namespace gc {
+namespace space {
+  class DlMallocTlab;
+}  // namespace space
+}  // namespace gc
+
 namespace mirror {
   class ArtMethod;
   class Array;
@@ -838,7 +844,18 @@ class PACKED(4) Thread {
 
   void MarkStartSuspensionTime(ThreadState);
   void MarkStartEndSuspensionTime(ThreadState);
+
+  gc::space::DlMallocTlab* GetDlMallocTlab() const {
+    return dlmalloc_tlab_;
+  }
+
+  void SetDlMallocTlab(gc::space::DlMallocTlab* tlab) {
+    dlmalloc_tlab_ = tlab;
+  }
 private:
+  // Thread-local allocation buffer of the alloc space, created on the first small allocation.
+  gc::space::DlMallocTlab* dlmalloc_tlab_;
+
   DISALLOW_COPY_AND_ASSIGN(Thread);
 };
 
@@ -0,0 +1,233 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <dlfcn.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include <ostream>
+
+#include "tiered_compiler.h"
+#include "cutils/atomic-inline.h"
+#include "instrumentation.h"
+#include "interpreter/interpreter.h"
+#include "mirror/art_method-inl.h"
+#include "mirror/class-inl.h"
+#include "runtime.h"
+#include "scoped_thread_state_change.h"
+#include "thread.h"
+#include "thread_pool.h"
+#include "utils.h"
+
+namespace art {
+
+const uint32_t TieredCompiler::kDefaultHotnessThreshold;
+const size_t TieredCompiler::kDefaultCodeCacheCapacity;
+
+// Alignment of the code committed to the code cache.
+static const size_t kCodeAlignment = 16;
+
+class TieredCompileTask : public Task {
+ public:
+  TieredCompileTask(TieredCompiler* tiered, mirror::ArtMethod* method)
+      : tiered_(tiered), method_(method) {
+  }
+
+  virtual void Run(Thread* self) {
+    tiered_->Compile(self, method_);
+  }
+
+  virtual void Finalize() {
+    delete this;
+  }
+
+ private:
+  TieredCompiler* const tiered_;
+  mirror::ArtMethod* const method_;
+};
+
+
+TieredCompiler::TieredCompiler(uint32_t hotness_threshold, size_t code_cache_capacity)
+    : hotness_threshold_(hotness_threshold),
+      compile_fn_(NULL),
+      compiler_library_(NULL),
+      compiler_context_(NULL),
+      lock_("tiered compiler lock"),
+      code_cache_used_(0),
+      code_cache_full_(false),
+      compiled_count_(0),
+      failed_count_(0) {
+  CHECK_GT(hotness_threshold, 0U);
+  code_cache_.reset(MemMap::MapAnonymous("tiered code cache", NULL,
+                                         RoundUp(code_cache_capacity, kPageSize),
+                                         PROT_READ | PROT_WRITE | PROT_EXEC));
+  if (code_cache_.get() == NULL) {
+    LOG(WARNING) << "Tiered compiler: cannot map a code cache of "
+                 << PrettySize(code_cache_capacity);
+    code_cache_full_ = true;
+  }
+}
+
+
+TieredCompiler::~TieredCompiler() {
+  // Joins the compile thread before the code cache goes away.
+  // The compiler library stays loaded, like the JNI libraries.
+  thread_pool_.reset();
+}
+
+
+bool TieredCompiler::LoadCompiler() {
+#if defined(ART_USE_PORTABLE_COMPILER)
+  // The code cache only takes position independent Quick code.
+  return false;
+#else
+  const char* library = kIsDebugBuild ? "libartd-compiler.so" : "libart-compiler.so";
+  compiler_library_ = dlopen(library, RTLD_LAZY);
+  if (compiler_library_ == NULL) {
+    LOG(WARNING) << "Tiered compiler: cannot load " << library << ": " << dlerror();
+    return false;
+  }
+  compile_fn_ = reinterpret_cast<TieredCompileFn*>(dlsym(compiler_library_,
+                                                         "ArtTieredCompileMethod"));
+  if (compile_fn_ == NULL) {
+    LOG(WARNING) << "Tiered compiler: cannot find ArtTieredCompileMethod: " << dlerror();
+    return false;
+  }
+  return true;
+#endif
+}
+
+
+void TieredCompiler::MethodIsHot(Thread* self, mirror::ArtMethod* method) {
+  if (compile_fn_ == NULL) {
+    return;
+  }
+  Runtime* runtime = Runtime::Current();
+  // Threads do not survive the fork of the zygote.
+  if (runtime->IsZygote() || runtime->GetInstrumentation()->InterpretOnly()) {
+    return;
+  }
+  // Static methods keep the resolution trampoline until their class is
+  // initialized, and class initializers run once.
+  if (method->IsStatic() &&
+      (method->IsConstructor() || !method->GetDeclaringClass()->IsInitialized())) {
+    return;
+  }
+  // The compile thread is started by the first hot method; creating it waits
+  // for the thread to attach, which must not happen while runnable.
+  ScopedThreadStateChange tsc(self, kNative);
+  MutexLock mu(self, lock_);
+  if (code_cache_full_ || !methods_.insert(method).second) {
+    return;
+  }
+  if (thread_pool_.get() == NULL) {
+    thread_pool_.reset(new ThreadPool(1));
+    thread_pool_->StartWorkers(self);
+  }
+  thread_pool_->AddTask(self, new TieredCompileTask(this, method));
+}
+
+
+void TieredCompiler::Compile(Thread* self, mirror::ArtMethod* method) {
+  TieredCode code;
+  memset(&code, 0, sizeof(code));
+  bool compiled = compile_fn_(this, self, method, &code);
+  if (compiled) {
+    ScopedObjectAccess soa(self);
+    if (Runtime::Current()->GetInstrumentation()->InterpretOnly()) {
+      // A debugger attached while compiling.
+      compiled = false;
+    } else {
+      LinkCode(method, code);
+    }
+  }
+  MutexLock mu(self, lock_);
+  if (compiled) {
+    compiled_count_++;
+  } else {
+    failed_count_++;
+  }
+}
+
+
+void TieredCompiler::LinkCode(mirror::ArtMethod* method, const TieredCode& code) {
+  method->SetFrameSizeInBytes(code.frame_size_in_bytes_);
+  method->SetCoreSpillMask(code.core_spill_mask_);
+  method->SetFpSpillMask(code.fp_spill_mask_);
+  method->SetMappingTable(code.mapping_table_);
+  method->SetVmapTable(code.vmap_table_);
+  method->SetNativeGcMap(code.gc_map_);
+  ANDROID_MEMBAR_STORE();
+  method->SetEntryPointFromInterpreter(artInterpreterToCompiledCodeBridge);
+  Runtime::Current()->GetInstrumentation()->UpdateMethodsCode(method, code.code_);
+}
+
+
+const void* TieredCompiler::CommitCode(const uint8_t* code, size_t size) {
+  MutexLock mu(Thread::Current(), lock_);
+  if (code_cache_full_) {
+    return NULL;
+  }
+  size_t offset = RoundUp(code_cache_used_, kCodeAlignment);
+  if (offset + size > code_cache_->Size()) {
+    LOG(INFO) << "Tiered compiler: code cache full after " << compiled_count_ << " methods";
+    code_cache_full_ = true;
+    return NULL;
+  }
+  uint8_t* begin = code_cache_->Begin() + offset;
+  memcpy(begin, code, size);
+  __builtin___clear_cache(reinterpret_cast<char*>(begin), reinterpret_cast<char*>(begin + size));
+  code_cache_used_ = offset + size;
+  return begin;
+}
+
+
+void TieredCompiler::WaitForCompilations(Thread* self) {
+  ThreadPool* thread_pool;
+  {
+    MutexLock mu(self, lock_);
+    thread_pool = thread_pool_.get();
+  }
+  if (thread_pool != NULL) {
+    // The compile thread needs the mutator lock to link the methods it compiles.
+    ScopedThreadStateChange tsc(self, kNative);
+    thread_pool->Wait(self, false, false);
+  }
+}
+
+
+size_t TieredCompiler::GetCompiledCount() {
+  MutexLock mu(Thread::Current(), lock_);
+  return compiled_count_;
+}
+
+
+size_t TieredCompiler::GetFailedCount() {
+  MutexLock mu(Thread::Current(), lock_);
+  return failed_count_;
+}
+
+
+void TieredCompiler::DumpForSigQuit(std::ostream& os) {
+  MutexLock mu(Thread::Current(), lock_);
+  os << "Tiered compiler: " << compiled_count_ << " methods compiled; " << failed_count_
+     << " failed; " << (methods_.size() - compiled_count_ - failed_count_) << " queued; code cache "
+     << PrettySize(code_cache_used_) << "/"
+     << PrettySize(code_cache_.get() == NULL ? 0 : code_cache_->Size())
+     << (code_cache_full_ ? " (full)" : "") << "\n";
+}
+
+}  // namespace art
@@ -0,0 +1,143 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_RUNTIME_TIERED_COMPILER_H_
+#define ART_RUNTIME_TIERED_COMPILER_H_
+
+#include <stdint.h>
+
+#include <iosfwd>
+#include <set>
+
+#include "base/macros.h"
+#include "base/mutex.h"
+#include "globals.h"
+#include "mem_map.h"
+#include "UniquePtr.h"
+
+namespace art {
+namespace mirror {
+  class ArtMethod;
+}  // namespace mirror
+class Thread;
+class ThreadPool;
+class TieredCompiler;
+
+// Code of a method compiled at runtime and the tables the stack walks need.
+struct TieredCode {
+  const void* code_;
+  size_t frame_size_in_bytes_;
+  uint32_t core_spill_mask_;
+  uint32_t fp_spill_mask_;
+  const uint8_t* mapping_table_;
+  const uint8_t* vmap_table_;
+  const uint8_t* gc_map_;
+};
+
+// Compiles method with the Quick backend and commits its code to the code
+// cache of tiered. Called on the compile thread, in the native state.
+typedef bool (TieredCompileFn)(TieredCompiler* tiered, Thread* self, mirror::ArtMethod* method,
+                               TieredCode* result);
+
+/*
+ * Hand-off of hot methods from the interpreter to the Quick backend for apps
+ * installed with the interpret-only filter. The interpreter counts the
+ * invocations and the backward branches of the preverified methods it runs
+ * and reports a method once its count reaches the hotness threshold. Hot
+ * methods are queued to a single compile thread that runs the Quick path of
+ * libart-compiler through TieredCompileFn, copies the code into a code cache
+ * of a fixed capacity and switches the entry points of the method to it.
+ * Invocations that already started stay in the interpreter, and so do the
+ * methods the DEX-to-DEX pass quickened, which the Quick backend rejects.
+ * Once the code cache is full no more methods are compiled.
+ */
+class TieredCompiler {
+ public:
+  static const uint32_t kDefaultHotnessThreshold = 10000;
+  static const size_t kDefaultCodeCacheCapacity = 2 * MB;
+
+  TieredCompiler(uint32_t hotness_threshold, size_t code_cache_capacity);
+  ~TieredCompiler();
+
+  // Looks the compiler up in libart-compiler; false leaves methods interpreted.
+  bool LoadCompiler();
+
+  void SetCompileFn(TieredCompileFn* compile_fn) {
+    compile_fn_ = compile_fn;
+  }
+
+  // State of the compiler library, only used on the compile thread. It lives
+  // as long as the runtime: the methods linked hold tables it owns.
+  void* GetCompilerContext() const {
+    return compiler_context_;
+  }
+
+  void SetCompilerContext(void* compiler_context) {
+    compiler_context_ = compiler_context;
+  }
+
+  uint32_t GetHotnessThreshold() const {
+    return hotness_threshold_;
+  }
+
+  // Queues method unless it was queued before or the code cache is full.
+  void MethodIsHot(Thread* self, mirror::ArtMethod* method)
+      LOCKS_EXCLUDED(lock_)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  // Copies code into the code cache; NULL once the cache is full.
+  const void* CommitCode(const uint8_t* code, size_t size) LOCKS_EXCLUDED(lock_);
+
+  // Waits for the queued methods to be compiled, in the native state.
+  void WaitForCompilations(Thread* self) LOCKS_EXCLUDED(lock_);
+
+  size_t GetCompiledCount() LOCKS_EXCLUDED(lock_);
+
+  // Methods that did not verify or that the backend declined.
+  size_t GetFailedCount() LOCKS_EXCLUDED(lock_);
+
+  void DumpForSigQuit(std::ostream& os) LOCKS_EXCLUDED(lock_);
+
+ private:
+  void Compile(Thread* self, mirror::ArtMethod* method) LOCKS_EXCLUDED(lock_);
+
+  // Publishes the code after the tables so that a thread entering the code
+  // finds the frame layout.
+  static void LinkCode(mirror::ArtMethod* method, const TieredCode& code)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  const uint32_t hotness_threshold_;
+  TieredCompileFn* compile_fn_;
+  void* compiler_library_;
+  void* compiler_context_;
+
+  Mutex lock_;
+  // Methods queued, compiled or that failed to compile.
+  std::set<const mirror::ArtMethod*> methods_ GUARDED_BY(lock_);
+  UniquePtr<ThreadPool> thread_pool_;
+  UniquePtr<MemMap> code_cache_;
+  size_t code_cache_used_ GUARDED_BY(lock_);
+  bool code_cache_full_ GUARDED_BY(lock_);
+  size_t compiled_count_ GUARDED_BY(lock_);
+  size_t failed_count_ GUARDED_BY(lock_);
+
+  friend class TieredCompileTask;
+  DISALLOW_COPY_AND_ASSIGN(TieredCompiler);
+};
+
+}  // namespace art
+
+#endif  // ART_RUNTIME_TIERED_COMPILER_H_
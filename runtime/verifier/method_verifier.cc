@@ -307,11 +307,22 @@ MethodVerifier::MethodVerifier(const DexFile* dex_file, mirror::DexCache* dex_ca
       monitor_enter_count_(0),
       can_load_classes_(can_load_classes),
       allow_soft_failures_(allow_soft_failures),
+      record_compiler_info_(Runtime::Current()->IsCompiler()),
       has_check_casts_(false),
       has_virtual_or_interface_invokes_(false) {
   DCHECK(class_def != NULL);
 }
 
+bool MethodVerifier::VerifyMethodForCompilation(mirror::ArtMethod* method) {
+  DCHECK(records_compiler_info_);
+  MethodHelper mh(method);
+  MethodVerifier verifier(&mh.GetDexFile(), mh.GetDexCache(), mh.GetClassLoader(),
+                          &mh.GetClassDef(), mh.GetCodeItem(), method->GetDexMethodIndex(),
+                          method, method->GetAccessFlags(), false, false);
+  verifier.record_compiler_info_ = true;
+  return verifier.Verify() && verifier.failures_.empty();
+}
+
 void MethodVerifier::FindLocksAtDexPc(mirror::ArtMethod* m, uint32_t dex_pc,
                                       std::vector<uint32_t>& monitor_enter_dex_pcs) {
   MethodHelper mh(m);
@@ -1052,9 +1063,11 @@ bool MethodVerifier::VerifyCodeFlow() {
   }
 
   // Compute information for compiler.
-  if (Runtime::Current()->IsCompiler()) {
+  if (record_compiler_info_) {
     MethodReference ref(dex_file_, dex_method_idx_);
-    bool compile = IsCandidateForCompilation(ref, method_access_flags_);
+    // Outside the compiler only the hot methods of the tiered compiler get here.
+    bool compile = !Runtime::Current()->IsCompiler() ||
+        IsCandidateForCompilation(ref, method_access_flags_);
     if (compile) {
       /* Generate a register map and add it to the method. */
       UniquePtr<const std::vector<uint8_t> > map(GenerateGcMap());
@@ -4076,7 +4089,7 @@ void MethodVerifier::VerifyGcMap(const std::vector<uint8_t>& data) {
 }
 
 void MethodVerifier::SetDexGcMap(MethodReference ref, const std::vector<uint8_t>& gc_map) {
-  DCHECK(Runtime::Current()->IsCompiler());
+  DCHECK(records_compiler_info_);
   {
     WriterMutexLock mu(Thread::Current(), *dex_gc_maps_lock_);
     DexGcMapTable::iterator it = dex_gc_maps_->find(ref);
@@ -4091,7 +4104,7 @@ void MethodVerifier::SetDexGcMap(MethodReference ref, const std::vector<uint8_t>
 
 
 void  MethodVerifier::SetSafeCastMap(MethodReference ref, const MethodSafeCastSet* cast_set) {
-  DCHECK(Runtime::Current()->IsCompiler());
+  DCHECK(records_compiler_info_);
   WriterMutexLock mu(Thread::Current(), *safecast_map_lock_);
   SafeCastMap::iterator it = safecast_map_->find(ref);
   if (it != safecast_map_->end()) {
@@ -4103,7 +4116,7 @@ void  MethodVerifier::SetSafeCastMap(MethodReference ref, const MethodSafeCastSe
 }
 
 bool MethodVerifier::IsSafeCast(MethodReference ref, uint32_t pc) {
-  DCHECK(Runtime::Current()->IsCompiler());
+  DCHECK(records_compiler_info_);
   ReaderMutexLock mu(Thread::Current(), *safecast_map_lock_);
   SafeCastMap::const_iterator it = safecast_map_->find(ref);
   if (it == safecast_map_->end()) {
@@ -4116,7 +4129,7 @@ bool MethodVerifier::IsSafeCast(MethodReference ref, uint32_t pc) {
 }
 
 const std::vector<uint8_t>* MethodVerifier::GetDexGcMap(MethodReference ref) {
-  DCHECK(Runtime::Current()->IsCompiler());
+  DCHECK(records_compiler_info_);
   ReaderMutexLock mu(Thread::Current(), *dex_gc_maps_lock_);
   DexGcMapTable::const_iterator it = dex_gc_maps_->find(ref);
   CHECK(it != dex_gc_maps_->end())
@@ -4127,7 +4140,7 @@ const std::vector<uint8_t>* MethodVerifier::GetDexGcMap(MethodReference ref) {
 
 void  MethodVerifier::SetDevirtMap(MethodReference ref,
                                    const PcToConcreteMethodMap* devirt_map) {
-  DCHECK(Runtime::Current()->IsCompiler());
+  DCHECK(records_compiler_info_);
   WriterMutexLock mu(Thread::Current(), *devirt_maps_lock_);
   DevirtualizationMapTable::iterator it = devirt_maps_->find(ref);
   if (it != devirt_maps_->end()) {
@@ -4141,7 +4154,7 @@ void  MethodVerifier::SetDevirtMap(MethodReference ref,
 
 const MethodReference* MethodVerifier::GetDevirtMap(const MethodReference& ref,
                                                                     uint32_t dex_pc) {
-  DCHECK(Runtime::Current()->IsCompiler());
+  DCHECK(records_compiler_info_);
   ReaderMutexLock mu(Thread::Current(), *devirt_maps_lock_);
   DevirtualizationMapTable::const_iterator it = devirt_maps_->find(ref);
   if (it == devirt_maps_->end()) {
@@ -4229,8 +4242,12 @@ MethodVerifier::DevirtualizationMapTable* MethodVerifier::devirt_maps_ = NULL;
 ReaderWriterMutex* MethodVerifier::rejected_classes_lock_ = NULL;
 MethodVerifier::RejectedClassesTable* MethodVerifier::rejected_classes_ = NULL;
 
+bool MethodVerifier::records_compiler_info_ = false;
+
 void MethodVerifier::Init() {
-  if (Runtime::Current()->IsCompiler()) {
+  Runtime* runtime = Runtime::Current();
+  records_compiler_info_ = runtime->IsCompiler() || runtime->GetTieredCompiler() != NULL;
+  if (records_compiler_info_) {
     dex_gc_maps_lock_ = new ReaderWriterMutex("verifier GC maps lock");
     Thread* self = Thread::Current();
     {
@@ -4261,7 +4278,7 @@ void MethodVerifier::Init() {
 }
 
 void MethodVerifier::Shutdown() {
-  if (Runtime::Current()->IsCompiler()) {
+  if (records_compiler_info_) {
     Thread* self = Thread::Current();
     {
       WriterMutexLock mu(self, *dex_gc_maps_lock_);
@@ -4302,7 +4319,7 @@ void MethodVerifier::Shutdown() {
 }
 
 void MethodVerifier::AddRejectedClass(ClassReference ref) {
-  DCHECK(Runtime::Current()->IsCompiler());
+  DCHECK(records_compiler_info_);
   {
     WriterMutexLock mu(Thread::Current(), *rejected_classes_lock_);
     rejected_classes_->insert(ref);
@@ -4311,7 +4328,7 @@ void MethodVerifier::AddRejectedClass(ClassReference ref) {
 }
 
 bool MethodVerifier::IsClassRejected(ClassReference ref) {
-  DCHECK(Runtime::Current()->IsCompiler());
+  DCHECK(records_compiler_info_);
   ReaderMutexLock mu(Thread::Current(), *rejected_classes_lock_);
   return (rejected_classes_->find(ref) != rejected_classes_->end());
 }
@@ -197,6 +197,11 @@ class MethodVerifier {
   // by using the check-cast elision peephole optimization in the verifier
   static bool IsSafeCast(MethodReference ref, uint32_t pc) LOCKS_EXCLUDED(safecast_map_lock_);
 
+  // Verifies 'method' of a running app again for the tiered compiler, recording the maps the
+  // compiler reads. Returns false if the method has any verification failure.
+  static bool VerifyMethodForCompilation(mirror::ArtMethod* method)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
   // Fills 'monitor_enter_dex_pcs' with the dex pcs of the monitor-enter instructions corresponding
   // to the locks held at 'dex_pc' in method 'm'.
   static void FindLocksAtDexPc(mirror::ArtMethod* m, uint32_t dex_pc,
@@ -667,6 +672,9 @@ class MethodVerifier {
   static ReaderWriterMutex* rejected_classes_lock_ DEFAULT_MUTEX_ACQUIRED_AFTER;
   static RejectedClassesTable* rejected_classes_ GUARDED_BY(rejected_classes_lock_);
 
+  // Whether the maps above exist: in the compiler and with a tiered compiler.
+  static bool records_compiler_info_;
+
   static void AddRejectedClass(ClassReference ref)
       LOCKS_EXCLUDED(rejected_classes_lock_);
 
@@ -729,6 +737,9 @@ class MethodVerifier {
   // running and the verifier is called from the class linker.
   const bool allow_soft_failures_;
 
+  // Records the GC, safe cast and devirtualization maps of the method when it verifies.
+  bool record_compiler_info_;
+
   // Indicates if the method being verified contains at least one check-cast instruction.
   bool has_check_casts_;
 
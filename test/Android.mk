@@ -25,7 +25,9 @@ TEST_DEX_DIRECTORIES := \
 	AllFields \
 	CreateMethodSignature \
 	ExceptionHandle \
+	HotLoop \
 	Interfaces \
+	LoopInvariants \
 	Main \
 	MyClass \
 	MyClassNatives \
@@ -0,0 +1,36 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Test case for the tiered compiler: sum gets hot in the interpreter through
+// its backward branch.
+class HotLoop {
+  static int sum(int n) {
+    int result = 0;
+    for (int i = 0; i < n; i++) {
+      result += i;
+    }
+    return result;
+  }
+
+  int total;
+
+  // Quickened before it gets hot: iget-quick and iput-quick in the loop.
+  void add(int n) {
+    for (int i = 0; i < n; i++) {
+      total += i;
+    }
+  }
+}
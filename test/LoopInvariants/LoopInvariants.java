@@ -0,0 +1,130 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Test cases for global value numbering and loop invariant code motion: tight
+// loops with and without invariant code, and checks that must stay in place.
+class LoopInvariants {
+  int size;
+  int scale;
+
+  LoopInvariants(int size, int scale) {
+    this.size = size;
+    this.scale = scale;
+  }
+
+  // Both field loads and the product of the bound can leave the loop.
+  int fieldBound() {
+    int result = 0;
+    for (int i = 0; i < size * scale; i++) {
+      result += i;
+    }
+    return result;
+  }
+
+  // The loop stores to a field, so its field loads stay.
+  int fieldWritten() {
+    int result = 0;
+    for (int i = 0; i < size; i++) {
+      scale += 1;
+      result += scale;
+    }
+    return result;
+  }
+
+  // The callee may store to the field.
+  int callInLoop() {
+    int result = 0;
+    for (int i = 0; i < size; i++) {
+      bump();
+      result += scale;
+    }
+    return result;
+  }
+
+  void bump() {
+    scale++;
+  }
+
+  // a is null checked before the loop, so its length can leave the loop.
+  static int sumArray(int[] a) {
+    int result = a[0];
+    for (int i = 1; i < a.length; i++) {
+      result += a[i];
+    }
+    return result;
+  }
+
+  // a is only dereferenced when the loop runs.
+  static int lengthInLoop(int[] a, int n) {
+    int result = 0;
+    for (int i = 0; i < n; i++) {
+      result += a.length;
+    }
+    return result;
+  }
+
+  // The handler must see the iterations run before the exception.
+  static int countThenThrow(int[] a, int n) {
+    int count = 0;
+    try {
+      for (int i = 0; i < n; i++) {
+        count++;
+        if (count > 2) {
+          count += a.length;
+        }
+      }
+    } catch (NullPointerException e) {
+      return -count;
+    }
+    return count;
+  }
+
+  static int indexInLoop(int[] a, int n) {
+    int result = 0;
+    for (int i = 0; i < n; i++) {
+      result += a[i];
+    }
+    return result;
+  }
+
+  static int invariantArithmetic(int x, int y, int n) {
+    int result = 0;
+    for (int i = 0; i < n; i++) {
+      int k = x * y + 7;
+      result += k ^ i;
+    }
+    return result;
+  }
+
+  // The element is read again after a store in another block.
+  static int readWriteElement(int[] a, int i, boolean flag) {
+    int before = a[i];
+    if (flag) {
+      a[i] = before + 1;
+    }
+    return a[i] + before;
+  }
+
+  // p and q may be the same object: the second index must be range checked.
+  static int aliasedIndex(LoopInvariants p, LoopInvariants q, int[] a) {
+    int x = a[p.size];
+    q.size = q.size + 1;
+    if (x > 0) {
+      x += a[p.size];
+    }
+    return x;
+  }
+}